@@ -26,6 +26,7 @@
 #include <common/gfal_plugin.h>
 #include <gfal_api.h>
 #include "gfal_file_handler_container.h"
+#include "gfal_stats_internal.h"
 
 // initialization
 __attribute__((constructor))
@@ -141,11 +142,21 @@ gfal2_context_t gfal2_context_new(GError **err)
         g_free(context);
         return NULL;
     }
+    gfal2_config_snapshot_init(context);
+    context->stats = gfal_stats_new();
+    g_static_rw_lock_init(&context->cred_lock);
     gfal_initCredentialLocation(context);
     context->plugin_opt.plugin_number = 0;
+    context->plugin_opt.mux_plugins = g_mutex_new();
+    context->plugin_opt.cond_plugins = g_cond_new();
     int ret = gfal_plugins_instance(context, &tmp_err);
     if (ret <= 0 && tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        g_mutex_free(context->plugin_opt.mux_plugins);
+        g_cond_free(context->plugin_opt.cond_plugins);
+        gfal2_config_snapshot_free(context);
+        gfal_stats_free(context->stats);
+        g_static_rw_lock_free(&context->cred_lock);
         g_key_file_free(context->config);
         g_free(context);
         return NULL;
@@ -168,24 +179,37 @@ void gfal2_context_free(gfal2_context_t context)
 
     gfal_plugins_delete(context, NULL);
     gfal_file_descriptor_handle_destroy(context->fdescs);
+    gfal2_config_snapshot_free(context);
+    gfal_stats_free(context->stats);
     g_key_file_free(context->config);
     g_list_free(context->plugin_opt.sorted_plugin);
+    g_list_free_full(context->plugin_opt.retired_sorted_plugins, (GDestroyNotify)g_list_free);
+    g_mutex_free(context->plugin_opt.mux_plugins);
+    g_cond_free(context->plugin_opt.cond_plugins);
     g_mutex_free(context->mux_cancel);
     g_hook_list_clear(&context->cancel_hooks);
     g_free(context->agent_name);
     g_free(context->agent_version);
     g_ptr_array_foreach(context->client_info, gfal_free_keyvalue, NULL);
     gfal2_cred_clean(context, NULL);
+    g_static_rw_lock_free(&context->cred_lock);
     g_free(context);
 }
 
 
 gchar **gfal2_get_plugin_names(gfal2_context_t context)
 {
-    gchar **array = g_new0(gchar*, context->plugin_opt.plugin_number + 1);
+    GError *tmp_err = NULL;
+    if (gfal_plugins_load_all(context, &tmp_err) < 0) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Could not load all the plugins: %s", tmp_err->message);
+        g_error_free(tmp_err);
+    }
+
+    const int plugin_number = g_atomic_int_get(&context->plugin_opt.plugin_number);
+    gchar **array = g_new0(gchar*, plugin_number + 1);
     int i;
 
-    for (i = 0; i < context->plugin_opt.plugin_number; ++i) {
+    for (i = 0; i < plugin_number; ++i) {
         array[i] = g_strdup(context->plugin_opt.plugin_list[i].getName());
     }
     array[i] = NULL;
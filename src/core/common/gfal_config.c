@@ -19,6 +19,7 @@
  */
 
 #include "gfal_handle.h"
+#include "gfal_config_internal.h"
 #include <gfal_api.h>
 #include <string.h>
 
@@ -170,11 +171,248 @@ GKeyFile* gfal2_init_config(GError **err)
 }
 
 
+// Typed value of a configuration key, parsed once per configuration generation
+typedef struct _gfal_config_entry {
+    gchar *string_value;
+    gchar **list_value;
+    gsize list_length;
+    gint int_value;
+    gboolean is_int;
+    gboolean bool_value;
+    gboolean is_bool;
+} gfal_config_entry;
+
+
+static void gfal_config_entry_free(gpointer data)
+{
+    gfal_config_entry *entry = (gfal_config_entry*) data;
+    g_free(entry->string_value);
+    g_strfreev(entry->list_value);
+    g_free(entry);
+}
+
+
+// Keys of a group, by name and in the order of the configuration
+typedef struct _gfal_config_group {
+    GHashTable *entries;
+    gchar **keys;
+    gsize n_keys;
+} gfal_config_group;
+
+
+static void gfal_config_group_free(gpointer data)
+{
+    gfal_config_group *group = (gfal_config_group*) data;
+    g_hash_table_destroy(group->entries);
+    g_strfreev(group->keys);
+    g_free(group);
+}
+
+
+// Snapshots are immutable once published, so readers only need to tell that they
+// are using one. They count themselves in the config_readers slot of the current
+// config_epoch. A rebuild publishes the new snapshot, moves to the next epoch, and waits
+// for the readers of the previous one to finish: only those could still see the old snapshot.
+typedef struct _gfal_config_snapshot {
+    gint generation;
+    GHashTable *groups;
+} gfal_config_snapshot;
+
+
+static void gfal_config_snapshot_delete(gpointer data)
+{
+    gfal_config_snapshot *snapshot = (gfal_config_snapshot*) data;
+    if (snapshot) {
+        g_hash_table_destroy(snapshot->groups);
+        g_free(snapshot);
+    }
+}
+
+
+void gfal2_config_snapshot_init(gfal2_context_t context)
+{
+    context->mux_config = g_mutex_new();
+    context->config_snapshot = NULL;
+    context->config_epoch = 0;
+    context->config_readers[0] = context->config_readers[1] = 0;
+}
+
+
+void gfal2_config_snapshot_free(gfal2_context_t context)
+{
+    gfal_config_snapshot_delete(context->config_snapshot);
+    g_mutex_free(context->mux_config);
+}
+
+
+static void gfal_config_changed(gfal2_context_t context)
+{
+    g_atomic_int_inc(&context->config_generation);
+}
+
+
+gint gfal2_get_opt_generation(gfal2_context_t context)
+{
+    g_assert(context != NULL);
+    return g_atomic_int_get(&context->config_generation);
+}
+
+
+// Parse every key of the configuration
+static gfal_config_snapshot *gfal_config_snapshot_new(GKeyFile *config, gint generation)
+{
+    gsize n_groups = 0, n_keys = 0;
+    gsize i, j;
+
+    gfal_config_snapshot *snapshot = g_new0(gfal_config_snapshot, 1);
+    snapshot->generation = generation;
+    snapshot->groups = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        gfal_config_group_free);
+
+    gchar **groups = g_key_file_get_groups(config, &n_groups);
+    for (i = 0; i < n_groups; ++i) {
+        gchar **keys = g_key_file_get_keys(config, groups[i], &n_keys, NULL);
+        if (keys == NULL) {
+            continue;
+        }
+
+        GHashTable *entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+            gfal_config_entry_free);
+        for (j = 0; j < n_keys; ++j) {
+            GError *tmp_err = NULL;
+            gfal_config_entry *entry = g_new0(gfal_config_entry, 1);
+
+            entry->string_value = g_key_file_get_string(config, groups[i], keys[j], NULL);
+            entry->int_value = g_key_file_get_integer(config, groups[i], keys[j], &tmp_err);
+            entry->is_int = (tmp_err == NULL);
+            g_clear_error(&tmp_err);
+            entry->bool_value = g_key_file_get_boolean(config, groups[i], keys[j], &tmp_err);
+            entry->is_bool = (tmp_err == NULL);
+            g_clear_error(&tmp_err);
+            entry->list_value = g_key_file_get_string_list(config, groups[i], keys[j],
+                &entry->list_length, NULL);
+
+            g_hash_table_insert(entries, g_strdup(keys[j]), entry);
+        }
+
+        gfal_config_group *group = g_new0(gfal_config_group, 1);
+        group->entries = entries;
+        group->keys = keys;
+        group->n_keys = n_keys;
+        g_hash_table_insert(snapshot->groups, g_strdup(groups[i]), group);
+    }
+    g_strfreev(groups);
+
+    return snapshot;
+}
+
+
+// Replace the snapshot if it is older than generation
+// The replaced one is freed once the readers that could still see it are done
+static void gfal_config_snapshot_publish(gfal2_context_t context, gint generation)
+{
+    g_mutex_lock(context->mux_config);
+
+    gfal_config_snapshot *current = g_atomic_pointer_get(&context->config_snapshot);
+    if (current == NULL || current->generation < generation) {
+        // Label with the generation read before parsing, so a concurrent change triggers another rebuild
+        gfal_config_snapshot *snapshot = gfal_config_snapshot_new(context->config,
+            g_atomic_int_get(&context->config_generation));
+        g_atomic_pointer_set(&context->config_snapshot, snapshot);
+
+        if (current) {
+            // Readers entering from now on see the new snapshot. Readers hold a snapshot
+            // for a single lookup, so this wait is short
+            gint previous = g_atomic_int_get(&context->config_epoch);
+            g_atomic_int_set(&context->config_epoch, previous + 1);
+            while (g_atomic_int_get(&context->config_readers[previous & 1]) != 0) {
+                g_thread_yield();
+            }
+            gfal_config_snapshot_delete(current);
+        }
+    }
+
+    g_mutex_unlock(context->mux_config);
+}
+
+
+// Get the current snapshot, rebuilding it if needed
+// slot must be passed to gfal_config_snapshot_release once done with the snapshot
+static gfal_config_snapshot *gfal_config_snapshot_acquire(gfal2_context_t context, gint *slot)
+{
+    const gint generation = g_atomic_int_get(&context->config_generation);
+
+    gfal_config_snapshot *snapshot = g_atomic_pointer_get(&context->config_snapshot);
+    if (snapshot == NULL || snapshot->generation < generation) {
+        gfal_config_snapshot_publish(context, generation);
+    }
+
+    // If the epoch moved meanwhile, the rebuild may already be waiting on the other slot
+    gint epoch;
+    while (1) {
+        epoch = g_atomic_int_get(&context->config_epoch);
+        g_atomic_int_inc(&context->config_readers[epoch & 1]);
+        if (g_atomic_int_get(&context->config_epoch) == epoch) {
+            break;
+        }
+        g_atomic_int_add(&context->config_readers[epoch & 1], -1);
+    }
+    *slot = epoch & 1;
+    return g_atomic_pointer_get(&context->config_snapshot);
+}
+
+
+static void gfal_config_snapshot_release(gfal2_context_t context, gint slot)
+{
+    g_atomic_int_add(&context->config_readers[slot], -1);
+}
+
+
+// Values gfal_config_snapshot_get copies into the entry, besides the scalars
+enum {
+    GFAL_CONFIG_COPY_STRING = 1,
+    GFAL_CONFIG_COPY_LIST = 2
+};
+
+
+// Lookup a key in the snapshot, copying the entry into value
+// Return FALSE if the key is not defined
+static gboolean gfal_config_snapshot_get(gfal2_context_t context, const gchar *group_name,
+    const gchar *key, gfal_config_entry *value, int copy)
+{
+    gboolean found = FALSE;
+    gint slot;
+    gfal_config_snapshot *snapshot = gfal_config_snapshot_acquire(context, &slot);
+
+    gfal_config_group *group = g_hash_table_lookup(snapshot->groups, group_name);
+    if (group) {
+        gfal_config_entry *entry = g_hash_table_lookup(group->entries, key);
+        if (entry) {
+            *value = *entry;
+            value->string_value = (copy & GFAL_CONFIG_COPY_STRING) ? g_strdup(entry->string_value) : NULL;
+            value->list_value = (copy & GFAL_CONFIG_COPY_LIST) ? g_strdupv(entry->list_value) : NULL;
+            found = TRUE;
+        }
+    }
+
+    gfal_config_snapshot_release(context, slot);
+    return found;
+}
+
+
 gchar *gfal2_get_opt_string(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
     g_assert(context != NULL);
-    return g_key_file_get_string(context->config, group_name, key, error);
+    gfal_config_entry entry;
+    if (gfal_config_snapshot_get(context, group_name, key, &entry, GFAL_CONFIG_COPY_STRING) && entry.string_value) {
+        return entry.string_value;
+    }
+    // Not there, or not valid: let GKeyFile report why
+    g_mutex_lock(context->mux_config);
+    gchar *value = g_key_file_get_string(context->config, group_name, key, error);
+    g_mutex_unlock(context->mux_config);
+    return value;
 }
 
 
@@ -182,17 +420,15 @@ gchar *gfal2_get_opt_string_with_default(gfal2_context_t handle,
     const gchar *group_name, const gchar *key, const gchar *default_value)
 {
     g_assert(handle != NULL);
-    GError *tmp_err = NULL;
+    gfal_config_entry entry;
 
-    gchar *value = gfal2_get_opt_string(handle, group_name, key, &tmp_err);
-    if (tmp_err) {
-        gfal2_log(G_LOG_LEVEL_DEBUG,
-                "Impossible to get string parameter %s:%s, set to default value %s, err %s",
-                group_name, key, default_value, tmp_err->message);
-        g_clear_error(&tmp_err);
-        value = g_strdup(default_value);
+    if (gfal_config_snapshot_get(handle, group_name, key, &entry, GFAL_CONFIG_COPY_STRING) && entry.string_value) {
+        return entry.string_value;
     }
-    return value;
+    gfal2_log(G_LOG_LEVEL_DEBUG,
+            "Impossible to get string parameter %s:%s, set to default value %s",
+            group_name, key, default_value);
+    return g_strdup(default_value);
 }
 
 
@@ -200,7 +436,10 @@ gint gfal2_set_opt_string(gfal2_context_t context, const gchar *group_name,
     const gchar *key, const gchar *value, GError **error)
 {
     g_assert(context != NULL);
+    g_mutex_lock(context->mux_config);
     g_key_file_set_string(context->config, group_name, key, value);
+    gfal_config_changed(context);
+    g_mutex_unlock(context->mux_config);
     return 0;
 }
 
@@ -209,24 +448,30 @@ gint gfal2_get_opt_integer(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
     g_assert(context != NULL);
-    return g_key_file_get_integer(context->config, group_name, key, error);
+    gfal_config_entry entry;
+    if (gfal_config_snapshot_get(context, group_name, key, &entry, 0) && entry.is_int) {
+        return entry.int_value;
+    }
+    g_mutex_lock(context->mux_config);
+    gint value = g_key_file_get_integer(context->config, group_name, key, error);
+    g_mutex_unlock(context->mux_config);
+    return value;
 }
 
 
 gint gfal2_get_opt_integer_with_default(gfal2_context_t context,
     const gchar *group_name, const gchar *key, gint default_value)
 {
-    GError *tmp_err = NULL;
+    g_assert(context != NULL);
+    gfal_config_entry entry;
 
-    gint res = gfal2_get_opt_integer(context, group_name, key, &tmp_err);
-    if (tmp_err) {
-        gfal2_log(G_LOG_LEVEL_DEBUG,
-            "Impossible to get integer parameter %s:%s, set to default value %d, err %s",
-            group_name, key, default_value, tmp_err->message);
-        g_clear_error(&tmp_err);
-        res = default_value;
+    if (gfal_config_snapshot_get(context, group_name, key, &entry, 0) && entry.is_int) {
+        return entry.int_value;
     }
-    return res;
+    gfal2_log(G_LOG_LEVEL_DEBUG,
+        "Impossible to get integer parameter %s:%s, set to default value %d",
+        group_name, key, default_value);
+    return default_value;
 }
 
 
@@ -234,7 +479,10 @@ gint gfal2_set_opt_integer(gfal2_context_t context, const gchar *group_name,
     const gchar *key, gint value, GError **error)
 {
     g_assert(context != NULL);
+    g_mutex_lock(context->mux_config);
     g_key_file_set_integer(context->config, group_name, key, value);
+    gfal_config_changed(context);
+    g_mutex_unlock(context->mux_config);
     return 0;
 }
 
@@ -243,25 +491,30 @@ gboolean gfal2_get_opt_boolean(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
     g_assert(context != NULL);
-    return g_key_file_get_boolean(context->config, group_name, key, error);
+    gfal_config_entry entry;
+    if (gfal_config_snapshot_get(context, group_name, key, &entry, 0) && entry.is_bool) {
+        return entry.bool_value;
+    }
+    g_mutex_lock(context->mux_config);
+    gboolean value = g_key_file_get_boolean(context->config, group_name, key, error);
+    g_mutex_unlock(context->mux_config);
+    return value;
 }
 
 
 gboolean gfal2_get_opt_boolean_with_default(gfal2_context_t context,
     const gchar *group_name, const gchar *key, gboolean default_value)
 {
-    GError *tmp_err = NULL;
+    g_assert(context != NULL);
+    gfal_config_entry entry;
 
-    gboolean res = gfal2_get_opt_boolean(context, group_name, key, &tmp_err);
-    if (tmp_err) {
-        gfal2_log(G_LOG_LEVEL_DEBUG,
-            "Impossible to get boolean parameter %s:%s, set to default value %s, err %s",
-            group_name, key, ((default_value) ? "TRUE" : "FALSE"),
-            tmp_err->message);
-        g_clear_error(&tmp_err);
-        res = default_value;
+    if (gfal_config_snapshot_get(context, group_name, key, &entry, 0) && entry.is_bool) {
+        return entry.bool_value;
     }
-    return res;
+    gfal2_log(G_LOG_LEVEL_DEBUG,
+        "Impossible to get boolean parameter %s:%s, set to default value %s",
+        group_name, key, ((default_value) ? "TRUE" : "FALSE"));
+    return default_value;
 }
 
 
@@ -269,7 +522,10 @@ gint gfal2_set_opt_boolean(gfal2_context_t context, const gchar *group_name,
     const gchar *key, gboolean value, GError **error)
 {
     g_assert(context != NULL);
+    g_mutex_lock(context->mux_config);
     g_key_file_set_boolean(context->config, group_name, key, value);
+    gfal_config_changed(context);
+    g_mutex_unlock(context->mux_config);
     return 0;
 }
 
@@ -279,7 +535,17 @@ gchar **gfal2_get_opt_string_list(gfal2_context_t context,
     GError **error)
 {
     g_assert(context != NULL);
-    return g_key_file_get_string_list(context->config, group_name, key, length, error);
+    gfal_config_entry entry;
+    if (gfal_config_snapshot_get(context, group_name, key, &entry, GFAL_CONFIG_COPY_LIST) && entry.list_value) {
+        if (length) {
+            *length = entry.list_length;
+        }
+        return entry.list_value;
+    }
+    g_mutex_lock(context->mux_config);
+    gchar **value = g_key_file_get_string_list(context->config, group_name, key, length, error);
+    g_mutex_unlock(context->mux_config);
+    return value;
 }
 
 
@@ -288,7 +554,10 @@ gint gfal2_set_opt_string_list(gfal2_context_t context, const gchar *group_name,
     GError **error)
 {
     g_assert(context != NULL);
+    g_mutex_lock(context->mux_config);
     g_key_file_set_string_list(context->config, group_name, key, list, length);
+    gfal_config_changed(context);
+    g_mutex_unlock(context->mux_config);
     return 0;
 }
 
@@ -297,42 +566,74 @@ gchar **gfal2_get_opt_string_list_with_default(gfal2_context_t context,
     const gchar *group_name, const gchar *key, gsize *length,
     char **default_value)
 {
-    GError *tmp_err = NULL;
-
-    gchar **res = gfal2_get_opt_string_list(context, group_name, key, length, &tmp_err);
+    g_assert(context != NULL);
+    gfal_config_entry entry;
 
-    if (tmp_err) {
-        if (gfal2_log_get_level() >= G_LOG_LEVEL_DEBUG) {
-            gchar *list_default = default_value ? g_strjoinv(",", default_value) : NULL;
-            gfal2_log(G_LOG_LEVEL_DEBUG,
-                "Impossible to get string_list parameter %s:%s, set to a default value %s, err %s",
-                group_name, key, list_default, tmp_err->message);
-            g_free(list_default);
+    if (gfal_config_snapshot_get(context, group_name, key, &entry, GFAL_CONFIG_COPY_LIST) && entry.list_value) {
+        if (length) {
+            *length = entry.list_length;
         }
-        g_clear_error(&tmp_err);
-        res = g_strdupv(default_value);
+        return entry.list_value;
+    }
+    if (gfal2_log_get_level() >= G_LOG_LEVEL_DEBUG) {
+        gchar *list_default = default_value ? g_strjoinv(",", default_value) : NULL;
+        gfal2_log(G_LOG_LEVEL_DEBUG,
+            "Impossible to get string_list parameter %s:%s, set to a default value %s",
+            group_name, key, list_default);
+        g_free(list_default);
+    }
+    if (length) {
+        *length = default_value ? g_strv_length(default_value) : 0;
     }
-    return res;
+    return g_strdupv(default_value);
 }
 
 
 gint gfal2_load_opts_from_file(gfal2_context_t context, const char *path,
     GError **error)
 {
-    return gfal_load_configuration_to_conf_manager(context->config, path, error);
+    g_mutex_lock(context->mux_config);
+    int ret = gfal_load_configuration_to_conf_manager(context->config, path, error);
+    gfal_config_changed(context);
+    g_mutex_unlock(context->mux_config);
+    return ret;
 }
 
 
 gchar **gfal2_get_opt_keys(gfal2_context_t context, const gchar *group_name, gsize *length, GError **error)
 {
-    return g_key_file_get_keys(context->config, group_name, length, error);
+    gchar **keys = NULL;
+    gint slot;
+    gfal_config_snapshot *snapshot = gfal_config_snapshot_acquire(context, &slot);
+
+    gfal_config_group *group = g_hash_table_lookup(snapshot->groups, group_name);
+    if (group) {
+        keys = g_strdupv(group->keys);
+        if (length) {
+            *length = group->n_keys;
+        }
+    }
+
+    gfal_config_snapshot_release(context, slot);
+
+    if (group == NULL) {
+        // Let GKeyFile report why
+        g_mutex_lock(context->mux_config);
+        keys = g_key_file_get_keys(context->config, group_name, length, error);
+        g_mutex_unlock(context->mux_config);
+    }
+    return keys;
 }
 
 
 gboolean gfal2_remove_opt(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
-    return g_key_file_remove_key(context->config, group_name, key, error);
+    g_mutex_lock(context->mux_config);
+    gboolean removed = g_key_file_remove_key(context->config, group_name, key, error);
+    gfal_config_changed(context);
+    g_mutex_unlock(context->mux_config);
+    return removed;
 }
 
 
@@ -248,6 +248,16 @@ gint gfal2_load_opts_from_file(gfal2_context_t context, const char* path, GError
 gchar **gfal2_get_opt_keys(gfal2_context_t context, const gchar *group_name, gsize *length, GError **error);
 
 
+/**
+ * Get the generation of the configuration of the context
+ * The generation changes every time the configuration is modified, so
+ * values derived from the configuration can be cached and refreshed only
+ * when it differs from the one they were computed with
+ * @param context : context of gfal2
+ * @return current configuration generation
+ */
+gint gfal2_get_opt_generation(gfal2_context_t context);
+
 /**
  * Removes a key from the settings
  * @param context : context of gfal2
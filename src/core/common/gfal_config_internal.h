@@ -23,10 +23,16 @@
 #define GFAL_CONFIG_INTERNAL_H_
 
 #include <glib.h>
+#include <common/gfal_common.h>
 
 // create or delete configuration manager for gfal2, internal
 GKeyFile* gfal2_init_config(GError **err);
 
 void gfal_free_keyvalue(gpointer data, gpointer user_data);
 
+// create or delete the typed configuration snapshot of a context, internal
+void gfal2_config_snapshot_init(gfal2_context_t context);
+
+void gfal2_config_snapshot_free(gfal2_context_t context);
+
 #endif /* GFAL_CONFIG_INTERNAL_H_ */
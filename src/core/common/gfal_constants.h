@@ -49,6 +49,8 @@ extern "C"
 #define GFAL_PLUGIN_DIR_SUFFIX "gfal2-plugins"
 /** plugin entry point */
 #define GFAL_PLUGIN_INIT_SYM "gfal_plugin_init"
+/** suffix of the plugin manifests used for lazy loading */
+#define GFAL_PLUGIN_MANIFEST_SUFFIX ".manifest"
 
 /**  environment variable for personnalized configuration directory */
 #define GFAL_CONFIG_DIR_ENV "GFAL_CONFIG_DIR"
@@ -20,39 +20,254 @@
 
 
 typedef struct {
-    size_t prefix_len;
     char *url_prefix;
     gfal2_cred_t *cred;
 } gfal2_cred_node_t ;
 
+//
+// Credentials are indexed by url prefix in a radix trie.
+// Each trie node holds the credentials whose prefix ends there, sorted by type,
+// and its children, sorted by the first character of their edge.
+// Visiting children in reverse order before the node itself yields the prefixes
+// in descending order, which is the order gfal2_cred_foreach has always used.
+//
+struct _gfal_cred_trie {
+    char *edge;
+    size_t edge_len;
+    GSList *creds;
+    GPtrArray *children;
+};
+
+
+static gint node_type_compare(gconstpointer a, gconstpointer b)
+{
+    const gfal2_cred_node_t *node_a = a, *node_b = b;
+    return strcmp(node_a->cred->type, node_b->cred->type);
+}
+
+
+static void node_free(gpointer ptr)
+{
+    gfal2_cred_node_t *node = ptr;
+    g_free(node->url_prefix);
+    gfal2_cred_free(node->cred);
+    g_free(node);
+}
+
+
+static gfal_cred_trie_t *trie_new(const char *edge, size_t edge_len)
+{
+    gfal_cred_trie_t *trie = g_new0(gfal_cred_trie_t, 1);
+    trie->edge = g_strndup(edge, edge_len);
+    trie->edge_len = edge_len;
+    trie->children = g_ptr_array_new();
+    return trie;
+}
+
+
+static void trie_free(gfal_cred_trie_t *trie)
+{
+    guint i;
+    if (trie == NULL) {
+        return;
+    }
+    for (i = 0; i < trie->children->len; ++i) {
+        trie_free(g_ptr_array_index(trie->children, i));
+    }
+    g_ptr_array_free(trie->children, TRUE);
+    g_slist_free_full(trie->creds, node_free);
+    g_free(trie->edge);
+    g_free(trie);
+}
 
-static gint node_compare(gconstpointer a, gconstpointer b)
+
+// Binary search of the child whose edge starts with c
+// Returns the child, or NULL and the position where it should be inserted
+static gfal_cred_trie_t *trie_child(const gfal_cred_trie_t *trie, char c, guint *index)
 {
-    const gfal2_cred_node_t *node_a, *node_b;
-    node_a = a;
-    node_b = b;
-    int comp = -strcmp(node_a->url_prefix, node_b->url_prefix);
-    if (comp == 0) {
-        return strcmp(node_a->cred->type, node_b->cred->type);
+    guint low = 0, high = trie->children->len;
+    while (low < high) {
+        guint mid = (low + high) / 2;
+        gfal_cred_trie_t *child = g_ptr_array_index(trie->children, mid);
+        unsigned char first = (unsigned char) child->edge[0];
+        if (first == (unsigned char) c) {
+            *index = mid;
+            return child;
+        }
+        else if (first < (unsigned char) c) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
     }
-    return comp;
+    *index = low;
+    return NULL;
 }
 
 
-static void node_copy(gpointer src, gpointer user_data)
+static void trie_insert_child(gfal_cred_trie_t *trie, guint index, gfal_cred_trie_t *child)
 {
-    gfal2_context_t dest = user_data;
-    const gfal2_cred_node_t *node = src;
-    gfal2_cred_set(dest, node->url_prefix, node->cred, NULL);
+    g_ptr_array_add(trie->children, NULL);
+    memmove(trie->children->pdata + index + 1, trie->children->pdata + index,
+        (trie->children->len - index - 1) * sizeof(gpointer));
+    trie->children->pdata[index] = child;
 }
 
 
-static void node_free(gpointer ptr)
+// Return the node for the exact prefix, creating it if needed
+static gfal_cred_trie_t *trie_insert_path(gfal_cred_trie_t *root, const char *prefix)
 {
-    gfal2_cred_node_t *node = ptr;
-    g_free(node->url_prefix);
-    gfal2_cred_free(node->cred);
-    g_free(node);
+    gfal_cred_trie_t *trie = root;
+    size_t left = strlen(prefix);
+
+    while (left > 0) {
+        guint index;
+        gfal_cred_trie_t *child = trie_child(trie, *prefix, &index);
+        if (child == NULL) {
+            child = trie_new(prefix, left);
+            trie_insert_child(trie, index, child);
+            return child;
+        }
+
+        size_t common = 1;
+        while (common < child->edge_len && common < left && child->edge[common] == prefix[common]) {
+            ++common;
+        }
+
+        if (common < child->edge_len) {
+            // Split the edge
+            gfal_cred_trie_t *middle = trie_new(child->edge, common);
+            char *remaining = g_strndup(child->edge + common, child->edge_len - common);
+            g_free(child->edge);
+            child->edge = remaining;
+            child->edge_len -= common;
+            g_ptr_array_add(middle->children, child);
+            trie->children->pdata[index] = middle;
+            child = middle;
+        }
+
+        trie = child;
+        prefix += common;
+        left -= common;
+    }
+    return trie;
+}
+
+
+static gfal2_cred_node_t *trie_get_type(const gfal_cred_trie_t *trie, const char *type)
+{
+    GSList *item;
+    for (item = trie->creds; item != NULL; item = g_slist_next(item)) {
+        gfal2_cred_node_t *node = item->data;
+        if (strcmp(node->cred->type, type) == 0) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+
+// Remove the credential for type and the exact prefix, pruning emptied nodes
+static gboolean trie_remove(gfal_cred_trie_t *trie, const char *prefix, const char *type)
+{
+    if (*prefix == '\0') {
+        gfal2_cred_node_t *node = trie_get_type(trie, type);
+        if (node == NULL) {
+            return FALSE;
+        }
+        trie->creds = g_slist_remove(trie->creds, node);
+        node_free(node);
+        return TRUE;
+    }
+
+    guint index;
+    gfal_cred_trie_t *child = trie_child(trie, *prefix, &index);
+    if (child == NULL || strncmp(prefix, child->edge, child->edge_len) != 0) {
+        return FALSE;
+    }
+
+    gboolean removed = trie_remove(child, prefix + child->edge_len, type);
+    if (removed && child->creds == NULL && child->children->len == 0) {
+        g_ptr_array_remove_index(trie->children, index);
+        trie_free(child);
+    }
+    return removed;
+}
+
+
+// A prefix of url must end on a directory of the target URL
+static gboolean prefix_on_boundary(const char *url, size_t prefix_len, size_t url_len)
+{
+    if (prefix_len >= url_len) {
+        return TRUE;
+    }
+    return (prefix_len > 0 && url[prefix_len - 1] == '/') || url[prefix_len] == '/';
+}
+
+
+// Walk url down the trie, calling func on each node whose prefix is on a directory boundary,
+// shortest first. Returns the node where the walk stopped: the node matching url exactly
+// (exact is set), the child whose edge extends past the end of url, or NULL if url diverges
+static gfal_cred_trie_t *trie_walk(gfal_cred_trie_t *root, const char *url,
+    void (*func)(gfal_cred_trie_t *trie, void *user_data), void *user_data, gboolean *exact)
+{
+    const size_t url_len = strlen(url);
+    gfal_cred_trie_t *trie = root;
+    size_t depth = 0;
+
+    *exact = FALSE;
+    while (1) {
+        if (trie->creds && prefix_on_boundary(url, depth, url_len)) {
+            func(trie, user_data);
+        }
+        if (depth == url_len) {
+            *exact = TRUE;
+            return trie;
+        }
+
+        guint index;
+        gfal_cred_trie_t *child = trie_child(trie, url[depth], &index);
+        if (child == NULL) {
+            return NULL;
+        }
+        if (child->edge_len > url_len - depth) {
+            // url ends inside this edge: whatever is below is longer than url
+            if (strncmp(url + depth, child->edge, url_len - depth) == 0) {
+                return child;
+            }
+            return NULL;
+        }
+        if (strncmp(url + depth, child->edge, child->edge_len) != 0) {
+            return NULL;
+        }
+        depth += child->edge_len;
+        trie = child;
+    }
+}
+
+
+static void lock_read(gfal2_context_t handle)
+{
+    g_static_rw_lock_reader_lock(&handle->cred_lock);
+}
+
+
+static void unlock_read(gfal2_context_t handle)
+{
+    g_static_rw_lock_reader_unlock(&handle->cred_lock);
+}
+
+
+static void lock_write(gfal2_context_t handle)
+{
+    g_static_rw_lock_writer_lock(&handle->cred_lock);
+}
+
+
+static void unlock_write(gfal2_context_t handle)
+{
+    g_static_rw_lock_writer_unlock(&handle->cred_lock);
 }
 
 
@@ -86,48 +301,71 @@ gfal2_cred_t* gfal2_cred_dup(const gfal2_cred_t *cred)
 
 int gfal2_cred_set(gfal2_context_t handle, const char *url_prefix, const gfal2_cred_t *cred, GError **error)
 {
+    // Without a credential there is no type to replace, so nothing to do
+    if (cred == NULL) {
+        return 0;
+    }
+
     gfal2_cred_node_t *node = g_malloc0(sizeof(gfal2_cred_node_t));
-    node->prefix_len = strlen(url_prefix);
     node->url_prefix = g_strdup(url_prefix);
     node->cred = gfal2_cred_dup(cred);
 
-    // Remove existing value
-    GList *item = g_list_find_custom(handle->cred_mapping, node, node_compare);
-    if (item) {
-        gfal2_cred_node_t *match = item->data;
-        node_free(match);
-        handle->cred_mapping = g_list_delete_link(handle->cred_mapping, item);
+    lock_write(handle);
+    if (handle->cred_mapping == NULL) {
+        handle->cred_mapping = trie_new("", 0);
     }
+    gfal_cred_trie_t *trie = trie_insert_path(handle->cred_mapping, url_prefix);
 
-    // If cred is NULL, done
-    if (cred == NULL) {
-        node_free(node);
-        return 0;
+    // Remove existing value
+    gfal2_cred_node_t *match = trie_get_type(trie, cred->type);
+    if (match) {
+        trie->creds = g_slist_remove(trie->creds, match);
+        node_free(match);
     }
+    trie->creds = g_slist_insert_sorted(trie->creds, node, node_type_compare);
+    unlock_write(handle);
 
-    handle->cred_mapping = g_list_insert_sorted(handle->cred_mapping, node, node_compare);
     return 0;
 }
 
 
-char *gfal2_cred_get(gfal2_context_t handle, const char *type, const char *url, char const** baseurl, GError **error)
+typedef struct {
+    const char *type;
+    gfal2_cred_node_t *best;
+} best_match_data;
+
+
+static void keep_best_match(gfal_cred_trie_t *trie, void *user_data)
 {
-    // Pick the first, which is the longest match, since the list is sorted
-    GList *item;
-    for (item = g_list_first(handle->cred_mapping); item != NULL; item = g_list_next(item)) {
-        gfal2_cred_node_t *node = item->data;
-        if (strcmp(node->cred->type, type) == 0 && strncmp(node->url_prefix, url, node->prefix_len) == 0) {
-            // Prefix must match a directory in the target URL
-            if (node->prefix_len < strlen(url) &&
-                (url[node->prefix_len - 1] != '/' && url[node->prefix_len] != '/')) {
-                continue;
-            }
+    best_match_data *data = user_data;
+    gfal2_cred_node_t *node = trie_get_type(trie, data->type);
+    if (node) {
+        data->best = node;
+    }
+}
 
-            if (baseurl) {
-                *baseurl = (char const*)(node->url_prefix);
-            }
-            return g_strdup(node->cred->value);
+
+char *gfal2_cred_get(gfal2_context_t handle, const char *type, const char *url, char const** baseurl, GError **error)
+{
+    // The walk goes from shortest to longest, so the last match is the best one
+    best_match_data data = {type, NULL};
+    gboolean exact;
+    char *value = NULL;
+
+    lock_read(handle);
+    if (handle->cred_mapping) {
+        trie_walk(handle->cred_mapping, url, keep_best_match, &data, &exact);
+    }
+    if (data.best) {
+        if (baseurl) {
+            *baseurl = (char const*)(data.best->url_prefix);
         }
+        value = g_strdup(data.best->cred->value);
+    }
+    unlock_read(handle);
+
+    if (data.best) {
+        return value;
     }
     if (baseurl) {
         *baseurl = "";
@@ -148,55 +386,171 @@ char *gfal2_cred_get(gfal2_context_t handle, const char *type, const char *url,
 
 int gfal2_cred_del(gfal2_context_t handle, const char *type, const char *url, GError **error)
 {
-    GList *item;
+    gboolean removed = FALSE;
 
-    for (item = g_list_first(handle->cred_mapping); item != NULL; item = g_list_next(item)) {
-        gfal2_cred_node_t *node = item->data;
-        if ((strcmp(node->cred->type, type) == 0) && (node->prefix_len == strlen(url)) &&
-            (strcmp(node->url_prefix, url) == 0)) {
-            node_free(node);
-            handle->cred_mapping = g_list_delete_link(handle->cred_mapping, item);
-            return 0;
-        }
+    lock_write(handle);
+    if (handle->cred_mapping) {
+        removed = trie_remove(handle->cred_mapping, url, type);
     }
+    unlock_write(handle);
 
-    return -1;
+    return removed ? 0 : -1;
 }
 
 int gfal2_cred_clean(gfal2_context_t handle, GError **error)
 {
-    g_list_free_full(handle->cred_mapping, node_free);
+    lock_write(handle);
+    trie_free(handle->cred_mapping);
     handle->cred_mapping = NULL;
+    unlock_write(handle);
     return 0;
 }
 
 
+typedef struct {
+    gfal_cred_func_t callback;
+    void *user_data;
+} callback_data;
+
+
+// Visit every credential below trie, in descending prefix order
+static void trie_foreach(gfal_cred_trie_t *trie, gfal_cred_func_t callback, void *user_data)
+{
+    guint i;
+    GSList *item;
+    for (i = trie->children->len; i > 0; --i) {
+        trie_foreach(g_ptr_array_index(trie->children, i - 1), callback, user_data);
+    }
+    for (item = trie->creds; item != NULL; item = g_slist_next(item)) {
+        gfal2_cred_node_t *node = item->data;
+        callback(node->url_prefix, node->cred, user_data);
+    }
+}
+
+
+// Copy of a node, so it can be used once the lock is released
+static void collect_node(const char *url_prefix, const gfal2_cred_t *cred, void *user_data)
+{
+    GPtrArray *nodes = user_data;
+    gfal2_cred_node_t *copy = g_malloc0(sizeof(gfal2_cred_node_t));
+    copy->url_prefix = g_strdup(url_prefix);
+    copy->cred = gfal2_cred_dup(cred);
+    g_ptr_array_add(nodes, copy);
+}
+
+
+// Copies of every credential, in descending prefix order
+static GPtrArray *collect_all(gfal2_context_t handle)
+{
+    GPtrArray *nodes = g_ptr_array_new_with_free_func(node_free);
+    lock_read(handle);
+    if (handle->cred_mapping) {
+        trie_foreach(handle->cred_mapping, collect_node, nodes);
+    }
+    unlock_read(handle);
+    return nodes;
+}
+
+
 int gfal2_cred_copy(gfal2_context_t dest, const gfal2_context_t src, GError **error)
 {
+    guint i;
     if (gfal2_cred_clean(dest, error) != 0) {
         return -1;
     }
-    g_list_foreach(src->cred_mapping, node_copy, dest);
+    GPtrArray *nodes = collect_all(src);
+    for (i = 0; i < nodes->len; ++i) {
+        gfal2_cred_node_t *node = g_ptr_array_index(nodes, i);
+        gfal2_cred_set(dest, node->url_prefix, node->cred, NULL);
+    }
+    g_ptr_array_free(nodes, TRUE);
     return 0;
 }
 
 
+// Callbacks are called without the lock, so they can use the mapping themselves
+void gfal2_cred_foreach(gfal2_context_t handle, gfal_cred_func_t callback, void *user_data)
+{
+    guint i;
+    GPtrArray *nodes = collect_all(handle);
+    for (i = 0; i < nodes->len; ++i) {
+        gfal2_cred_node_t *node = g_ptr_array_index(nodes, i);
+        callback(node->url_prefix, node->cred, user_data);
+    }
+    g_ptr_array_free(nodes, TRUE);
+}
+
+
 typedef struct {
-    gfal_cred_func_t callback;
-    void *user_data;
-} callback_data;
+    const char *type;
+    const char *url;
+    size_t url_len;
+    GPtrArray *ancestors;
+    GPtrArray *matches;
+} match_data;
 
 
-static void foreach_callback_wrapper(gpointer item, gpointer user_data)
+static void collect_ancestor(gfal_cred_trie_t *trie, void *user_data)
 {
-    callback_data *data = user_data;
-    gfal2_cred_node_t *node = item;
-    data->callback(node->url_prefix, node->cred, data->user_data);
+    match_data *data = user_data;
+    gfal2_cred_node_t *node = trie_get_type(trie, data->type);
+    if (node) {
+        g_ptr_array_add(data->ancestors, node);
+    }
 }
 
 
-void gfal2_cred_foreach(gfal2_context_t handle, gfal_cred_func_t callback, void *user_data)
+static void match_child(const char *url_prefix, const gfal2_cred_t *cred, void *user_data)
+{
+    match_data *data = user_data;
+    size_t prefix_len = strlen(url_prefix);
+    if (strcmp(cred->type, data->type) != 0 || prefix_len <= data->url_len) {
+        return;
+    }
+    // url must match a directory of the prefix
+    if (prefix_on_boundary(url_prefix, data->url_len, prefix_len)) {
+        collect_node(url_prefix, cred, data->matches);
+    }
+}
+
+
+void gfal2_cred_foreach_match(gfal2_context_t handle, const char *type, const char *url,
+    gboolean include_children, gfal_cred_match_func_t callback, void *user_data)
 {
-    callback_data data = {callback, user_data};
-    g_list_foreach(handle->cred_mapping, foreach_callback_wrapper, &data);
+    match_data data = {type, url, strlen(url), g_ptr_array_new(), g_ptr_array_new_with_free_func(node_free)};
+    gboolean stop = FALSE;
+    guint i;
+
+    // Collect copies of the matches under the lock, call back without it
+    lock_read(handle);
+    if (handle->cred_mapping) {
+        gboolean exact;
+        gfal_cred_trie_t *end = trie_walk(handle->cred_mapping, url, collect_ancestor, &data, &exact);
+
+        // Longer prefixes first, as in the descending order of gfal2_cred_foreach
+        if (include_children && end != NULL) {
+            if (exact) {
+                // The credentials of end itself are already among the ancestors
+                for (i = end->children->len; i > 0; --i) {
+                    trie_foreach(g_ptr_array_index(end->children, i - 1), match_child, &data);
+                }
+            }
+            else {
+                trie_foreach(end, match_child, &data);
+            }
+        }
+
+        for (i = data.ancestors->len; i > 0; --i) {
+            gfal2_cred_node_t *node = g_ptr_array_index(data.ancestors, i - 1);
+            collect_node(node->url_prefix, node->cred, data.matches);
+        }
+    }
+    unlock_read(handle);
+    g_ptr_array_free(data.ancestors, TRUE);
+
+    for (i = 0; i < data.matches->len && !stop; ++i) {
+        gfal2_cred_node_t *node = g_ptr_array_index(data.matches, i);
+        stop = callback(node->url_prefix, node->cred, user_data);
+    }
+    g_ptr_array_free(data.matches, TRUE);
 }
@@ -56,6 +56,12 @@ typedef struct {
  */
 typedef void (*gfal_cred_func_t)(const char *url_prefix, const gfal2_cred_t *cred, void *user_data);
 
+/**
+ * Callback type for gfal2_cred_foreach_match
+ * @return TRUE to stop the iteration
+ */
+typedef gboolean (*gfal_cred_match_func_t)(const char *url_prefix, const gfal2_cred_t *cred, void *user_data);
+
 /**
  * Create a new gfal2_cred_t
  * @return An initialized gfal2_cred_t
@@ -131,6 +137,21 @@ int gfal2_cred_copy(gfal2_context_t dest, const gfal2_context_t src, GError **er
  */
 void gfal2_cred_foreach(gfal2_context_t handle, gfal_cred_func_t callback, void *user_data);
 
+/**
+ * Iterate over the credentials of a type whose prefix matches a directory of url,
+ * best match first
+ * @param handle            The gfal2 context
+ * @param type              Credential type
+ * @param url               Full URL
+ * @param include_children  If TRUE, credentials whose prefix is a path below url are visited too, first
+ * @param callback          Callback for each item, returning TRUE to stop
+ * @param user_data         To be passed to the callback
+ * @note                    url_prefix and cred are borrowed, and only valid during the callback,
+ *                          which must not modify the credentials of the context
+ */
+void gfal2_cred_foreach_match(gfal2_context_t handle, const char *type, const char *url,
+    gboolean include_children, gfal_cred_match_func_t callback, void *user_data);
+
 #ifdef __cplusplus
 }
 #endif
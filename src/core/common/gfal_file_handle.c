@@ -20,6 +20,7 @@
 
 #include "gfal_file_handle.h"
 #include "gfal_file_handler_container.h"
+#include "gfal_read_cache_internal.h"
 
 
 gfal_file_handle gfal_file_handle_new(const char* module_name, gpointer fdesc)
@@ -31,6 +32,7 @@ gfal_file_handle gfal_file_handle_new(const char* module_name, gpointer fdesc)
     f->fdesc = fdesc;
     f->ext_data = NULL;
     f->path = NULL;
+    f->cache = NULL;
     return f;
 }
 
@@ -88,6 +90,7 @@ void gfal_file_handle_delete(gfal_file_handle fh)
 {
     if (fh) {
         g_mutex_free(fh->lock);
+        gfal_read_cache_handle_free(fh->cache);
         g_free(fh->path);
         g_free(fh);
     }
@@ -46,6 +46,8 @@ struct _gfal_file_handle {
 	gpointer ext_data;
 	gpointer fdesc;
     gchar* path;
+    // Set by gfal2_open when the file is read through the read cache
+    struct _gfal_read_cache_handle* cache;
 };
 
 
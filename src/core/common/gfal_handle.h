@@ -35,10 +35,21 @@ extern "C"
 #endif
 
 
+typedef struct _gfal_cred_trie gfal_cred_trie_t;
+
+
 struct _gfal_plugin_opts {
     gfal_plugin_interface plugin_list[MAX_PLUGIN_LIST];
     GList* sorted_plugin;
     int plugin_number;
+    // lazy loading: plugins described by a manifest, not dlopen'ed yet
+    GMutex* mux_plugins;
+    GList* pending_plugins;
+    // lazy loads in progress, cond_plugins is signaled when one ends
+    volatile gint loading_plugins;
+    GCond* cond_plugins;
+    // previous sorted lists, kept alive for concurrent readers
+    GList* retired_sorted_plugins;
 };
 typedef struct _gfal_plugin_opts gfal_plugin_opts;
 
@@ -50,14 +61,26 @@ struct gfal_handle_ {
 	//struct for the file descriptors
 	gfal_file_handle_container fdescs;
 	GKeyFile *config;
+    // typed snapshot of config, rebuilt when config_generation changes
+    // Getters do not lock, mux_config serializes the changes and the rebuilds
+    // Readers count themselves in config_readers[config_epoch & 1] while they use the snapshot
+    volatile gint config_generation;
+    GMutex* mux_config;
+    gpointer volatile config_snapshot;
+    volatile gint config_epoch;
+    volatile gint config_readers[2];
     // cancel logic
     volatile gint running_ops;
     gboolean cancel;
     GMutex* mux_cancel;
     GHookList cancel_hooks;
 
-	// Credential mapping
-    GList *cred_mapping;
+	// Credential mapping, indexed by url prefix
+    gfal_cred_trie_t *cred_mapping;
+    GStaticRWLock cred_lock;
+
+    // operation statistics, see gfal_stats.c
+    struct _gfal_stats *stats;
 
     // client information
     char* agent_name;
@@ -31,6 +31,8 @@
 #include "gfal_constants.h"
 #include "gfal_error.h"
 #include "gfal_file_handler_container.h"
+#include "gfal_stats_internal.h"
+#include "gfal_read_cache_internal.h"
 #include <future/glib.h>
 
 #ifndef GFAL_PLUGIN_DIR_DEFAULT
@@ -80,31 +82,29 @@ gboolean gfal_plugin_checker_safe(gfal_plugin_interface* cata_list,
 }
 
 //
-// Resolve entry point in a plugin and add it to the current plugin list
+// Resolve the entry point of a plugin and run its constructor into ifce
+// Nothing is published, so this runs without holding mux_plugins
 //
 static int gfal_module_init(gfal2_context_t handle, void* dlhandle,
-        const char* module_name, GError** err)
+        const char* module_name, gfal_plugin_interface* ifce, GError** err)
 {
     GError* tmp_err = NULL;
-    static gfal_plugin_interface (*constructor)(gfal2_context_t, GError**);
-    int* n = &handle->plugin_opt.plugin_number;
+    gfal_plugin_interface (*constructor)(gfal2_context_t, GError**);
     int res = -1;
+
     constructor = (gfal_plugin_interface (*)(gfal2_context_t, GError**)) dlsym(dlhandle, GFAL_PLUGIN_INIT_SYM);
     if (constructor == NULL) {
         g_set_error(&tmp_err, gfal2_get_plugins_quark(), EINVAL,
                 "No symbol %s found in the plugin %s, failure",
                 GFAL_PLUGIN_INIT_SYM, module_name);
-        *n = 0;
     }
     else {
-        handle->plugin_opt.plugin_list[*n] = constructor(handle, &tmp_err);
-        handle->plugin_opt.plugin_list[*n].gfal_data = dlhandle;
+        *ifce = constructor(handle, &tmp_err);
+        ifce->gfal_data = dlhandle;
         if (tmp_err) {
             g_prefix_error(&tmp_err, "Unable to load plugin %s : ", module_name);
-            *n = 0;
         }
         else {
-            *n += 1;
             gfal2_log(G_LOG_LEVEL_MESSAGE, "[gfal_module_load] plugin %s loaded with success ", module_name);
             res = 0;
         }
@@ -112,6 +112,39 @@ static int gfal_module_init(gfal2_context_t handle, void* dlhandle,
     G_RETURN_ERR(res, tmp_err, err);
 }
 
+//
+// Add a plugin to the current plugin list, mux_plugins must be held
+// The new slot is filled before plugin_number is published, so concurrent
+// readers never see a partially initialized plugin
+//
+static int gfal_plugin_add(gfal2_context_t handle, const gfal_plugin_interface* ifce, GError** err)
+{
+    const int n = handle->plugin_opt.plugin_number;
+    if (n >= MAX_PLUGIN_LIST) {
+        gfal2_set_error(err, gfal2_get_plugins_quark(), ENOMEM,
+                __func__, "Not enough space to allocate a new plugin");
+        return -1;
+    }
+    handle->plugin_opt.plugin_list[n] = *ifce;
+    g_atomic_int_set(&handle->plugin_opt.plugin_number, n + 1);
+    return 0;
+}
+
+// Plugin described by a manifest, waiting to be loaded
+typedef struct _gfal_plugin_manifest {
+    char* path;
+    char** schemes;
+} gfal_plugin_manifest;
+
+
+static void gfal_plugin_manifest_free(gpointer data)
+{
+    gfal_plugin_manifest* manifest = (gfal_plugin_manifest*) data;
+    g_free(manifest->path);
+    g_strfreev(manifest->schemes);
+    g_free(manifest);
+}
+
 // unload each loaded plugin
 int gfal_plugins_delete(gfal2_context_t handle, GError** err)
 {
@@ -127,6 +160,8 @@ int gfal_plugins_delete(gfal2_context_t handle, GError** err)
 
         handle->plugin_opt.plugin_number = 0;
     }
+    g_list_free_full(handle->plugin_opt.pending_plugins, gfal_plugin_manifest_free);
+    handle->plugin_opt.pending_plugins = NULL;
     return 0;
 }
 
@@ -139,6 +174,8 @@ gfal_plugin_interface* gfal_plugin_map_file_handle(gfal2_context_t handle, gfal_
     gfal_plugin_interface* cata_list = NULL;
     int n = gfal_plugins_instance(handle, &tmp_err);
     if (n > 0) {
+        // a file handle always comes from an already loaded plugin
+        n = g_atomic_int_get(&handle->plugin_opt.plugin_number);
         cata_list = handle->plugin_opt.plugin_list;
         for (i = 0; i < n; ++i) {
             if (strncmp(cata_list[i].getName(), fh->module_name, GFAL_MODULE_NAME_SIZE) == 0)
@@ -149,9 +186,8 @@ gfal_plugin_interface* gfal_plugin_map_file_handle(gfal2_context_t handle, gfal_
     else {
         g_set_error(&tmp_err, gfal2_get_plugins_quark(), EINVAL, "No gfal_module loaded");
     }
-    if (tmp_err)
-        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
-    return cata_list;
+    gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+    return NULL;
 }
 
 // external function to get the list of the plugins loaded
@@ -160,7 +196,8 @@ char** gfal_plugins_get_list(gfal2_context_t handle, GError** err)
     GError* tmp_err = NULL;
     char** resu = NULL;
     int n = gfal_plugins_instance(handle, &tmp_err);
-    if (n > 0) {
+    if (n > 0 && gfal_plugins_load_all(handle, &tmp_err) >= 0) {
+        n = g_atomic_int_get(&handle->plugin_opt.plugin_number);
         resu = g_new0(char*, n + 1);
         int i;
         gfal_plugin_interface* cata_list = handle->plugin_opt.plugin_list;
@@ -173,6 +210,21 @@ char** gfal_plugins_get_list(gfal2_context_t handle, GError** err)
     return resu;
 }
 
+
+static gfal_plugin_interface* gfal_search_loaded_plugin_with_name(gfal2_context_t handle,
+        const char* name)
+{
+    const int n = g_atomic_int_get(&handle->plugin_opt.plugin_number);
+    int i;
+    gfal_plugin_interface* cata_list = handle->plugin_opt.plugin_list;
+    for (i = 0; i < n; ++i, ++cata_list) {
+        const char* plugin_name = cata_list->getName();
+        if (plugin_name != NULL && strcmp(plugin_name, name) == 0)
+            return cata_list;
+    }
+    return NULL;
+}
+
 // external function to return a gfal_plugin_interface from a given plugin name
 gfal_plugin_interface* gfal_search_plugin_with_name(gfal2_context_t handle,
         const char* name, GError** err)
@@ -182,16 +234,11 @@ gfal_plugin_interface* gfal_search_plugin_with_name(gfal2_context_t handle,
     gfal_plugin_interface* resu = NULL;
     int n = gfal_plugins_instance(handle, &tmp_err);
     if (n > 0) {
-        int i;
-        gfal_plugin_interface* cata_list = handle->plugin_opt.plugin_list;
-        for (i = 0; i < n; ++i, ++cata_list) {
-            const char* plugin_name = cata_list->getName();
-            if (plugin_name != NULL && strcmp(plugin_name, name) == 0) {
-                resu = cata_list;
-                break;
-            }
-        }
-        if (resu == NULL)
+        resu = gfal_search_loaded_plugin_with_name(handle, name);
+        // plugin names are only known once loaded
+        if (resu == NULL && gfal_plugins_load_all(handle, &tmp_err) > 0)
+            resu = gfal_search_loaded_plugin_with_name(handle, name);
+        if (resu == NULL && tmp_err == NULL)
             g_set_error(&tmp_err, gfal2_get_plugins_quark(), ENOENT,
                     " No plugin loaded with this name %s", name);
     }
@@ -201,8 +248,10 @@ gfal_plugin_interface* gfal_search_plugin_with_name(gfal2_context_t handle,
     return resu;
 }
 
-//  load the gfal_plugins in the listed library
-static int gfal_module_load(gfal2_context_t handle, char* module_name, GError** err)
+//  load the gfal_plugins in the listed library into ifce
+//  return 1 if loaded, 0 if the library could not be opened, -1 on error
+static int gfal_module_load(gfal2_context_t handle, const char* module_name,
+        gfal_plugin_interface* ifce, GError** err)
 {
     void* dlhandle = dlopen(module_name, RTLD_NOW);
     GError * tmp_err = NULL;
@@ -211,16 +260,60 @@ static int gfal_module_load(gfal2_context_t handle, char* module_name, GError**
         gfal2_log(G_LOG_LEVEL_WARNING, "Unable to open the %s plugin specified in the plugin directory: %s",
             module_name, dlerror());
     }
-    else {
-        res = gfal_module_init(handle, dlhandle, module_name, &tmp_err);
+    else if (gfal_module_init(handle, dlhandle, module_name, ifce, &tmp_err) == 0) {
+        res = 1;
     }
     if (tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        res = -1;
     }
     return res;
 }
 
 
+//
+// Read the manifest shipped next to a plugin library, if any
+// libgfal_plugin_xyz.so -> libgfal_plugin_xyz.manifest
+//
+static gfal_plugin_manifest* gfal_plugin_manifest_load(const char* module_name)
+{
+    const char* suffix = strstr(module_name, G_MODULE_SUFFIX);
+    if (suffix == NULL)
+        return NULL;
+
+    char* manifest_path = g_strdup_printf("%.*s%s", (int)(suffix - module_name), module_name,
+            GFAL_PLUGIN_MANIFEST_SUFFIX);
+
+    gfal_plugin_manifest* manifest = NULL;
+    GError* tmp_err = NULL;
+    GKeyFile* key_file = g_key_file_new();
+
+    if (g_file_test(manifest_path, G_FILE_TEST_IS_REGULAR) &&
+        g_key_file_load_from_file(key_file, manifest_path, G_KEY_FILE_NONE, &tmp_err)) {
+        gsize n_schemes = 0;
+        char** schemes = g_key_file_get_string_list(key_file, "plugin", "schemes", &n_schemes, &tmp_err);
+        if (schemes != NULL && n_schemes > 0) {
+            manifest = g_new0(gfal_plugin_manifest, 1);
+            manifest->path = g_strdup(module_name);
+            manifest->schemes = schemes;
+        }
+        else {
+            g_strfreev(schemes);
+        }
+    }
+
+    if (tmp_err) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Ignoring invalid plugin manifest %s: %s",
+                manifest_path, tmp_err->message);
+        g_error_free(tmp_err);
+    }
+
+    g_key_file_free(key_file);
+    g_free(manifest_path);
+    return manifest;
+}
+
+
 /*
  * Provide a list of the gfal2 plugins path
  * Return NULL terminated table of plugins
@@ -253,7 +346,7 @@ char ** gfal_list_directory_plugins(const char * dir, GError ** err)
                 g_string_append(strbuff, d_name);
                 *p_res = g_string_free(strbuff, FALSE);
             }
-            else {
+            else if (!g_str_has_suffix(d_name, GFAL_PLUGIN_MANIFEST_SUFFIX)) {
                 gfal2_log(G_LOG_LEVEL_DEBUG,
                         " [gfal_list_directory_plugins] WARNING : File that is not a plugin in the plugin directory %s%s%s ",
                         dir, G_DIR_SEPARATOR_S, d_name);
@@ -302,13 +395,31 @@ int gfal_modules_resolve(gfal2_context_t handle, GError** err)
     GError* tmp_err = NULL;
     int res = -1;
     char** tab_args;
+    const gboolean lazy = gfal2_get_opt_boolean_with_default(handle, CORE_CONFIG_GROUP,
+            "LAZY_PLUGIN_LOADING", FALSE);
 
     if ((tab_args = gfal_localize_plugins(&tmp_err)) != NULL) {
         char** p = tab_args;
         while (*p != NULL) {
             if (**p == '\0')
                 break;
-            if (gfal_module_load(handle, *p, &tmp_err) != 0) {
+            gfal_plugin_manifest* manifest = NULL;
+            if (lazy && (manifest = gfal_plugin_manifest_load(*p)) != NULL) {
+                handle->plugin_opt.pending_plugins = g_list_append(
+                        handle->plugin_opt.pending_plugins, manifest);
+                gfal2_log(G_LOG_LEVEL_DEBUG, " gfal_plugin deferred until first use : %s", *p);
+                res = 0;
+                p++;
+                continue;
+            }
+            gfal_plugin_interface ifce;
+            int loaded = gfal_module_load(handle, *p, &ifce, &tmp_err);
+            if (loaded > 0) {
+                g_mutex_lock(handle->plugin_opt.mux_plugins);
+                gfal_plugin_add(handle, &ifce, &tmp_err);
+                g_mutex_unlock(handle->plugin_opt.mux_plugins);
+            }
+            if (tmp_err) {
                 res = -1;
                 break;
             }
@@ -336,28 +447,32 @@ gint gfal_plugin_compare(gconstpointer a, gconstpointer b)
 
 //
 // Sort plugins by priority
+// The new list replaces the previous one atomically; the previous one is kept
+// until the context is freed, since another thread may still be iterating it
 //
 int gfal_plugins_sort(gfal2_context_t handle, GError ** err)
 {
-    if (handle->plugin_opt.sorted_plugin) {
-        g_list_free(handle->plugin_opt.sorted_plugin);
-        handle->plugin_opt.sorted_plugin = NULL;
-    }
+    GList* sorted = NULL;
+    GList* previous = handle->plugin_opt.sorted_plugin;
+    const int plugin_number = handle->plugin_opt.plugin_number;
 
     int i;
-    for (i = 0; i < handle->plugin_opt.plugin_number; ++i) {
-        handle->plugin_opt.sorted_plugin = g_list_append(
-                handle->plugin_opt.sorted_plugin,
-                &(handle->plugin_opt.plugin_list[i]));
+    for (i = 0; i < plugin_number; ++i) {
+        sorted = g_list_append(sorted, &(handle->plugin_opt.plugin_list[i]));
+    }
+    sorted = g_list_sort(sorted, &gfal_plugin_compare);
+
+    g_atomic_pointer_set(&handle->plugin_opt.sorted_plugin, sorted);
+    if (previous) {
+        handle->plugin_opt.retired_sorted_plugins = g_list_prepend(
+                handle->plugin_opt.retired_sorted_plugins, previous);
     }
-    handle->plugin_opt.sorted_plugin = g_list_sort(
-            handle->plugin_opt.sorted_plugin, &gfal_plugin_compare);
 
     if (gfal2_log_get_level() >= G_LOG_LEVEL_DEBUG) { // print plugin order
         GString* strbuff = g_string_new(" plugin priority order: ");
-        GList* l = handle->plugin_opt.sorted_plugin;
+        GList* l = sorted;
 
-        for (i = 0; i < handle->plugin_opt.plugin_number; ++i) {
+        for (i = 0; i < plugin_number; ++i) {
             strbuff = g_string_append(strbuff,
                     ((gfal_plugin_interface*) l->data)->getName());
             strbuff = g_string_append(strbuff, " -> ");
@@ -369,16 +484,25 @@ int gfal_plugins_sort(gfal2_context_t handle, GError ** err)
     return 0;
 }
 
+// Plugins described by a manifest and not published yet, loading included
+static int gfal_plugins_has_pending(gfal2_context_t handle)
+{
+    return g_atomic_pointer_get(&handle->plugin_opt.pending_plugins) != NULL ||
+           g_atomic_int_get(&handle->plugin_opt.loading_plugins) > 0;
+}
+
 //
 // Instantiate all plugins for use if it's not the case
-// return the number of plugins available
+// return the number of plugins loaded, plus one if some are still pending,
+// so a positive value means at least one plugin is available
 //
 int gfal_plugins_instance(gfal2_context_t handle, GError** err)
 {
     g_return_val_err_if_fail(handle, -1, err,
             "[gfal_plugins_instance]  invalid value of handle");
-    const int plugin_number = handle->plugin_opt.plugin_number;
-    if (plugin_number <= 0) {
+    const int plugin_number = g_atomic_int_get(&handle->plugin_opt.plugin_number);
+    const int has_pending = gfal_plugins_has_pending(handle);
+    if (plugin_number <= 0 && !has_pending) {
         GError* tmp_err = NULL;
         gfal_modules_resolve(handle, &tmp_err);
         if (tmp_err) {
@@ -392,9 +516,154 @@ int gfal_plugins_instance(gfal2_context_t handle, GError** err)
                 return -1;
             }
         }
-        return handle->plugin_opt.plugin_number;
+        return handle->plugin_opt.plugin_number + gfal_plugins_has_pending(handle);
+    }
+    return plugin_number + has_pending;
+}
+
+
+// Extract the scheme of an url, or an empty string for plain paths
+static void gfal_plugin_url_scheme(const char* url, char* buff, size_t s_buff)
+{
+    size_t i = 0;
+    buff[0] = '\0';
+    while (url[i] != '\0' && url[i] != ':' && i < s_buff - 1) {
+        if (!g_ascii_isalnum(url[i]) && url[i] != '+' && url[i] != '-' && url[i] != '.')
+            return;
+        ++i;
+    }
+    if (url[i] == ':') {
+        memcpy(buff, url, i);
+        buff[i] = '\0';
+    }
+}
+
+
+static gboolean gfal_plugin_manifest_match(const gfal_plugin_manifest* manifest, const char* scheme)
+{
+    char** s;
+    if (scheme == NULL)
+        return TRUE;
+    for (s = manifest->schemes; *s != NULL; ++s) {
+        if (g_ascii_strcasecmp(*s, scheme) == 0)
+            return TRUE;
     }
-    return plugin_number;
+    return FALSE;
+}
+
+// Lazy loads run by this thread, so it does not wait for itself when
+// a plugin constructor ends up looking for another plugin
+static __thread int gfal_plugins_loading_here = 0;
+
+//
+// Load the pending plugins that declare the given scheme, or all of them if scheme is NULL
+// The manifests are taken off the pending list under mux_plugins, but the plugins are
+// initialized without it, since their constructors may call back into the core.
+// A thread that finds nothing to take waits for the loads in progress instead,
+// as the plugin it needs may be one of them.
+// return the number of plugins loaded, -1 on error
+//
+static int gfal_plugins_load_pending(gfal2_context_t handle, const char* scheme, GError** err)
+{
+    GError* tmp_err = NULL;
+    GList* taken = NULL;
+    GList* item;
+    int n_loaded = 0;
+
+    if (!gfal_plugins_has_pending(handle))
+        return 0;
+
+    g_mutex_lock(handle->plugin_opt.mux_plugins);
+
+    GList* pending = handle->plugin_opt.pending_plugins;
+    item = pending;
+    while (item != NULL) {
+        GList* next = g_list_next(item);
+        if (gfal_plugin_manifest_match((gfal_plugin_manifest*) item->data, scheme)) {
+            pending = g_list_remove_link(pending, item);
+            taken = g_list_concat(taken, item);
+        }
+        item = next;
+    }
+    g_atomic_pointer_set(&handle->plugin_opt.pending_plugins, pending);
+
+    if (taken == NULL) {
+        while (g_atomic_int_get(&handle->plugin_opt.loading_plugins) > 0 && gfal_plugins_loading_here == 0)
+            g_cond_wait(handle->plugin_opt.cond_plugins, handle->plugin_opt.mux_plugins);
+        g_mutex_unlock(handle->plugin_opt.mux_plugins);
+        return 0;
+    }
+
+    g_atomic_int_inc(&handle->plugin_opt.loading_plugins);
+    g_mutex_unlock(handle->plugin_opt.mux_plugins);
+    ++gfal_plugins_loading_here;
+
+    for (item = taken; item != NULL && tmp_err == NULL; item = taken) {
+        gfal_plugin_manifest* manifest = (gfal_plugin_manifest*) item->data;
+        gfal_plugin_interface ifce;
+        taken = g_list_delete_link(taken, item);
+
+        gfal2_log(G_LOG_LEVEL_DEBUG, " lazy loading of gfal_plugin %s", manifest->path);
+        if (gfal_module_load(handle, manifest->path, &ifce, &tmp_err) > 0) {
+            g_mutex_lock(handle->plugin_opt.mux_plugins);
+            if (gfal_plugin_add(handle, &ifce, &tmp_err) == 0) {
+                gfal_plugins_sort(handle, NULL);
+                ++n_loaded;
+            }
+            g_mutex_unlock(handle->plugin_opt.mux_plugins);
+        }
+        gfal_plugin_manifest_free(manifest);
+    }
+
+    --gfal_plugins_loading_here;
+    g_mutex_lock(handle->plugin_opt.mux_plugins);
+    // Stopped by an error, what was not tried yet is still pending
+    if (taken != NULL) {
+        g_atomic_pointer_set(&handle->plugin_opt.pending_plugins,
+                g_list_concat(handle->plugin_opt.pending_plugins, taken));
+    }
+    g_atomic_int_add(&handle->plugin_opt.loading_plugins, -1);
+    g_cond_broadcast(handle->plugin_opt.cond_plugins);
+    g_mutex_unlock(handle->plugin_opt.mux_plugins);
+
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    return n_loaded;
+}
+
+
+int gfal_plugins_load_for_url(gfal2_context_t handle, const char* url, GError** err)
+{
+    char scheme[64];
+    if (!gfal_plugins_has_pending(handle))
+        return 0;
+    gfal_plugin_url_scheme(url, scheme, sizeof(scheme));
+    return gfal_plugins_load_pending(handle, scheme, err);
+}
+
+
+int gfal_plugins_load_all(gfal2_context_t handle, GError** err)
+{
+    return gfal_plugins_load_pending(handle, NULL, err);
+}
+
+
+static gfal_plugin_interface* gfal_find_loaded_plugin(gfal2_context_t handle, const char * url,
+        plugin_mode acc_mode, GError** err)
+{
+    GList * plugin_list = g_list_first(g_atomic_pointer_get(&handle->plugin_opt.sorted_plugin));
+    while (plugin_list != NULL) {
+        gfal_plugin_interface* plugin_ifce = plugin_list->data;
+        gboolean compatible = gfal_plugin_checker_safe(plugin_ifce, url, acc_mode, err);
+        if (*err)
+            break;
+        if (compatible)
+            return plugin_ifce;
+        plugin_list = g_list_next(plugin_list);
+    }
+    return NULL;
 }
 
 
@@ -402,19 +671,17 @@ gfal_plugin_interface* gfal_find_plugin(gfal2_context_t handle, const char * url
         plugin_mode acc_mode, GError** err)
 {
     GError* tmp_err = NULL;
-    gboolean compatible = FALSE;
+    gfal_plugin_interface* plugin_ifce = NULL;
     const int n_plugins = gfal_plugins_instance(handle, &tmp_err);
     if (n_plugins > 0) {
-        GList * plugin_list = g_list_first(handle->plugin_opt.sorted_plugin);
-        while (plugin_list != NULL) {
-            gfal_plugin_interface* plugin_ifce = plugin_list->data;
-            compatible = gfal_plugin_checker_safe(plugin_ifce, url, acc_mode, &tmp_err);
-            if (tmp_err)
-                break;
-            if (compatible)
-                return plugin_ifce;
-            plugin_list = g_list_next(plugin_list);
-        }
+        gfal_plugins_load_for_url(handle, url, &tmp_err);
+        if (tmp_err == NULL)
+            plugin_ifce = gfal_find_loaded_plugin(handle, url, acc_mode, &tmp_err);
+        // A plugin may accept urls beyond the schemes of its manifest
+        if (plugin_ifce == NULL && tmp_err == NULL && gfal_plugins_load_all(handle, &tmp_err) > 0)
+            plugin_ifce = gfal_find_loaded_plugin(handle, url, acc_mode, &tmp_err);
+        if (plugin_ifce != NULL)
+            return plugin_ifce;
     }
     if (tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
@@ -430,17 +697,13 @@ gfal_plugin_interface* gfal_find_plugin(gfal2_context_t handle, const char * url
 int gfal2_register_plugin(gfal2_context_t handle, const gfal_plugin_interface* ifce,
         GError** error)
 {
-    if (handle->plugin_opt.plugin_number >= MAX_PLUGIN_LIST) {
-        gfal2_set_error(error, gfal2_get_plugins_quark(), ENOMEM,
-                __func__, "Not enough space to allocate a new plugin");
-        return -1;
-    }
-
-    int i = handle->plugin_opt.plugin_number;
-    handle->plugin_opt.plugin_number++;
-    handle->plugin_opt.plugin_list[i] = *ifce;
-
-    return gfal_plugins_sort(handle, error);
+    int ret;
+    g_mutex_lock(handle->plugin_opt.mux_plugins);
+    ret = gfal_plugin_add(handle, ifce, error);
+    if (ret == 0)
+        ret = gfal_plugins_sort(handle, error);
+    g_mutex_unlock(handle->plugin_opt.mux_plugins);
+    return ret;
 }
 
 
@@ -454,12 +717,15 @@ int gfal_plugins_accessG(gfal2_context_t handle, const char* path, int mode,
     g_return_val_err_if_fail(handle && path, EINVAL, err, "[gfal_plugins_accessG] Invalid arguments");
     int res = -1;
     GError * tmp_err = NULL;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* p = gfal_find_plugin(handle, path,
             GFAL_PLUGIN_ACCESS, &tmp_err);
 
     if (p)
         res = p->accessG(gfal_get_plugin_handle(p), path, mode, &tmp_err);
 
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_ACCESS, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -470,12 +736,16 @@ int gfal_plugin_statG(gfal2_context_t handle, const char* path, struct stat* st,
     int res = -1;
     GError* tmp_err = NULL;
 
+    const gint64 stats_start = gfal_stats_start(handle);
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_STAT,
             &tmp_err);
 
     if (p)
         res = p->statG(gfal_get_plugin_handle(p), path, st, &tmp_err);
 
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_STAT, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -487,12 +757,16 @@ int gfal_plugin_lstatG(gfal2_context_t handle, const char* path, struct stat* st
     int res = -1;
     GError* tmp_err = NULL;
 
+    const gint64 stats_start = gfal_stats_start(handle);
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_LSTAT,
             &tmp_err);
 
     if (p)
         res = p->lstatG(gfal_get_plugin_handle(p), path, st, &tmp_err);
 
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_LSTAT, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -505,6 +779,8 @@ ssize_t gfal_plugin_readlinkG(gfal2_context_t handle, const char* path, char* bu
     GError* tmp_err = NULL;
     ssize_t resu = -1;
 
+    const gint64 stats_start = gfal_stats_start(handle);
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path,
             GFAL_PLUGIN_READLINK, &tmp_err);
 
@@ -512,6 +788,8 @@ ssize_t gfal_plugin_readlinkG(gfal2_context_t handle, const char* path, char* bu
         resu = p->readlinkG(gfal_get_plugin_handle(p), path, buff, buffsiz,
                 &tmp_err);
 
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_READLINK, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -524,11 +802,15 @@ int gfal_plugin_chmodG(gfal2_context_t handle, const char* path, mode_t mode, GE
     GError* tmp_err = NULL;
     int res = -1;
 
+    const gint64 stats_start = gfal_stats_start(handle);
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_CHMOD, &tmp_err);
 
     if (p)
         res = p->chmodG(gfal_get_plugin_handle(p), path, mode, &tmp_err);
 
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_CHMOD, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -541,6 +823,8 @@ int gfal_plugin_renameG(gfal2_context_t handle, const char* oldpath, const char*
     int res = -1;
     gfal_plugin_interface *src_p, *dst_p;
 
+    const gint64 stats_start = gfal_stats_start(handle);
+
     src_p = gfal_find_plugin(handle, oldpath, GFAL_PLUGIN_RENAME, &tmp_err);
     if (src_p) {
         dst_p = gfal_find_plugin(handle, newpath, GFAL_PLUGIN_RENAME, &tmp_err);
@@ -548,6 +832,8 @@ int gfal_plugin_renameG(gfal2_context_t handle, const char* oldpath, const char*
             res = dst_p->renameG(gfal_get_plugin_handle(dst_p), oldpath, newpath, &tmp_err);
     }
 
+    gfal_stats_record(handle, src_p ? src_p->getName() : NULL, GFAL_STATS_RENAME, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -559,6 +845,8 @@ int gfal_plugin_symlinkG(gfal2_context_t handle, const char* oldpath, const char
     int res = -1;
     gfal_plugin_interface *src_p, *dst_p;
 
+    const gint64 stats_start = gfal_stats_start(handle);
+
     src_p = gfal_find_plugin(handle, oldpath, GFAL_PLUGIN_SYMLINK, &tmp_err);
     if (src_p) {
         dst_p = gfal_find_plugin(handle, newpath, GFAL_PLUGIN_SYMLINK, &tmp_err);
@@ -566,6 +854,8 @@ int gfal_plugin_symlinkG(gfal2_context_t handle, const char* oldpath, const char
             res = dst_p->symlinkG(gfal_get_plugin_handle(dst_p), oldpath, newpath, &tmp_err);
     }
 
+    gfal_stats_record(handle, src_p ? src_p->getName() : NULL, GFAL_STATS_SYMLINK, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -576,6 +866,8 @@ int gfal_plugin_mkdirp(gfal2_context_t handle, const char* path, mode_t mode, gb
     GError* tmp_err = NULL;
     int res = -1;
 
+    const gint64 stats_start = gfal_stats_start(handle);
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_MKDIR, &tmp_err);
 
     if (p)
@@ -587,6 +879,8 @@ int gfal_plugin_mkdirp(gfal2_context_t handle, const char* path, mode_t mode, gb
         res = 0;
     }
 
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_MKDIR, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -596,11 +890,14 @@ int gfal_plugin_rmdirG(gfal2_context_t handle, const char* path, GError** err)
     g_return_val_err_if_fail(handle && path, -1, err, "[gfal_plugin_rmdirp] Invalid arguments in path or/and handle");
     GError* tmp_err = NULL;
     int res = -1;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_RMDIR, &tmp_err);
 
     if (p)
         res = p->rmdirG(gfal_get_plugin_handle(p), path, &tmp_err);
 
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_RMDIR, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -611,11 +908,15 @@ gfal_file_handle gfal_plugin_opendirG(gfal2_context_t handle, const char* name,
     GError* tmp_err = NULL;
     gfal_file_handle resu = NULL;
 
+    const gint64 stats_start = gfal_stats_start(handle);
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, name, GFAL_PLUGIN_OPENDIR, &tmp_err);
 
     if (p)
         resu = p->opendirG(gfal_get_plugin_handle(p), name, &tmp_err);
 
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_OPENDIR, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -625,9 +926,11 @@ int gfal_plugin_closedirG(gfal2_context_t handle, gfal_file_handle fh, GError**
     g_return_val_err_if_fail(handle && fh, -1, err, "[gfal_plugin_closedirG] Invalid args ");
     GError* tmp_err = NULL;
     int res = -1;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err)
         res = if_cata->closedirG(if_cata->plugin_data, fh, &tmp_err);
+    gfal_stats_record(handle, if_cata ? if_cata->getName() : NULL, GFAL_STATS_CLOSEDIR, stats_start, -1, tmp_err);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -638,11 +941,15 @@ gfal_file_handle gfal_plugin_openG(gfal2_context_t handle, const char * path, in
     gfal_file_handle resu = NULL;
     gfal2_log(G_LOG_LEVEL_DEBUG, " %s ->", __func__);
 
+    const gint64 stats_start = gfal_stats_start(handle);
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_OPEN, &tmp_err);
 
     if (p)
         resu = p->openG(gfal_get_plugin_handle(p), path, flag, mode, &tmp_err);
 
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_OPEN, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -655,10 +962,14 @@ int gfal_plugin_closeG(gfal2_context_t handle, gfal_file_handle fh, GError** err
 
     gfal2_log(G_LOG_LEVEL_DEBUG, " <- %s", __func__);
 
+    const gint64 stats_start = gfal_stats_start(handle);
+
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err)
         res = if_cata->closeG(if_cata->plugin_data, fh, &tmp_err);
 
+    gfal_stats_record(handle, if_cata ? if_cata->getName() : NULL, GFAL_STATS_CLOSE, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -668,10 +979,13 @@ struct dirent* gfal_plugin_readdirG(gfal2_context_t handle, gfal_file_handle fh,
     g_return_val_err_if_fail(handle && fh, NULL, err, "[gfal_plugin_readdirG] Invalid args ");
     GError* tmp_err = NULL;
     struct dirent* res = NULL;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err)
         res = if_cata->readdirG(if_cata->plugin_data, fh, &tmp_err);
 
+    gfal_stats_record(handle, if_cata ? if_cata->getName() : NULL, GFAL_STATS_READDIR, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -682,6 +996,7 @@ struct dirent* gfal_plugin_readdirppG(gfal2_context_t handle, gfal_file_handle f
     g_return_val_err_if_fail(handle && fh, NULL, err, "[gfal_plugin_readdirppG] Invalid args ");
     GError* tmp_err = NULL;
     struct dirent* res = NULL;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
 
     if (!tmp_err) {
@@ -690,6 +1005,8 @@ struct dirent* gfal_plugin_readdirppG(gfal2_context_t handle, gfal_file_handle f
             res = if_cata->readdirppG(if_cata->plugin_data, fh, st, &tmp_err);
     }
 
+    gfal_stats_record(handle, if_cata ? if_cata->getName() : NULL, GFAL_STATS_READDIRPP, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -699,6 +1016,8 @@ ssize_t gfal_plugin_getxattrG(gfal2_context_t handle, const char* path, const ch
     GError* tmp_err = NULL;
     ssize_t resu = -1;
 
+    const gint64 stats_start = gfal_stats_start(handle);
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_GETXATTR, &tmp_err);
 
     if (p)
@@ -719,6 +1038,8 @@ ssize_t gfal_plugin_getxattrG(gfal2_context_t handle, const char* path, const ch
         }
     }
 
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_GETXATTR, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -728,11 +1049,15 @@ ssize_t gfal_plugin_listxattrG(gfal2_context_t handle, const char* path, char* l
     GError* tmp_err = NULL;
     ssize_t resu = -1;
 
+    const gint64 stats_start = gfal_stats_start(handle);
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_LISTXATTR, &tmp_err);
 
     if (p)
         resu = p->listxattrG(gfal_get_plugin_handle(p), path, list, s_list, &tmp_err);
 
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_LISTXATTR, stats_start, -1, tmp_err);
+
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -742,25 +1067,16 @@ int gfal_plugin_setxattrG(gfal2_context_t handle, const char* path, const char*
     GError* tmp_err = NULL;
     int resu = -1;
 
+    const gint64 stats_start = gfal_stats_start(handle);
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_SETXATTR, &tmp_err);
 
     if (p)
         resu = p->setxattrG(gfal_get_plugin_handle(p), path, name, value, size, flags, &tmp_err);
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_SETXATTR, stats_start, -1, tmp_err);
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
-// Execute a read function on the appropriate plugin
-int gfal_plugin_readG(gfal2_context_t handle, gfal_file_handle fh, void* buff, size_t s_buff, GError** err)
-{
-    g_return_val_err_if_fail(handle && fh && buff && s_buff > 0, -1, err, "[gfal_plugin_readG] Invalid args ");
-    GError* tmp_err = NULL;
-    int res = -1;
-    gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
-    if (!tmp_err)
-        res = if_cata->readG(if_cata->plugin_data, fh, buff, s_buff, &tmp_err);
-    G_RETURN_ERR(res, tmp_err, err);
-}
-
 // Simulate a pread operation in case of non-parallels read support
 // this is slower than a normal pread/pwrite operation
 static ssize_t gfal_plugin_simulate_preadG(gfal2_context_t handle, gfal_plugin_interface* if_cata, gfal_file_handle fh, void* buff, size_t s_buff,
@@ -783,20 +1099,48 @@ static ssize_t gfal_plugin_simulate_preadG(gfal2_context_t handle, gfal_plugin_i
     G_RETURN_ERR(res, tmp_err, err);
 }
 
+// pread on the plugin, simulated if not supported
+static ssize_t gfal_plugin_fetchG(gfal2_context_t handle, gfal_plugin_interface* if_cata, gfal_file_handle fh, void* buff, size_t s_buff,
+        off_t offset, GError** err)
+{
+    if (if_cata->preadG)
+        return if_cata->preadG(if_cata->plugin_data, fh, buff, s_buff, offset, err);
+    return gfal_plugin_simulate_preadG(handle, if_cata, fh, buff, s_buff, offset, err);
+}
+
 // Execute a pread function on the appropriate plugin
 ssize_t gfal_plugin_preadG(gfal2_context_t handle, gfal_file_handle fh, void* buff, size_t s_buff, off_t offset, GError** err)
 {
     g_return_val_err_if_fail(handle && fh && buff, -1, err, "[gfal_plugin_preadG] Invalid args ");
     GError* tmp_err = NULL;
     ssize_t res = -1;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err) {
-        if (if_cata->preadG)
-            res = if_cata->preadG(if_cata->plugin_data, fh, buff, s_buff, offset, &tmp_err);
-        else {
-            res = gfal_plugin_simulate_preadG(handle, if_cata, fh, buff, s_buff, offset, &tmp_err);
-        }
+        if (fh->cache)
+            res = gfal_read_cache_pread(handle, if_cata, fh, gfal_plugin_fetchG, buff, s_buff, offset, &tmp_err);
+        else
+            res = gfal_plugin_fetchG(handle, if_cata, fh, buff, s_buff, offset, &tmp_err);
     }
+    gfal_stats_record(handle, if_cata ? if_cata->getName() : NULL, GFAL_STATS_PREAD, stats_start, res, tmp_err);
+    G_RETURN_ERR(res, tmp_err, err);
+}
+
+// Execute a read function on the appropriate plugin
+int gfal_plugin_readG(gfal2_context_t handle, gfal_file_handle fh, void* buff, size_t s_buff, GError** err)
+{
+    g_return_val_err_if_fail(handle && fh && buff && s_buff > 0, -1, err, "[gfal_plugin_readG] Invalid args ");
+    GError* tmp_err = NULL;
+    int res = -1;
+    const gint64 stats_start = gfal_stats_start(handle);
+    gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
+    if (!tmp_err) {
+        if (fh->cache)
+            res = gfal_read_cache_read(handle, if_cata, fh, gfal_plugin_fetchG, buff, s_buff, &tmp_err);
+        else
+            res = if_cata->readG(if_cata->plugin_data, fh, buff, s_buff, &tmp_err);
+    }
+    gfal_stats_record(handle, if_cata ? if_cata->getName() : NULL, GFAL_STATS_READ, stats_start, res, tmp_err);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -828,6 +1172,7 @@ ssize_t gfal_plugin_pwriteG(gfal2_context_t handle, gfal_file_handle fh, void* b
     g_return_val_err_if_fail(handle && fh && buff, -1, err, "[gfal_plugin_pwriteG] Invalid args ");
     GError* tmp_err = NULL;
     ssize_t res = -1;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err) {
         if (if_cata->pwriteG)
@@ -836,6 +1181,7 @@ ssize_t gfal_plugin_pwriteG(gfal2_context_t handle, gfal_file_handle fh, void* b
             res = gfal_plugin_simulate_pwriteG(handle, if_cata, fh, buff, s_buff, offset, &tmp_err);
         }
     }
+    gfal_stats_record(handle, if_cata ? if_cata->getName() : NULL, GFAL_STATS_PWRITE, stats_start, res, tmp_err);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -845,9 +1191,15 @@ int gfal_plugin_lseekG(gfal2_context_t handle, gfal_file_handle fh, off_t offset
     g_return_val_err_if_fail(handle && fh, -1, err, "[gfal_plugin_lseekG] Invalid args ");
     GError* tmp_err = NULL;
     int res = -1;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
-    if (!tmp_err)
-        res = if_cata->lseekG(if_cata->plugin_data, fh, offset, whence, &tmp_err);
+    if (!tmp_err) {
+        if (fh->cache)
+            res = gfal_read_cache_lseek(fh->cache, offset, whence, &tmp_err);
+        else
+            res = if_cata->lseekG(if_cata->plugin_data, fh, offset, whence, &tmp_err);
+    }
+    gfal_stats_record(handle, if_cata ? if_cata->getName() : NULL, GFAL_STATS_LSEEK, stats_start, -1, tmp_err);
     G_RETURN_ERR(res, tmp_err, err);
 
 }
@@ -858,9 +1210,11 @@ int gfal_plugin_writeG(gfal2_context_t handle, gfal_file_handle fh, void* buff,
     g_return_val_err_if_fail(handle && fh && buff && s_buff > 0, -1, err, "[gfal_plugin_writeG] Invalid args ");
     GError* tmp_err = NULL;
     int res = -1;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err)
         res = if_cata->writeG(if_cata->plugin_data, fh, buff, s_buff, &tmp_err);
+    gfal_stats_record(handle, if_cata ? if_cata->getName() : NULL, GFAL_STATS_WRITE, stats_start, res, tmp_err);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -869,10 +1223,12 @@ int gfal_plugin_unlinkG(gfal2_context_t handle, const char* path, GError** err)
 {
     GError* tmp_err = NULL;
     int resu = -1;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_UNLINK, &tmp_err);
 
     if (p)
         resu = p->unlinkG(gfal_get_plugin_handle(p), path, &tmp_err);
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_UNLINK, stats_start, -1, tmp_err);
     G_RETURN_ERR(resu, tmp_err, err);
 
 }
@@ -883,11 +1239,13 @@ int gfal_plugin_bring_onlineG(gfal2_context_t handle, const char* uri, time_t pi
 {
     GError* tmp_err = NULL;
     int resu = -1;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* p = gfal_find_plugin(handle, uri, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
     if (p)
         resu = p->bring_online(gfal_get_plugin_handle(p), uri, pintime, timeout, token, tsize,
                 async, &tmp_err);
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_BRING_ONLINE, stats_start, -1, tmp_err);
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -953,10 +1311,12 @@ int gfal_plugin_bring_online_pollG(gfal2_context_t handle, const char* uri, cons
 {
     GError* tmp_err = NULL;
     int resu = -1;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* p = gfal_find_plugin(handle, uri, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
     if (p)
         resu = p->bring_online_poll(gfal_get_plugin_handle(p), uri, token, &tmp_err);
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_BRING_ONLINE_POLL, stats_start, -1, tmp_err);
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -966,10 +1326,12 @@ int gfal_plugin_release_fileG(gfal2_context_t handle, const char* uri, const cha
 {
     GError* tmp_err = NULL;
     int resu = -1;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* p = gfal_find_plugin(handle, uri, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
     if (p)
         resu = p->release_file(gfal_get_plugin_handle(p), uri, token, &tmp_err);
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_RELEASE_FILE, stats_start, -1, tmp_err);
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -1050,10 +1412,23 @@ int gfal_plugin_release_file_listG(gfal2_context_t handle, int nbfiles, const ch
 }
 
 
+// First error of a bulk operation, for the statistics
+static const GError* gfal_stats_first_error(int nbfiles, GError** errors)
+{
+    int i;
+    for (i = 0; i < nbfiles; ++i) {
+        if (errors[i])
+            return errors[i];
+    }
+    return NULL;
+}
+
+
 int gfal_plugin_unlink_listG(gfal2_context_t handle, int nbfiles, const char* const* uris, GError ** errors)
 {
     GError* tmp_err = NULL;
     int resu = -1;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface* p = gfal_find_plugin(handle, *uris, GFAL_PLUGIN_UNLINK, &tmp_err);
 
     if (p) {
@@ -1078,6 +1453,76 @@ int gfal_plugin_unlink_listG(gfal2_context_t handle, int nbfiles, const char* co
         g_error_free(tmp_err);
     }
 
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_UNLINK_LIST, stats_start, -1,
+        resu < 0 ? gfal_stats_first_error(nbfiles, errors) : NULL);
+    return resu;
+}
+
+
+int gfal_plugin_stat_listG(gfal2_context_t handle, int nbfiles, const char* const* uris,
+        struct stat* buffers, GError ** errors)
+{
+    GError* tmp_err = NULL;
+    int resu = -1;
+    const gint64 stats_start = gfal_stats_start(handle);
+    gfal_plugin_interface* p = gfal_find_plugin(handle, *uris, GFAL_PLUGIN_STAT, &tmp_err);
+
+    if (p) {
+        plugin_handle plugin_data = gfal_get_plugin_handle(p);
+        if (p->stat_listG) {
+            resu = p->stat_listG(plugin_data, nbfiles, uris, buffers, errors);
+        }
+        // Fallback
+        else {
+            int i;
+            resu = 0;
+            for (i = 0; i < nbfiles; ++i) {
+                if (p->statG(plugin_data, uris[i], &(buffers[i]), &(errors[i])) < 0)
+                    resu = -1;
+            }
+        }
+    }
+    else {
+        int i;
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+    }
+
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_STAT_LIST, stats_start, -1,
+        resu < 0 ? gfal_stats_first_error(nbfiles, errors) : NULL);
+    return resu;
+}
+
+
+int gfal_plugin_getxattr_listG(gfal2_context_t handle, int nbfiles, const char* const* uris,
+        const char* name, char** values, size_t s_value, GError ** errors)
+{
+    GError* tmp_err = NULL;
+    int resu = -1;
+    gfal_plugin_interface* p = gfal_find_plugin(handle, *uris, GFAL_PLUGIN_GETXATTR, &tmp_err);
+
+    if (p && p->getxattr_listG) {
+        resu = p->getxattr_listG(gfal_get_plugin_handle(p), nbfiles, uris, name, values, s_value, errors);
+    }
+    // Fallback, which also covers the checksum emulation of gfal_plugin_getxattrG
+    else if (p) {
+        int i;
+        resu = 0;
+        for (i = 0; i < nbfiles; ++i) {
+            if (gfal_plugin_getxattrG(handle, uris[i], name, values[i], s_value, &(errors[i])) < 0)
+                resu = -1;
+        }
+    }
+    else {
+        int i;
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+    }
+
     return resu;
 }
 
@@ -68,6 +68,18 @@ char** gfal_plugins_get_list(gfal2_context_t, GError** err);
 
 int gfal_plugins_delete(gfal2_context_t, GError** err);
 
+/**
+ * Load the pending plugins whose manifest declares the scheme of url
+ * Return the number of plugins loaded, or -1 on error
+ */
+int gfal_plugins_load_for_url(gfal2_context_t handle, const char* url, GError** err);
+
+/**
+ * Load all the pending plugins
+ * Return the number of plugins loaded, or -1 on error
+ */
+int gfal_plugins_load_all(gfal2_context_t handle, GError** err);
+
 gboolean gfal_feature_is_supported(void *ptr, GQuark scope, const char *func_name, const char *surl, GError **err);
 
 /**
@@ -697,9 +697,39 @@ struct _gfal_plugin_interface {
                             gboolean write_access, unsigned validity, const char* const* activities,
                             char* buff, size_t s_buff, GError** err);
 
+    // BULK NAMESPACE API
+
+  /**
+   * OPTIONAL: stat nbfiles files at once
+   *
+   * @param plugin_data: internal plugin data
+   * @param nbfiles: number of files
+   * @param urls: the URLs to stat
+   * @param buffers: array of nbfiles stat structures to fill
+   * @param errors: preallocated array of nbfiles GError pointers, set for each file that failed
+   * @return 0 if all the files succeeded, -1 otherwise
+   */
+  int (*stat_listG)(plugin_handle plugin_data, int nbfiles, const char* const* urls,
+                    struct stat* buffers, GError** errors);
+
+  /**
+   * OPTIONAL: get the same extended attribute of nbfiles files at once
+   *
+   * @param plugin_data: internal plugin data
+   * @param nbfiles: number of files
+   * @param urls: the URLs to query
+   * @param name: name of the extended attribute
+   * @param values: array of nbfiles buffers, of s_value bytes each, for the values
+   * @param s_value: size of each buffer
+   * @param errors: preallocated array of nbfiles GError pointers, set for each file that failed
+   * @return 0 if all the files succeeded, -1 otherwise
+   */
+  int (*getxattr_listG)(plugin_handle plugin_data, int nbfiles, const char* const* urls,
+                        const char* name, char** values, size_t s_value, GError** errors);
+
       // reserved for future usage
 	 //! @cond
-     void* future[6];
+     void* future[4];
 	 //! @endcond
 };
 
@@ -773,6 +803,12 @@ int gfal_plugin_bring_online_poll_listG(gfal2_context_t handle, int nbfiles, con
 int gfal_plugin_release_file_listG(gfal2_context_t handle, int nbfiles, const char* const* uris,
                               const char* token, GError ** err);
 
+int gfal_plugin_stat_listG(gfal2_context_t handle, int nbfiles, const char* const* uris,
+                           struct stat* buffers, GError ** errors);
+
+int gfal_plugin_getxattr_listG(gfal2_context_t handle, int nbfiles, const char* const* uris,
+                               const char* name, char** values, size_t s_value, GError ** errors);
+
 int gfal_plugin_unlink_listG(gfal2_context_t handle, int nbfiles, const char* const* uris, GError ** errors);
 
 int gfal_plugin_abort_filesG(gfal2_context_t handle, int nbfiles, const char* const* uris, const char* token, GError ** err);
@@ -0,0 +1,528 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "gfal_common.h"
+#include "gfal_config.h"
+#include "gfal_error.h"
+#include "gfal_file_handler_container.h"
+#include "gfal_read_cache_internal.h"
+
+
+// The cache is a tree of block files, shared by all the processes of the user:
+//    <READ_CACHE_DIR>/<uid>/<key[0:2]>/<key>/<block index>
+// READ_CACHE_DIR may be shared between users, but <uid> must belong to the user and be
+// writable only by them, since whoever can write there can feed the user any data.
+// where key is the hash of the url, the size and the modification time of the file,
+// so a modified file gets a new entry, and the stale one ages out.
+// Blocks are written to a temporary file and renamed, so readers only ever see complete blocks.
+// Blocks are touched when read, and the least recently used are evicted under an flock of
+// <READ_CACHE_DIR>/.lock when the cache grows over READ_CACHE_MAX_SIZE.
+
+#define GFAL_READ_CACHE_DEFAULT_BLOCK_SIZE (1024 * 1024)
+#define GFAL_READ_CACHE_DEFAULT_MAX_SIZE_MB 10240
+
+// Do not update the modification time of blocks read more often than this, in seconds
+#define GFAL_READ_CACHE_TOUCH_DELAY 60
+
+// Temporary files older than this are left overs of dead processes, in seconds
+#define GFAL_READ_CACHE_STALE_TMP 3600
+
+
+struct _gfal_read_cache_handle {
+    gchar *cache_dir;
+    gchar *entry_dir;
+    gint64 size;
+    gint64 block_size;
+    gint64 max_size;
+    off_t position;
+
+    // Last block read, kept open for sequential reads
+    GMutex *lock;
+    int block_fd;
+    gint64 block_index;
+};
+
+
+typedef struct {
+    gchar *path;
+    time_t mtime;
+    gint64 size;
+} gfal_read_cache_block_t;
+
+
+// Bytes written by this process since the last eviction pass, -1 before the first one
+static GStaticMutex gfal_read_cache_evict_lock = G_STATIC_MUTEX_INIT;
+static gint64 gfal_read_cache_written = -1;
+
+
+static void gfal_read_cache_scan_entry(const gchar *entry_dir, GArray *blocks, gint64 *total, time_t now)
+{
+    GDir *dir = g_dir_open(entry_dir, 0, NULL);
+    if (!dir)
+        return;
+
+    const gchar *name;
+    while ((name = g_dir_read_name(dir)) != NULL) {
+        gchar *path = g_build_filename(entry_dir, name, NULL);
+        struct stat st;
+        if (stat(path, &st) < 0 || !S_ISREG(st.st_mode)) {
+            g_free(path);
+            continue;
+        }
+        if (name[0] == '.') {
+            if (now - st.st_mtime > GFAL_READ_CACHE_STALE_TMP)
+                unlink(path);
+            g_free(path);
+            continue;
+        }
+        gfal_read_cache_block_t block = {path, st.st_mtime, st.st_size};
+        g_array_append_val(blocks, block);
+        *total += st.st_size;
+    }
+    g_dir_close(dir);
+}
+
+
+static gint gfal_read_cache_block_cmp(gconstpointer a, gconstpointer b)
+{
+    const gfal_read_cache_block_t *ba = (const gfal_read_cache_block_t*)a;
+    const gfal_read_cache_block_t *bb = (const gfal_read_cache_block_t*)b;
+    if (ba->mtime < bb->mtime)
+        return -1;
+    return ba->mtime > bb->mtime;
+}
+
+
+// Remove the least recently used blocks until the cache is 10% under max_size.
+// Only one process evicts at a time, the others skip the pass.
+static void gfal_read_cache_evict(const gchar *cache_dir, gint64 max_size)
+{
+    gchar *lock_path = g_build_filename(cache_dir, ".lock", NULL);
+    int lock_fd = open(lock_path, O_RDWR | O_CREAT | O_NOFOLLOW, 0600);
+    g_free(lock_path);
+    if (lock_fd < 0)
+        return;
+    if (flock(lock_fd, LOCK_EX | LOCK_NB) < 0) {
+        close(lock_fd);
+        return;
+    }
+
+    GArray *blocks = g_array_new(FALSE, FALSE, sizeof(gfal_read_cache_block_t));
+    gint64 total = 0;
+    time_t now = time(NULL);
+    guint i;
+
+    GDir *top = g_dir_open(cache_dir, 0, NULL);
+    const gchar *prefix;
+    while (top && (prefix = g_dir_read_name(top)) != NULL) {
+        if (prefix[0] == '.')
+            continue;
+        gchar *prefix_dir = g_build_filename(cache_dir, prefix, NULL);
+        GDir *entries = g_dir_open(prefix_dir, 0, NULL);
+        const gchar *key;
+        while (entries && (key = g_dir_read_name(entries)) != NULL) {
+            gchar *entry_dir = g_build_filename(prefix_dir, key, NULL);
+            gfal_read_cache_scan_entry(entry_dir, blocks, &total, now);
+            g_free(entry_dir);
+        }
+        if (entries)
+            g_dir_close(entries);
+        g_free(prefix_dir);
+    }
+    if (top)
+        g_dir_close(top);
+
+    if (total > max_size) {
+        const gint64 target = max_size - max_size / 10;
+        gint64 freed = 0;
+        g_array_sort(blocks, gfal_read_cache_block_cmp);
+        for (i = 0; i < blocks->len && total - freed > target; ++i) {
+            gfal_read_cache_block_t *block = &g_array_index(blocks, gfal_read_cache_block_t, i);
+            if (unlink(block->path) == 0) {
+                freed += block->size;
+                // Fails while the entry still has blocks
+                gchar *entry_dir = g_path_get_dirname(block->path);
+                rmdir(entry_dir);
+                g_free(entry_dir);
+            }
+        }
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Read cache: evicted %lld bytes out of %lld",
+            (long long)freed, (long long)total);
+    }
+
+    for (i = 0; i < blocks->len; ++i)
+        g_free(g_array_index(blocks, gfal_read_cache_block_t, i).path);
+    g_array_free(blocks, TRUE);
+
+    flock(lock_fd, LOCK_UN);
+    close(lock_fd);
+}
+
+
+// Trigger an eviction pass on the first use, and then each time this process
+// has written 1/16th of the cache size
+static void gfal_read_cache_account(const gfal_read_cache_handle_t *cache, gint64 written)
+{
+    gboolean evict;
+
+    g_static_mutex_lock(&gfal_read_cache_evict_lock);
+    if (gfal_read_cache_written < 0) {
+        evict = TRUE;
+    }
+    else {
+        gfal_read_cache_written += written;
+        evict = (gfal_read_cache_written >= cache->max_size / 16);
+    }
+    if (evict)
+        gfal_read_cache_written = 0;
+    g_static_mutex_unlock(&gfal_read_cache_evict_lock);
+
+    if (evict)
+        gfal_read_cache_evict(cache->cache_dir, cache->max_size);
+}
+
+
+static gchar *gfal_read_cache_block_path(const gfal_read_cache_handle_t *cache, gint64 index)
+{
+    return g_strdup_printf("%s/%lld", cache->entry_dir, (long long)index);
+}
+
+
+// Return the directory of the user under base_dir, creating it if needed,
+// or NULL if it is not safe to use
+static gchar *gfal_read_cache_user_dir(const gchar *base_dir)
+{
+    struct stat st;
+    const uid_t uid = geteuid();
+
+    // Somebody else could replace the user directory in a shared directory without sticky bit
+    if (stat(base_dir, &st) < 0 || !S_ISDIR(st.st_mode)) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Read cache: disabled, %s is not a directory", base_dir);
+        return NULL;
+    }
+    if ((st.st_mode & (S_IWGRP | S_IWOTH)) && !(st.st_mode & S_ISVTX) && st.st_uid != uid) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Read cache: disabled, %s is writable by others without sticky bit",
+            base_dir);
+        return NULL;
+    }
+
+    gchar *user_dir = g_strdup_printf("%s/%u", base_dir, (unsigned) uid);
+    if (mkdir(user_dir, 0700) < 0 && errno != EEXIST) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Read cache: disabled, could not create %s: %s",
+            user_dir, strerror(errno));
+        g_free(user_dir);
+        return NULL;
+    }
+    // lstat, so a symlink planted by somebody else is refused
+    if (lstat(user_dir, &st) < 0 || !S_ISDIR(st.st_mode) || st.st_uid != uid ||
+        (st.st_mode & (S_IWGRP | S_IWOTH))) {
+        gfal2_log(G_LOG_LEVEL_WARNING,
+            "Read cache: disabled, %s must be a directory owned by uid %u, and not writable by others",
+            user_dir, (unsigned) uid);
+        g_free(user_dir);
+        return NULL;
+    }
+    return user_dir;
+}
+
+
+gfal_read_cache_handle_t *gfal_read_cache_open(gfal2_context_t context, const char *url, int flags)
+{
+    if ((flags & O_ACCMODE) != O_RDONLY)
+        return NULL;
+    // Local files do not need it
+    if (url[0] == '/' || g_str_has_prefix(url, "file:"))
+        return NULL;
+
+    gchar *base_dir = gfal2_get_opt_string_with_default(context, "CORE", "READ_CACHE_DIR", NULL);
+    if (base_dir == NULL || base_dir[0] == '\0') {
+        g_free(base_dir);
+        return NULL;
+    }
+    gchar *cache_dir = gfal_read_cache_user_dir(base_dir);
+    g_free(base_dir);
+    if (cache_dir == NULL)
+        return NULL;
+
+    // The cheap validation: a file modified since it was cached has a different key
+    GError *tmp_err = NULL;
+    struct stat st;
+    if (gfal_plugin_statG(context, url, &st, &tmp_err) < 0) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Read cache: not used for %s, stat failed: %s", url, tmp_err->message);
+        g_error_free(tmp_err);
+        g_free(cache_dir);
+        return NULL;
+    }
+    if (!S_ISREG(st.st_mode) || st.st_size <= 0 || st.st_mtime == 0) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Read cache: not used for %s, can not be validated", url);
+        g_free(cache_dir);
+        return NULL;
+    }
+
+    gint64 block_size = gfal2_get_opt_integer_with_default(context, "CORE", "READ_CACHE_BLOCK_SIZE",
+        GFAL_READ_CACHE_DEFAULT_BLOCK_SIZE);
+    if (block_size <= 0)
+        block_size = GFAL_READ_CACHE_DEFAULT_BLOCK_SIZE;
+    gint64 max_size_mb = gfal2_get_opt_integer_with_default(context, "CORE", "READ_CACHE_MAX_SIZE",
+        GFAL_READ_CACHE_DEFAULT_MAX_SIZE_MB);
+
+    // The block size is part of the key, since it defines the layout of the entry
+    gchar *id = g_strdup_printf("%s\n%lld\n%lld\n%lld", url, (long long)st.st_size,
+        (long long)st.st_mtime, (long long)block_size);
+    gchar *key = g_compute_checksum_for_string(G_CHECKSUM_SHA256, id, -1);
+    gchar prefix[3] = {key[0], key[1], '\0'};
+
+    gfal_read_cache_handle_t *cache = g_new0(gfal_read_cache_handle_t, 1);
+    cache->cache_dir = cache_dir;
+    cache->entry_dir = g_build_filename(cache_dir, prefix, key, NULL);
+    cache->size = st.st_size;
+    cache->block_size = block_size;
+    cache->max_size = max_size_mb * 1024 * 1024;
+    cache->lock = g_mutex_new();
+    cache->block_fd = -1;
+    cache->block_index = -1;
+
+    g_free(id);
+    g_free(key);
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Read cache: %s cached in %s", url, cache->entry_dir);
+
+    gfal_read_cache_account(cache, 0);
+    return cache;
+}
+
+
+void gfal_read_cache_handle_free(gfal_read_cache_handle_t *cache)
+{
+    if (cache == NULL)
+        return;
+    if (cache->block_fd >= 0)
+        close(cache->block_fd);
+    g_mutex_free(cache->lock);
+    g_free(cache->entry_dir);
+    g_free(cache->cache_dir);
+    g_free(cache);
+}
+
+
+// Read from a cached block. Returns -1 if the block is not in the cache.
+static ssize_t gfal_read_cache_read_block(gfal_read_cache_handle_t *cache, gint64 index, size_t block_len,
+    void *buff, size_t s_buff, off_t in_block)
+{
+    ssize_t ret = -1;
+
+    g_mutex_lock(cache->lock);
+    if (cache->block_index != index) {
+        if (cache->block_fd >= 0)
+            close(cache->block_fd);
+        cache->block_index = -1;
+
+        gchar *path = gfal_read_cache_block_path(cache, index);
+        cache->block_fd = open(path, O_RDONLY | O_NOFOLLOW);
+        if (cache->block_fd >= 0) {
+            struct stat st;
+            if (fstat(cache->block_fd, &st) < 0 || st.st_size != (off_t)block_len) {
+                gfal2_log(G_LOG_LEVEL_WARNING, "Read cache: dropping corrupted block %s", path);
+                unlink(path);
+                close(cache->block_fd);
+                cache->block_fd = -1;
+            }
+            else {
+                if (time(NULL) - st.st_mtime > GFAL_READ_CACHE_TOUCH_DELAY)
+                    futimens(cache->block_fd, NULL);
+                cache->block_index = index;
+            }
+        }
+        g_free(path);
+    }
+    if (cache->block_fd >= 0) {
+        ret = pread(cache->block_fd, buff, s_buff, in_block);
+        if (ret != (ssize_t)s_buff)
+            ret = -1;
+    }
+    g_mutex_unlock(cache->lock);
+
+    return ret;
+}
+
+
+// Best effort, a block that can not be stored is just not cached
+static void gfal_read_cache_store_block(gfal_read_cache_handle_t *cache, gint64 index,
+    const char *data, size_t len)
+{
+    if (g_mkdir_with_parents(cache->entry_dir, 0700) < 0) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Read cache: could not create %s: %s", cache->entry_dir, strerror(errno));
+        return;
+    }
+
+    gchar *path = gfal_read_cache_block_path(cache, index);
+    gchar *tmp_path = g_strdup_printf("%s/.%lld.%d.%p", cache->entry_dir, (long long)index,
+        (int)getpid(), data);
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_EXCL, 0600);
+    size_t written = 0;
+    while (fd >= 0 && written < len) {
+        ssize_t ret = write(fd, data + written, len - written);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            break;
+        written += ret;
+    }
+
+    if (fd < 0 || close(fd) < 0 || written != len || rename(tmp_path, path) < 0) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Read cache: could not store %s: %s", path, strerror(errno));
+        unlink(tmp_path);
+    }
+    else {
+        gfal_read_cache_account(cache, len);
+    }
+
+    g_free(tmp_path);
+    g_free(path);
+}
+
+
+// Fetch a whole block from the source, store it, and copy the requested part
+static ssize_t gfal_read_cache_fill_block(gfal2_context_t context, gfal_plugin_interface *ifce,
+    gfal_file_handle fh, gfal_read_cache_fetch_func fetch, gint64 index, size_t block_len,
+    void *buff, size_t s_buff, off_t in_block, GError **err)
+{
+    gfal_read_cache_handle_t *cache = fh->cache;
+    const off_t block_start = index * cache->block_size;
+    char *block = g_malloc(block_len);
+    size_t got = 0;
+
+    while (got < block_len) {
+        ssize_t ret = fetch(context, ifce, fh, block + got, block_len - got, block_start + got, err);
+        if (ret < 0) {
+            g_free(block);
+            return -1;
+        }
+        if (ret == 0)
+            break;
+        got += ret;
+    }
+
+    if (got == block_len) {
+        gfal_read_cache_store_block(cache, index, block, block_len);
+    }
+    else {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Read cache: %s is shorter than expected, not caching it",
+            gfal_file_handle_get_path(fh) ? gfal_file_handle_get_path(fh) : cache->entry_dir);
+    }
+
+    size_t done = 0;
+    if (got > (size_t)in_block)
+        done = MIN(s_buff, got - in_block);
+    memcpy(buff, block + in_block, done);
+    g_free(block);
+    return done;
+}
+
+
+ssize_t gfal_read_cache_pread(gfal2_context_t context, gfal_plugin_interface *ifce, gfal_file_handle fh,
+    gfal_read_cache_fetch_func fetch, void *buff, size_t s_buff, off_t offset, GError **err)
+{
+    gfal_read_cache_handle_t *cache = fh->cache;
+    size_t done = 0;
+
+    if (offset < 0) {
+        gfal2_set_error(err, gfal2_get_core_quark(), EINVAL, __func__, "Negative offset");
+        return -1;
+    }
+
+    while (done < s_buff && offset + (off_t)done < cache->size) {
+        const off_t pos = offset + done;
+        const gint64 index = pos / cache->block_size;
+        const off_t block_start = index * cache->block_size;
+        const size_t block_len = MIN(cache->block_size, cache->size - block_start);
+        const off_t in_block = pos - block_start;
+        const size_t chunk = MIN(s_buff - done, block_len - in_block);
+
+        ssize_t ret = gfal_read_cache_read_block(cache, index, block_len, (char*)buff + done, chunk, in_block);
+        if (ret < 0) {
+            GError *tmp_err = NULL;
+            ret = gfal_read_cache_fill_block(context, ifce, fh, fetch, index, block_len,
+                (char*)buff + done, chunk, in_block, &tmp_err);
+            if (ret < 0) {
+                // Return what we have, the error will show up again on the next call
+                if (done > 0) {
+                    g_error_free(tmp_err);
+                    break;
+                }
+                gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+                return -1;
+            }
+        }
+        done += ret;
+        if ((size_t)ret < chunk)
+            break;
+    }
+
+    return done;
+}
+
+
+ssize_t gfal_read_cache_read(gfal2_context_t context, gfal_plugin_interface *ifce, gfal_file_handle fh,
+    gfal_read_cache_fetch_func fetch, void *buff, size_t s_buff, GError **err)
+{
+    gfal_read_cache_handle_t *cache = fh->cache;
+    ssize_t ret = gfal_read_cache_pread(context, ifce, fh, fetch, buff, s_buff, cache->position, err);
+    if (ret > 0)
+        cache->position += ret;
+    return ret;
+}
+
+
+off_t gfal_read_cache_lseek(gfal_read_cache_handle_t *cache, off_t offset, int whence, GError **err)
+{
+    off_t base;
+    switch (whence) {
+        case SEEK_SET:
+            base = 0;
+            break;
+        case SEEK_CUR:
+            base = cache->position;
+            break;
+        case SEEK_END:
+            base = cache->size;
+            break;
+        default:
+            gfal2_set_error(err, gfal2_get_core_quark(), EINVAL, __func__, "Invalid whence %d", whence);
+            return -1;
+    }
+    if (base + offset < 0) {
+        gfal2_set_error(err, gfal2_get_core_quark(), EINVAL, __func__, "Negative offset");
+        return -1;
+    }
+    cache->position = base + offset;
+    return cache->position;
+}
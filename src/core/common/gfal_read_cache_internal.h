@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_READ_CACHE_INTERNAL_H_
+#define GFAL_READ_CACHE_INTERNAL_H_
+
+#include <glib.h>
+#include <sys/types.h>
+#include <common/gfal_common.h>
+#include <common/gfal_plugin_interface.h>
+
+typedef struct _gfal_read_cache_handle gfal_read_cache_handle_t;
+
+// Reads a range of the remote file, bypassing the cache
+typedef ssize_t (*gfal_read_cache_fetch_func)(gfal2_context_t context, gfal_plugin_interface *ifce,
+    gfal_file_handle fh, void *buff, size_t s_buff, off_t offset, GError **err);
+
+// Returns a cache handle for a file opened with flags, or NULL if the read cache
+// is disabled ([CORE] READ_CACHE_DIR) or does not apply to this file
+gfal_read_cache_handle_t *gfal_read_cache_open(gfal2_context_t context, const char *url, int flags);
+
+void gfal_read_cache_handle_free(gfal_read_cache_handle_t *cache);
+
+// pread through the cache of fh. Blocks missing from the cache are fetched with fetch
+ssize_t gfal_read_cache_pread(gfal2_context_t context, gfal_plugin_interface *ifce, gfal_file_handle fh,
+    gfal_read_cache_fetch_func fetch, void *buff, size_t s_buff, off_t offset, GError **err);
+
+// read through the cache of fh, from the position kept by the cache
+ssize_t gfal_read_cache_read(gfal2_context_t context, gfal_plugin_interface *ifce, gfal_file_handle fh,
+    gfal_read_cache_fetch_func fetch, void *buff, size_t s_buff, GError **err);
+
+// lseek on a cached file only moves the position kept by the cache
+off_t gfal_read_cache_lseek(gfal_read_cache_handle_t *cache, off_t offset, int whence, GError **err);
+
+#endif /* GFAL_READ_CACHE_INTERNAL_H_ */
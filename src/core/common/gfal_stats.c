@@ -0,0 +1,516 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <json.h>
+
+#include "gfal_common.h"
+#include "gfal_config.h"
+#include "gfal_error.h"
+#include "gfal_handle.h"
+#include "gfal_stats.h"
+#include "gfal_stats_internal.h"
+
+
+// Each thread writes to its own shard, so recording only takes an uncontended lock.
+// Threads beyond GFAL_STATS_SHARDS share shards.
+#define GFAL_STATS_SHARDS 16
+
+// Log-linear latency histogram, in nanoseconds: each power of two is split in
+// 2^GFAL_STATS_SUB_BITS buckets, up to 2^GFAL_STATS_MAX_EXPONENT ns (~18 minutes)
+#define GFAL_STATS_SUB_BITS 3
+#define GFAL_STATS_SUB_COUNT (1 << GFAL_STATS_SUB_BITS)
+#define GFAL_STATS_MAX_EXPONENT 40
+#define GFAL_STATS_BUCKETS ((GFAL_STATS_MAX_EXPONENT - GFAL_STATS_SUB_BITS + 2) * GFAL_STATS_SUB_COUNT)
+
+// Errors are counted per errno below this value, the rest go together in slot 0
+#define GFAL_STATS_MAX_ERRNO 134
+
+static const char *gfal_stats_op_names[GFAL_STATS_OP_COUNT] = {
+    "access", "stat", "lstat", "readlink", "chmod", "rename", "symlink", "mkdir", "rmdir", "unlink",
+    "opendir", "readdir", "readdirpp", "closedir",
+    "open", "read", "pread", "write", "pwrite", "lseek", "close",
+    "getxattr", "listxattr", "setxattr", "checksum",
+    "bring_online", "bring_online_poll", "release_file",
+    "stat_list", "unlink_list",
+    "copy", "copy_bulk"
+};
+
+typedef struct {
+    guint64 calls;
+    guint64 errors;
+    guint64 bytes;
+    guint64 latency_sum;
+    guint64 latency_max;
+    guint64 error_codes[GFAL_STATS_MAX_ERRNO];
+    guint64 histogram[GFAL_STATS_BUCKETS];
+} gfal_stats_cell;
+
+// One cell per operation, allocated on first use
+typedef struct {
+    gfal_stats_cell *cells[GFAL_STATS_OP_COUNT];
+} gfal_stats_plugin;
+
+typedef struct {
+    GMutex *lock;
+    // plugin name (not owned, compared by address) -> gfal_stats_plugin
+    GHashTable *plugins;
+} gfal_stats_shard;
+
+struct _gfal_stats {
+    gfal_stats_shard shards[GFAL_STATS_SHARDS];
+    // cached [CORE] STATS
+    volatile gint enabled;
+    volatile gint enabled_generation;
+};
+
+typedef struct {
+    gfal2_op_stats_t pub;
+    gfal_stats_cell cell;
+} gfal_stats_entry;
+
+struct _gfal2_stats {
+    GArray *entries;
+};
+
+static const char *gfal_stats_no_plugin = "none";
+
+static volatile gint gfal_stats_next_shard = 0;
+static __thread int gfal_stats_thread_shard = -1;
+
+
+static void gfal_stats_plugin_free(gpointer data)
+{
+    gfal_stats_plugin *plugin = data;
+    int i;
+    for (i = 0; i < GFAL_STATS_OP_COUNT; ++i)
+        g_free(plugin->cells[i]);
+    g_free(plugin);
+}
+
+
+gfal_stats_t *gfal_stats_new(void)
+{
+    gfal_stats_t *stats = g_new0(gfal_stats_t, 1);
+    int i;
+    for (i = 0; i < GFAL_STATS_SHARDS; ++i) {
+        stats->shards[i].lock = g_mutex_new();
+        stats->shards[i].plugins = g_hash_table_new_full(NULL, NULL, NULL, gfal_stats_plugin_free);
+    }
+    stats->enabled_generation = -1;
+    return stats;
+}
+
+
+void gfal_stats_free(gfal_stats_t *stats)
+{
+    int i;
+    if (!stats)
+        return;
+    for (i = 0; i < GFAL_STATS_SHARDS; ++i) {
+        g_hash_table_destroy(stats->shards[i].plugins);
+        g_mutex_free(stats->shards[i].lock);
+    }
+    g_free(stats);
+}
+
+
+static gint64 gfal_stats_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (gint64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+gint64 gfal_stats_start(gfal2_context_t context)
+{
+    gfal_stats_t *stats = context->stats;
+    const gint generation = gfal2_get_opt_generation(context);
+    if (g_atomic_int_get(&stats->enabled_generation) != generation) {
+        g_atomic_int_set(&stats->enabled,
+            gfal2_get_opt_boolean_with_default(context, CORE_CONFIG_GROUP, "STATS", TRUE));
+        g_atomic_int_set(&stats->enabled_generation, generation);
+    }
+    if (!g_atomic_int_get(&stats->enabled))
+        return 0;
+    return gfal_stats_now();
+}
+
+
+static int gfal_stats_bucket(guint64 value)
+{
+    if (value < GFAL_STATS_SUB_COUNT)
+        return value;
+    int exponent = g_bit_storage(value) - 1;
+    if (exponent > GFAL_STATS_MAX_EXPONENT)
+        return GFAL_STATS_BUCKETS - 1;
+    return (exponent - GFAL_STATS_SUB_BITS + 1) * GFAL_STATS_SUB_COUNT +
+        ((value >> (exponent - GFAL_STATS_SUB_BITS)) & (GFAL_STATS_SUB_COUNT - 1));
+}
+
+
+// Middle of the range of values that fall in the bucket
+static guint64 gfal_stats_bucket_value(int bucket)
+{
+    if (bucket < GFAL_STATS_SUB_COUNT)
+        return bucket;
+    int exponent = bucket / GFAL_STATS_SUB_COUNT + GFAL_STATS_SUB_BITS - 1;
+    int sub = bucket % GFAL_STATS_SUB_COUNT;
+    guint64 width = G_GUINT64_CONSTANT(1) << (exponent - GFAL_STATS_SUB_BITS);
+    return (GFAL_STATS_SUB_COUNT + sub) * width + width / 2;
+}
+
+
+void gfal_stats_record(gfal2_context_t context, const char *plugin_name, gfal_stats_op op,
+    gint64 start, gint64 bytes, const GError *error)
+{
+    if (start == 0)
+        return;
+
+    const gint64 elapsed = gfal_stats_now() - start;
+    gfal_stats_t *stats = context->stats;
+
+    if (gfal_stats_thread_shard < 0)
+        gfal_stats_thread_shard = g_atomic_int_add(&gfal_stats_next_shard, 1) % GFAL_STATS_SHARDS;
+    gfal_stats_shard *shard = &stats->shards[gfal_stats_thread_shard];
+
+    if (!plugin_name)
+        plugin_name = gfal_stats_no_plugin;
+
+    g_mutex_lock(shard->lock);
+
+    gfal_stats_plugin *plugin = g_hash_table_lookup(shard->plugins, plugin_name);
+    if (!plugin) {
+        plugin = g_new0(gfal_stats_plugin, 1);
+        g_hash_table_insert(shard->plugins, (gpointer)plugin_name, plugin);
+    }
+    gfal_stats_cell *cell = plugin->cells[op];
+    if (!cell) {
+        cell = plugin->cells[op] = g_new0(gfal_stats_cell, 1);
+    }
+
+    cell->calls += 1;
+    if (bytes > 0)
+        cell->bytes += bytes;
+    if (error) {
+        cell->errors += 1;
+        if (error->code > 0 && error->code < GFAL_STATS_MAX_ERRNO)
+            cell->error_codes[error->code] += 1;
+        else
+            cell->error_codes[0] += 1;
+    }
+    if (elapsed > 0) {
+        cell->latency_sum += elapsed;
+        if ((guint64)elapsed > cell->latency_max)
+            cell->latency_max = elapsed;
+    }
+    cell->histogram[gfal_stats_bucket(elapsed > 0 ? elapsed : 0)] += 1;
+
+    g_mutex_unlock(shard->lock);
+}
+
+
+static void gfal_stats_cell_merge(gfal_stats_cell *dst, const gfal_stats_cell *src)
+{
+    int i;
+    dst->calls += src->calls;
+    dst->errors += src->errors;
+    dst->bytes += src->bytes;
+    dst->latency_sum += src->latency_sum;
+    dst->latency_max = MAX(dst->latency_max, src->latency_max);
+    for (i = 0; i < GFAL_STATS_MAX_ERRNO; ++i)
+        dst->error_codes[i] += src->error_codes[i];
+    for (i = 0; i < GFAL_STATS_BUCKETS; ++i)
+        dst->histogram[i] += src->histogram[i];
+}
+
+
+static gint gfal_stats_entry_compare(gconstpointer a, gconstpointer b)
+{
+    const gfal_stats_entry *ea = a, *eb = b;
+    int ret = strcmp(ea->pub.plugin, eb->pub.plugin);
+    if (ret == 0)
+        ret = strcmp(ea->pub.operation, eb->pub.operation);
+    return ret;
+}
+
+
+gfal2_stats_t gfal2_get_stats(gfal2_context_t context, GError **error)
+{
+    g_return_val_err_if_fail(context != NULL, NULL, error, "[gfal2_get_stats] Invalid context");
+
+    gfal_stats_t *stats = context->stats;
+    gfal2_stats_t snapshot = g_new0(struct _gfal2_stats, 1);
+    snapshot->entries = g_array_new(FALSE, TRUE, sizeof(gfal_stats_entry));
+
+    // plugin name -> index of its first entry, per operation
+    GHashTable *index = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+    GHashTableIter iter;
+    gpointer key, value;
+    int i, op;
+
+    for (i = 0; i < GFAL_STATS_SHARDS; ++i) {
+        gfal_stats_shard *shard = &stats->shards[i];
+        g_mutex_lock(shard->lock);
+
+        g_hash_table_iter_init(&iter, shard->plugins);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            gfal_stats_plugin *plugin = value;
+            gint *positions = g_hash_table_lookup(index, key);
+            if (!positions) {
+                positions = g_new(gint, GFAL_STATS_OP_COUNT);
+                for (op = 0; op < GFAL_STATS_OP_COUNT; ++op)
+                    positions[op] = -1;
+                g_hash_table_insert(index, key, positions);
+            }
+
+            for (op = 0; op < GFAL_STATS_OP_COUNT; ++op) {
+                if (!plugin->cells[op])
+                    continue;
+                if (positions[op] < 0) {
+                    gfal_stats_entry entry;
+                    memset(&entry, 0, sizeof(entry));
+                    entry.pub.plugin = g_strdup(key);
+                    entry.pub.operation = gfal_stats_op_names[op];
+                    g_array_append_val(snapshot->entries, entry);
+                    positions[op] = snapshot->entries->len - 1;
+                }
+                gfal_stats_entry *entry = &g_array_index(snapshot->entries, gfal_stats_entry, positions[op]);
+                gfal_stats_cell_merge(&entry->cell, plugin->cells[op]);
+            }
+        }
+
+        g_mutex_unlock(shard->lock);
+    }
+    g_hash_table_destroy(index);
+
+    g_array_sort(snapshot->entries, gfal_stats_entry_compare);
+    for (i = 0; i < (int)snapshot->entries->len; ++i) {
+        gfal_stats_entry *entry = &g_array_index(snapshot->entries, gfal_stats_entry, i);
+        entry->pub.calls = entry->cell.calls;
+        entry->pub.errors = entry->cell.errors;
+        entry->pub.bytes = entry->cell.bytes;
+        entry->pub.latency_sum_ns = entry->cell.latency_sum;
+        entry->pub.latency_max_ns = entry->cell.latency_max;
+    }
+    return snapshot;
+}
+
+
+void gfal2_stats_free(gfal2_stats_t snapshot)
+{
+    guint i;
+    if (!snapshot)
+        return;
+    for (i = 0; i < snapshot->entries->len; ++i)
+        g_free((gchar*)g_array_index(snapshot->entries, gfal_stats_entry, i).pub.plugin);
+    g_array_free(snapshot->entries, TRUE);
+    g_free(snapshot);
+}
+
+
+void gfal2_reset_stats(gfal2_context_t context)
+{
+    gfal_stats_t *stats = context->stats;
+    int i;
+    for (i = 0; i < GFAL_STATS_SHARDS; ++i) {
+        g_mutex_lock(stats->shards[i].lock);
+        g_hash_table_remove_all(stats->shards[i].plugins);
+        g_mutex_unlock(stats->shards[i].lock);
+    }
+}
+
+
+gsize gfal2_stats_size(gfal2_stats_t snapshot)
+{
+    return snapshot ? snapshot->entries->len : 0;
+}
+
+
+static const gfal_stats_entry *gfal_stats_get_entry(gfal2_stats_t snapshot, gsize index)
+{
+    if (!snapshot || index >= snapshot->entries->len)
+        return NULL;
+    return &g_array_index(snapshot->entries, gfal_stats_entry, index);
+}
+
+
+const gfal2_op_stats_t *gfal2_stats_get(gfal2_stats_t snapshot, gsize index)
+{
+    const gfal_stats_entry *entry = gfal_stats_get_entry(snapshot, index);
+    return entry ? &entry->pub : NULL;
+}
+
+
+guint64 gfal2_stats_get_latency_percentile(gfal2_stats_t snapshot, gsize index, double percentile)
+{
+    const gfal_stats_entry *entry = gfal_stats_get_entry(snapshot, index);
+    if (!entry || entry->cell.calls == 0)
+        return 0;
+
+    // Nearest rank
+    const double exact_rank = percentile * entry->cell.calls;
+    guint64 rank = (guint64)exact_rank;
+    if (rank < exact_rank || rank < 1)
+        rank += 1;
+
+    guint64 seen = 0;
+    int i;
+    for (i = 0; i < GFAL_STATS_BUCKETS; ++i) {
+        seen += entry->cell.histogram[i];
+        if (seen >= rank)
+            return MIN(gfal_stats_bucket_value(i), entry->cell.latency_max);
+    }
+    return entry->cell.latency_max;
+}
+
+
+guint64 gfal2_stats_get_error_count(gfal2_stats_t snapshot, gsize index, int errcode)
+{
+    const gfal_stats_entry *entry = gfal_stats_get_entry(snapshot, index);
+    if (!entry || errcode <= 0 || errcode >= GFAL_STATS_MAX_ERRNO)
+        return 0;
+    return entry->cell.error_codes[errcode];
+}
+
+
+static const double gfal_stats_quantiles[] = {0.5, 0.9, 0.99};
+static const char *gfal_stats_quantile_names[] = {"p50", "p90", "p99"};
+
+
+gchar *gfal2_stats_to_json(gfal2_stats_t snapshot)
+{
+    struct json_object *root = json_object_new_object();
+    struct json_object *operations = json_object_new_array();
+    gsize i;
+    int j;
+
+    for (i = 0; i < gfal2_stats_size(snapshot); ++i) {
+        const gfal_stats_entry *entry = gfal_stats_get_entry(snapshot, i);
+        struct json_object *op = json_object_new_object();
+        struct json_object *latency = json_object_new_object();
+        struct json_object *error_codes = json_object_new_object();
+
+        json_object_object_add(op, "plugin", json_object_new_string(entry->pub.plugin));
+        json_object_object_add(op, "operation", json_object_new_string(entry->pub.operation));
+        json_object_object_add(op, "calls", json_object_new_int64(entry->pub.calls));
+        json_object_object_add(op, "errors", json_object_new_int64(entry->pub.errors));
+        json_object_object_add(op, "bytes", json_object_new_int64(entry->pub.bytes));
+
+        json_object_object_add(latency, "mean",
+            json_object_new_int64(entry->pub.calls ? entry->pub.latency_sum_ns / entry->pub.calls : 0));
+        for (j = 0; j < (int)G_N_ELEMENTS(gfal_stats_quantiles); ++j) {
+            json_object_object_add(latency, gfal_stats_quantile_names[j], json_object_new_int64(
+                gfal2_stats_get_latency_percentile(snapshot, i, gfal_stats_quantiles[j])));
+        }
+        json_object_object_add(latency, "max", json_object_new_int64(entry->pub.latency_max_ns));
+        json_object_object_add(op, "latency_ns", latency);
+
+        for (j = 0; j < GFAL_STATS_MAX_ERRNO; ++j) {
+            if (entry->cell.error_codes[j]) {
+                char code[16];
+                if (j == 0)
+                    g_strlcpy(code, "other", sizeof(code));
+                else
+                    snprintf(code, sizeof(code), "%d", j);
+                json_object_object_add(error_codes, code, json_object_new_int64(entry->cell.error_codes[j]));
+            }
+        }
+        json_object_object_add(op, "error_codes", error_codes);
+
+        json_object_array_add(operations, op);
+    }
+    json_object_object_add(root, "operations", operations);
+
+    gchar *serialized = g_strdup(json_object_to_json_string(root));
+    json_object_put(root);
+    return serialized;
+}
+
+
+gchar *gfal2_stats_to_prometheus(gfal2_stats_t snapshot)
+{
+    GString *out = g_string_new(NULL);
+    const gsize size = gfal2_stats_size(snapshot);
+    gsize i;
+    int j;
+
+    g_string_append(out,
+        "# HELP gfal2_operations_total Operations dispatched to a plugin\n"
+        "# TYPE gfal2_operations_total counter\n");
+    for (i = 0; i < size; ++i) {
+        const gfal_stats_entry *entry = gfal_stats_get_entry(snapshot, i);
+        g_string_append_printf(out, "gfal2_operations_total{plugin=\"%s\",operation=\"%s\"} %" G_GUINT64_FORMAT "\n",
+            entry->pub.plugin, entry->pub.operation, entry->pub.calls);
+    }
+
+    g_string_append(out,
+        "# HELP gfal2_operation_errors_total Failed operations, by errno\n"
+        "# TYPE gfal2_operation_errors_total counter\n");
+    for (i = 0; i < size; ++i) {
+        const gfal_stats_entry *entry = gfal_stats_get_entry(snapshot, i);
+        for (j = 0; j < GFAL_STATS_MAX_ERRNO; ++j) {
+            if (!entry->cell.error_codes[j])
+                continue;
+            g_string_append_printf(out, "gfal2_operation_errors_total{plugin=\"%s\",operation=\"%s\",errno=\"",
+                entry->pub.plugin, entry->pub.operation);
+            if (j == 0)
+                g_string_append(out, "other");
+            else
+                g_string_append_printf(out, "%d", j);
+            g_string_append_printf(out, "\"} %" G_GUINT64_FORMAT "\n", entry->cell.error_codes[j]);
+        }
+    }
+
+    g_string_append(out,
+        "# HELP gfal2_operation_bytes_total Bytes read or written\n"
+        "# TYPE gfal2_operation_bytes_total counter\n");
+    for (i = 0; i < size; ++i) {
+        const gfal_stats_entry *entry = gfal_stats_get_entry(snapshot, i);
+        if (entry->pub.bytes) {
+            g_string_append_printf(out,
+                "gfal2_operation_bytes_total{plugin=\"%s\",operation=\"%s\"} %" G_GUINT64_FORMAT "\n",
+                entry->pub.plugin, entry->pub.operation, entry->pub.bytes);
+        }
+    }
+
+    g_string_append(out,
+        "# HELP gfal2_operation_duration_seconds Latency of the operations\n"
+        "# TYPE gfal2_operation_duration_seconds summary\n");
+    for (i = 0; i < size; ++i) {
+        const gfal_stats_entry *entry = gfal_stats_get_entry(snapshot, i);
+        for (j = 0; j < (int)G_N_ELEMENTS(gfal_stats_quantiles); ++j) {
+            g_string_append_printf(out,
+                "gfal2_operation_duration_seconds{plugin=\"%s\",operation=\"%s\",quantile=\"%g\"} %.9f\n",
+                entry->pub.plugin, entry->pub.operation, gfal_stats_quantiles[j],
+                gfal2_stats_get_latency_percentile(snapshot, i, gfal_stats_quantiles[j]) / 1e9);
+        }
+        g_string_append_printf(out, "gfal2_operation_duration_seconds_sum{plugin=\"%s\",operation=\"%s\"} %.9f\n",
+            entry->pub.plugin, entry->pub.operation, entry->pub.latency_sum_ns / 1e9);
+        g_string_append_printf(out,
+            "gfal2_operation_duration_seconds_count{plugin=\"%s\",operation=\"%s\"} %" G_GUINT64_FORMAT "\n",
+            entry->pub.plugin, entry->pub.operation, entry->pub.calls);
+    }
+
+    return g_string_free(out, FALSE);
+}
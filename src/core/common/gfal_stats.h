@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_STATS_H_
+#define GFAL_STATS_H_
+
+#if !defined(__GFAL2_H_INSIDE__) && !defined(__GFAL2_BUILD__)
+#   warning "Direct inclusion of gfal2 headers is deprecated. Please, include only gfal_api.h or gfal_plugins_api.h"
+#endif
+
+#include "gfal_common.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @file gfal_stats.h
+ * @brief gfal2 operation statistics API
+ */
+
+/*!
+    \defgroup stats_group Statistics API
+
+    Every operation dispatched to a plugin is accounted per (plugin, operation):
+    number of calls, failures by error code, bytes read or written, and a latency histogram.
+    Collection can be disabled with [CORE] STATS=false.
+
+    Example ( print the statistics in the Prometheus text format ) :
+        gfal2_stats_t stats = gfal2_get_stats(context, NULL);
+        gchar *text = gfal2_stats_to_prometheus(stats);
+        printf("%s", text);
+        g_free(text);
+        gfal2_stats_free(stats);
+*/
+
+/** Snapshot of the statistics of a context */
+typedef struct _gfal2_stats* gfal2_stats_t;
+
+/** Counters of one operation on one plugin */
+typedef struct {
+    /** Plugin name, or "none" if no plugin accepted the url */
+    const char *plugin;
+    /** Operation name (i.e. "stat", "pread", "copy") */
+    const char *operation;
+    guint64 calls;
+    guint64 errors;
+    /** Bytes read or written */
+    guint64 bytes;
+    guint64 latency_sum_ns;
+    guint64 latency_max_ns;
+} gfal2_op_stats_t;
+
+/**
+ * Take a snapshot of the statistics collected so far by the context
+ * @param context : context of gfal2
+ * @param error : GError error report system
+ * @return A snapshot, to be freed with gfal2_stats_free, or NULL on error
+ */
+gfal2_stats_t gfal2_get_stats(gfal2_context_t context, GError **error);
+
+/**
+ * Release a snapshot
+ */
+void gfal2_stats_free(gfal2_stats_t stats);
+
+/**
+ * Reset all the counters of the context
+ */
+void gfal2_reset_stats(gfal2_context_t context);
+
+/**
+ * @return The number of (plugin, operation) entries in the snapshot
+ */
+gsize gfal2_stats_size(gfal2_stats_t stats);
+
+/**
+ * @return The entry at index, sorted by plugin and operation, or NULL if out of range.
+ *         The entry is owned by the snapshot.
+ */
+const gfal2_op_stats_t *gfal2_stats_get(gfal2_stats_t stats, gsize index);
+
+/**
+ * @param percentile : between 0 and 1 (i.e. 0.99)
+ * @return The latency, in nanoseconds, of the given percentile of the entry at index.
+ *         Histogram buckets have a relative precision of 12.5%
+ */
+guint64 gfal2_stats_get_latency_percentile(gfal2_stats_t stats, gsize index, double percentile);
+
+/**
+ * @return How many calls of the entry at index failed with errcode
+ */
+guint64 gfal2_stats_get_error_count(gfal2_stats_t stats, gsize index, int errcode);
+
+/**
+ * @return The snapshot serialized as JSON. Use g_free to release it.
+ */
+gchar *gfal2_stats_to_json(gfal2_stats_t stats);
+
+/**
+ * @return The snapshot serialized in the Prometheus text exposition format. Use g_free to release it.
+ */
+gchar *gfal2_stats_to_prometheus(gfal2_stats_t stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GFAL_STATS_H_ */
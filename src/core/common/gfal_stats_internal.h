@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_STATS_INTERNAL_H_
+#define GFAL_STATS_INTERNAL_H_
+
+#include <glib.h>
+#include <common/gfal_common.h>
+
+// Operations accounted by the dispatch layer, keep in sync with gfal_stats_op_names
+typedef enum {
+    GFAL_STATS_ACCESS = 0,
+    GFAL_STATS_STAT,
+    GFAL_STATS_LSTAT,
+    GFAL_STATS_READLINK,
+    GFAL_STATS_CHMOD,
+    GFAL_STATS_RENAME,
+    GFAL_STATS_SYMLINK,
+    GFAL_STATS_MKDIR,
+    GFAL_STATS_RMDIR,
+    GFAL_STATS_UNLINK,
+    GFAL_STATS_OPENDIR,
+    GFAL_STATS_READDIR,
+    GFAL_STATS_READDIRPP,
+    GFAL_STATS_CLOSEDIR,
+    GFAL_STATS_OPEN,
+    GFAL_STATS_READ,
+    GFAL_STATS_PREAD,
+    GFAL_STATS_WRITE,
+    GFAL_STATS_PWRITE,
+    GFAL_STATS_LSEEK,
+    GFAL_STATS_CLOSE,
+    GFAL_STATS_GETXATTR,
+    GFAL_STATS_LISTXATTR,
+    GFAL_STATS_SETXATTR,
+    GFAL_STATS_CHECKSUM,
+    GFAL_STATS_BRING_ONLINE,
+    GFAL_STATS_BRING_ONLINE_POLL,
+    GFAL_STATS_RELEASE_FILE,
+    GFAL_STATS_STAT_LIST,
+    GFAL_STATS_UNLINK_LIST,
+    GFAL_STATS_COPY,
+    GFAL_STATS_COPY_BULK,
+    GFAL_STATS_OP_COUNT
+} gfal_stats_op;
+
+typedef struct _gfal_stats gfal_stats_t;
+
+// create or delete the statistics of a context, internal
+gfal_stats_t *gfal_stats_new(void);
+
+void gfal_stats_free(gfal_stats_t *stats);
+
+// Returns the start time of an operation, or 0 if statistics are disabled
+gint64 gfal_stats_start(gfal2_context_t context);
+
+// Account an operation started at start. plugin_name must be a string that lives as long as the
+// plugin (i.e. what getName returns), NULL if no plugin was found.
+// bytes is ignored if negative.
+void gfal_stats_record(gfal2_context_t context, const char *plugin_name, gfal_stats_op op,
+    gint64 start, gint64 bytes, const GError *error);
+
+#endif /* GFAL_STATS_INTERNAL_H_ */
@@ -24,6 +24,7 @@
 #include <common/gfal_error.h>
 #include <common/gfal_file_handler_container.h>
 #include <common/gfal_cancel.h>
+#include <common/gfal_read_cache_internal.h>
 
 
 /*
@@ -62,6 +63,7 @@ int gfal2_open2(gfal2_context_t handle, const char *uri, int flag, mode_t mode,
     }
 
     if (fhandle) {
+        fhandle->cache = gfal_read_cache_open(handle, uri, flag);
         key = gfal_rw_file_handle_store(handle, fhandle, &tmp_err);
     }
     GFAL2_END_SCOPE_CANCEL(handle);
@@ -24,6 +24,7 @@
 #include <common/gfal_plugin.h>
 #include <common/gfal_error.h>
 #include <common/gfal_cancel.h>
+#include <common/gfal_stats_internal.h>
 
 int gfal2_access(gfal2_context_t context, const char *url, int amode, GError **err)
 {
@@ -538,6 +539,66 @@ int gfal2_release_file_list(gfal2_context_t context, int nbfiles, const char *co
 }
 
 
+int gfal2_stat_list(gfal2_context_t context, int nbfiles, const char *const *urls,
+    struct stat *buffers, GError **errors)
+{
+    GError *tmp_err = NULL;
+    int res = 0;
+
+    if (urls == NULL || *urls == NULL || context == NULL || buffers == NULL) {
+        g_set_error(&tmp_err, gfal2_get_core_quark(), EFAULT,
+            "urls or/and buffers or/and context are an incorrect arguments");
+        res = -1;
+    }
+    else {
+        res = gfal2_start_scope_cancel(context, &tmp_err);
+        if (res == 0) {
+            res = gfal_plugin_stat_listG(context, nbfiles, urls, buffers, errors);
+            gfal2_end_scope_cancel(context);
+        }
+    }
+
+    if (tmp_err) {
+        int i;
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+    }
+    return res;
+}
+
+
+int gfal2_getxattr_list(gfal2_context_t context, int nbfiles, const char *const *urls,
+    const char *name, char **values, size_t size, GError **errors)
+{
+    GError *tmp_err = NULL;
+    int res = 0;
+
+    if (urls == NULL || *urls == NULL || context == NULL || name == NULL || values == NULL) {
+        g_set_error(&tmp_err, gfal2_get_core_quark(), EFAULT,
+            "urls or/and name or/and values or/and context are an incorrect arguments");
+        res = -1;
+    }
+    else {
+        res = gfal2_start_scope_cancel(context, &tmp_err);
+        if (res == 0) {
+            res = gfal_plugin_getxattr_listG(context, nbfiles, urls, name, values, size, errors);
+            gfal2_end_scope_cancel(context);
+        }
+    }
+
+    if (tmp_err) {
+        int i;
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+    }
+    return res;
+}
+
+
 int gfal2_unlink_list(gfal2_context_t context, int nbfiles, const char *const *urls, GError **errors)
 {
     GError *tmp_err = NULL;
@@ -633,6 +694,7 @@ int gfal2_checksum(gfal2_context_t handle, const char *url, const char *check_ty
     GFAL2_BEGIN_SCOPE_CANCEL(handle, -1, err);
     int res = -1;
     GError *tmp_err = NULL;
+    const gint64 stats_start = gfal_stats_start(handle);
     gfal_plugin_interface *p = gfal_find_plugin(handle, url, GFAL_PLUGIN_CHECKSUM, &tmp_err);
 
     if (p) {
@@ -640,6 +702,7 @@ int gfal2_checksum(gfal2_context_t handle, const char *url, const char *check_ty
             start_offset,
             data_length, &tmp_err);
     }
+    gfal_stats_record(handle, p ? p->getName() : NULL, GFAL_STATS_CHECKSUM, stats_start, -1, tmp_err);
     GFAL2_END_SCOPE_CANCEL(handle);
     G_RETURN_ERR(res, tmp_err, err);
 }
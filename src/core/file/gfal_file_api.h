@@ -503,6 +503,40 @@ int gfal2_bring_online_poll_list(gfal2_context_t context, int nbfiles, const cha
 int gfal2_release_file_list(gfal2_context_t context, int nbfiles, const char* const* urls,
                        const char* token, GError ** errors);
 
+/**
+ * @brief Perform a bulk stat
+ *
+ * @param context : gfal2 handle, see \ref gfal2_context_new
+ * @param nbfiles : number of files
+ * @param urls    : urls of the files
+ * @param buffers : Pre-allocated array of nbfiles stat structures
+ * @param errors  : Pre-allocated array with nbfiles pointers to errors.
+ *                  It is the user's responsability to allocate and free.
+ * @return 0 if success for all the files, -1 if error. errors is set for each file that failed
+ * @note The plugin tried will be the one that matches the first url
+ * @note If bulk stat is not supported, gfal2_stat will be called nbfiles times
+ */
+int gfal2_stat_list(gfal2_context_t context, int nbfiles, const char* const* urls,
+                    struct stat* buffers, GError ** errors);
+
+/**
+ * @brief Get the same extended attribute of a list of resources
+ *
+ * @param context : gfal2 handle, see \ref gfal2_context_new
+ * @param nbfiles : number of files
+ * @param urls    : urls of the files
+ * @param name    : key of the extended attribute
+ * @param values  : Array of nbfiles buffers for the values, of size bytes each
+ * @param size    : size of each buffer
+ * @param errors  : Pre-allocated array with nbfiles pointers to errors.
+ *                  It is the user's responsability to allocate and free.
+ * @return 0 if success for all the files, -1 if error. errors is set for each file that failed
+ * @note The plugin tried will be the one that matches the first url
+ * @note If the bulk query is not supported, gfal2_getxattr will be called nbfiles times
+ */
+int gfal2_getxattr_list(gfal2_context_t context, int nbfiles, const char* const* urls,
+                        const char* name, char** values, size_t size, GError ** errors);
+
 /**
  * @brief Perform a bulk deletion
  *
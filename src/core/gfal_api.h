@@ -45,6 +45,9 @@
 /* operation control API */
 #include <common/gfal_cancel.h>
 
+/* operation statistics */
+#include <common/gfal_stats.h>
+
 /* posix compatibility layer */
 #include <posix/gfal_posix_api.h>
 
@@ -25,30 +25,400 @@
 
 #include "gfal_logger.h"
 
+// Records per thread buffer
+#define GFAL2_LOG_RING_SIZE 256
+// Messages longer than this are allocated on the heap
+#define GFAL2_LOG_INLINE_SIZE 104
+// How often the background thread flushes, in microseconds
+#define GFAL2_LOG_FLUSH_INTERVAL 100000
+// Formats tracked per thread by the rate limit
+#define GFAL2_LOG_RATE_SLOTS 16
+
 
 static GLogLevelFlags gfal2_log_level = G_LOG_LEVEL_WARNING;
 
 
+typedef struct {
+    gint64 timestamp;
+    GLogLevelFlags level;
+    gchar *heap;
+    gchar text[GFAL2_LOG_INLINE_SIZE];
+} gfal2_log_record;
 
-void gfal2_log(GLogLevelFlags level, const char* msg, ...)
+// Single producer (the owner thread), single consumer (whoever holds gfal2_log_rings_lock)
+typedef struct _gfal2_log_ring {
+    volatile gint head;
+    volatile gint tail;
+    volatile gint dropped;
+    // Set when the owner thread exits, the ring is freed once empty
+    volatile gint orphaned;
+    struct _gfal2_log_ring *next;
+    gfal2_log_record records[GFAL2_LOG_RING_SIZE];
+} gfal2_log_ring;
+
+typedef struct {
+    const char *format;
+    gint64 window_start;
+    guint count;
+    guint suppressed;
+    GLogLevelFlags level;
+} gfal2_log_rate_slot;
+
+// Rate limit slots of a thread. Shared with gfal2_log_flush, so what was suppressed
+// is reported even if the thread does not log that format again
+typedef struct _gfal2_log_rate_state {
+    GStaticMutex lock;
+    gfal2_log_rate_slot slots[GFAL2_LOG_RATE_SLOTS];
+    // Set when the owner thread exits, the state is freed once reported
+    volatile gint orphaned;
+    struct _gfal2_log_rate_state *next;
+} gfal2_log_rate_state;
+
+typedef struct {
+    const char *format;
+    GLogLevelFlags level;
+    guint suppressed;
+} gfal2_log_rate_report;
+
+
+static volatile gint gfal2_log_async = FALSE;
+static volatile gint gfal2_log_rate_limit = 0;
+
+// Protects the list of rings, only taken when a thread logs for the first time, and to flush
+static GStaticMutex gfal2_log_rings_lock = G_STATIC_MUTEX_INIT;
+static gfal2_log_ring *gfal2_log_rings = NULL;
+
+// Background flusher
+static GStaticMutex gfal2_log_thread_lock = G_STATIC_MUTEX_INIT;
+static GThread *gfal2_log_thread = NULL;
+static GMutex *gfal2_log_wakeup_lock = NULL;
+static GCond *gfal2_log_wakeup = NULL;
+static volatile gint gfal2_log_thread_running = FALSE;
+
+// Protects the list of rate limit states
+static GStaticMutex gfal2_log_rate_states_lock = G_STATIC_MUTEX_INIT;
+static gfal2_log_rate_state *gfal2_log_rate_states = NULL;
+
+static pthread_key_t gfal2_log_ring_key;
+static pthread_key_t gfal2_log_rate_key;
+static pthread_once_t gfal2_log_keys_once = PTHREAD_ONCE_INIT;
+
+static __thread gfal2_log_ring *gfal2_log_thread_ring = NULL;
+// Set while the thread delivers buffered messages, so handlers that log do not reenter
+static __thread gboolean gfal2_log_draining = FALSE;
+static __thread gfal2_log_rate_state *gfal2_log_thread_rate = NULL;
+// Set once the thread started exiting, so no new ring or rate state is created for it
+static __thread gboolean gfal2_log_thread_exiting = FALSE;
+
+
+// The flusher may free an orphaned ring at any time, so forget it first: a destructor
+// running later in this thread that logs falls back to synchronous logging
+static void gfal2_log_ring_orphan(void *data)
 {
-    if (level <= gfal2_log_level) {
-        va_list args;
-        va_start(args, msg);
-        g_logv("GFAL2", level, msg, args);
-        va_end(args);
+    gfal2_log_ring *ring = (gfal2_log_ring*)data;
+    gfal2_log_thread_exiting = TRUE;
+    gfal2_log_thread_ring = NULL;
+    g_atomic_int_set(&ring->orphaned, TRUE);
+}
+
+
+static void gfal2_log_rate_orphan(void *data)
+{
+    gfal2_log_rate_state *state = (gfal2_log_rate_state*)data;
+    gfal2_log_thread_exiting = TRUE;
+    gfal2_log_thread_rate = NULL;
+    g_atomic_int_set(&state->orphaned, TRUE);
+}
+
+
+static void gfal2_log_keys_init(void)
+{
+    pthread_key_create(&gfal2_log_ring_key, gfal2_log_ring_orphan);
+    pthread_key_create(&gfal2_log_rate_key, gfal2_log_rate_orphan);
+}
+
+
+static gfal2_log_ring *gfal2_log_get_ring(void)
+{
+    if (G_LIKELY(gfal2_log_thread_ring != NULL))
+        return gfal2_log_thread_ring;
+
+    // The records are written before being read, so do not touch their pages until used
+    gfal2_log_ring *ring = g_new(gfal2_log_ring, 1);
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    ring->orphaned = FALSE;
+    pthread_once(&gfal2_log_keys_once, gfal2_log_keys_init);
+    pthread_setspecific(gfal2_log_ring_key, ring);
+
+    g_static_mutex_lock(&gfal2_log_rings_lock);
+    ring->next = gfal2_log_rings;
+    gfal2_log_rings = ring;
+    g_static_mutex_unlock(&gfal2_log_rings_lock);
+
+    gfal2_log_thread_ring = ring;
+    return ring;
+}
+
+
+static gfal2_log_rate_state *gfal2_log_get_rate_state(void)
+{
+    if (G_LIKELY(gfal2_log_thread_rate != NULL))
+        return gfal2_log_thread_rate;
+
+    gfal2_log_rate_state *state = g_new0(gfal2_log_rate_state, 1);
+    g_static_mutex_init(&state->lock);
+    pthread_once(&gfal2_log_keys_once, gfal2_log_keys_init);
+    pthread_setspecific(gfal2_log_rate_key, state);
+
+    g_static_mutex_lock(&gfal2_log_rate_states_lock);
+    state->next = gfal2_log_rate_states;
+    gfal2_log_rate_states = state;
+    g_static_mutex_unlock(&gfal2_log_rate_states_lock);
+
+    gfal2_log_thread_rate = state;
+    return state;
+}
+
+
+static void gfal2_log_rate_report_suppressed(const gfal2_log_rate_report *report)
+{
+    gfal2_log(report->level, "%u messages suppressed by the rate limit: %s",
+        report->suppressed, report->format);
+}
+
+
+// Report the suppressed messages of the windows that are over, or of all of them
+// if all is set. The reports are logged once the locks are released
+static void gfal2_log_rate_flush(gboolean all)
+{
+    GArray *reports = NULL;
+    gfal2_log_rate_state *state, **prev;
+    const gint64 now = g_get_monotonic_time();
+    guint i;
+
+    g_static_mutex_lock(&gfal2_log_rate_states_lock);
+    prev = &gfal2_log_rate_states;
+    while ((state = *prev) != NULL) {
+        const gboolean orphaned = g_atomic_int_get(&state->orphaned);
+
+        g_static_mutex_lock(&state->lock);
+        for (i = 0; i < GFAL2_LOG_RATE_SLOTS; ++i) {
+            gfal2_log_rate_slot *slot = &state->slots[i];
+            if (slot->suppressed > 0 && (all || orphaned || now - slot->window_start >= G_USEC_PER_SEC)) {
+                gfal2_log_rate_report report = {slot->format, slot->level, slot->suppressed};
+                if (!reports)
+                    reports = g_array_new(FALSE, FALSE, sizeof(gfal2_log_rate_report));
+                g_array_append_val(reports, report);
+                slot->suppressed = 0;
+            }
+        }
+        g_static_mutex_unlock(&state->lock);
+
+        if (orphaned) {
+            *prev = state->next;
+            g_static_mutex_free(&state->lock);
+            g_free(state);
+        }
+        else {
+            prev = &state->next;
+        }
+    }
+    g_static_mutex_unlock(&gfal2_log_rate_states_lock);
+
+    if (reports) {
+        for (i = 0; i < reports->len; ++i)
+            gfal2_log_rate_report_suppressed(&g_array_index(reports, gfal2_log_rate_report, i));
+        g_array_free(reports, TRUE);
     }
 }
 
 
+// Enqueue a message into the ring of the calling thread
+static void gfal2_log_enqueue(GLogLevelFlags level, const char* msg, va_list args)
+{
+    gfal2_log_ring *ring = gfal2_log_get_ring();
+    const guint head = (guint)ring->head;
+    const guint tail = (guint)g_atomic_int_get(&ring->tail);
+
+    if (head - tail >= GFAL2_LOG_RING_SIZE) {
+        g_atomic_int_inc(&ring->dropped);
+        return;
+    }
+
+    gfal2_log_record *record = &ring->records[head % GFAL2_LOG_RING_SIZE];
+    va_list args_copy;
+    va_copy(args_copy, args);
+    int len = g_vsnprintf(record->text, sizeof(record->text), msg, args_copy);
+    va_end(args_copy);
+    record->heap = (len >= (int)sizeof(record->text)) ? g_strdup_vprintf(msg, args) : NULL;
+    record->level = level;
+    record->timestamp = g_get_monotonic_time();
+
+    g_atomic_int_set(&ring->head, (gint)(head + 1));
+
+    // Do not wait for the next period if the ring is filling up
+    if (head - tail == GFAL2_LOG_RING_SIZE / 2 && gfal2_log_wakeup)
+        g_cond_signal(gfal2_log_wakeup);
+}
+
+
+// Deliver all the pending records, oldest first.
+// Must be called with gfal2_log_rings_lock held
+static void gfal2_log_drain(void)
+{
+    gfal2_log_ring *ring, **prev;
+
+    while (TRUE) {
+        gfal2_log_ring *oldest = NULL;
+        gint64 oldest_timestamp = G_MAXINT64;
+
+        for (ring = gfal2_log_rings; ring != NULL; ring = ring->next) {
+            const guint tail = (guint)ring->tail;
+            if (tail != (guint)g_atomic_int_get(&ring->head)) {
+                gfal2_log_record *record = &ring->records[tail % GFAL2_LOG_RING_SIZE];
+                if (record->timestamp < oldest_timestamp) {
+                    oldest_timestamp = record->timestamp;
+                    oldest = ring;
+                }
+            }
+        }
+        if (!oldest)
+            break;
+
+        const guint tail = (guint)oldest->tail;
+        gfal2_log_record *record = &oldest->records[tail % GFAL2_LOG_RING_SIZE];
+        g_log("GFAL2", record->level, "%s", record->heap ? record->heap : record->text);
+        g_free(record->heap);
+        record->heap = NULL;
+        g_atomic_int_set(&oldest->tail, (gint)(tail + 1));
+    }
+
+    prev = &gfal2_log_rings;
+    while ((ring = *prev) != NULL) {
+        gint dropped = g_atomic_int_get(&ring->dropped);
+        if (dropped) {
+            g_atomic_int_add(&ring->dropped, -dropped);
+            g_log("GFAL2", G_LOG_LEVEL_WARNING, "%d log messages dropped, the asynchronous buffer was full",
+                dropped);
+        }
+        if (g_atomic_int_get(&ring->orphaned) && ring->tail == g_atomic_int_get(&ring->head)) {
+            *prev = ring->next;
+            g_free(ring);
+        }
+        else {
+            prev = &ring->next;
+        }
+    }
+}
+
+
+void gfal2_log_flush(void)
+{
+    if (gfal2_log_draining)
+        return;
+    gfal2_log_rate_flush(FALSE);
+    g_static_mutex_lock(&gfal2_log_rings_lock);
+    gfal2_log_draining = TRUE;
+    gfal2_log_drain();
+    gfal2_log_draining = FALSE;
+    g_static_mutex_unlock(&gfal2_log_rings_lock);
+}
+
+
+static gpointer gfal2_log_flusher(gpointer data)
+{
+    g_mutex_lock(gfal2_log_wakeup_lock);
+    while (g_atomic_int_get(&gfal2_log_thread_running)) {
+        GTimeVal deadline;
+        g_get_current_time(&deadline);
+        g_time_val_add(&deadline, GFAL2_LOG_FLUSH_INTERVAL);
+        g_cond_timed_wait(gfal2_log_wakeup, gfal2_log_wakeup_lock, &deadline);
+        g_mutex_unlock(gfal2_log_wakeup_lock);
+
+        gfal2_log_flush();
+
+        g_mutex_lock(gfal2_log_wakeup_lock);
+    }
+    g_mutex_unlock(gfal2_log_wakeup_lock);
+    return NULL;
+}
+
+
+// Returns TRUE if the message must be skipped
+static gboolean gfal2_log_rate_limited(GLogLevelFlags level, const char* msg)
+{
+    const guint limit = (guint)g_atomic_int_get(&gfal2_log_rate_limit);
+    if (G_LIKELY(limit == 0))
+        return FALSE;
+    if (gfal2_log_thread_exiting && gfal2_log_thread_rate == NULL)
+        return FALSE;
+
+    gfal2_log_rate_state *state = gfal2_log_get_rate_state();
+    gfal2_log_rate_slot *slot = &state->slots[((gsize)msg >> 3) % GFAL2_LOG_RATE_SLOTS];
+    gfal2_log_rate_report report = {NULL, 0, 0};
+    gboolean skip = FALSE;
+    const gint64 now = g_get_monotonic_time();
+
+    // Only contended while gfal2_log_flush goes through the slots
+    g_static_mutex_lock(&state->lock);
+    if (slot->format != msg || now - slot->window_start >= G_USEC_PER_SEC) {
+        if (slot->suppressed > 0) {
+            report.format = slot->format;
+            report.level = slot->level;
+            report.suppressed = slot->suppressed;
+            slot->suppressed = 0;
+        }
+        slot->format = msg;
+        slot->window_start = now;
+        slot->count = 0;
+    }
+    if (++slot->count > limit) {
+        slot->level = level;
+        ++slot->suppressed;
+        skip = TRUE;
+    }
+    g_static_mutex_unlock(&state->lock);
+
+    // Report what was skipped in the previous window, with the level it was logged with
+    if (report.suppressed > 0)
+        gfal2_log_rate_report_suppressed(&report);
+    return skip;
+}
+
+
 void gfal2_logv(GLogLevelFlags level, const char* msg, va_list args)
 {
-    if (level <= gfal2_log_level) {
+    if (level > gfal2_log_level)
+        return;
+    if (gfal2_log_rate_limited(level, msg))
+        return;
+
+    const gboolean has_ring = !gfal2_log_thread_exiting || gfal2_log_thread_ring != NULL;
+    if (g_atomic_int_get(&gfal2_log_async) && !gfal2_log_draining && has_ring) {
+        gfal2_log_enqueue(level, msg, args);
+        // Do not hold back errors, the process may be about to abort
+        if (level & (G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL))
+            gfal2_log_flush();
+    }
+    else {
         g_logv("GFAL2", level, msg, args);
     }
 }
 
 
+void gfal2_log(GLogLevelFlags level, const char* msg, ...)
+{
+    if (level <= gfal2_log_level) {
+        va_list args;
+        va_start(args, msg);
+        gfal2_logv(level, msg, args);
+        va_end(args);
+    }
+}
+
+
 void gfal2_log_set_level(GLogLevelFlags level)
 {
     gfal2_log_level = level;
@@ -66,3 +436,57 @@ int gfal2_log_set_handler(GLogFunc func, gpointer user_data)
     return g_log_set_handler("GFAL2", G_LOG_LEVEL_MASK, func, user_data);
 }
 
+
+int gfal2_log_set_async(gboolean async, GError** error)
+{
+    int ret = 0;
+    g_static_mutex_lock(&gfal2_log_thread_lock);
+
+    if (async && gfal2_log_thread == NULL) {
+        if (gfal2_log_wakeup == NULL) {
+            gfal2_log_wakeup_lock = g_mutex_new();
+            gfal2_log_wakeup = g_cond_new();
+        }
+        g_atomic_int_set(&gfal2_log_thread_running, TRUE);
+        gfal2_log_thread = g_thread_create(gfal2_log_flusher, NULL, TRUE, error);
+        if (gfal2_log_thread) {
+            g_atomic_int_set(&gfal2_log_async, TRUE);
+        }
+        else {
+            g_atomic_int_set(&gfal2_log_thread_running, FALSE);
+            ret = -1;
+        }
+    }
+    else if (!async && gfal2_log_thread != NULL) {
+        g_atomic_int_set(&gfal2_log_async, FALSE);
+
+        g_mutex_lock(gfal2_log_wakeup_lock);
+        g_atomic_int_set(&gfal2_log_thread_running, FALSE);
+        g_cond_signal(gfal2_log_wakeup);
+        g_mutex_unlock(gfal2_log_wakeup_lock);
+
+        g_thread_join(gfal2_log_thread);
+        gfal2_log_thread = NULL;
+        gfal2_log_flush();
+    }
+
+    g_static_mutex_unlock(&gfal2_log_thread_lock);
+    return ret;
+}
+
+
+void gfal2_log_set_rate_limit(guint max_per_second)
+{
+    g_atomic_int_set(&gfal2_log_rate_limit, (gint)max_per_second);
+}
+
+
+// Do not lose what is still buffered when the process exits
+__attribute__((destructor))
+static void gfal2_log_exit(void)
+{
+    if (gfal2_log_rate_states)
+        gfal2_log_rate_flush(TRUE);
+    if (gfal2_log_rings)
+        gfal2_log_flush();
+}
@@ -69,6 +69,34 @@ GLogLevelFlags gfal2_log_get_level(void);
  */
 int gfal2_log_set_handler(GLogFunc func, gpointer user_data);
 
+/**
+ * Enable or disable the asynchronous logging.
+ * When enabled, messages are formatted by the calling thread into a per thread buffer,
+ * and passed to the handler by a background thread, so the handler runs outside
+ * of the data paths. Messages from different threads are delivered in timestamp order.
+ * G_LOG_LEVEL_CRITICAL and G_LOG_LEVEL_ERROR messages are delivered before gfal2_log returns.
+ * If a thread logs faster than the buffer is flushed, extra messages are dropped, and the
+ * amount reported.
+ * Disabling it flushes the pending messages.
+ * @return 0 on success, -1 if the background thread could not be started
+ */
+int gfal2_log_set_async(gboolean async, GError** error);
+
+/**
+ * Deliver all the messages pending in the asynchronous buffers, and report the messages
+ * suppressed by the rate limit during the seconds that are over.
+ * The asynchronous logging calls it periodically.
+ */
+void gfal2_log_flush(void);
+
+/**
+ * Limit how many times per second each thread can log messages with the same format.
+ * Messages over the limit are not formatted, and are reported as a count once
+ * the second is over, by the next message with the same format or by gfal2_log_flush.
+ * 0 (default) disables the limit.
+ */
+void gfal2_log_set_rate_limit(guint max_per_second);
+
 
 #ifdef __cplusplus
 }
@@ -556,6 +556,8 @@ const char *gfal2_version();
  * @brief get context for advanced operation
  * Return the gfal2 context used for POSIX operations
  * Allow to do advanced operation ( config, checksum, transfer ) on this context
+ * @note This context is shared by all the threads of the process, so
+ *       configuration changes are seen by all of them. Errors remain per thread.
  * @warning Delete this context leads to undefined behavior.
  */
 gfal2_context_t gfal_posix_get_handle();
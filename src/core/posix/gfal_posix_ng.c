@@ -24,25 +24,31 @@
 #include "gfal_posix_api.h"
 
 /**
- * Context per thread
+ * Error state per thread
+ * The gfal2 context itself is shared by all the threads: it is thread safe,
+ * and creating one means loading the configuration and initializing every plugin
  */
 typedef struct _Gfal2ThreadContext {
-    gfal2_context_t context;
     GError *error;
 } Gfal2ThreadContext;
 
-/** Release the context bound to a thread when the later ends */
+/** Release the error state bound to a thread when the later ends */
 static void gfal_posix_free_context(gpointer ptr)
 {
     Gfal2ThreadContext *thread_context = (Gfal2ThreadContext*)ptr;
-    g_error_free(thread_context->error);
-    gfal2_context_free(thread_context->context);
+    if (thread_context->error)
+        g_error_free(thread_context->error);
     g_free(thread_context);
 }
 
 /** Thread local storage */
 static GPrivate *thread_private;
 
+/** Context shared by all threads, created on first use.
+ * It is never freed: at exit, the plugins it holds may have been torn down already */
+static gfal2_context_t shared_context = NULL;
+static GStaticMutex shared_context_mutex = G_STATIC_MUTEX_INIT;
+
 __attribute__((constructor))
 static void init_thread_private()
 {
@@ -63,18 +69,29 @@ static Gfal2ThreadContext* gfal_posix_get_thread_context()
 }
 
 
-/** Return the gfal2 handle for the current thread */
+/** Return the gfal2 handle, shared by all threads */
 gfal2_context_t gfal_posix_get_handle()
 {
     errno = 0;
-    Gfal2ThreadContext *thread_context = gfal_posix_get_thread_context();
-    if (thread_context->context == NULL) {
-        thread_context->context = gfal2_context_new(&thread_context->error);
+    gfal2_context_t context = g_atomic_pointer_get(&shared_context);
+    if (context != NULL) {
+        return context;
+    }
+
+    // Creation failures are reported to the calling thread, and retried on the next call
+    g_static_mutex_lock(&shared_context_mutex);
+    if (shared_context == NULL) {
+        Gfal2ThreadContext *thread_context = gfal_posix_get_thread_context();
+        g_clear_error(&thread_context->error);
+        context = gfal2_context_new(&thread_context->error);
         if (thread_context->error != NULL) {
             errno = thread_context->error->code;
         }
+        g_atomic_pointer_set(&shared_context, context);
     }
-    return thread_context->context;
+    context = shared_context;
+    g_static_mutex_unlock(&shared_context_mutex);
+    return context;
 }
 
 
@@ -122,6 +122,36 @@ typedef struct _gfalt_event* gfalt_event_t;
  */
 typedef void (*gfalt_event_func)(const gfalt_event_t e, gpointer user_data);
 
+/**
+ * @brief Trace span.
+ * A span covers either a whole copy ("copy", "copy_bulk"), or one of its phases.
+ * Phases bracketed by ENTER and EXIT events are traced as the lower-cased stage name
+ * ("prepare", "transfer", "close", "checksum", ...). Plugins may trace other phases,
+ * like "mkdir_parent" or "overwrite".
+ */
+typedef struct {
+    const char       *trace_id;       /**< 32 hexadecimal characters, shared by all the spans of a copy */
+    const char       *span_id;        /**< 16 hexadecimal characters */
+    const char       *parent_span_id; /**< Enclosing copy, NULL for the outermost one */
+    const char       *name;           /**< Copy or phase name */
+    const char       *plugin;         /**< Plugin name for copies, event domain for phases */
+    gfal_event_side_t side;           /**< Side of the phase, GFAL_EVENT_NONE for copies */
+    gint64            start_time;     /**< Nanoseconds since the Epoch */
+    gint64            end_time;       /**< Nanoseconds since the Epoch */
+    guint64           bytes;          /**< Bytes transferred, if known */
+    int               status;         /**< 0 on success, errno otherwise */
+    const char       *status_message; /**< Error message, or NULL */
+    const char       *source;         /**< Source url, NULL for phases */
+    const char       *destination;    /**< Destination url, NULL for phases */
+} gfalt_span_t;
+
+/**
+ * This function is called each time a span ends. Phases end before their copy.
+ * @param span : Finished span, only valid during the call
+ * @param user_data : external pointer provided before
+ */
+typedef void (*gfalt_span_func)(const gfalt_span_t *span, gpointer user_data);
+
 /**
  * Checksum verification mode
  */
@@ -360,6 +390,22 @@ gint gfalt_add_event_callback(gfalt_params_t params, gfalt_event_func callback,
  */
 gint gfalt_remove_event_callback(gfalt_params_t params, gfalt_event_func callback, GError** err);
 
+/**
+ * @brief Add a new callback for tracing
+ * Spans are only collected if there is at least one span callback, or if
+ * [CORE] TRANSFER_TRACE_FILE is set, in which case they are also appended to that file
+ * in the OpenTelemetry (OTLP) JSON format, one line per copy.
+ * Same semantics as gfalt_add_event_callback regarding udata and udata_free.
+ */
+gint gfalt_add_span_callback(gfalt_params_t params, gfalt_span_func callback,
+        gpointer udata, GDestroyNotify udata_free, GError** err);
+
+/**
+ * @brief Remove an installed span callback
+ * It will call the method registered to free the user data
+ */
+gint gfalt_remove_span_callback(gfalt_params_t params, gfalt_span_func callback, GError** err);
+
 /**
  *	@brief copy function
  *  start a synchronous copy of the file
@@ -394,7 +440,8 @@ gint gfalt_copy_get_status(gfalt_transfer_status_t, GError ** err);
 size_t gfalt_copy_get_average_baudrate(gfalt_transfer_status_t, GError ** err);
 
 /**
- * Get an estimation of the instant baudrate in bytes/s
+ * Get an estimation of the instant baudrate in bytes/s.
+ * Streamed copies report a moving average with a time constant of 5 seconds
  */
 size_t gfalt_copy_get_instant_baudrate(gfalt_transfer_status_t, GError ** err);
 
@@ -407,6 +454,27 @@ size_t gfalt_copy_get_bytes_transfered(gfalt_transfer_status_t, GError ** err);
  */
 time_t gfalt_copy_get_elapsed_time(gfalt_transfer_status_t, GError ** err);
 
+/**
+ * Get the time at which the status was sampled, in nanoseconds of the monotonic clock
+ */
+gint64 gfalt_copy_get_timestamp(gfalt_transfer_status_t, GError ** err);
+
+/**
+ * Get the elapsed time since the start of the transfer, in nanoseconds.
+ * Falls back to the resolution of \ref gfalt_copy_get_elapsed_time if the plugin does not provide better
+ */
+gint64 gfalt_copy_get_elapsed_time_ns(gfalt_transfer_status_t, GError ** err);
+
+/**
+ * Get the number of parallel streams used by the transfer, 0 if unknown
+ */
+guint gfalt_copy_get_streams(gfalt_transfer_status_t, GError ** err);
+
+/**
+ * Get the number of bytes sent, but not yet acknowledged by the destination
+ */
+size_t gfalt_copy_get_bytes_in_flight(gfalt_transfer_status_t, GError ** err);
+
 /**
     @}
     End of the File Transfer API
@@ -23,16 +23,22 @@
 #include <transfer/gfal_transfer_plugins.h>
 #include <transfer/gfal_transfer_internal.h>
 #include <common/gfal_cancel.h>
+#include <common/gfal_stats_internal.h>
+
+// Names under which copies not handled by a plugin are accounted
+static const char *local_copy_name = "local";
+static const char *bulk_fallback_name = "fallback";
+
 
 static GQuark scope_copy_domain() {
     return g_quark_from_static_string("GFAL2:CORE:COPY");
 }
 
 
-static gfal_plugin_interface* find_copy_plugin(gfal2_context_t context, gfal_url2_check operation,
-        const char* src, const char* dst, void** plugin_data, GError** error)
+static gfal_plugin_interface* find_loaded_copy_plugin(gfal2_context_t context, gfal_url2_check operation,
+        const char* src, const char* dst, void** plugin_data)
 {
-    GList* item = g_list_first(context->plugin_opt.sorted_plugin);
+    GList* item = g_list_first(g_atomic_pointer_get(&context->plugin_opt.sorted_plugin));
     void* resu = NULL;
 
     while (item != NULL && resu == NULL) {
@@ -52,9 +58,29 @@ static gfal_plugin_interface* find_copy_plugin(gfal2_context_t context, gfal_url
 }
 
 
+static gfal_plugin_interface* find_copy_plugin(gfal2_context_t context, gfal_url2_check operation,
+        const char* src, const char* dst, void** plugin_data, GError** error)
+{
+    GError* tmp_err = NULL;
+    gfal_plugin_interface* resu = NULL;
+
+    // with lazy plugin loading, bring in the plugins for both ends first
+    if (gfal_plugins_load_for_url(context, src, &tmp_err) >= 0 &&
+        gfal_plugins_load_for_url(context, dst, &tmp_err) >= 0) {
+        resu = find_loaded_copy_plugin(context, operation, src, dst, plugin_data);
+        if (resu == NULL && gfal_plugins_load_all(context, &tmp_err) > 0)
+            resu = find_loaded_copy_plugin(context, operation, src, dst, plugin_data);
+    }
+
+    if (tmp_err)
+        gfal2_propagate_prefixed_error(error, tmp_err, __func__);
+    return resu;
+}
+
+
 static int trigger_listener_plugins(gfal2_context_t context, gfalt_params_t params, GError** error)
 {
-    GList *item = g_list_first(context->plugin_opt.sorted_plugin);
+    GList *item = g_list_first(g_atomic_pointer_get(&context->plugin_opt.sorted_plugin));
 
     while (item != NULL) {
         gfal_plugin_interface* plugin_ifce = (gfal_plugin_interface*)item->data;
@@ -109,19 +135,27 @@ static int perform_copy(gfal2_context_t context, gfalt_params_t params, const ch
         gfal2_propagate_prefixed_error(error, tmp_err, __func__);
         return -1;
     }
+
+    gfalt_trace_span_t span = gfalt_trace_copy_begin(context, params, "copy", src, dst);
+    const char *plugin_name = NULL;
+
     if (notify_copy_list(context, params, 1, &src, &dst, &tmp_err)) {
+        gfalt_trace_copy_end(params, span, NULL, tmp_err);
         gfal2_propagate_prefixed_error(error, tmp_err, __func__);
         return -1;
     }
 
     void *plugin_data = NULL;
+    const gint64 stats_start = gfal_stats_start(context);
     gfal_plugin_interface* plugin = find_copy_plugin(context, GFAL_FILE_COPY, src, dst,
             &plugin_data, &tmp_err);
 
     if (tmp_err == NULL) {
         if (plugin == NULL) {
             if (gfalt_get_local_transfer_perm(params, NULL)) {
+                plugin_name = local_copy_name;
                 res = perform_local_copy(context, params, src, dst, &tmp_err);
+                gfal_stats_record(context, local_copy_name, GFAL_STATS_COPY, stats_start, -1, tmp_err);
             }
             else {
                 gfal2_set_error(error, scope_copy_domain(), EPROTONOSUPPORT, __func__,
@@ -131,10 +165,15 @@ static int perform_copy(gfal2_context_t context, gfalt_params_t params, const ch
             }
         }
         else {
+            plugin_name = plugin->getName();
             res = plugin->copy_file(plugin_data, context, params, src, dst, &tmp_err);
+            gfal_stats_record(context, plugin_name, GFAL_STATS_COPY, stats_start, -1, tmp_err);
         }
     }
 
+    gfalt_trace_copy_end(params, span, plugin_name,
+            (tmp_err || res == 0 || error == NULL) ? tmp_err : *error);
+
     gfal2_log(G_LOG_LEVEL_DEBUG, " <- Gfal::Transfer::FileCopy");
 
     if (tmp_err != NULL)
@@ -198,6 +237,20 @@ static int bulk_fallback(gfal2_context_t context, gfalt_params_t params, size_t
 }
 
 
+// Error reported by a failed bulk copy, for the statistics
+static const GError* bulk_first_error(size_t nbfiles, GError** op_error, GError** file_errors)
+{
+    size_t i;
+    if (op_error && *op_error)
+        return *op_error;
+    for (i = 0; file_errors && i < nbfiles; ++i) {
+        if (file_errors[i])
+            return file_errors[i];
+    }
+    return NULL;
+}
+
+
 static int perform_bulk_copy(gfal2_context_t context, gfalt_params_t params,
         size_t nbfiles, const char* const * srcs, const char* const * dsts,
         const char* const * checksums, GError** op_error, GError*** file_errors)
@@ -211,12 +264,18 @@ static int perform_bulk_copy(gfal2_context_t context, gfalt_params_t params,
         gfal2_propagate_prefixed_error(op_error, tmp_err, __func__);
         return -1;
     }
+
+    // Copies done by the fallback are traced as children of this span
+    gfalt_trace_span_t span = gfalt_trace_copy_begin(context, params, "copy_bulk", NULL, NULL);
+
     if (notify_copy_list(context, params, nbfiles, srcs, dsts, &tmp_err)) {
+        gfalt_trace_copy_end(params, span, NULL, tmp_err);
         gfal2_propagate_prefixed_error(op_error, tmp_err, __func__);
         return -1;
     }
 
     void *plugin_data = NULL;
+    const gint64 stats_start = gfal_stats_start(context);
     gfal_plugin_interface *plugin = find_copy_plugin(context, GFAL_BULK_COPY, srcs[0],
             dsts[0], &plugin_data, &tmp_err);
 
@@ -229,6 +288,14 @@ static int perform_bulk_copy(gfal2_context_t context, gfalt_params_t params,
             res = plugin->copy_bulk(plugin_data, context, params, nbfiles, srcs, dsts, checksums,
                     op_error, file_errors);
         }
+        // Individual copies done by the fallback are accounted on their own
+        const GError *bulk_error = res < 0 ? bulk_first_error(nbfiles, op_error, file_errors ? *file_errors : NULL) : NULL;
+        gfal_stats_record(context, plugin ? plugin->getName() : bulk_fallback_name, GFAL_STATS_COPY_BULK,
+                stats_start, -1, bulk_error);
+        gfalt_trace_copy_end(params, span, plugin ? plugin->getName() : bulk_fallback_name, bulk_error);
+    }
+    else {
+        gfalt_trace_copy_end(params, span, NULL, tmp_err);
     }
 
     gfal2_log(G_LOG_LEVEL_DEBUG, " <- Gfal::Transfer::BulkFileCopy");
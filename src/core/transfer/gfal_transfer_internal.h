@@ -48,6 +48,9 @@ struct _gfalt_params_t {
     // callback lists
     GSList *monitor_callbacks;
     GSList *event_callbacks;
+    GSList *span_callbacks;
+    // trace of the ongoing copy, shared with the copies of this handle
+    struct _gfalt_trace *trace;
 };
 
 
@@ -57,6 +60,26 @@ struct _gfalt_callback_entry {
 };
 
 
+// Tracing, see gfal_transfer_trace.c
+// Opens a copy span, returns NULL if tracing is disabled
+gfalt_trace_span_t gfalt_trace_copy_begin(gfal2_context_t context, gfalt_params_t params,
+    const char *name, const char *src, const char *dst);
+
+// Closes a copy span, and the phases left open under it
+void gfalt_trace_copy_end(gfalt_params_t params, gfalt_trace_span_t span, const char *plugin,
+    const GError *error);
+
+// Opens or closes a phase from an ENTER or EXIT event
+void gfalt_trace_event(gfalt_params_t params, GQuark domain, gfal_event_side_t side, GQuark stage);
+
+// Records the bytes transferred so far by the innermost copy
+void gfalt_trace_monitor(gfalt_params_t params, size_t bytes);
+
+struct _gfalt_trace *gfalt_trace_ref(struct _gfalt_trace *trace);
+
+void gfalt_trace_unref(struct _gfalt_trace *trace);
+
+
 int perform_local_copy(gfal2_context_t context, gfalt_params_t params,
     const char *src, const char *dst, GError **error);
 
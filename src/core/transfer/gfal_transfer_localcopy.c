@@ -128,29 +128,6 @@ static int unlink_if_exists(gfal2_context_t context, gfalt_params_t params,
 }
 
 
-struct perf_data_t {
-    time_t start, last_update, now;
-    size_t done;
-    size_t done_since_last_update;
-};
-
-
-static void send_performance_data(gfalt_params_t params, const char* src, const char* dst, const struct perf_data_t* perf)
-{
-    struct _gfalt_transfer_status status;
-
-    time_t total_time = perf->now - perf->start;
-    time_t inc_time = perf->now - perf->last_update;
-
-    status.average_baudrate = (size_t)(perf->done / total_time);
-    status.bytes_transfered = (size_t)(perf->done);
-    status.instant_baudrate = (size_t)(perf->done_since_last_update / inc_time);
-    status.transfer_time    = total_time;
-
-    plugin_trigger_monitor(params, &status, src, dst);
-}
-
-
 static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
         const char* src, const char* dst, GError** error)
 {
@@ -213,11 +190,11 @@ static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
         return -1;
     }
 
-    struct perf_data_t perf_data;
-    perf_data.start = perf_data.now = perf_data.last_update = time(NULL);
-    perf_data.done = perf_data.done_since_last_update = 0;
+    gfalt_perf_meter_t perf_meter;
+    gfalt_perf_meter_init(context, &perf_meter);
+    struct _gfalt_transfer_status perf_status;
 
-    const time_t timeout = perf_data.start + gfalt_get_timeout(params, NULL);
+    const time_t timeout = time(NULL) + gfalt_get_timeout(params, NULL);
     ssize_t s_file = 1;
 
     gfal2_log(G_LOG_LEVEL_DEBUG, "  begin local transfer %s ->  %s with buffer size %ld", src, dst, buffersize);
@@ -228,26 +205,19 @@ static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
             gfal_plugin_writeG(context, f_dst, buffer, s_file, &nested_error);
         }
 
-        perf_data.done += s_file;
-        perf_data.done_since_last_update += s_file;
-
         // Make sure we don't have to cancel
         if (gfal2_is_canceled(context)) {
             if (nested_error == NULL)
                 g_set_error(&nested_error, local_copy_domain(), ECANCELED, "Transfer canceled");
         }
         // Timed-out?
-        else {
-            perf_data.now = time(NULL);
-            if (perf_data.now >= timeout) {
-                if (nested_error == NULL)
-                    g_set_error(&nested_error, local_copy_domain(), ETIMEDOUT, "Transfer canceled because the timeout expired");
-            }
-            else if (perf_data.now - perf_data.last_update > 5) {
-                send_performance_data(params, src, dst, &perf_data);
-                perf_data.done_since_last_update = 0;
-                perf_data.last_update = perf_data.now;
-            }
+        else if (time(NULL) >= timeout) {
+            if (nested_error == NULL)
+                g_set_error(&nested_error, local_copy_domain(), ETIMEDOUT, "Transfer canceled because the timeout expired");
+        }
+        else if (gfalt_perf_meter_update(&perf_meter, (s_file > 0) ? s_file : 0, &perf_status)) {
+            perf_status.streams = 1;
+            plugin_trigger_monitor_ext(params, &perf_status, sizeof(perf_status), src, dst);
         }
     }
     free(buffer);
@@ -312,7 +282,10 @@ int perform_local_copy(gfal2_context_t context, gfalt_params_t params,
 
     if (!is_strict_mode) {
         // Parent directory
+        gfalt_trace_span_t span = gfalt_trace_begin(params, local_copy_domain(),
+                GFAL_EVENT_DESTINATION, "mkdir_parent");
         create_parent(context, params, dst, &nested_error);
+        gfalt_trace_end(params, span, -1, nested_error);
         if (nested_error != NULL) {
             gfal2_propagate_prefixed_error(error, nested_error, __func__);
             return -1;
@@ -320,7 +293,9 @@ int perform_local_copy(gfal2_context_t context, gfalt_params_t params,
 
         // Remove if exists and overwrite is set
         if (!is_strict_mode) {
+            span = gfalt_trace_begin(params, local_copy_domain(), GFAL_EVENT_DESTINATION, "overwrite");
             unlink_if_exists(context, params, dst, &nested_error);
+            gfalt_trace_end(params, span, -1, nested_error);
             if (nested_error != NULL) {
                 gfal2_propagate_prefixed_error(error, nested_error, __func__);
                 return -1;
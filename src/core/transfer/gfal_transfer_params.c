@@ -41,6 +41,8 @@ static void gfalt_params_handle_init(gfalt_params_t p, GError ** err)
 
     p->monitor_callbacks = NULL;
     p->event_callbacks = NULL;
+    p->span_callbacks = NULL;
+    p->trace = NULL;
 }
 
 
@@ -71,6 +73,9 @@ gfalt_params_t gfalt_params_handle_copy(gfalt_params_t params, GError ** err)
 
     p->monitor_callbacks = gfalt_params_copy_callbacks(params->monitor_callbacks);
     p->event_callbacks = gfalt_params_copy_callbacks(params->event_callbacks);
+    p->span_callbacks = gfalt_params_copy_callbacks(params->span_callbacks);
+    // Copies done with this handle belong to the same trace
+    p->trace = gfalt_trace_ref(params->trace);
 
     return p;
 }
@@ -106,6 +111,9 @@ void gfalt_params_handle_delete(gfalt_params_t params, GError ** err)
         g_slist_free(params->monitor_callbacks);
         g_slist_foreach(params->event_callbacks, gfalt_params_free_callback , NULL);
         g_slist_free(params->event_callbacks);
+        g_slist_foreach(params->span_callbacks, gfalt_params_free_callback , NULL);
+        g_slist_free(params->span_callbacks);
+        gfalt_trace_unref(params->trace);
 
         g_free(params);
     }
@@ -298,6 +306,53 @@ gint gfalt_remove_event_callback(gfalt_params_t params, gfalt_event_func callbac
 }
 
 
+gint gfalt_add_span_callback(gfalt_params_t params, gfalt_span_func callback,
+        gpointer udata, GDestroyNotify udata_free, GError** err)
+{
+    g_return_val_err_if_fail(params != NULL, -1, err, "[BUG] invalid params handle");
+
+    struct _gfalt_callback_entry* entry;
+    GSList* i = gfalt_search_callback(params->span_callbacks, callback);
+
+    if (i) {
+        entry = (struct _gfalt_callback_entry*)i->data;
+        if (entry->udata_free)
+            entry->udata_free(entry->udata);
+        entry->udata = udata;
+        entry->udata_free = udata_free;
+    }
+    else {
+        entry = g_new0(struct _gfalt_callback_entry, 1);
+        entry->func = callback;
+        entry->udata = udata;
+        entry->udata_free = udata_free;
+        params->span_callbacks = g_slist_append(params->span_callbacks, entry);
+    }
+
+    return 0;
+}
+
+
+gint gfalt_remove_span_callback(gfalt_params_t params, gfalt_span_func callback,
+        GError** err)
+{
+    g_return_val_err_if_fail(params != NULL, -1, err, "[BUG] invalid params handle");
+
+    GSList* i = gfalt_search_callback(params->span_callbacks, callback);
+    if (i) {
+        struct _gfalt_callback_entry* entry = i->data;
+        if (entry->udata_free)
+            entry->udata_free(entry->udata);
+        g_free(i->data);
+        params->span_callbacks = g_slist_delete_link(params->span_callbacks, i);
+        return 0;
+    }
+
+    gfal2_set_error(err, gfal2_get_core_quark(), ENOENT, __func__, "Could not find the callback");
+    return -1;
+}
+
+
 guint gfalt_get_nbstreams(gfalt_params_t params, GError** err)
 {
     g_return_val_err_if_fail(params != NULL, -1, err, "[BUG] invalid parameter handle");
@@ -492,3 +547,33 @@ time_t gfalt_copy_get_elapsed_time(gfalt_transfer_status_t s, GError ** err)
     g_return_val_err_if_fail(s != NULL, -1, err, "[BUG] invalid transfer status handle");
     return s->transfer_time;
 }
+
+
+gint64 gfalt_copy_get_timestamp(gfalt_transfer_status_t s, GError ** err)
+{
+    g_return_val_err_if_fail(s != NULL, -1, err, "[BUG] invalid transfer status handle");
+    return s->timestamp;
+}
+
+
+gint64 gfalt_copy_get_elapsed_time_ns(gfalt_transfer_status_t s, GError ** err)
+{
+    g_return_val_err_if_fail(s != NULL, -1, err, "[BUG] invalid transfer status handle");
+    if (s->start_time > 0 && s->timestamp >= s->start_time)
+        return s->timestamp - s->start_time;
+    return (gint64)s->transfer_time * 1000000000LL;
+}
+
+
+guint gfalt_copy_get_streams(gfalt_transfer_status_t s, GError ** err)
+{
+    g_return_val_err_if_fail(s != NULL, 0, err, "[BUG] invalid transfer status handle");
+    return s->streams;
+}
+
+
+size_t gfalt_copy_get_bytes_in_flight(gfalt_transfer_status_t s, GError ** err)
+{
+    g_return_val_err_if_fail(s != NULL, -1, err, "[BUG] invalid transfer status handle");
+    return s->bytes_in_flight;
+}
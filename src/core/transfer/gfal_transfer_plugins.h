@@ -33,6 +33,12 @@ extern "C"
 {
 #endif  // __cplusplus
 
+/**
+ * Status passed to the monitor callbacks.
+ * New fields are only appended, so the size of the structure identifies its version:
+ * plugins pass sizeof(struct _gfalt_transfer_status) to plugin_trigger_monitor_ext.
+ * plugin_trigger_monitor only reads the fields up to bytes_transfered.
+ */
 struct _gfalt_transfer_status {
     gpointer plugin_transfer_data;
     int status;
@@ -40,8 +46,41 @@ struct _gfalt_transfer_status {
     size_t instant_baudrate;
     time_t transfer_time;
     size_t bytes_transfered;
+    // Only read by plugin_trigger_monitor_ext
+    // Monotonic clock, in nanoseconds. If timestamp is left to 0, the monitor sets it.
+    gint64 start_time;
+    gint64 timestamp;
+    // Parallel streams (0 if unknown), and bytes sent but not yet acknowledged by the destination
+    guint streams;
+    size_t bytes_in_flight;
 };
 
+/**
+ * Helper to compute the performance markers of a copy
+ * performed by the plugin itself (i.e. streamed copies)
+ */
+typedef struct {
+    gint64 start, last_update;
+    // Minimum time between markers, in nanoseconds
+    gint64 interval;
+    guint64 done, done_since_last_update;
+    // Exponentially weighted moving average of the rate, in bytes/s
+    double rate;
+} gfalt_perf_meter_t;
+
+/**
+ * Initialize a meter. The interval between markers is [CORE] TRANSFER_MONITOR_INTERVAL.
+ */
+void gfalt_perf_meter_init(gfal2_context_t context, gfalt_perf_meter_t* meter);
+
+/**
+ * Account for bytes transferred.
+ * @return TRUE if a marker is due, in which case status is filled and the caller should
+ *         complete it (streams, bytes_in_flight) and pass it to plugin_trigger_monitor_ext
+ */
+gboolean gfalt_perf_meter_update(gfalt_perf_meter_t* meter, size_t bytes,
+        struct _gfalt_transfer_status* status);
+
 /**
  * Convenience method for event callback
  * @param params The transfer parameters.
@@ -64,6 +103,39 @@ int plugin_trigger_event(gfalt_params_t params, GQuark domain,
 int plugin_trigger_monitor(gfalt_params_t params, gfalt_transfer_status_t status,
         const char* src, const char* dst);
 
+/**
+ * Same as plugin_trigger_monitor, including the fields added after bytes_transfered.
+ * status is copied, never modified.
+ * @param status_size sizeof(struct _gfalt_transfer_status) as seen by the caller
+ */
+int plugin_trigger_monitor_ext(gfalt_params_t params, gfalt_transfer_status_t status, size_t status_size,
+        const char* src, const char* dst);
+
+/**
+ * Opaque handle of a traced phase
+ */
+typedef struct _gfalt_trace_span* gfalt_trace_span_t;
+
+/**
+ * Start tracing a phase of the current copy that is not bracketed by ENTER/EXIT events
+ * (i.e. "mkdir_parent", "overwrite")
+ * @param params The transfer parameters.
+ * @param domain The plugin domain.
+ * @param side   The side of the phase.
+ * @param phase  Phase name.
+ * @return       A handle for gfalt_trace_end, or NULL if the copy is not being traced.
+ */
+gfalt_trace_span_t gfalt_trace_begin(gfalt_params_t params, GQuark domain,
+        gfal_event_side_t side, const char* phase);
+
+/**
+ * Finish tracing a phase started with gfalt_trace_begin. span can be NULL.
+ * @param bytes  Bytes moved during the phase, negative if irrelevant.
+ * @param error  The error the phase failed with, NULL on success.
+ */
+void gfalt_trace_end(gfalt_params_t params, gfalt_trace_span_t span, gint64 bytes,
+        const GError* error);
+
 /**
  * Convenience error methods for copy implementations
  */
@@ -0,0 +1,488 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <json.h>
+
+#include <gfal_api.h>
+#include "gfal_transfer_internal.h"
+
+
+struct _gfalt_trace_span {
+    gfalt_span_t pub;
+    gchar span_id[17];
+    gchar parent_span_id[17];
+    // Phase quark, to match ENTER and EXIT events
+    GQuark phase;
+    gboolean is_copy;
+    gint64 start_monotonic;
+};
+
+
+struct _gfalt_trace {
+    gint refcount;
+    GMutex *lock;
+    gchar trace_id[33];
+    // Open spans, innermost first
+    GList *open;
+    // Finished spans waiting to be written, as OTLP json
+    struct json_object *exported;
+    gchar *file;
+};
+
+
+static void gfalt_trace_random_id(gchar *buffer, int words)
+{
+    int i;
+    for (i = 0; i < words; ++i)
+        g_snprintf(buffer + i * 8, 9, "%08x", g_random_int());
+}
+
+
+static struct _gfalt_trace *gfalt_trace_new(gfal2_context_t context)
+{
+    struct _gfalt_trace *trace = g_new0(struct _gfalt_trace, 1);
+    trace->refcount = 1;
+    trace->lock = g_mutex_new();
+    gfalt_trace_random_id(trace->trace_id, 4);
+
+    trace->file = gfal2_get_opt_string_with_default(context, "CORE", "TRANSFER_TRACE_FILE", "");
+    if (trace->file[0] == '\0') {
+        g_free(trace->file);
+        trace->file = NULL;
+    }
+    else {
+        trace->exported = json_object_new_array();
+    }
+    return trace;
+}
+
+
+struct _gfalt_trace *gfalt_trace_ref(struct _gfalt_trace *trace)
+{
+    if (trace)
+        g_atomic_int_inc(&trace->refcount);
+    return trace;
+}
+
+
+static void gfalt_trace_span_free(struct _gfalt_trace_span *span)
+{
+    g_free((gchar*)span->pub.name);
+    g_free((gchar*)span->pub.plugin);
+    g_free((gchar*)span->pub.status_message);
+    g_free((gchar*)span->pub.source);
+    g_free((gchar*)span->pub.destination);
+    g_free(span);
+}
+
+
+void gfalt_trace_unref(struct _gfalt_trace *trace)
+{
+    if (!trace || !g_atomic_int_dec_and_test(&trace->refcount))
+        return;
+    g_list_free_full(trace->open, (GDestroyNotify)gfalt_trace_span_free);
+    if (trace->exported)
+        json_object_put(trace->exported);
+    g_free(trace->file);
+    g_mutex_free(trace->lock);
+    g_free(trace);
+}
+
+
+// Innermost open copy, must be called with the lock held
+static struct _gfalt_trace_span *gfalt_trace_current_copy(struct _gfalt_trace *trace)
+{
+    GList *i;
+    for (i = trace->open; i != NULL; i = i->next) {
+        struct _gfalt_trace_span *span = i->data;
+        if (span->is_copy)
+            return span;
+    }
+    return NULL;
+}
+
+
+// Must be called with the lock held
+static struct _gfalt_trace_span *gfalt_trace_open(struct _gfalt_trace *trace, const char *name,
+        const char *plugin, gfal_event_side_t side)
+{
+    struct _gfalt_trace_span *span = g_new0(struct _gfalt_trace_span, 1);
+    struct _gfalt_trace_span *parent = gfalt_trace_current_copy(trace);
+
+    gfalt_trace_random_id(span->span_id, 2);
+    if (parent) {
+        g_strlcpy(span->parent_span_id, parent->span_id, sizeof(span->parent_span_id));
+        span->pub.parent_span_id = span->parent_span_id;
+    }
+    span->pub.trace_id = trace->trace_id;
+    span->pub.span_id = span->span_id;
+    span->pub.name = g_strdup(name);
+    span->pub.plugin = g_strdup(plugin);
+    span->pub.side = side;
+    span->pub.start_time = g_get_real_time() * 1000;
+    span->start_monotonic = g_get_monotonic_time();
+
+    trace->open = g_list_prepend(trace->open, span);
+    return span;
+}
+
+
+// Must be called with the lock held. The span is removed from the open list.
+static void gfalt_trace_close(struct _gfalt_trace *trace, struct _gfalt_trace_span *span,
+        gint64 bytes, int status, const char *message)
+{
+    trace->open = g_list_remove(trace->open, span);
+    span->pub.end_time = span->pub.start_time + (g_get_monotonic_time() - span->start_monotonic) * 1000;
+    if (bytes >= 0)
+        span->pub.bytes = bytes;
+    span->pub.status = status;
+    span->pub.status_message = g_strdup(message);
+}
+
+
+static const char *gfalt_trace_side_str(gfal_event_side_t side)
+{
+    switch (side) {
+        case GFAL_EVENT_SOURCE:
+            return "source";
+        case GFAL_EVENT_DESTINATION:
+            return "destination";
+        default:
+            return "none";
+    }
+}
+
+
+static void gfalt_trace_add_attribute(struct json_object *attributes, const char *key, const char *type,
+        struct json_object *value)
+{
+    struct json_object *attribute = json_object_new_object();
+    struct json_object *wrapper = json_object_new_object();
+    json_object_object_add(wrapper, type, value);
+    json_object_object_add(attribute, "key", json_object_new_string(key));
+    json_object_object_add(attribute, "value", wrapper);
+    json_object_array_add(attributes, attribute);
+}
+
+
+// OTLP encodes 64 bits integers as strings
+static struct json_object *gfalt_trace_int64(gint64 value)
+{
+    char buffer[32];
+    g_snprintf(buffer, sizeof(buffer), "%" G_GINT64_FORMAT, value);
+    return json_object_new_string(buffer);
+}
+
+
+static struct json_object *gfalt_trace_span_to_otlp(const gfalt_span_t *span)
+{
+    struct json_object *obj = json_object_new_object();
+    json_object_object_add(obj, "traceId", json_object_new_string(span->trace_id));
+    json_object_object_add(obj, "spanId", json_object_new_string(span->span_id));
+    if (span->parent_span_id)
+        json_object_object_add(obj, "parentSpanId", json_object_new_string(span->parent_span_id));
+    json_object_object_add(obj, "name", json_object_new_string(span->name));
+    // SPAN_KIND_INTERNAL
+    json_object_object_add(obj, "kind", json_object_new_int(1));
+    json_object_object_add(obj, "startTimeUnixNano", gfalt_trace_int64(span->start_time));
+    json_object_object_add(obj, "endTimeUnixNano", gfalt_trace_int64(span->end_time));
+
+    struct json_object *attributes = json_object_new_array();
+    if (span->plugin)
+        gfalt_trace_add_attribute(attributes, "gfal2.plugin", "stringValue",
+            json_object_new_string(span->plugin));
+    gfalt_trace_add_attribute(attributes, "gfal2.side", "stringValue",
+        json_object_new_string(gfalt_trace_side_str(span->side)));
+    gfalt_trace_add_attribute(attributes, "gfal2.bytes", "intValue", gfalt_trace_int64(span->bytes));
+    if (span->source)
+        gfalt_trace_add_attribute(attributes, "gfal2.source", "stringValue",
+            json_object_new_string(span->source));
+    if (span->destination)
+        gfalt_trace_add_attribute(attributes, "gfal2.destination", "stringValue",
+            json_object_new_string(span->destination));
+    if (span->status)
+        gfalt_trace_add_attribute(attributes, "gfal2.errno", "intValue", gfalt_trace_int64(span->status));
+    json_object_object_add(obj, "attributes", attributes);
+
+    // STATUS_CODE_OK or STATUS_CODE_ERROR
+    struct json_object *status = json_object_new_object();
+    json_object_object_add(status, "code", json_object_new_int(span->status ? 2 : 1));
+    if (span->status_message)
+        json_object_object_add(status, "message", json_object_new_string(span->status_message));
+    json_object_object_add(obj, "status", status);
+    return obj;
+}
+
+
+// Append all the spans of the trace to the trace file, as one OTLP json line
+static void gfalt_trace_write(const char *path, struct json_object *spans)
+{
+    struct json_object *root = json_object_new_object();
+    struct json_object *resource_spans = json_object_new_array();
+    struct json_object *resource_span = json_object_new_object();
+    struct json_object *resource = json_object_new_object();
+    struct json_object *resource_attributes = json_object_new_array();
+    struct json_object *scope_spans = json_object_new_array();
+    struct json_object *scope_span = json_object_new_object();
+    struct json_object *scope = json_object_new_object();
+
+    gfalt_trace_add_attribute(resource_attributes, "service.name", "stringValue",
+        json_object_new_string("gfal2"));
+    json_object_object_add(resource, "attributes", resource_attributes);
+    json_object_object_add(scope, "name", json_object_new_string("gfal2.transfer"));
+    json_object_object_add(scope, "version", json_object_new_string(gfal2_version()));
+    json_object_object_add(scope_span, "scope", scope);
+    json_object_object_add(scope_span, "spans", json_object_get(spans));
+    json_object_array_add(scope_spans, scope_span);
+    json_object_object_add(resource_span, "resource", resource);
+    json_object_object_add(resource_span, "scopeSpans", scope_spans);
+    json_object_array_add(resource_spans, resource_span);
+    json_object_object_add(root, "resourceSpans", resource_spans);
+
+    gchar *line = g_strconcat(json_object_to_json_string(root), "\n", NULL);
+    json_object_put(root);
+
+    // A single write keeps lines from concurrent processes apart
+    int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Could not open the trace file %s: %s", path, strerror(errno));
+    }
+    else {
+        if (write(fd, line, strlen(line)) < 0)
+            gfal2_log(G_LOG_LEVEL_WARNING, "Could not write the trace file %s: %s", path, strerror(errno));
+        close(fd);
+    }
+    g_free(line);
+}
+
+
+static void gfalt_trace_emit_callback(gpointer data, gpointer user_data)
+{
+    struct _gfalt_callback_entry* entry = (struct _gfalt_callback_entry*)data;
+    gfalt_span_func callback = (gfalt_span_func)entry->func;
+    callback((const gfalt_span_t*)user_data, entry->udata);
+}
+
+
+// Report and release closed spans. Called without the lock, since callbacks may take time.
+static void gfalt_trace_emit(gfalt_params_t params, struct _gfalt_trace *trace, GList *closed)
+{
+    GList *i;
+    for (i = closed; i != NULL; i = i->next) {
+        struct _gfalt_trace_span *span = i->data;
+        g_slist_foreach(params->span_callbacks, gfalt_trace_emit_callback, &span->pub);
+        if (trace->exported) {
+            g_mutex_lock(trace->lock);
+            json_object_array_add(trace->exported, gfalt_trace_span_to_otlp(&span->pub));
+            g_mutex_unlock(trace->lock);
+        }
+        gfalt_trace_span_free(span);
+    }
+    g_list_free(closed);
+}
+
+
+gfalt_trace_span_t gfalt_trace_copy_begin(gfal2_context_t context, gfalt_params_t params,
+        const char *name, const char *src, const char *dst)
+{
+    struct _gfalt_trace *trace = params->trace;
+
+    // A handle reused after its trace finished starts a new one
+    if (trace && trace->open == NULL) {
+        gfalt_trace_unref(trace);
+        params->trace = trace = NULL;
+    }
+
+    if (!trace) {
+        if (params->span_callbacks == NULL) {
+            gchar *file = gfal2_get_opt_string_with_default(context, "CORE", "TRANSFER_TRACE_FILE", "");
+            gboolean enabled = (file[0] != '\0');
+            g_free(file);
+            if (!enabled)
+                return NULL;
+        }
+        params->trace = trace = gfalt_trace_new(context);
+    }
+
+    g_mutex_lock(trace->lock);
+    struct _gfalt_trace_span *span = gfalt_trace_open(trace, name, NULL, GFAL_EVENT_NONE);
+    span->is_copy = TRUE;
+    span->pub.source = g_strdup(src);
+    span->pub.destination = g_strdup(dst);
+    g_mutex_unlock(trace->lock);
+    return span;
+}
+
+
+void gfalt_trace_copy_end(gfalt_params_t params, gfalt_trace_span_t span, const char *plugin,
+        const GError *error)
+{
+    struct _gfalt_trace *trace = params->trace;
+    if (!span || !trace)
+        return;
+
+    const int status = error ? error->code : 0;
+    const char *message = error ? error->message : NULL;
+    GList *closed = NULL;
+
+    g_mutex_lock(trace->lock);
+    // Phases the plugin did not close failed with the copy
+    while (trace->open && trace->open->data != span) {
+        struct _gfalt_trace_span *phase = trace->open->data;
+        gfalt_trace_close(trace, phase, -1, status, message);
+        closed = g_list_append(closed, phase);
+    }
+    g_free((gchar*)span->pub.plugin);
+    span->pub.plugin = g_strdup(plugin);
+    gfalt_trace_close(trace, span, -1, status, message);
+    closed = g_list_append(closed, span);
+    const gboolean finished = (trace->open == NULL);
+    g_mutex_unlock(trace->lock);
+
+    gfalt_trace_emit(params, trace, closed);
+
+    if (finished) {
+        if (trace->file)
+            gfalt_trace_write(trace->file, trace->exported);
+        params->trace = NULL;
+        gfalt_trace_unref(trace);
+    }
+}
+
+
+gfalt_trace_span_t gfalt_trace_begin(gfalt_params_t params, GQuark domain,
+        gfal_event_side_t side, const char* phase)
+{
+    struct _gfalt_trace *trace = params ? params->trace : NULL;
+    if (!trace)
+        return NULL;
+
+    g_mutex_lock(trace->lock);
+    struct _gfalt_trace_span *span = NULL;
+    // Only trace phases of an ongoing copy
+    if (trace->open)
+        span = gfalt_trace_open(trace, phase, g_quark_to_string(domain), side);
+    g_mutex_unlock(trace->lock);
+    return span;
+}
+
+
+void gfalt_trace_end(gfalt_params_t params, gfalt_trace_span_t span, gint64 bytes,
+        const GError* error)
+{
+    struct _gfalt_trace *trace = params ? params->trace : NULL;
+    if (!span || !trace)
+        return;
+
+    g_mutex_lock(trace->lock);
+    // It may have been closed already by the end of its copy
+    if (g_list_find(trace->open, span) == NULL) {
+        g_mutex_unlock(trace->lock);
+        return;
+    }
+    gfalt_trace_close(trace, span, bytes, error ? error->code : 0, error ? error->message : NULL);
+    g_mutex_unlock(trace->lock);
+
+    gfalt_trace_emit(params, trace, g_list_append(NULL, span));
+}
+
+
+// Split "PHASE:ENTER" or "PHASE:EXIT" into the lower-cased phase quark
+static GQuark gfalt_trace_parse_stage(GQuark stage, gboolean *enter)
+{
+    const char *str = g_quark_to_string(stage);
+    const char *colon = str ? strrchr(str, ':') : NULL;
+    if (!colon)
+        return 0;
+    if (strcmp(colon + 1, "ENTER") == 0)
+        *enter = TRUE;
+    else if (strcmp(colon + 1, "EXIT") == 0)
+        *enter = FALSE;
+    else
+        return 0;
+
+    gchar *phase = g_ascii_strdown(str, colon - str);
+    GQuark quark = g_quark_from_string(phase);
+    g_free(phase);
+    return quark;
+}
+
+
+void gfalt_trace_event(gfalt_params_t params, GQuark domain, gfal_event_side_t side, GQuark stage)
+{
+    struct _gfalt_trace *trace = params->trace;
+    if (!trace)
+        return;
+
+    gboolean enter = FALSE;
+    GQuark phase = gfalt_trace_parse_stage(stage, &enter);
+    if (!phase)
+        return;
+
+    if (enter) {
+        g_mutex_lock(trace->lock);
+        if (trace->open) {
+            struct _gfalt_trace_span *span = gfalt_trace_open(trace, g_quark_to_string(phase),
+                g_quark_to_string(domain), side);
+            span->phase = phase;
+        }
+        g_mutex_unlock(trace->lock);
+        return;
+    }
+
+    g_mutex_lock(trace->lock);
+    struct _gfalt_trace_span *span = NULL;
+    GList *i;
+    for (i = trace->open; i != NULL && !((struct _gfalt_trace_span*)i->data)->is_copy; i = i->next) {
+        struct _gfalt_trace_span *candidate = i->data;
+        if (candidate->phase == phase && candidate->pub.side == side) {
+            span = candidate;
+            break;
+        }
+    }
+    if (span) {
+        // The transfer phase moved what the copy reported so far
+        struct _gfalt_trace_span *copy = gfalt_trace_current_copy(trace);
+        gint64 bytes = (phase == g_quark_from_static_string("transfer") && copy) ? (gint64)copy->pub.bytes : -1;
+        gfalt_trace_close(trace, span, bytes, 0, NULL);
+    }
+    g_mutex_unlock(trace->lock);
+
+    if (span)
+        gfalt_trace_emit(params, trace, g_list_append(NULL, span));
+}
+
+
+void gfalt_trace_monitor(gfalt_params_t params, size_t bytes)
+{
+    struct _gfalt_trace *trace = params->trace;
+    if (!trace)
+        return;
+
+    g_mutex_lock(trace->lock);
+    struct _gfalt_trace_span *copy = gfalt_trace_current_copy(trace);
+    if (copy && bytes > copy->pub.bytes)
+        copy->pub.bytes = bytes;
+    g_mutex_unlock(trace->lock);
+}
@@ -19,10 +19,12 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <glib.h>
 #include <time.h>
 
 #include <transfer/gfal_transfer_internal.h>
+#include <common/gfal_config.h>
 #include <common/gfal_error.h>
 
 
@@ -98,6 +100,7 @@ int plugin_trigger_event(gfalt_params_t params, GQuark domain, gfal_event_side_t
     event.description = buffer;
 
     g_slist_foreach(params->event_callbacks, plugin_trigger_event_callback, &event);
+    gfalt_trace_event(params, domain, side, stage);
 
     const char* side_str;
     switch (side) {
@@ -134,11 +137,32 @@ static void plugin_trigger_monitor_callback(gpointer data, gpointer user_data)
 }
 
 
-int plugin_trigger_monitor(gfalt_params_t params, gfalt_transfer_status_t status,
+static gint64 gfalt_monotonic_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (gint64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+int plugin_trigger_monitor_ext(gfalt_params_t params, gfalt_transfer_status_t status, size_t status_size,
         const char* src, const char* dst)
 {
+    // Never write into the status of the plugin, nor read past status_size:
+    // a plugin built against an older header has a smaller structure
+    struct _gfalt_transfer_status copy;
+    gfalt_transfer_status_t copy_ptr = NULL;
+    if (status) {
+        memset(&copy, 0, sizeof(copy));
+        memcpy(&copy, status, MIN(status_size, sizeof(copy)));
+        if (copy.timestamp == 0)
+            copy.timestamp = gfalt_monotonic_now();
+        gfalt_trace_monitor(params, copy.bytes_transfered);
+        copy_ptr = &copy;
+    }
+
     struct _gfalt_monitor_data monitor;
-    monitor.status = &status;
+    monitor.status = &copy_ptr;
     monitor.src = src;
     monitor.dst = dst;
     g_slist_foreach(params->monitor_callbacks, plugin_trigger_monitor_callback, &monitor);
@@ -146,6 +170,67 @@ int plugin_trigger_monitor(gfalt_params_t params, gfalt_transfer_status_t status
 }
 
 
+int plugin_trigger_monitor(gfalt_params_t params, gfalt_transfer_status_t status,
+        const char* src, const char* dst)
+{
+    // Only the fields that existed before plugin_trigger_monitor_ext are known to be there
+    return plugin_trigger_monitor_ext(params, status,
+        G_STRUCT_OFFSET(struct _gfalt_transfer_status, start_time), src, dst);
+}
+
+
+// Time constant of the moving average of the instant rate, in nanoseconds
+#define GFALT_PERF_EWMA_TAU (5 * 1000000000LL)
+
+
+void gfalt_perf_meter_init(gfal2_context_t context, gfalt_perf_meter_t* meter)
+{
+    gint interval_ms = gfal2_get_opt_integer_with_default(context, "CORE", "TRANSFER_MONITOR_INTERVAL", 1000);
+    if (interval_ms < 0)
+        interval_ms = 0;
+
+    memset(meter, 0, sizeof(*meter));
+    meter->start = meter->last_update = gfalt_monotonic_now();
+    meter->interval = (gint64)interval_ms * 1000000LL;
+}
+
+
+gboolean gfalt_perf_meter_update(gfalt_perf_meter_t* meter, size_t bytes,
+        struct _gfalt_transfer_status* status)
+{
+    meter->done += bytes;
+    meter->done_since_last_update += bytes;
+
+    gint64 now = gfalt_monotonic_now();
+    gint64 total_time = now - meter->start;
+    gint64 inc_time = now - meter->last_update;
+    if (inc_time < meter->interval || inc_time <= 0)
+        return FALSE;
+
+    // Weight each sample by the time it covers, so irregular intervals do not bias the average
+    double instant = (double)meter->done_since_last_update * 1e9 / inc_time;
+    if (meter->last_update == meter->start) {
+        meter->rate = instant;
+    }
+    else {
+        double alpha = (double)inc_time / (inc_time + GFALT_PERF_EWMA_TAU);
+        meter->rate += alpha * (instant - meter->rate);
+    }
+
+    memset(status, 0, sizeof(*status));
+    status->start_time = meter->start;
+    status->timestamp = now;
+    status->transfer_time = (time_t)(total_time / 1000000000LL);
+    status->bytes_transfered = (size_t)meter->done;
+    status->average_baudrate = (size_t)((double)meter->done * 1e9 / total_time);
+    status->instant_baudrate = (size_t)meter->rate;
+
+    meter->done_since_last_update = 0;
+    meter->last_update = now;
+    return TRUE;
+}
+
+
 void gfalt_propagate_prefixed_error(GError **dest, GError *src, const gchar *function,
         const gchar *side, const gchar *note)
 {
@@ -0,0 +1,539 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#endif
+
+#include <checksums/checksums.h>
+#include "gfal_file_plugin.h"
+
+#ifdef __linux__
+#  if defined __GLIBC_PREREQ
+#    if __GLIBC_PREREQ(2,27)
+#      define HAVE_COPY_FILE_RANGE
+#    endif
+#  endif
+#  if !defined HAVE_COPY_FILE_RANGE && defined __NR_copy_file_range
+#    define HAVE_COPY_FILE_RANGE
+// Older glibc do not wrap the syscall
+static ssize_t copy_file_range(int fd_in, loff_t *off_in, int fd_out, loff_t *off_out, size_t len, unsigned int flags)
+{
+    return syscall(__NR_copy_file_range, fd_in, off_in, fd_out, off_out, len, flags);
+}
+#  endif
+#  define HAVE_SENDFILE
+#endif
+
+#ifdef FICLONE
+static int file_clone(int fd_dst, int fd_src)
+{
+    return ioctl(fd_dst, FICLONE, fd_src);
+}
+#else
+static int file_clone(int fd_dst, int fd_src)
+{
+    errno = ENOTTY;
+    return -1;
+}
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+static ssize_t file_copy_range(int fd_in, off_t *off_in, int fd_out, size_t len)
+{
+    loff_t off = *off_in;
+    ssize_t ret = copy_file_range(fd_in, &off, fd_out, NULL, len, 0);
+    *off_in = off;
+    return ret;
+}
+#else
+static ssize_t file_copy_range(int fd_in, off_t *off_in, int fd_out, size_t len)
+{
+    errno = ENOSYS;
+    return -1;
+}
+#endif
+
+#ifdef HAVE_SENDFILE
+static ssize_t file_sendfile(int fd_out, int fd_in, off_t *offset, size_t len)
+{
+    return sendfile(fd_out, fd_in, offset, len);
+}
+#else
+static ssize_t file_sendfile(int fd_out, int fd_in, off_t *offset, size_t len)
+{
+    errno = ENOSYS;
+    return -1;
+}
+#endif
+
+struct _gfal_file_copy_syscalls gfal_file_copy_syscalls = {
+    .clone = &file_clone,
+    .copy_range = &file_copy_range,
+    .sendfile = &file_sendfile
+};
+
+// Bytes moved by each copy_file_range/sendfile call, so cancellation,
+// timeout and the performance markers are checked regularly
+static const size_t KERNEL_COPY_CHUNK = 64 * 1024 * 1024;
+static const size_t DEFAULT_BUFFER_SIZE = 16 * 1024 * 1024;
+
+
+typedef struct {
+    gfal2_context_t context;
+    gfalt_params_t params;
+    const char *src, *dst;
+    int fd_src, fd_dst;
+    struct stat st_src;
+    // Offset into the source. The destination uses its own file position.
+    off_t offset;
+    time_t timeout;
+    // Performance markers
+    gfalt_perf_meter_t perf;
+} gfal_file_copy_t;
+
+
+// Copy implementation for one chunk. Returns the number of bytes written,
+// 0 at the end of the source, and -1 with errno set on failure
+typedef ssize_t (*gfal_file_copy_chunk_func)(gfal_file_copy_t *copy, void *buffer, size_t len);
+
+
+static const char *local_path(const char *url)
+{
+    return url + GFAL_FILE_PREFIX_LEN;
+}
+
+
+static int create_parent(gfal_file_copy_t *copy, GError **err)
+{
+    if (!gfalt_get_create_parent_dir(copy->params, NULL))
+        return 0;
+
+    char *parent = g_path_get_dirname(local_path(copy->dst));
+    int ret = g_mkdir_with_parents(parent, 0755);
+    if (ret < 0) {
+        gfalt_set_error(err, gfal2_get_plugin_file_quark(), errno, __func__,
+            GFALT_ERROR_DESTINATION, GFALT_ERROR_PARENT, "Could not create the parent directory %s: %s",
+            parent, strerror(errno));
+    }
+    g_free(parent);
+    return ret;
+}
+
+
+static int unlink_if_exists(gfal_file_copy_t *copy, GError **err)
+{
+    struct stat st;
+    if (stat(local_path(copy->dst), &st) < 0) {
+        if (errno == ENOENT)
+            return 0;
+        gfal_plugin_file_report_error(__func__, err);
+        return -1;
+    }
+
+    if (S_ISFIFO(st.st_mode) || S_ISCHR(st.st_mode) || S_ISBLK(st.st_mode) || S_ISSOCK(st.st_mode)) {
+        gfal2_log(G_LOG_LEVEL_MESSAGE, "%s is a special file (%o), so keep going", copy->dst, S_IFMT & st.st_mode);
+        return 0;
+    }
+
+    if (!gfalt_get_replace_existing_file(copy->params, NULL)) {
+        gfalt_set_error(err, gfal2_get_plugin_file_quark(), EEXIST, __func__,
+            GFALT_ERROR_DESTINATION, GFALT_ERROR_EXISTS, "The file exists and overwrite is not set");
+        return -1;
+    }
+
+    if (unlink(local_path(copy->dst)) < 0) {
+        if (errno == ENOENT)
+            return 0;
+        gfal_plugin_file_report_error(__func__, err);
+        return -1;
+    }
+    plugin_trigger_event(copy->params, gfal2_get_plugin_file_quark(),
+        GFAL_EVENT_DESTINATION, GFAL_EVENT_OVERWRITE_DESTINATION,
+        "Deleted %s", copy->dst);
+    return 0;
+}
+
+
+/*
+ * Account for a chunk, and check for cancellation and timeout
+ */
+static int copy_progress(gfal_file_copy_t *copy, size_t done, GError **err)
+{
+    struct _gfalt_transfer_status status;
+
+    copy->offset += done;
+
+    if (gfal2_is_canceled(copy->context)) {
+        gfal2_set_error(err, gfal2_get_plugin_file_quark(), ECANCELED, __func__, "Transfer canceled");
+        return -1;
+    }
+
+    if (time(NULL) >= copy->timeout) {
+        gfal2_set_error(err, gfal2_get_plugin_file_quark(), ETIMEDOUT, __func__,
+            "Transfer canceled because the timeout expired");
+        return -1;
+    }
+    else if (gfalt_perf_meter_update(&copy->perf, done, &status)) {
+        status.streams = 1;
+        plugin_trigger_monitor_ext(copy->params, &status, sizeof(status), copy->src, copy->dst);
+    }
+    return 0;
+}
+
+/*
+ * Errors meaning the kernel can not do this copy this way, but a less
+ * specialized method can
+ */
+static gboolean copy_method_unsupported(int errcode)
+{
+    switch (errcode) {
+        case ENOSYS:
+        case EXDEV:
+        case EINVAL:
+        case EBADF:
+        case EOPNOTSUPP:
+#if defined ENOTSUP && ENOTSUP != EOPNOTSUPP
+        case ENOTSUP:
+#endif
+        case ENOTTY:
+        case EPERM:
+        case ETXTBSY:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+/*
+ * Copy the rest of the source using func.
+ * Returns 0 when done, 1 if the method is not usable for this pair of files
+ * (only decided on the first call, before anything was written) and -1 on error.
+ */
+static int copy_loop(gfal_file_copy_t *copy, const char *method, gfal_file_copy_chunk_func func,
+    void *buffer, size_t chunk, gboolean can_fallback, GError **err)
+{
+    gboolean first = can_fallback;
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Local copy %s => %s using %s from offset %lld",
+        copy->src, copy->dst, method, (long long)copy->offset);
+
+    while (1) {
+        ssize_t done = func(copy, buffer, chunk);
+        if (done < 0) {
+            if (errno == EINTR)
+                continue;
+            if (first && copy_method_unsupported(errno)) {
+                gfal2_log(G_LOG_LEVEL_DEBUG, "%s not usable: %s", method, strerror(errno));
+                return 1;
+            }
+            gfal2_set_error(err, gfal2_get_plugin_file_quark(), errno, __func__,
+                "%s failed: %s", method, strerror(errno));
+            return -1;
+        }
+        if (done == 0) {
+            // Some filesystems (i.e. procfs) report a size, but copy nothing
+            if (first && copy->offset == 0 && copy->st_src.st_size > 0) {
+                gfal2_log(G_LOG_LEVEL_DEBUG, "%s copied nothing", method);
+                return 1;
+            }
+            return 0;
+        }
+        first = FALSE;
+        if (copy_progress(copy, done, err) < 0)
+            return -1;
+    }
+}
+
+
+static ssize_t copy_chunk_file_range(gfal_file_copy_t *copy, void *buffer, size_t len)
+{
+    off_t off = copy->offset;
+    return gfal_file_copy_syscalls.copy_range(copy->fd_src, &off, copy->fd_dst, len);
+}
+
+
+static ssize_t copy_chunk_sendfile(gfal_file_copy_t *copy, void *buffer, size_t len)
+{
+    off_t off = copy->offset;
+    return gfal_file_copy_syscalls.sendfile(copy->fd_dst, copy->fd_src, &off, len);
+}
+
+
+static ssize_t copy_chunk_buffer(gfal_file_copy_t *copy, void *buffer, size_t len)
+{
+    ssize_t nread;
+    if (S_ISREG(copy->st_src.st_mode))
+        nread = pread(copy->fd_src, buffer, len, copy->offset);
+    else
+        nread = read(copy->fd_src, buffer, len);
+    if (nread <= 0)
+        return nread;
+
+    ssize_t written = 0;
+    while (written < nread) {
+        ssize_t ret = write(copy->fd_dst, (char*)buffer + written, nread - written);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        written += ret;
+    }
+    return nread;
+}
+
+static int copy_chunk_uring(const char *data, size_t len, void *user_data, GError **err)
+{
+    return copy_progress((gfal_file_copy_t*) user_data, len, err);
+}
+
+/*
+ * Pipelined read/write of the rest of the source, with io_uring
+ * Returns 1 if io_uring can not be used
+ */
+static int copy_uring(gfal_file_copy_t *copy, GError **err)
+{
+    struct stat st_dst;
+    if (fstat(copy->fd_dst, &st_dst) < 0 || !S_ISREG(st_dst.st_mode))
+        return 1;
+    off_t dst_offset = lseek(copy->fd_dst, 0, SEEK_CUR);
+    if (dst_offset < 0)
+        return 1;
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Local copy %s => %s using io_uring from offset %lld",
+        copy->src, copy->dst, (long long)copy->offset);
+    return gfal_file_uring_pipeline(copy->context, copy->fd_src, copy->offset, -1,
+        copy->fd_dst, dst_offset, copy_chunk_uring, copy, err);
+}
+
+/*
+ * Try, in order: reflink, copy_file_range, sendfile, io_uring if enabled, and a read/write loop.
+ * All of them are offset based on the source, so a method can pick up
+ * where the previous one gave up.
+ */
+static int copy_data(gfal_file_copy_t *copy, GError **err)
+{
+    int ret;
+    const gboolean regular = S_ISREG(copy->st_src.st_mode);
+
+    if (regular && gfal2_get_opt_boolean_with_default(copy->context, "FILE PLUGIN", "COPY_REFLINK", TRUE)) {
+        if (gfal_file_copy_syscalls.clone(copy->fd_dst, copy->fd_src) == 0) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Local copy %s => %s done with a reflink", copy->src, copy->dst);
+            copy->offset = copy->st_src.st_size;
+            if (lseek(copy->fd_dst, 0, SEEK_END) < 0) {
+                gfal_plugin_file_report_error(__func__, err);
+                return -1;
+            }
+            return 0;
+        }
+        gfal2_log(G_LOG_LEVEL_DEBUG, "reflink not usable: %s", strerror(errno));
+    }
+
+    if (regular) {
+        ret = copy_loop(copy, "copy_file_range", copy_chunk_file_range, NULL, KERNEL_COPY_CHUNK, TRUE, err);
+        if (ret <= 0)
+            return ret;
+        ret = copy_loop(copy, "sendfile", copy_chunk_sendfile, NULL, KERNEL_COPY_CHUNK, TRUE, err);
+        if (ret <= 0)
+            return ret;
+        if (gfal_file_uring_enabled(copy->context)) {
+            ret = copy_uring(copy, err);
+            if (ret <= 0)
+                return ret;
+        }
+    }
+
+    size_t buffersize = gfal2_get_opt_integer_with_default(copy->context, "FILE PLUGIN", "COPY_BUFFERSIZE",
+        DEFAULT_BUFFER_SIZE);
+    void *buffer = g_try_malloc(buffersize);
+    if (!buffer) {
+        gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOMEM, __func__,
+            "Failed to allocate a copy buffer of %zu bytes", buffersize);
+        return -1;
+    }
+    ret = copy_loop(copy, "read/write", copy_chunk_buffer, buffer, buffersize, FALSE, err);
+    g_free(buffer);
+    return ret;
+}
+
+
+static int copy_file(gfal_file_copy_t *copy, GError **err)
+{
+    GError *nested_error = NULL;
+
+    plugin_trigger_event(copy->params, gfal2_get_plugin_file_quark(),
+        GFAL_EVENT_NONE, GFAL_EVENT_TRANSFER_ENTER,
+        "%s => %s", copy->src, copy->dst);
+    plugin_trigger_event(copy->params, gfal2_get_plugin_file_quark(),
+        GFAL_EVENT_NONE, GFAL_EVENT_TRANSFER_TYPE,
+        "%s", GFAL_TRANSFER_TYPE_STREAMED);
+
+    copy->fd_src = open(local_path(copy->src), O_RDONLY);
+    if (copy->fd_src < 0 || fstat(copy->fd_src, &copy->st_src) < 0) {
+        gfalt_set_error(err, gfal2_get_plugin_file_quark(), errno, __func__,
+            GFALT_ERROR_SOURCE, GFALT_ERROR_TRANSFER, "Could not open source: %s", strerror(errno));
+        if (copy->fd_src >= 0)
+            close(copy->fd_src);
+        return -1;
+    }
+
+    // Same flags as the core streamed copy: unless in strict mode, an existing
+    // destination was removed already, so there is nothing to truncate
+    copy->fd_dst = open(local_path(copy->dst), O_WRONLY | O_CREAT, 0755);
+    if (copy->fd_dst < 0) {
+        gfalt_set_error(err, gfal2_get_plugin_file_quark(), errno, __func__,
+            GFALT_ERROR_DESTINATION, GFALT_ERROR_TRANSFER, "Could not open destination: %s", strerror(errno));
+        close(copy->fd_src);
+        return -1;
+    }
+
+    copy->offset = 0;
+    gfalt_perf_meter_init(copy->context, &copy->perf);
+    copy->timeout = time(NULL) + gfalt_get_timeout(copy->params, NULL);
+
+    copy_data(copy, &nested_error);
+
+    if (close(copy->fd_dst) < 0 && nested_error == NULL) {
+        gfalt_set_error(&nested_error, gfal2_get_plugin_file_quark(), errno, __func__,
+            GFALT_ERROR_DESTINATION, GFALT_ERROR_TRANSFER, "Could not close destination: %s", strerror(errno));
+    }
+    close(copy->fd_src);
+
+    if (nested_error) {
+        gfal2_propagate_prefixed_error(err, nested_error, __func__);
+        return -1;
+    }
+
+    plugin_trigger_event(copy->params, gfal2_get_plugin_file_quark(), GFAL_EVENT_NONE,
+        GFAL_EVENT_TRANSFER_EXIT, "%s => %s", copy->src, copy->dst);
+    return 0;
+}
+
+
+int gfal_plugin_file_check_url_transfer(plugin_handle handle, gfal2_context_t context,
+    const char *src, const char *dst, gfal_url2_check check)
+{
+    if (check != GFAL_FILE_COPY || src == NULL || dst == NULL)
+        return 0;
+    if (!gfal2_get_opt_boolean_with_default(context, "FILE PLUGIN", "NATIVE_COPY", TRUE))
+        return 0;
+    // Direct IO is only honored by the core streamed copy
+    if (gfal2_get_opt_boolean_with_default(context, "CORE", "COPY_DIRECT_IO", FALSE))
+        return 0;
+    return gfal_is_file(src) && gfal_is_file(dst);
+}
+
+
+int gfal_plugin_file_copy(plugin_handle handle, gfal2_context_t context, gfalt_params_t params,
+    const char *src, const char *dst, GError **err)
+{
+    GError *nested_error = NULL;
+    gfal_file_copy_t copy;
+    memset(&copy, 0, sizeof(copy));
+    copy.context = context;
+    copy.params = params;
+    copy.src = src;
+    copy.dst = dst;
+
+    char checksum_type[1024] = {0};
+    char user_checksum[1024] = {0};
+    char source_checksum[1024] = {0};
+    gboolean is_strict_mode = gfalt_get_strict_copy_mode(params, NULL);
+    gfalt_checksum_mode_t checksum_mode = GFALT_CHECKSUM_NONE;
+
+    if (!is_strict_mode) {
+        checksum_mode = gfalt_get_checksum(params,
+            checksum_type, sizeof(checksum_type),
+            user_checksum, sizeof(user_checksum),
+            NULL);
+    }
+
+    if (checksum_type[0] == '\0') {
+        g_strlcpy(checksum_type, "ADLER32", sizeof(checksum_type));
+    }
+
+    // Source checksum
+    if (checksum_mode & GFALT_CHECKSUM_SOURCE) {
+        plugin_trigger_event(params, gfal2_get_plugin_file_quark(), GFAL_EVENT_SOURCE, GFAL_EVENT_CHECKSUM_ENTER, "");
+        gfal2_checksum(context, src, checksum_type, 0, 0, source_checksum, sizeof(source_checksum), &nested_error);
+        if (nested_error != NULL) {
+            gfal2_propagate_prefixed_error_extended(err, nested_error, __func__, "Could not get the source checksum: ");
+            return -1;
+        }
+        plugin_trigger_event(params, gfal2_get_plugin_file_quark(), GFAL_EVENT_SOURCE, GFAL_EVENT_CHECKSUM_EXIT, "");
+
+        if (user_checksum[0] && gfal_compare_checksums(user_checksum, source_checksum, sizeof(source_checksum)) != 0) {
+            gfalt_set_error(err, gfal2_get_plugin_file_quark(), EIO, __func__,
+                GFALT_ERROR_SOURCE, GFALT_ERROR_CHECKSUM_MISMATCH,
+                "Source checksum and user-specified checksum do not match: %s != %s", source_checksum, user_checksum);
+            return -1;
+        }
+    }
+
+    if (!is_strict_mode) {
+        if (create_parent(&copy, &nested_error) < 0 || unlink_if_exists(&copy, &nested_error) < 0) {
+            gfal2_propagate_prefixed_error(err, nested_error, __func__);
+            return -1;
+        }
+    }
+
+    if (copy_file(&copy, &nested_error) < 0) {
+        gfal2_propagate_prefixed_error(err, nested_error, __func__);
+        return -1;
+    }
+
+    // Destination checksum
+    if (checksum_mode & GFALT_CHECKSUM_TARGET) {
+        char destination_checksum[1024];
+        const char *compare_against = user_checksum[0] ? user_checksum : source_checksum;
+        const char *compare_side = user_checksum[0] ? "User defined" : "Source";
+
+        plugin_trigger_event(params, gfal2_get_plugin_file_quark(), GFAL_EVENT_DESTINATION, GFAL_EVENT_CHECKSUM_ENTER, "");
+        gfal2_checksum(context, dst, checksum_type, 0, 0, destination_checksum, sizeof(destination_checksum), &nested_error);
+        if (nested_error != NULL) {
+            gfal2_propagate_prefixed_error_extended(err, nested_error, __func__, "Could not get the destination checksum: ");
+            return -1;
+        }
+        plugin_trigger_event(params, gfal2_get_plugin_file_quark(), GFAL_EVENT_DESTINATION, GFAL_EVENT_CHECKSUM_EXIT, "");
+
+        if (gfal_compare_checksums(compare_against, destination_checksum, sizeof(destination_checksum)) != 0) {
+            gfalt_set_error(err, gfal2_get_plugin_file_quark(), EIO, __func__,
+                GFALT_ERROR_DESTINATION, GFALT_ERROR_CHECKSUM_MISMATCH,
+                "%s checksum and destination checksum do not match: %s != %s",
+                compare_side, compare_against, destination_checksum);
+            return -1;
+        }
+    }
+
+    return 0;
+}
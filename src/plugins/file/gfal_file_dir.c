@@ -0,0 +1,496 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <glib.h>
+
+#ifdef __linux__
+#include <sys/statfs.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#endif
+
+#include "gfal_file_plugin.h"
+
+// Requested stat fields
+#define FIELD_TYPE      0x001
+#define FIELD_MODE      0x002
+#define FIELD_NLINK     0x004
+#define FIELD_UID       0x008
+#define FIELD_GID       0x010
+#define FIELD_ATIME     0x020
+#define FIELD_MTIME     0x040
+#define FIELD_CTIME     0x080
+#define FIELD_INO       0x100
+#define FIELD_SIZE      0x200
+#define FIELD_BLOCKS    0x400
+#define FIELD_ALL       0x7FF
+
+static const size_t DEFAULT_DENTS_BUFFER_SIZE = 1024 * 1024;
+static const int DEFAULT_PARALLEL_STAT = 8;
+
+
+typedef struct {
+    const char *name;
+    unsigned field;
+} stat_field_name;
+
+
+static const stat_field_name stat_field_names[] = {
+    {"type", FIELD_TYPE}, {"mode", FIELD_MODE}, {"nlink", FIELD_NLINK},
+    {"uid", FIELD_UID}, {"gid", FIELD_GID}, {"atime", FIELD_ATIME},
+    {"mtime", FIELD_MTIME}, {"ctime", FIELD_CTIME}, {"ino", FIELD_INO},
+    {"size", FIELD_SIZE}, {"blocks", FIELD_BLOCKS},
+    {NULL, 0}
+};
+
+// One entry of the current batch
+typedef struct {
+    struct dirent *dirent;
+    struct stat st;
+    int stat_errno;
+} gfal_file_dir_entry;
+
+
+typedef struct _gfal_file_dir {
+    int fd;
+    unsigned fields;
+#ifdef __linux__
+    // getdents64 batch
+    char *buffer;
+    size_t buffer_size;
+    long pos, end;
+    gboolean eof;
+    struct dirent dirent;
+#else
+    DIR *dir;
+#endif
+    // Network filesystems, stat all the entries of a batch in parallel
+    GThreadPool *pool;
+    gfal_file_dir_entry *entries;
+    size_t n_entries, next_entry, max_entries;
+    GMutex *mutex;
+    GCond *cond;
+    int pending;
+} gfal_file_dir_t;
+
+
+typedef struct {
+    gfal_file_dir_t *dir;
+    size_t start, end;
+} gfal_file_dir_slice;
+
+
+static unsigned parse_stat_fields(gfal2_context_t context)
+{
+    gsize n_fields = 0, i;
+    gchar **fields = gfal2_get_opt_string_list(context, "FILE PLUGIN", "READDIRPP_STAT_FIELDS", &n_fields, NULL);
+    if (fields == NULL || n_fields == 0) {
+        g_strfreev(fields);
+        return FIELD_ALL;
+    }
+
+    unsigned mask = 0;
+    for (i = 0; i < n_fields; ++i) {
+        const stat_field_name *f;
+        for (f = stat_field_names; f->name != NULL; ++f) {
+            if (g_ascii_strcasecmp(g_strstrip(fields[i]), f->name) == 0)
+                break;
+        }
+        if (f->name)
+            mask |= f->field;
+        else
+            gfal2_log(G_LOG_LEVEL_WARNING, "Unknown READDIRPP_STAT_FIELDS entry: %s", fields[i]);
+    }
+    g_strfreev(fields);
+    return mask ? mask : FIELD_ALL;
+}
+
+/*
+ * Filesystems where each stat is a round trip to a server
+ */
+static gboolean is_network_filesystem(int fd)
+{
+#ifdef __linux__
+    struct statfs stfs;
+    if (fstatfs(fd, &stfs) < 0)
+        return FALSE;
+    switch ((unsigned long) stfs.f_type) {
+        case 0x6969:        // NFS
+        case 0x00c36400:    // CephFS
+        case 0x0BD00BD0:    // Lustre
+        case 0x47504653:    // GPFS
+        case 0xFF534D42:    // CIFS
+        case 0xFE534D42:    // SMB2
+        case 0x65735546:    // FUSE
+        case 0x5346414F:    // AFS
+        case 0x19830326:    // BeeGFS
+        case 0xAAD7AAEA:    // PanFS
+            return TRUE;
+        default:
+            return FALSE;
+    }
+#else
+    return FALSE;
+#endif
+}
+
+/*
+ * stat a directory entry, asking only for the requested fields when the kernel supports statx
+ */
+static int stat_entry(int dirfd, const struct dirent *entry, unsigned fields, struct stat *st)
+{
+    memset(st, 0, sizeof(*st));
+
+#if defined(DT_UNKNOWN) && defined(DTTOIF)
+    // Nothing needed beyond what getdents already said.
+    // For a symlink stat reports its target, which getdents does not know
+    if ((fields & ~(FIELD_TYPE | FIELD_INO)) == 0 &&
+        entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK) {
+        st->st_mode = DTTOIF(entry->d_type);
+        st->st_ino = entry->d_ino;
+        return 0;
+    }
+#endif
+
+#ifdef STATX_BASIC_STATS
+    static gint statx_unsupported = 0;
+    if (!g_atomic_int_get(&statx_unsupported)) {
+        unsigned mask = 0;
+        if (fields & FIELD_TYPE) mask |= STATX_TYPE;
+        if (fields & FIELD_MODE) mask |= STATX_MODE;
+        if (fields & FIELD_NLINK) mask |= STATX_NLINK;
+        if (fields & FIELD_UID) mask |= STATX_UID;
+        if (fields & FIELD_GID) mask |= STATX_GID;
+        if (fields & FIELD_ATIME) mask |= STATX_ATIME;
+        if (fields & FIELD_MTIME) mask |= STATX_MTIME;
+        if (fields & FIELD_CTIME) mask |= STATX_CTIME;
+        if (fields & FIELD_INO) mask |= STATX_INO;
+        if (fields & FIELD_SIZE) mask |= STATX_SIZE;
+        if (fields & FIELD_BLOCKS) mask |= STATX_BLOCKS;
+
+        struct statx stx;
+        int ret = statx(dirfd, entry->d_name, AT_NO_AUTOMOUNT, mask, &stx);
+        // Dangling symlink
+        if (ret < 0 && errno == ENOENT)
+            ret = statx(dirfd, entry->d_name, AT_NO_AUTOMOUNT | AT_SYMLINK_NOFOLLOW, mask, &stx);
+        if (ret == 0) {
+            st->st_dev = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+            st->st_rdev = makedev(stx.stx_rdev_major, stx.stx_rdev_minor);
+            st->st_blksize = stx.stx_blksize;
+            st->st_mode = stx.stx_mode;
+            if (stx.stx_mask & STATX_NLINK) st->st_nlink = stx.stx_nlink;
+            if (stx.stx_mask & STATX_UID) st->st_uid = stx.stx_uid;
+            if (stx.stx_mask & STATX_GID) st->st_gid = stx.stx_gid;
+            if (stx.stx_mask & STATX_INO) st->st_ino = stx.stx_ino;
+            if (stx.stx_mask & STATX_SIZE) st->st_size = stx.stx_size;
+            if (stx.stx_mask & STATX_BLOCKS) st->st_blocks = stx.stx_blocks;
+            if (stx.stx_mask & STATX_ATIME) {
+                st->st_atim.tv_sec = stx.stx_atime.tv_sec;
+                st->st_atim.tv_nsec = stx.stx_atime.tv_nsec;
+            }
+            if (stx.stx_mask & STATX_MTIME) {
+                st->st_mtim.tv_sec = stx.stx_mtime.tv_sec;
+                st->st_mtim.tv_nsec = stx.stx_mtime.tv_nsec;
+            }
+            if (stx.stx_mask & STATX_CTIME) {
+                st->st_ctim.tv_sec = stx.stx_ctime.tv_sec;
+                st->st_ctim.tv_nsec = stx.stx_ctime.tv_nsec;
+            }
+            return 0;
+        }
+        if (errno != ENOSYS)
+            return -1;
+        g_atomic_int_set(&statx_unsupported, 1);
+    }
+#endif
+
+    int ret = fstatat(dirfd, entry->d_name, st, 0);
+    if (ret < 0 && errno == ENOENT)
+        ret = fstatat(dirfd, entry->d_name, st, AT_SYMLINK_NOFOLLOW);
+    return ret;
+}
+
+
+static void stat_slice(gpointer data, gpointer user_data)
+{
+    gfal_file_dir_slice *slice = (gfal_file_dir_slice*) data;
+    gfal_file_dir_t *dir = slice->dir;
+    size_t i;
+
+    for (i = slice->start; i < slice->end; ++i) {
+        gfal_file_dir_entry *entry = &dir->entries[i];
+        entry->stat_errno = 0;
+        if (stat_entry(dir->fd, entry->dirent, dir->fields, &entry->st) < 0)
+            entry->stat_errno = errno;
+    }
+    g_free(slice);
+
+    g_mutex_lock(dir->mutex);
+    if (--dir->pending == 0)
+        g_cond_broadcast(dir->cond);
+    g_mutex_unlock(dir->mutex);
+}
+
+
+#ifdef __linux__
+
+// As returned by getdents64, not exposed by older glibc
+struct linux_dirent64 {
+    guint64 d_ino;
+    gint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+/*
+ * Next entry of the directory, refilling the batch when needed.
+ * Returns NULL at the end, or on error with errno set
+ */
+static struct dirent *dir_next(gfal_file_dir_t *dir)
+{
+    if (dir->pos >= dir->end) {
+        if (dir->eof) {
+            errno = 0;
+            return NULL;
+        }
+        long nread = syscall(SYS_getdents64, dir->fd, dir->buffer, dir->buffer_size);
+        if (nread <= 0) {
+            dir->eof = TRUE;
+            if (nread == 0)
+                errno = 0;
+            return NULL;
+        }
+        dir->pos = 0;
+        dir->end = nread;
+    }
+
+    struct linux_dirent64 *raw = (struct linux_dirent64*) (dir->buffer + dir->pos);
+    dir->pos += raw->d_reclen;
+
+    dir->dirent.d_ino = raw->d_ino;
+    dir->dirent.d_off = raw->d_off;
+    dir->dirent.d_reclen = sizeof(struct dirent);
+    dir->dirent.d_type = raw->d_type;
+    g_strlcpy(dir->dirent.d_name, raw->d_name, sizeof(dir->dirent.d_name));
+    return &dir->dirent;
+}
+
+/*
+ * Take the rest of the current getdents batch, or the next one, and stat all of it in parallel
+ */
+static int dir_load_batch(gfal_file_dir_t *dir)
+{
+    size_t i;
+    for (i = 0; i < dir->n_entries; ++i)
+        g_free(dir->entries[i].dirent);
+    dir->n_entries = dir->next_entry = 0;
+
+    struct dirent *entry = dir_next(dir);
+    while (entry != NULL) {
+        if (dir->n_entries == dir->max_entries) {
+            dir->max_entries = MAX(64, dir->max_entries * 2);
+            dir->entries = g_renew(gfal_file_dir_entry, dir->entries, dir->max_entries);
+        }
+        dir->entries[dir->n_entries].dirent = g_memdup(entry, sizeof(struct dirent));
+        ++dir->n_entries;
+        if (dir->pos >= dir->end)
+            break;
+        entry = dir_next(dir);
+    }
+    if (dir->n_entries == 0)
+        return errno ? -1 : 0;
+
+    const int n_threads = g_thread_pool_get_max_threads(dir->pool);
+    const size_t per_slice = MAX(1, (dir->n_entries + n_threads - 1) / n_threads);
+
+    g_mutex_lock(dir->mutex);
+    for (i = 0; i < dir->n_entries; i += per_slice) {
+        gfal_file_dir_slice *slice = g_new0(gfal_file_dir_slice, 1);
+        slice->dir = dir;
+        slice->start = i;
+        slice->end = MIN(i + per_slice, dir->n_entries);
+        ++dir->pending;
+        g_thread_pool_push(dir->pool, slice, NULL);
+    }
+    while (dir->pending > 0)
+        g_cond_wait(dir->cond, dir->mutex);
+    g_mutex_unlock(dir->mutex);
+    return 0;
+}
+
+#else
+
+static struct dirent *dir_next(gfal_file_dir_t *dir)
+{
+    errno = 0;
+    return readdir(dir->dir);
+}
+
+#endif
+
+
+gfal_file_handle gfal_plugin_file_opendir(plugin_handle plugin_data, const char *path, GError **err)
+{
+    gfal2_context_t context = (gfal2_context_t) plugin_data;
+    gfal_file_dir_t *dir = g_new0(gfal_file_dir_t, 1);
+
+#ifdef __linux__
+    dir->fd = open(path + GFAL_FILE_PREFIX_LEN, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir->fd < 0) {
+        gfal_plugin_file_report_error(__func__, err);
+        g_free(dir);
+        return NULL;
+    }
+    dir->buffer_size = gfal2_get_opt_integer_with_default(context, "FILE PLUGIN", "READDIRPP_BUFFER_SIZE",
+        DEFAULT_DENTS_BUFFER_SIZE);
+    dir->buffer_size = MAX(dir->buffer_size, 32768);
+    dir->buffer = g_malloc(dir->buffer_size);
+
+    const int n_threads = gfal2_get_opt_integer_with_default(context, "FILE PLUGIN", "READDIRPP_PARALLEL_STAT",
+        DEFAULT_PARALLEL_STAT);
+    if (n_threads > 1 && is_network_filesystem(dir->fd)) {
+        dir->pool = g_thread_pool_new(stat_slice, NULL, n_threads, FALSE, NULL);
+        dir->mutex = g_mutex_new();
+        dir->cond = g_cond_new();
+    }
+#else
+    dir->dir = opendir(path + GFAL_FILE_PREFIX_LEN);
+    if (dir->dir == NULL) {
+        gfal_plugin_file_report_error(__func__, err);
+        g_free(dir);
+        return NULL;
+    }
+    dir->fd = dirfd(dir->dir);
+#endif
+
+    dir->fields = parse_stat_fields(context);
+    return gfal_file_handle_new2(gfal_file_plugin_getName(), (gpointer) dir, NULL, path);
+}
+
+
+struct dirent *gfal_plugin_file_readdir(plugin_handle plugin_data, gfal_file_handle fh, GError **err)
+{
+    gfal_file_dir_t *dir = gfal_file_handle_get_fdesc(fh);
+    struct dirent *res;
+
+    if (dir->pool && dir->next_entry < dir->n_entries)
+        return dir->entries[dir->next_entry++].dirent;
+
+    res = dir_next(dir);
+    if (res == NULL && errno) {
+        gfal_plugin_file_report_error(__func__, err);
+    }
+    return res;
+}
+
+
+struct dirent *gfal_plugin_file_readdirpp(plugin_handle plugin_data, gfal_file_handle fh, struct stat *st,
+    GError **err)
+{
+    gfal_file_dir_t *dir = gfal_file_handle_get_fdesc(fh);
+
+    while (1) {
+        struct dirent *res = NULL;
+        int stat_errno = 0;
+
+#ifdef __linux__
+        if (dir->pool) {
+            if (dir->next_entry >= dir->n_entries && dir_load_batch(dir) < 0) {
+                gfal_plugin_file_report_error(__func__, err);
+                return NULL;
+            }
+            if (dir->next_entry >= dir->n_entries)
+                return NULL;
+            gfal_file_dir_entry *entry = &dir->entries[dir->next_entry++];
+            res = entry->dirent;
+            stat_errno = entry->stat_errno;
+            *st = entry->st;
+        }
+        else
+#endif
+        {
+            res = dir_next(dir);
+            if (res == NULL) {
+                if (errno)
+                    gfal_plugin_file_report_error(__func__, err);
+                return NULL;
+            }
+            if (stat_entry(dir->fd, res, dir->fields, st) < 0)
+                stat_errno = errno;
+        }
+
+        // Removed since it was listed
+        if (stat_errno == ENOENT)
+            continue;
+        // One entry that can not be stat'ed must not hide the rest of the listing,
+        // so return it with whatever getdents said
+        if (stat_errno) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Could not stat %s: %s", res->d_name, strerror(stat_errno));
+            memset(st, 0, sizeof(*st));
+#if defined(DT_UNKNOWN) && defined(DTTOIF)
+            if (res->d_type != DT_UNKNOWN)
+                st->st_mode = DTTOIF(res->d_type);
+#endif
+            st->st_ino = res->d_ino;
+        }
+        return res;
+    }
+}
+
+
+int gfal_plugin_file_closedir(plugin_handle plugin_data, gfal_file_handle fh, GError **err)
+{
+    gfal_file_dir_t *dir = gfal_file_handle_get_fdesc(fh);
+    size_t i;
+
+#ifdef __linux__
+    const int res = close(dir->fd);
+#else
+    const int res = closedir(dir->dir);
+#endif
+    if (res < 0) {
+        gfal_plugin_file_report_error(__func__, err);
+        return res;
+    }
+
+    if (dir->pool) {
+        g_thread_pool_free(dir->pool, FALSE, TRUE);
+        g_mutex_free(dir->mutex);
+        g_cond_free(dir->cond);
+    }
+    for (i = 0; i < dir->n_entries; ++i)
+        g_free(dir->entries[i].dirent);
+    g_free(dir->entries);
+#ifdef __linux__
+    g_free(dir->buffer);
+#endif
+    g_free(dir);
+    gfal_file_handle_delete(fh);
+    return res;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GFAL_FILE_PLUGIN_H
+#define GFAL_FILE_PLUGIN_H
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <gfal_plugins_api.h>
+
+// Length of the file:// prefix
+#define GFAL_FILE_PREFIX_LEN 7
+
+// Helpers
+const char *gfal_file_plugin_getName();
+
+GQuark gfal2_get_plugin_file_quark();
+
+int gfal_is_file(const char *url);
+
+void gfal_plugin_file_report_error(const char* funcname, GError** err);
+
+// Directories, see gfal_file_dir.c
+gfal_file_handle gfal_plugin_file_opendir(plugin_handle plugin_data, const char *path, GError **err);
+
+struct dirent *gfal_plugin_file_readdir(plugin_handle plugin_data, gfal_file_handle fh, GError **err);
+
+struct dirent *gfal_plugin_file_readdirpp(plugin_handle plugin_data, gfal_file_handle fh, struct stat *st,
+    GError **err);
+
+int gfal_plugin_file_closedir(plugin_handle plugin_data, gfal_file_handle fh, GError **err);
+
+// Transfer
+int gfal_plugin_file_check_url_transfer(plugin_handle handle, gfal2_context_t context,
+    const char *src, const char *dst, gfal_url2_check check);
+
+int gfal_plugin_file_copy(plugin_handle handle, gfal2_context_t context, gfalt_params_t params,
+    const char *src, const char *dst, GError **err);
+
+// Kernel copy methods, tried in this order before a read/write loop.
+// They fail with errno ENOTTY or ENOSYS where not available.
+// Replaceable, so the tests can exercise the fallbacks.
+struct _gfal_file_copy_syscalls {
+    // FICLONE
+    int (*clone)(int fd_dst, int fd_src);
+    // copy_file_range, at the current position of fd_out
+    ssize_t (*copy_range)(int fd_in, off_t *off_in, int fd_out, size_t len);
+    ssize_t (*sendfile)(int fd_out, int fd_in, off_t *offset, size_t len);
+};
+
+extern struct _gfal_file_copy_syscalls gfal_file_copy_syscalls;
+
+// io_uring backend, see gfal_file_uring.c
+typedef struct _gfal_file_uring gfal_file_uring_t;
+
+// Called for each chunk of data, in order when reading only.
+// Returns < 0 and sets err to stop the pipeline.
+typedef int (*gfal_file_uring_chunk_func)(const char *data, size_t len, void *user_data, GError **err);
+
+gboolean gfal_file_uring_enabled(gfal2_context_t context);
+
+// Returns NULL, with errno set, if io_uring is not available
+gfal_file_uring_t *gfal_file_uring_new(unsigned entries);
+
+void gfal_file_uring_free(gfal_file_uring_t *ring);
+
+// Ring owned by the calling thread, created on first use and freed when the thread exits.
+// Returns NULL, with errno set, if io_uring is not available
+gfal_file_uring_t *gfal_file_uring_thread(void);
+
+// Same as pread/pwrite, or read/write if offset is negative
+// ring is the one of gfal_file_uring_thread, which is discarded if a completion can not be reaped
+ssize_t gfal_file_uring_rw(gfal_file_uring_t *ring, gboolean write_op, int fd, void *buffer, size_t len,
+    off_t offset);
+
+// Read length bytes (until the end of the file if negative) from fd_src starting at offset,
+// keeping IO_URING_QUEUE_DEPTH reads in flight. If fd_dst is >= 0, the data is written there at dst_offset.
+// Returns 0 on success, -1 on error, and 1 if io_uring can not be used and nothing was done.
+int gfal_file_uring_pipeline(gfal2_context_t context, int fd_src, off_t offset, off_t length,
+    int fd_dst, off_t dst_offset, gfal_file_uring_chunk_func func, void *user_data, GError **err);
+
+#endif // GFAL_FILE_PLUGIN_H
@@ -41,6 +41,7 @@
 #include <checksums/checksums.h>
 #include <uri/gfal2_uri.h>
 #include <future/glib.h>
+#include "gfal_file_plugin.h"
 
 typedef struct _chksum_interface{
     // init checksum handle
@@ -52,7 +53,7 @@ typedef struct _chksum_interface{
 } Chksum_interface;
 
 
-static const int FILE_PREFIX_LEN = 7; // file://
+static const int FILE_PREFIX_LEN = GFAL_FILE_PREFIX_LEN; // file://
 
 
 // File plugin GQuark
@@ -70,7 +71,7 @@ const char* gfal_file_plugin_getName(){
 /*
  * Return 1 if url is a file url
  */
-static int gfal_is_file(const char *url) {
+int gfal_is_file(const char *url) {
     GError *err = NULL;
     gfal2_uri *parsed = gfal2_parse_uri(url, &err);
     if (!parsed) {
@@ -240,28 +241,6 @@ int gfal_plugin_file_unlink(plugin_handle plugin_data, const char *path, GError
 }
 
 
-gfal_file_handle gfal_plugin_file_opendir(plugin_handle plugin_data, const char *path, GError **err)
-{
-    DIR *ret = opendir(path + FILE_PREFIX_LEN);
-    gfal_file_handle resu = NULL;
-    if (ret == NULL) {
-        gfal_plugin_file_report_error(__func__, err);
-    }
-    if (ret)
-        resu = gfal_file_handle_new2(gfal_file_plugin_getName(), (gpointer) ret, NULL, path);
-    return resu;
-}
-
-struct dirent *gfal_plugin_file_readdir(plugin_handle plugin_data, gfal_file_handle fh, GError **err)
-{
-    errno = 0;
-    struct dirent *res = readdir(gfal_file_handle_get_fdesc(fh));
-    if (res == NULL && errno) {
-        gfal_plugin_file_report_error(__func__, err);
-    }
-    return res;
-}
-
 gfal_file_handle gfal_plugin_file_open(plugin_handle plugin_data, const char *path, int flag, mode_t mode, GError **err)
 {
     errno = 0;
@@ -270,11 +249,19 @@ gfal_file_handle gfal_plugin_file_open(plugin_handle plugin_data, const char *pa
         gfal_plugin_file_report_error(__func__, err);
         return NULL;
     } else {
-        return gfal_file_handle_new(gfal_file_plugin_getName(), GINT_TO_POINTER(ret));
+        // The handle only remembers whether to use io_uring, the ring belongs to the thread
+        gpointer use_uring = GINT_TO_POINTER(gfal_file_uring_enabled((gfal2_context_t) plugin_data));
+        return gfal_file_handle_new2(gfal_file_plugin_getName(), GINT_TO_POINTER(ret), use_uring, NULL);
     }
 }
 
 
+static gfal_file_uring_t *gfal_plugin_file_ring(gfal_file_handle fh)
+{
+    return gfal_file_handle_get_user_data(fh) ? gfal_file_uring_thread() : NULL;
+}
+
+
 /*
  *  map the gfal_read call to the local read call for file://
  * */
@@ -282,7 +269,8 @@ ssize_t gfal_plugin_file_read(plugin_handle plugin_data, gfal_file_handle fh, vo
 {
     errno = 0;
     const int fd = GPOINTER_TO_INT(gfal_file_handle_get_fdesc(fh));
-    const int ret = read(fd, buff, s_buff);
+    gfal_file_uring_t *ring = gfal_plugin_file_ring(fh);
+    const ssize_t ret = ring ? gfal_file_uring_rw(ring, FALSE, fd, buff, s_buff, -1) : read(fd, buff, s_buff);
     if (ret < 0)
         gfal_plugin_file_report_error(__func__, err);
     return ret;
@@ -296,7 +284,8 @@ ssize_t gfal_plugin_file_pread(plugin_handle plugin_data, gfal_file_handle fh, v
 {
     errno = 0;
     const int fd = GPOINTER_TO_INT(gfal_file_handle_get_fdesc(fh));
-    const ssize_t ret = pread(fd, buff, s_buff, offset);
+    gfal_file_uring_t *ring = gfal_plugin_file_ring(fh);
+    const ssize_t ret = ring ? gfal_file_uring_rw(ring, FALSE, fd, buff, s_buff, offset) : pread(fd, buff, s_buff, offset);
     if (ret < 0)
         gfal_plugin_file_report_error(__func__, err);
     return ret;
@@ -318,7 +307,9 @@ ssize_t gfal_plugin_file_write(plugin_handle plugin_data, gfal_file_handle fh, c
     GError **err)
 {
     errno = 0;
-    const int ret = write(GPOINTER_TO_INT(gfal_file_handle_get_fdesc(fh)), buff, s_buff);
+    const int fd = GPOINTER_TO_INT(gfal_file_handle_get_fdesc(fh));
+    gfal_file_uring_t *ring = gfal_plugin_file_ring(fh);
+    const ssize_t ret = ring ? gfal_file_uring_rw(ring, TRUE, fd, (void*) buff, s_buff, -1) : write(fd, buff, s_buff);
     if (ret < 0)
         gfal_plugin_file_report_error(__func__, err);
     return ret;
@@ -331,7 +322,9 @@ ssize_t gfal_plugin_file_pwrite(plugin_handle plugin_data, gfal_file_handle fh,
     off_t offset, GError **err)
 {
     errno = 0;
-    const ssize_t ret = pwrite(GPOINTER_TO_INT(gfal_file_handle_get_fdesc(fh)), buff, s_buff, offset);
+    const int fd = GPOINTER_TO_INT(gfal_file_handle_get_fdesc(fh));
+    gfal_file_uring_t *ring = gfal_plugin_file_ring(fh);
+    const ssize_t ret = ring ? gfal_file_uring_rw(ring, TRUE, fd, (void*) buff, s_buff, offset) : pwrite(fd, buff, s_buff, offset);
     if (ret < 0)
         gfal_plugin_file_report_error(__func__, err);
     return ret;
@@ -375,19 +368,6 @@ int gfal_plugin_file_rmdir(plugin_handle plugin_data, const char *path, GError *
     return res;
 }
 
-/*
- *  local closedir mapper
- *
- * */
-int gfal_plugin_file_closedir(plugin_handle plugin_data, gfal_file_handle fh, GError** err){
-    const int res = closedir(gfal_file_handle_get_fdesc(fh));
-    if(res<0)
-        gfal_plugin_file_report_error(__func__, err);
-    else
-        gfal_file_handle_delete(fh);
-    return res;
-}
-
 int gfal_plugin_file_symlink(plugin_handle plugin_data, const char *oldpath, const char *newpath, GError **err)
 {
     const int res = symlink(oldpath + FILE_PREFIX_LEN, newpath + FILE_PREFIX_LEN);
@@ -473,6 +453,55 @@ static int md5_getResult(void *chk_handler, char *resu, size_t s_b)
 
 // checksum implem
 
+typedef struct {
+    Chksum_interface *i_chk;
+    void *c_handle;
+} Chksum_update;
+
+
+static int gfal_plugin_file_chk_update(const char *data, size_t len, void *user_data, GError **err)
+{
+    Chksum_update *update = (Chksum_update*) user_data;
+    update->i_chk->update(update->c_handle, data, len);
+    return 0;
+}
+
+/*
+ * Same as gfal_plugin_file_chk_compute, keeping several reads in flight with io_uring
+ * Returns 1 if io_uring can not be used
+ */
+static int gfal_plugin_file_chk_compute_uring(gfal2_context_t handle, const char *url,
+    char *checksum_buffer, size_t buffer_length,
+    off_t start_offset, size_t data_length,
+    Chksum_interface *i_chk,
+    GError **err)
+{
+    const int fd = open(url + FILE_PREFIX_LEN, O_RDONLY);
+    if (fd < 0) {
+        gfal_plugin_file_report_error(__func__, err);
+        return -1;
+    }
+
+    Chksum_update update = {i_chk, i_chk->init()};
+    int ret = gfal_file_uring_pipeline(handle, fd, start_offset, (data_length > 0) ? (off_t) data_length : -1,
+        -1, 0, gfal_plugin_file_chk_update, &update, err);
+    close(fd);
+
+    if (ret != 0) {
+        // Release the checksum handler
+        char discard[64];
+        i_chk->getResult(update.c_handle, discard, sizeof(discard));
+        return ret;
+    }
+
+    if (i_chk->getResult(update.c_handle, checksum_buffer, buffer_length) < 0) {
+        gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOBUFS, __func__, "buffer for checksum too short");
+        return -1;
+    }
+    return 0;
+}
+
+
 static int gfal_plugin_file_chk_compute(plugin_handle data, const char *url, const char *check_type,
     char *checksum_buffer, size_t buffer_length,
     off_t start_offset, size_t data_length,
@@ -485,6 +514,13 @@ static int gfal_plugin_file_chk_compute(plugin_handle data, const char *url, con
     int fd;
     ssize_t ret = 0, remain_bytes = ((data_length > 0) ? (data_length) : (chunk_size));
 
+    if (gfal_file_uring_enabled(handle)) {
+        ret = gfal_plugin_file_chk_compute_uring(handle, url, checksum_buffer, buffer_length,
+            start_offset, data_length, i_chk, err);
+        if (ret <= 0)
+            return ret;
+    }
+
     if ((fd = gfal2_open(handle, url, O_RDONLY, &tmp_err)) < 0) {
         g_prefix_error(err, "Error during checksum calculation, open ");
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
@@ -585,6 +621,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     file_plugin.rmdirG = &gfal_plugin_file_rmdir;
     file_plugin.opendirG = &gfal_plugin_file_opendir;
     file_plugin.readdirG = &gfal_plugin_file_readdir;
+    file_plugin.readdirppG = &gfal_plugin_file_readdirpp;
     file_plugin.closedirG = &gfal_plugin_file_closedir;
     file_plugin.readlinkG = &gfal_plugin_file_readlink;
 
@@ -603,5 +640,8 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     file_plugin.setxattrG = &gfal_plugin_file_setxattr;
     file_plugin.checksum_calcG = &gfal_plugin_filechecksum_calc;
 
+    file_plugin.check_plugin_url_transfer = &gfal_plugin_file_check_url_transfer;
+    file_plugin.copy_file = &gfal_plugin_file_copy;
+
     return file_plugin;
 }
@@ -0,0 +1,609 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib.h>
+
+#include "gfal_file_plugin.h"
+
+static const unsigned DEFAULT_QUEUE_DEPTH = 8;
+static const size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+
+gboolean gfal_file_uring_enabled(gfal2_context_t context)
+{
+    return gfal2_get_opt_boolean_with_default(context, "FILE PLUGIN", "IO_URING", FALSE);
+}
+
+
+#ifdef HAVE_IO_URING
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+
+struct _gfal_file_uring {
+    int fd;
+    unsigned entries;
+    unsigned features;
+    gboolean fixed_buffers;
+    // Submission queue
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned to_submit;
+    // Completion queue
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+    // Mappings
+    void *sq_ptr, *cq_ptr;
+    size_t sq_size, cq_size, sqes_size;
+};
+
+// Set once the kernel refused io_uring, so it is not probed again
+static gint uring_unavailable = 0;
+
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+
+static int sys_io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+    return (int) syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+
+gfal_file_uring_t *gfal_file_uring_new(unsigned entries)
+{
+    if (g_atomic_int_get(&uring_unavailable)) {
+        errno = ENOSYS;
+        return NULL;
+    }
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = sys_io_uring_setup(entries, &params);
+    if (fd < 0) {
+        if (errno == ENOSYS || errno == EPERM) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "io_uring not available, using plain syscalls: %s", strerror(errno));
+            g_atomic_int_set(&uring_unavailable, 1);
+        }
+        return NULL;
+    }
+
+    gfal_file_uring_t *ring = g_new0(gfal_file_uring_t, 1);
+    ring->fd = fd;
+    ring->entries = params.sq_entries;
+    ring->features = params.features;
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    gboolean single_mmap = FALSE;
+#ifdef IORING_FEAT_SINGLE_MMAP
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        single_mmap = TRUE;
+        ring->sq_size = ring->cq_size = MAX(ring->sq_size, ring->cq_size);
+    }
+#endif
+
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        ring->sq_ptr = NULL;
+        goto fail;
+    }
+    if (single_mmap) {
+        ring->cq_ptr = ring->sq_ptr;
+    }
+    else {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            ring->cq_ptr = NULL;
+            goto fail;
+        }
+    }
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        goto fail;
+    }
+
+    char *sq = ring->sq_ptr, *cq = ring->cq_ptr;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return ring;
+
+fail:
+    gfal_file_uring_free(ring);
+    return NULL;
+}
+
+
+void gfal_file_uring_free(gfal_file_uring_t *ring)
+{
+    if (ring == NULL)
+        return;
+    if (ring->sqes)
+        munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ptr && ring->cq_ptr != ring->sq_ptr)
+        munmap(ring->cq_ptr, ring->cq_size);
+    if (ring->sq_ptr)
+        munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+    g_free(ring);
+}
+
+
+// Ring of the calling thread for single operations, freed when the thread exits
+static pthread_key_t uring_thread_key;
+static pthread_once_t uring_thread_key_once = PTHREAD_ONCE_INIT;
+static __thread gfal_file_uring_t *uring_thread_ring = NULL;
+
+
+static void uring_thread_exit(void *data)
+{
+    gfal_file_uring_free((gfal_file_uring_t*) data);
+}
+
+
+static void uring_thread_key_init(void)
+{
+    pthread_key_create(&uring_thread_key, uring_thread_exit);
+}
+
+
+gfal_file_uring_t *gfal_file_uring_thread(void)
+{
+    if (G_LIKELY(uring_thread_ring != NULL))
+        return uring_thread_ring;
+
+    // Operations are waited for one at a time
+    gfal_file_uring_t *ring = gfal_file_uring_new(2);
+    if (ring != NULL) {
+        pthread_once(&uring_thread_key_once, uring_thread_key_init);
+        pthread_setspecific(uring_thread_key, ring);
+        uring_thread_ring = ring;
+    }
+    return ring;
+}
+
+/*
+ * Free the ring of the thread after a failed wait, as whatever it still has in flight can not
+ * be reaped. Closing the ring cancels them, and the next operation gets a new ring
+ */
+static void uring_thread_discard(gfal_file_uring_t *ring)
+{
+    if (ring != uring_thread_ring)
+        return;
+    int errno_saved = errno;
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Discarding the io_uring of the thread: %s", strerror(errno_saved));
+    pthread_setspecific(uring_thread_key, NULL);
+    uring_thread_ring = NULL;
+    gfal_file_uring_free(ring);
+    errno = errno_saved;
+}
+
+/*
+ * Queue an operation. Returns -1 if the submission queue is full.
+ * iov must stay valid until the completion for non fixed operations.
+ */
+static int uring_queue(gfal_file_uring_t *ring, int opcode, int fd, void *addr, unsigned len,
+    off_t offset, unsigned buf_index, guint64 user_data)
+{
+    unsigned tail = *ring->sq_tail;
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (tail - head >= ring->entries) {
+        errno = EBUSY;
+        return -1;
+    }
+
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->off = (guint64) offset;
+    sqe->addr = (guint64) (uintptr_t) addr;
+    sqe->len = len;
+    sqe->buf_index = buf_index;
+    sqe->user_data = user_data;
+
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++ring->to_submit;
+    return 0;
+}
+
+/*
+ * Submit whatever is queued, and wait for one completion
+ */
+static int uring_wait(gfal_file_uring_t *ring, struct io_uring_cqe *cqe)
+{
+    while (1) {
+        unsigned head = *ring->cq_head;
+        unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+        if (head != tail) {
+            *cqe = ring->cqes[head & *ring->cq_mask];
+            __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+            return 0;
+        }
+
+        int ret = sys_io_uring_enter(ring->fd, ring->to_submit, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        ring->to_submit -= MIN((unsigned) ret, ring->to_submit);
+    }
+}
+
+
+ssize_t gfal_file_uring_rw(gfal_file_uring_t *ring, gboolean write_op, int fd, void *buffer, size_t len, off_t offset)
+{
+    // Older kernels can not use the current file position
+#ifdef IORING_FEAT_RW_CUR_POS
+    const gboolean cur_pos = (ring->features & IORING_FEAT_RW_CUR_POS) != 0;
+#else
+    const gboolean cur_pos = FALSE;
+#endif
+    if (offset < 0 && !cur_pos) {
+        return write_op ? write(fd, buffer, len) : read(fd, buffer, len);
+    }
+
+    struct iovec iov = {buffer, len};
+    struct io_uring_cqe cqe;
+
+    do {
+        if (uring_queue(ring, write_op ? IORING_OP_WRITEV : IORING_OP_READV, fd, &iov, 1,
+                offset < 0 ? (off_t) -1 : offset, 0, 0) < 0) {
+            return -1;
+        }
+        // The entry is queued, and points to iov and buffer, so it must not outlive the call
+        if (uring_wait(ring, &cqe) < 0) {
+            uring_thread_discard(ring);
+            return -1;
+        }
+    } while (cqe.res == -EAGAIN || cqe.res == -EINTR);
+
+    if (cqe.res < 0) {
+        errno = -cqe.res;
+        return -1;
+    }
+    return cqe.res;
+}
+
+
+typedef enum {
+    SLOT_IDLE,
+    SLOT_READING,
+    SLOT_READY,
+    SLOT_WRITING
+} uring_slot_state;
+
+
+typedef struct {
+    uring_slot_state state;
+    char *buffer;
+    // Source offset of the chunk
+    off_t offset;
+    size_t requested;
+    // Bytes read, and then bytes written
+    size_t done;
+    size_t length;
+    struct iovec iov;
+} uring_slot_t;
+
+
+typedef struct {
+    gfal_file_uring_t *ring;
+    uring_slot_t *slots;
+    unsigned depth;
+    size_t buffer_size;
+    int fd_src, fd_dst;
+    off_t start, next_offset, end, dst_start;
+    gboolean input_done;
+    unsigned inflight;
+} uring_pipeline_t;
+
+
+static int pipeline_queue(uring_pipeline_t *p, unsigned index)
+{
+    uring_slot_t *slot = &p->slots[index];
+    gboolean write_op = (slot->state == SLOT_WRITING);
+    int fd;
+    off_t offset;
+    size_t len;
+
+    if (write_op) {
+        fd = p->fd_dst;
+        offset = p->dst_start + (slot->offset - p->start) + slot->done;
+        len = slot->length - slot->done;
+    }
+    else {
+        fd = p->fd_src;
+        offset = slot->offset + slot->done;
+        len = slot->requested - slot->done;
+    }
+
+    int ret;
+    if (p->ring->fixed_buffers) {
+        ret = uring_queue(p->ring, write_op ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED,
+            fd, slot->buffer + slot->done, len, offset, index, index);
+    }
+    else {
+        slot->iov.iov_base = slot->buffer + slot->done;
+        slot->iov.iov_len = len;
+        ret = uring_queue(p->ring, write_op ? IORING_OP_WRITEV : IORING_OP_READV,
+            fd, &slot->iov, 1, offset, 0, index);
+    }
+    if (ret == 0)
+        ++p->inflight;
+    return ret;
+}
+
+/*
+ * Give the next chunk of the source to this slot, if any
+ */
+static int pipeline_read_next(uring_pipeline_t *p, unsigned index)
+{
+    uring_slot_t *slot = &p->slots[index];
+    slot->state = SLOT_IDLE;
+    if (p->input_done)
+        return 0;
+
+    size_t requested = p->buffer_size;
+    if (p->end >= 0)
+        requested = MIN(requested, (size_t)(p->end - p->next_offset));
+    if (requested == 0) {
+        p->input_done = TRUE;
+        return 0;
+    }
+
+    slot->offset = p->next_offset;
+    slot->requested = requested;
+    slot->done = slot->length = 0;
+    slot->state = SLOT_READING;
+    p->next_offset += requested;
+    return pipeline_queue(p, index);
+}
+
+
+int gfal_file_uring_pipeline(gfal2_context_t context, int fd_src, off_t offset, off_t length,
+    int fd_dst, off_t dst_offset, gfal_file_uring_chunk_func func, void *user_data, GError **err)
+{
+    uring_pipeline_t p;
+    memset(&p, 0, sizeof(p));
+
+    p.depth = CLAMP(gfal2_get_opt_integer_with_default(context, "FILE PLUGIN", "IO_URING_QUEUE_DEPTH",
+        DEFAULT_QUEUE_DEPTH), 1, 256);
+    p.buffer_size = gfal2_get_opt_integer_with_default(context, "FILE PLUGIN", "IO_URING_BUFFER_SIZE",
+        DEFAULT_BUFFER_SIZE);
+    p.buffer_size = MAX(p.buffer_size, 4096);
+    p.fd_src = fd_src;
+    p.fd_dst = fd_dst;
+    p.start = p.next_offset = offset;
+    p.end = (length >= 0) ? offset + length : -1;
+    p.dst_start = dst_offset;
+
+    p.ring = gfal_file_uring_new(p.depth);
+    if (p.ring == NULL) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Could not create an io_uring: %s", strerror(errno));
+        return 1;
+    }
+
+    char *memory = NULL;
+    errno = posix_memalign((void**)&memory, 4096, p.depth * p.buffer_size);
+    if (errno) {
+        gfal2_set_error(err, gfal2_get_plugin_file_quark(), errno, __func__,
+            "Failed to allocate the io_uring buffers");
+        gfal_file_uring_free(p.ring);
+        return -1;
+    }
+
+    unsigned i;
+    p.slots = g_new0(uring_slot_t, p.depth);
+    struct iovec *iovs = g_new0(struct iovec, p.depth);
+    for (i = 0; i < p.depth; ++i) {
+        p.slots[i].buffer = memory + i * p.buffer_size;
+        iovs[i].iov_base = p.slots[i].buffer;
+        iovs[i].iov_len = p.buffer_size;
+    }
+    // Pinning may be refused (i.e. RLIMIT_MEMLOCK), plain buffers still work
+    if (sys_io_uring_register(p.ring->fd, IORING_REGISTER_BUFFERS, iovs, p.depth) == 0) {
+        p.ring->fixed_buffers = TRUE;
+    }
+    else {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Could not register the io_uring buffers: %s", strerror(errno));
+    }
+    g_free(iovs);
+
+    GError *tmp_err = NULL;
+    gboolean unusable = FALSE, progressed = FALSE;
+    unsigned next_consume = 0;
+
+    for (i = 0; i < p.depth && !tmp_err; ++i) {
+        if (pipeline_read_next(&p, i) < 0)
+            gfal_plugin_file_report_error(__func__, &tmp_err);
+    }
+
+    while (p.inflight > 0) {
+        struct io_uring_cqe cqe;
+        if (uring_wait(p.ring, &cqe) < 0) {
+            // Can not reap what is in flight, so the buffers and their iovecs can not be released
+            gfal_plugin_file_report_error(__func__, &tmp_err);
+            memory = NULL;
+            p.slots = NULL;
+            break;
+        }
+        --p.inflight;
+
+        unsigned index = (unsigned) cqe.user_data;
+        uring_slot_t *slot = &p.slots[index];
+        int res = cqe.res;
+
+        if (tmp_err || unusable)
+            continue;
+
+        if (res == -EAGAIN || res == -EINTR) {
+            if (pipeline_queue(&p, index) < 0)
+                gfal_plugin_file_report_error(__func__, &tmp_err);
+            continue;
+        }
+        if (res < 0) {
+            if (!progressed && (res == -EINVAL || res == -EOPNOTSUPP || res == -EBADF)) {
+                gfal2_log(G_LOG_LEVEL_DEBUG, "io_uring not usable for this file: %s", strerror(-res));
+                unusable = TRUE;
+            }
+            else {
+                gfal2_set_error(&tmp_err, gfal2_get_plugin_file_quark(), -res, __func__,
+                    "io_uring %s failed: %s", slot->state == SLOT_WRITING ? "write" : "read", strerror(-res));
+            }
+            continue;
+        }
+
+        if (slot->state == SLOT_WRITING) {
+            slot->done += res;
+            if (slot->done < slot->length) {
+                if (pipeline_queue(&p, index) < 0)
+                    gfal_plugin_file_report_error(__func__, &tmp_err);
+                continue;
+            }
+            progressed = TRUE;
+            if (func(slot->buffer, slot->length, user_data, &tmp_err) < 0)
+                continue;
+            if (pipeline_read_next(&p, index) < 0)
+                gfal_plugin_file_report_error(__func__, &tmp_err);
+            continue;
+        }
+
+        // Reading
+        if (res == 0) {
+            p.input_done = TRUE;
+        }
+        else {
+            slot->done += res;
+            if (slot->done < slot->requested) {
+                if (pipeline_queue(&p, index) < 0)
+                    gfal_plugin_file_report_error(__func__, &tmp_err);
+                continue;
+            }
+        }
+        slot->length = slot->done;
+        slot->state = SLOT_READY;
+
+        if (fd_dst >= 0) {
+            // Writes are positioned, so they can complete in any order
+            if (slot->length == 0) {
+                slot->state = SLOT_IDLE;
+                continue;
+            }
+            slot->done = 0;
+            slot->state = SLOT_WRITING;
+            if (pipeline_queue(&p, index) < 0)
+                gfal_plugin_file_report_error(__func__, &tmp_err);
+        }
+        else {
+            // Consumers get the data in order
+            while (p.slots[next_consume].state == SLOT_READY && !tmp_err) {
+                uring_slot_t *ready = &p.slots[next_consume];
+                if (ready->length > 0) {
+                    progressed = TRUE;
+                    if (func(ready->buffer, ready->length, user_data, &tmp_err) < 0)
+                        break;
+                }
+                if (pipeline_read_next(&p, next_consume) < 0)
+                    gfal_plugin_file_report_error(__func__, &tmp_err);
+                next_consume = (next_consume + 1) % p.depth;
+            }
+        }
+    }
+
+    gfal_file_uring_free(p.ring);
+    free(memory);
+    g_free(p.slots);
+
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    return unusable ? 1 : 0;
+}
+
+#else
+
+gfal_file_uring_t *gfal_file_uring_new(unsigned entries)
+{
+    errno = ENOSYS;
+    return NULL;
+}
+
+
+void gfal_file_uring_free(gfal_file_uring_t *ring)
+{
+}
+
+
+gfal_file_uring_t *gfal_file_uring_thread(void)
+{
+    errno = ENOSYS;
+    return NULL;
+}
+
+
+ssize_t gfal_file_uring_rw(gfal_file_uring_t *ring, gboolean write_op, int fd, void *buffer, size_t len, off_t offset)
+{
+    if (offset < 0)
+        return write_op ? write(fd, buffer, len) : read(fd, buffer, len);
+    return write_op ? pwrite(fd, buffer, len, offset) : pread(fd, buffer, len, offset);
+}
+
+
+int gfal_file_uring_pipeline(gfal2_context_t context, int fd_src, off_t offset, off_t length,
+    int fd_dst, off_t dst_offset, gfal_file_uring_chunk_func func, void *user_data, GError **err)
+{
+    return 1;
+}
+
+#endif
@@ -80,6 +80,7 @@ struct GridFTPBulkPerformance {
     gfalt_params_t params;
     bool ipv6;
     time_t start_time;
+    guint nbstreams;
 
     globus_ftp_client_plugin_t* plugin;
 };
@@ -187,12 +188,14 @@ void gridftp_bulk_throughput_cb(void *user_specific,
     globus_ftp_client_throughput_plugin_get_user_specific(original->plugin, (void**)(&pd));
 
     _gfalt_transfer_status status;
+    memset(&status, 0, sizeof(status));
     status.bytes_transfered = bytes;
     status.average_baudrate = (size_t) avg_throughput;
     status.instant_baudrate = (size_t) instantaneous_throughput;
     status.transfer_time = (time(NULL) - pd->start_time);
+    status.streams = pd->nbstreams;
 
-    plugin_trigger_monitor(pd->params, &status, pd->source.c_str(), pd->destination.c_str());
+    plugin_trigger_monitor_ext(pd->params, &status, sizeof(status), pd->source.c_str(), pd->destination.c_str());
 }
 
 
@@ -271,9 +274,17 @@ int gridftp_pipeline_transfer(plugin_handle plugin_data,
 
     pairs->started[pairs->index] = true;
 
+    int nbstreams = gfal2_get_opt_integer_with_default(context, GRIDFTP_CONFIG_GROUP,
+            GRIDFTP_CONFIG_NB_STREAM, 0);
+
+    if (nbstreams == 0) {
+        nbstreams = gfalt_get_nbstreams(pairs->params, NULL);
+    }
+
     GridFTPBulkPerformance perf;
     perf.params = pairs->params;
     perf.ipv6 = gfal2_get_opt_boolean_with_default(context, GRIDFTP_CONFIG_GROUP, GRIDFTP_CONFIG_IPV6, false);
+    perf.nbstreams = nbstreams;
     perf.plugin = &throughput_plugin;
 
     globus_ftp_client_throughput_plugin_init(&throughput_plugin,
@@ -294,12 +305,6 @@ int gridftp_pipeline_transfer(plugin_handle plugin_data,
         &ftp_operation_attr_dst, handler.get_ftp_client_operationattr(), &cred_id_dst,
         context, udt, pairs->dsts[pairs->index], op_error);
 
-    int nbstreams = gfal2_get_opt_integer_with_default(context, GRIDFTP_CONFIG_GROUP,
-            GRIDFTP_CONFIG_NB_STREAM, 0);
-
-    if (nbstreams == 0) {
-        nbstreams = gfalt_get_nbstreams(pairs->params, NULL);
-    }
     guint64 buffer_size = gfalt_get_tcp_buffer_size(pairs->params, NULL);
     globus_ftp_control_parallelism_t parallelism;
     globus_ftp_control_tcpbuffer_t tcp_buffer_size;
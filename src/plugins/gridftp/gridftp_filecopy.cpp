@@ -258,6 +258,11 @@ struct CallbackHandler {
     {
         timeout_value = gfal2_get_opt_integer_with_default(context,
                     GRIDFTP_CONFIG_GROUP, GRIDFTP_CONFIG_TRANSFER_PERF_TIMEOUT, 180);
+        // Same precedence as gridftp_filecopy_copy_file_internal
+        nbstreams = gfal2_get_opt_integer_with_default(context,
+                    GRIDFTP_CONFIG_GROUP, GRIDFTP_CONFIG_NB_STREAM, 0);
+        if (nbstreams == 0)
+            nbstreams = gfalt_get_nbstreams(params, NULL);
 
         start_time = time(NULL);
 
@@ -289,6 +294,7 @@ struct CallbackHandler {
     time_t timeout_time;
     pthread_t timer_pthread;
     globus_off_t source_size;
+    guint nbstreams;
 };
 
 
@@ -298,12 +304,14 @@ void gsiftp_3rd_callback(void* user_args, globus_gass_copy_handle_t* handle,
     CallbackHandler* args = (CallbackHandler*)user_args;
 
     _gfalt_transfer_status status;
+    memset(&status, 0, sizeof(status));
     status.bytes_transfered = total_bytes;
     status.average_baudrate = (size_t) avg_throughput;
     status.instant_baudrate = (size_t) throughput;
     status.transfer_time = (time(NULL) - args->start_time);
+    status.streams = args->nbstreams;
 
-    plugin_trigger_monitor(args->params, &status, args->src, args->dst);
+    plugin_trigger_monitor_ext(args->params, &status, sizeof(status), args->src, args->dst);
 
     if (args->timeout_time > 0) {
         // If throughput != 0, or the file has been already sent, reset timer callback
@@ -419,9 +427,19 @@ int gridftp_filecopy_copy_file_internal(GridFTPModule* module,
     Gfal::gerror_to_cpp(&tmp_err);
 
     if (!is_strict_mode) {
+        // Phases that throw are closed by the core with the error of the copy
+        gfalt_trace_span_t span = gfalt_trace_begin(params, GFAL_GRIDFTP_DOMAIN_GSIFTP,
+                GFAL_EVENT_DESTINATION, "overwrite");
         // If 1, the destination was deleted. So the parent directory is there!
-        if (gridftp_filecopy_delete_existing(module, params, dst) == 0)
+        const int deleted = gridftp_filecopy_delete_existing(module, params, dst);
+        gfalt_trace_end(params, span, -1, NULL);
+
+        if (deleted == 0 && gfalt_get_create_parent_dir(params, NULL)) {
+            span = gfalt_trace_begin(params, GFAL_GRIDFTP_DOMAIN_GSIFTP,
+                    GFAL_EVENT_DESTINATION, "mkdir_parent");
             gridftp_create_parent_copy(module, params, dst);
+            gfalt_trace_end(params, span, -1, NULL);
+        }
     }
 
     GridFTPSessionHandler handler(factory, src);
@@ -291,13 +291,14 @@ static void gfal_http_3rdcopy_perfcallback(const Davix::PerformanceData& perfDat
     if (pdata)
     {
         _gfalt_transfer_status status;
+        memset(&status, 0, sizeof(status));
 
         status.average_baudrate = static_cast<size_t>(perfData.avgTransfer());
         status.bytes_transfered = static_cast<size_t>(perfData.totalTransferred());
         status.instant_baudrate = static_cast<size_t>(perfData.diffTransfer());
         status.transfer_time    = perfData.absElapsed();
 
-        plugin_trigger_monitor(pdata->params, &status, pdata->source.c_str(), pdata->destination.c_str());
+        plugin_trigger_monitor_ext(pdata->params, &status, sizeof(status), pdata->source.c_str(), pdata->destination.c_str());
     }
 }
 
@@ -427,17 +428,14 @@ struct HttpStreamProvider {
     gfal2_context_t context;
     gfalt_params_t params;
     int source_fd;
-    time_t start, last_update;
-    dav_ssize_t read_instant;
-    _gfalt_transfer_status perf;
+    gfalt_perf_meter_t perf;
 
     HttpStreamProvider(const char* source, const char* destination,
             gfal2_context_t context, int source_fd, gfalt_params_t params):
         source(source), destination(destination),
-        context(context), params(params), source_fd(source_fd), start(time(NULL)),
-        last_update(start), read_instant(0)
+        context(context), params(params), source_fd(source_fd)
     {
-        memset(&perf, 0, sizeof(perf));
+        gfalt_perf_meter_init(context, &perf);
     }
 };
 
@@ -449,32 +447,19 @@ static dav_ssize_t gfal_http_streamed_provider(void *userdata,
     HttpStreamProvider* data = static_cast<HttpStreamProvider*>(userdata);
     dav_ssize_t ret = 0;
 
-    time_t now = time(NULL);
-
     if (buflen == 0) {
-        data->perf.bytes_transfered = data->read_instant = 0;
-        data->perf.average_baudrate = 0;
-        data->perf.instant_baudrate = 0;
-        data->start = data->last_update = now;
+        gfalt_perf_meter_init(data->context, &data->perf);
 
         if (gfal2_lseek(data->context, data->source_fd, 0, SEEK_SET, &error) < 0)
             ret = -1;
     }
     else {
         ret = gfal2_read(data->context, data->source_fd, buffer, buflen, &error);
-        if (ret > 0)
-            data->read_instant += ret;
-
-        if (now - data->last_update >= 5) {
-            data->perf.bytes_transfered += data->read_instant;
-            data->perf.transfer_time = now - data->start;
-            data->perf.average_baudrate = data->perf.bytes_transfered / data->perf.transfer_time;
-            data->perf.instant_baudrate = data->read_instant / (now - data->last_update);
-
-            data->last_update = now;
-            data->read_instant = 0;
 
-            plugin_trigger_monitor(data->params, &data->perf, data->source, data->destination);
+        _gfalt_transfer_status status;
+        if (gfalt_perf_meter_update(&data->perf, (ret > 0) ? ret : 0, &status)) {
+            status.streams = 1;
+            plugin_trigger_monitor_ext(data->params, &status, sizeof(status), data->source, data->destination);
         }
     }
 
@@ -642,8 +627,18 @@ int gfal_http_copy(plugin_handle plugin_data, gfal2_context_t context,
     // When this flag is not set, the plugin should handle overwriting,
     // parent directory creation,...
     if (!gfalt_get_strict_copy_mode(params, NULL)) {
-        if (gfal_http_copy_overwrite(plugin_data, params, dst, &nested_error) != 0 ||
-            gfal_http_copy_make_parent(plugin_data, params, context, dst, &nested_error) != 0) {
+        gfalt_trace_span_t span = gfalt_trace_begin(params, http_plugin_domain,
+                GFAL_EVENT_DESTINATION, "overwrite");
+        int ret = gfal_http_copy_overwrite(plugin_data, params, dst, &nested_error);
+        gfalt_trace_end(params, span, -1, nested_error);
+
+        if (ret == 0 && gfalt_get_create_parent_dir(params, NULL)) {
+            span = gfalt_trace_begin(params, http_plugin_domain, GFAL_EVENT_DESTINATION, "mkdir_parent");
+            ret = gfal_http_copy_make_parent(plugin_data, params, context, dst, &nested_error);
+            gfalt_trace_end(params, span, -1, nested_error);
+        }
+
+        if (ret != 0) {
             gfal2_propagate_prefixed_error(err, nested_error, __func__);
             return -1;
         }
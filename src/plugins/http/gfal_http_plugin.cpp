@@ -25,6 +25,7 @@
 #include <cstring>
 #include <sstream>
 #include <list>
+#include <functional>
 #include <davix.hpp>
 #include <errno.h>
 #include <davix/utils/davix_gcloud_utils.hpp>
@@ -118,8 +119,6 @@ static bool gfal_http_get_x509_cert_pair(gfal2_context_t handle, const Davix::Ur
 
 char* GfalHttpPluginData::find_se_token(const Davix::Uri& uri, const OP& operation)
 {
-    using credTuple = std::pair<std::string, std::string>;
-
     if (!allowsBearerTokenRetrieve(uri)) {
         return NULL;
     }
@@ -147,38 +146,28 @@ char* GfalHttpPluginData::find_se_token(const Davix::Uri& uri, const OP& operati
         return false;
     };
 
-    // Helper function to extract all credentials of type "BEARER"
-    auto cred_map_callback = [](const char* url_prefix, const gfal2_cred_t* cred, void* user_data) {
-        auto cred_list = static_cast<std::list<credTuple>*>(user_data);
-
-        if (strcmp(cred->type, GFAL_CRED_BEARER) == 0) {
-            cred_list->emplace_back(url_prefix, cred->value);
-        }
-    };
+    // Credentials are visited best match first; stop at the first one with enough access
+    struct MatchData {
+        std::function<bool(const char*, const char*, bool)> accept;
+        bool write_access;
+        char* token;
+    } match_data = {find_in_token_map, write_access, NULL};
 
-    // Helper function to check whether a path contains the search path
-    auto path_contains = [](const std::string& path, const std::string& search) -> bool {
-        size_t pos = path.find(search);
+    auto cred_match_callback = [](const char* url_prefix, const gfal2_cred_t* cred, void* user_data) -> gboolean {
+        auto data = static_cast<MatchData*>(user_data);
 
-        if (pos == 0) {
-            return (path.size() == search.size()) ||
-                   (path.at(search.size() - 1) == '/') ||
-                   (path.at(search.size()) == '/');
+        if (data->accept(cred->value, url_prefix, data->write_access)) {
+            data->token = g_strdup(cred->value);
+            return TRUE;
         }
-
-        return false;
+        return FALSE;
     };
 
-    std::list<credTuple> cred_list;
-    gfal2_cred_foreach(handle, cred_map_callback, &cred_list);
+    gfal2_cred_foreach_match(handle, GFAL_CRED_BEARER, uri.getString().c_str(), extended_search,
+                             cred_match_callback, &match_data);
 
-    for (auto cred = cred_list.begin(); cred != cred_list.end(); cred++) {
-        if (path_contains(uri.getString(), cred->first) ||
-            (extended_search && path_contains(cred->first, uri.getString()))) {
-            if (find_in_token_map(cred->second.c_str(), cred->first.c_str(), write_access)) {
-                return g_strdup(cred->second.c_str());
-            }
-        }
+    if (match_data.token) {
+        return match_data.token;
     }
 
     // Search token for the full host (backwards compatibility with FTS)
@@ -529,22 +518,22 @@ void GfalHttpPluginData::get_params_internal(Davix::RequestParams& params, const
         params.setProtocol(Davix::RequestProtocol::Auto);
     }
 
+    const RequestConfig config = get_request_config();
+
     // Insecure flag
-    gboolean insecure_mode = gfal2_get_opt_boolean_with_default(handle, "HTTP PLUGIN", "INSECURE", FALSE);
-    if (insecure_mode) {
+    if (config.insecure) {
         params.setSSLCAcheck(false);
     }
 
     // Keep alive
-    gboolean keep_alive = gfal2_get_opt_boolean_with_default(handle, "HTTP PLUGIN", "KEEP_ALIVE", TRUE);
-    params.setKeepAlive(keep_alive);
+    params.setKeepAlive(config.keep_alive);
 
     // Reset here the verbosity level
     davix_set_log_level(get_corresponding_davix_log_level());
 
     // Reset sensitive scope mask
     int davix_scope_mask = Davix::getLogScope() & ~(DAVIX_LOG_SSL | DAVIX_LOG_SENSITIVE);
-    if (gfal2_get_opt_boolean_with_default(handle, "HTTP PLUGIN", "LOG_SENSITIVE", false)) {
+    if (config.log_sensitive) {
         davix_scope_mask |= (DAVIX_LOG_SSL | DAVIX_LOG_SENSITIVE);
     }
     Davix::setLogScope(davix_scope_mask);
@@ -571,6 +560,32 @@ void GfalHttpPluginData::get_params_internal(Davix::RequestParams& params, const
     g_free(client_info);
 
     // Custom headers
+    for (auto it = config.headers.begin(); it != config.headers.end(); ++it) {
+        params.addHeader(it->first, it->second);
+    }
+
+    // Timeout
+    struct timespec opTimeout;
+    opTimeout.tv_sec = config.operation_timeout;
+    params.setOperationTimeout(&opTimeout);
+}
+
+GfalHttpPluginData::RequestConfig GfalHttpPluginData::get_request_config()
+{
+    std::lock_guard<std::mutex> lock(request_config_mutex);
+
+    const gint generation = gfal2_get_opt_generation(handle);
+    if (request_config.generation == generation) {
+        return request_config;
+    }
+
+    RequestConfig config;
+    config.generation = generation;
+    config.insecure = gfal2_get_opt_boolean_with_default(handle, "HTTP PLUGIN", "INSECURE", FALSE);
+    config.keep_alive = gfal2_get_opt_boolean_with_default(handle, "HTTP PLUGIN", "KEEP_ALIVE", TRUE);
+    config.log_sensitive = gfal2_get_opt_boolean_with_default(handle, "HTTP PLUGIN", "LOG_SENSITIVE", FALSE);
+    config.operation_timeout = gfal2_get_opt_integer_with_default(handle, "HTTP PLUGIN", HTTP_CONFIG_OP_TIMEOUT, 8000);
+
     gsize headers_length = 0;
     char **headers = gfal2_get_opt_string_list_with_default(handle, "HTTP PLUGIN", "HEADERS", &headers_length, NULL);
     if (headers) {
@@ -578,16 +593,14 @@ void GfalHttpPluginData::get_params_internal(Davix::RequestParams& params, const
             char **kv = g_strsplit(*hi, ":", 2);
             g_strstrip(kv[0]);
             g_strstrip(kv[1]);
-            params.addHeader(kv[0], kv[1]);
+            config.headers.push_back(std::make_pair(std::string(kv[0]), std::string(kv[1])));
             g_strfreev(kv);
         }
         g_strfreev(headers);
     }
 
-    // Timeout
-    struct timespec opTimeout;
-    opTimeout.tv_sec = gfal2_get_opt_integer_with_default(handle, "HTTP PLUGIN", HTTP_CONFIG_OP_TIMEOUT, 8000);
-    params.setOperationTimeout(&opTimeout);
+    request_config = config;
+    return request_config;
 }
 
 void GfalHttpPluginData::get_tpc_params(Davix::RequestParams* req_params,
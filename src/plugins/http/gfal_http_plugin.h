@@ -22,6 +22,8 @@
 #define _GFAL_HTTP_PLUGIN_H
 
 #include <map>
+#include <mutex>
+#include <vector>
 
 #include <gfal_plugins_api.h>
 #include <davix.hpp>
@@ -77,6 +79,21 @@ private:
     /// token retriever object (can be chained)
     std::unique_ptr<TokenRetriever> token_retriever_chain;
 
+    /// configuration used by every request, parsed once per configuration generation
+    struct RequestConfig {
+        gint generation = -1;
+        bool insecure = false;
+        bool keep_alive = true;
+        bool log_sensitive = false;
+        int operation_timeout = 8000;
+        std::vector<std::pair<std::string, std::string> > headers;
+    };
+    RequestConfig request_config;
+    std::mutex request_config_mutex;
+
+    // Return the request configuration, refreshed if the gfal2 configuration changed
+    RequestConfig get_request_config();
+
     // Set up general request parameters
     void get_params_internal(Davix::RequestParams& params, const Davix::Uri& uri);
 
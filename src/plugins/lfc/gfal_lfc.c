@@ -194,7 +194,6 @@ int lfc_chmodG(plugin_handle handle, const char *path, mode_t mode, GError **err
     if ((ret = url_converter(handle, path, &url_host, &url_path, &tmp_err)) == 0) {
         ret = lfc_configure_environment(ops, url_host, path, &tmp_err);
         if (!tmp_err) {
-            gfal_auto_maintain_session(ops, &tmp_err);
             ret = ops->chmod(url_path, mode);
             if (ret < 0) {
                 const int myerrno = gfal_lfc_get_errno(ops);
@@ -229,7 +228,6 @@ int lfc_accessG(plugin_handle handle, const char *lfn, int mode, GError **err)
     if ((ret = url_converter(handle, lfn, &url_host, &url_path, &tmp_err)) == 0) {
         ret = lfc_configure_environment(ops, url_host, lfn, &tmp_err);
         if (!tmp_err) {
-            gfal_auto_maintain_session(ops, &tmp_err);
             ret = ops->access(url_path, mode);
             if (ret < 0) {
                 int sav_errno = gfal_lfc_get_errno(ops);
@@ -267,7 +265,6 @@ int lfc_renameG(plugin_handle handle, const char *oldpath, const char *newpath,
         && (ret = url_converter(handle, newpath, &dest_url_host, &dest_url_path, &tmp_err)) == 0) {
         ret = lfc_configure_environment(ops, source_url_host, oldpath, &tmp_err);
         if (!tmp_err) {
-            gfal_auto_maintain_session(ops, &tmp_err);
             ret = ops->rename(source_url_path, dest_url_path);
             if (ret < 0) {
                 int sav_errno = gfal_lfc_get_errno(ops);
@@ -308,7 +305,6 @@ int lfc_symlinkG(plugin_handle handle, const char *oldpath, const char *newpath,
         && (ret = url_converter(handle, newpath, &link_url_host, &link_url_path, &tmp_err)) == 0) {
         ret = lfc_configure_environment(ops, url_host, oldpath, &tmp_err);
         if (!tmp_err) {
-            gfal_auto_maintain_session(ops, &tmp_err);
             ret = ops->symlink(url_path, link_url_path);
             if (ret < 0) {
                 int sav_errno = gfal_lfc_get_errno(ops);
@@ -339,7 +335,6 @@ int lfc_statG(plugin_handle handle, const char *path, struct stat *st, GError **
     if ((ret = url_converter(handle, path, &url_host, &url_path, &tmp_err)) == 0) {
         ret = lfc_configure_environment(ops, url_host, path, &tmp_err);
         if (!tmp_err) {
-            gfal_auto_maintain_session(ops, &tmp_err);
             struct lfc_filestatg statbuf;
             ret = gfal_lfc_statg(ops, url_path, &statbuf, &tmp_err);
             if (ret == 0) {
@@ -377,7 +372,6 @@ static int lfc_lstatG(plugin_handle handle, const char *path, struct stat *st, G
             }
             else {
                 gfal2_log(G_LOG_LEVEL_DEBUG, " lfc_lstatG -> value not in cache, do normal call");
-                gfal_auto_maintain_session(ops, &tmp_err);
                 if (!tmp_err) {
                     ret = ops->lstat(url_path, &statbuf);
                     if (ret != 0) {
@@ -414,7 +408,6 @@ static int lfc_mkdirpG(plugin_handle handle, const char *path, mode_t mode, gboo
     if ((ret = url_converter(handle, path, &url_host, &url_path, &tmp_err)) == 0) {
         ret = lfc_configure_environment(ops, url_host, path, &tmp_err);
         if (!tmp_err) {
-            gfal_auto_maintain_session(ops, &tmp_err);
             ret = gfal_lfc_ifce_mkdirpG(ops, url_path, mode, pflag, &tmp_err);
         }
     }
@@ -469,8 +462,6 @@ static gfal_file_handle lfc_opendirG(plugin_handle handle, const char *path, GEr
     if (url_converter(handle, path, &url_host, &url_path, &tmp_err) == 0) {
         lfc_configure_environment(ops, url_host, path, &tmp_err);
         if (!tmp_err) {
-            gfal_auto_maintain_session(ops, &tmp_err);
-
             d = (DIR *) ops->opendirg(url_path, NULL);
             if (d == NULL) {
                 int sav_errno = gfal_lfc_get_errno(ops);
@@ -538,7 +529,6 @@ static struct dirent *lfc_readdirppG(plugin_handle handle, gfal_file_handle fh,
     int sav_errno = 0;
     struct lfc_ops *ops = (struct lfc_ops *) handle;
 
-    gfal_auto_maintain_session(ops, &tmp_err);
     gfal_lfc_reset_errno(ops);
 
     lfc_opendir_handle oh = (lfc_opendir_handle) gfal_file_handle_get_user_data(fh);
@@ -592,7 +582,6 @@ static int lfc_checksumG(plugin_handle handle, const char *path, const char *che
     struct lfc_ops *ops = (struct lfc_ops *) handle;
     GError *tmp_err = NULL;
     ssize_t ret = -1;
-    gfal_auto_maintain_session(ops, &tmp_err);
 
     char *url_path = NULL, *url_host = NULL;
 
@@ -622,7 +611,6 @@ static int lfc_checksumTypeG(plugin_handle handle, const char *path,
     struct lfc_ops *ops = (struct lfc_ops *) handle;
     GError *tmp_err = NULL;
     ssize_t ret = -1;
-    gfal_auto_maintain_session(ops, &tmp_err);
 
     char *url_path = NULL, *url_host = NULL;
 
@@ -746,7 +734,6 @@ ssize_t lfc_getxattrG(plugin_handle handle, const char *path, const char *name,
     GError *tmp_err = NULL;
     ssize_t res = -1;
     struct lfc_ops *ops = (struct lfc_ops *) handle;
-    gfal_auto_maintain_session(ops, &tmp_err);
     if (strncmp(name, GFAL_XATTR_GUID, LFC_MAX_XATTR_LEN) == 0) {
         res = lfc_getxattr_getguid(handle, path, buff, size, &tmp_err);
     }
@@ -959,7 +946,6 @@ static ssize_t lfc_readlinkG(plugin_handle handle, const char *path, char *buff,
     GError *tmp_err = NULL;
     ssize_t ret = -1;
     char res_buff[LFC_BUFF_SIZE];
-    gfal_auto_maintain_session(ops, &tmp_err);
 
     char *url_path = NULL, *url_host = NULL;
 
@@ -992,6 +978,142 @@ static ssize_t lfc_readlinkG(plugin_handle handle, const char *path, char *buff,
 }
 
 
+/*
+ * Bulk operations are issued per LFC host, over consecutive runs of urls
+ * resolving to the same host, by batches of at most BULK_SIZE files
+ */
+typedef int (*lfc_bulk_func)(struct lfc_ops *ops, int nbfiles, const char *const *paths,
+    int offset, void *user_data, GError **errors);
+
+static int lfc_bulk_foreach_host(struct lfc_ops *ops, int nbfiles, const char *const *urls,
+    lfc_bulk_func func, void *user_data, GError **errors)
+{
+    char **hosts = g_new0(char *, nbfiles);
+    char **paths = g_new0(char *, nbfiles);
+    int i, ret = 0;
+    const int bulk_size = MAX(1, gfal2_get_opt_integer_with_default(ops->handle,
+        LFC_ENV_VAR_GROUP_PLUGIN, LFC_CONFIG_BULK_SIZE, 1000));
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (url_converter(ops, urls[i], &hosts[i], &paths[i], &errors[i]) != 0) {
+            if (errors[i] == NULL)
+                gfal2_set_error(&errors[i], gfal2_get_plugin_lfc_quark(), EINVAL, __func__,
+                    "Invalid lfc url %s", urls[i]);
+            g_free(paths[i]);
+            paths[i] = NULL;
+            ret = -1;
+        }
+    }
+
+    int first = 0;
+    while (first < nbfiles) {
+        int last = first + 1;
+        while (last < nbfiles && last - first < bulk_size && g_strcmp0(hosts[first], hosts[last]) == 0)
+            ++last;
+
+        GError *tmp_err = NULL;
+        lfc_configure_environment(ops, hosts[first], urls[first], &tmp_err);
+        if (tmp_err == NULL) {
+            if (func(ops, last - first, (const char *const *) paths + first, first, user_data, errors + first) < 0)
+                ret = -1;
+        }
+        else {
+            for (i = first; i < last; ++i) {
+                if (paths[i] != NULL)
+                    errors[i] = g_error_copy(tmp_err);
+            }
+            g_error_free(tmp_err);
+            ret = -1;
+        }
+        lfc_unset_environment(ops);
+        first = last;
+    }
+
+    for (i = 0; i < nbfiles; ++i) {
+        g_free(hosts[i]);
+        g_free(paths[i]);
+    }
+    g_free(hosts);
+    g_free(paths);
+    return ret;
+}
+
+
+static int lfc_stat_list_batch(struct lfc_ops *ops, int nbfiles, const char *const *paths,
+    int offset, void *user_data, GError **errors)
+{
+    struct stat *buffers = ((struct stat *) user_data) + offset;
+    struct lfc_filestatg *statbufs = g_new0(struct lfc_filestatg, nbfiles);
+    int i;
+
+    int ret = gfal_lfc_statg_list(ops, nbfiles, paths, statbufs, errors);
+    for (i = 0; i < nbfiles; ++i) {
+        if (paths[i] != NULL && errors[i] == NULL)
+            gfal_lfc_convert_statg(&buffers[i], &statbufs[i], NULL);
+    }
+    errno = 0;
+    g_free(statbufs);
+    return ret;
+}
+
+/*
+ * stat a list of lfns, reusing the session of the host for all of them
+ */
+static int lfc_stat_listG(plugin_handle handle, int nbfiles, const char *const *urls,
+    struct stat *buffers, GError **errors)
+{
+    struct lfc_ops *ops = (struct lfc_ops *) handle;
+    return lfc_bulk_foreach_host(ops, nbfiles, urls, lfc_stat_list_batch, buffers, errors);
+}
+
+
+struct lfc_getxattr_list_data {
+    char **values;
+    size_t s_value;
+};
+
+static int lfc_getsurl_list_batch(struct lfc_ops *ops, int nbfiles, const char *const *paths,
+    int offset, void *user_data, GError **errors)
+{
+    struct lfc_getxattr_list_data *data = (struct lfc_getxattr_list_data *) user_data;
+    char ***replicas = g_new0(char **, nbfiles);
+    int i;
+
+    int ret = gfal_lfc_getSURL_list(ops, nbfiles, paths, replicas, errors);
+    for (i = 0; i < nbfiles; ++i) {
+        if (replicas[i] != NULL) {
+            g_strv_catbuff(replicas[i], data->values[offset + i], data->s_value);
+            g_strfreev(replicas[i]);
+        }
+    }
+    errno = 0;
+    g_free(replicas);
+    return ret;
+}
+
+/*
+ * getxattr over a list of lfns
+ * user.replicas is resolved with one getreplicas request per batch, other attributes file by file
+ */
+static int lfc_getxattr_listG(plugin_handle handle, int nbfiles, const char *const *urls,
+    const char *name, char **values, size_t s_value, GError **errors)
+{
+    struct lfc_ops *ops = (struct lfc_ops *) handle;
+    int i, ret = 0;
+
+    if (strncmp(name, GFAL_XATTR_REPLICA, LFC_MAX_XATTR_LEN) == 0) {
+        struct lfc_getxattr_list_data data = {values, s_value};
+        return lfc_bulk_foreach_host(ops, nbfiles, urls, lfc_getsurl_list_batch, &data, errors);
+    }
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (lfc_getxattrG(handle, urls[i], name, values[i], s_value, &errors[i]) < 0)
+            ret = -1;
+    }
+    return ret;
+}
+
+
 static void internal_stat_copy(gpointer original, gpointer copy)
 {
     memcpy(copy, original, sizeof(struct stat));
@@ -1048,6 +1170,8 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     lfc_plugin.unlinkG = &lfc_unlinkG;
     lfc_plugin.readdirppG = &lfc_readdirppG;
     lfc_plugin.checksum_calcG = &lfc_checksumG;
+    lfc_plugin.stat_listG = &lfc_stat_listG;
+    lfc_plugin.getxattr_listG = &lfc_getxattr_listG;
 
     // Copy (as register)
     lfc_plugin.check_plugin_url_transfer = gfal_lfc_register_check;
@@ -47,9 +47,25 @@ int _Cthread_addcid(char *, int, char *, int, Cth_pid_t *, unsigned, void *(*)(v
 
 static __thread int _local_thread_init = FALSE;
 
-static volatile time_t session_timestamp = 0;
-static long session_duration = 20;
-static pthread_mutex_t m_session = PTHREAD_MUTEX_INITIALIZER;
+// liblfc binds a session to the thread that started it, so sessions are kept per thread.
+// A session is restarted when the host or the credentials change, when it expires,
+// or after a communication error
+struct gfal_lfc_session {
+    gboolean open;
+    gboolean broken;
+    time_t expires;
+    // ops->endsess of the plugin that started the session, the ops may be gone by thread exit
+    int (*endsess) ();
+    // host and credentials the session was started with
+    char key[GFAL_URL_MAX_LEN];
+};
+
+// The session of the thread, also registered under session_key so it is ended when the thread exits
+static __thread struct gfal_lfc_session *_local_session = NULL;
+static pthread_key_t session_key;
+static pthread_once_t session_key_once = PTHREAD_ONCE_INIT;
+
+static volatile gint session_duration = 20;
 
 int gfal_lfc_regex_compile(regex_t *rex, GError **err)
 {
@@ -175,6 +191,11 @@ int lfc_configure_environment(struct lfc_ops *ops, const char *host, const char
     g_free(ucert);
     g_free(ukey);
 
+    // Host and credentials are set, so the session can be checked against them
+    if (ret == 0 && !tmp_err) {
+        gfal_auto_maintain_session(ops, &tmp_err);
+    }
+
     G_RETURN_ERR(ret, tmp_err, err);
 }
 
@@ -213,51 +234,123 @@ void gfal_lfc_init_thread(struct lfc_ops *ops)
 }
 
 
-// WARNING : ALL SESSIONS and transactions for LFC disabled
-// REASONS : unstable, can just fail forever in case of connexion drop
+// Called when a thread exits, the only one that can end its session
+static void gfal_lfc_session_orphan(void *data)
+{
+    struct gfal_lfc_session *session = (struct gfal_lfc_session *) data;
+    if (session->open) {
+        session->endsess();
+    }
+    g_free(session);
+}
+
+
+static void gfal_lfc_session_key_init(void)
+{
+    pthread_key_create(&session_key, gfal_lfc_session_orphan);
+}
+
+
+static struct gfal_lfc_session *gfal_lfc_get_session(void)
+{
+    if (G_LIKELY(_local_session != NULL))
+        return _local_session;
+
+    struct gfal_lfc_session *session = g_new0(struct gfal_lfc_session, 1);
+    pthread_once(&session_key_once, gfal_lfc_session_key_init);
+    pthread_setspecific(session_key, session);
+    _local_session = session;
+    return session;
+}
+
+
 int gfal_lfc_startSession(struct lfc_ops *ops, GError **err)
 {
-    /*if (ops->startsess (ops->lfc_endpoint, "gfal2 auto-session") < 0){
-		int sav_errno = gfal_lfc_get_errno(ops);
+    char *host = g_strdup(lfc_plugin_get_lfc_env(ops, LFC_ENV_VAR_HOST));
+    if (ops->startsess(host, "gfal2 auto-session") < 0) {
+        int sav_errno = gfal_lfc_get_errno(ops);
         gfal2_set_error(err, gfal2_get_plugin_lfc_quark(), sav_errno, __func__,
             "Error while start session with lfc, lfc_endpoint: %s, Error : %s ",
-             ops->lfc_endpoint, gfal_lfc_get_strerror(ops));
-		return -1;
-    }*/
+            host, gfal_lfc_get_strerror(ops));
+        g_free(host);
+        return -1;
+    }
+    g_free(host);
     return 0;
 }
-/* --> session reused disabled -> bugged in liblfc
-static int gfal_lfc_endSession(struct lfc_ops* ops, GError ** err){
-	if (ops->endsess() < 0){
-		int sav_errno = gfal_lfc_get_errno(ops);
+
+
+static int gfal_lfc_endSession(struct lfc_ops *ops, GError **err)
+{
+    gfal_lfc_get_session()->open = FALSE;
+    if (ops->endsess() < 0) {
+        int sav_errno = gfal_lfc_get_errno(ops);
         gfal2_set_error(err, gfal2_get_plugin_lfc_quark(), sav_errno, __func__,
-            "Error while start transaction with lfc, Error : %s ", gfal_lfc_get_strerror(ops));
-		return -1;
-	}
-	return 0;
-}*/
+            "Error while end session with lfc, Error : %s ", gfal_lfc_get_strerror(ops));
+        return -1;
+    }
+    return 0;
+}
+
+
+static void gfal_lfc_session_key(struct lfc_ops *ops, char *buff, size_t s_buff)
+{
+    const char *host = lfc_plugin_get_lfc_env(ops, LFC_ENV_VAR_HOST);
+    const char *cert = getenv("X509_USER_CERT");
+    const char *key = getenv("X509_USER_KEY");
+    const char *proxy = getenv("X509_USER_PROXY");
+    snprintf(buff, s_buff, "%s|%s|%s|%s", host ? host : "", cert ? cert : "",
+        key ? key : "", proxy ? proxy : "");
+}
+
 
 // session re-use
+// Must be called once the environment has been configured for the call
 void gfal_auto_maintain_session(struct lfc_ops *ops, GError **err)
 {
-    /*time_t current = time(NULL); --> disabled, thread safety problem in liblfc inthe current state
-    if(session_timestamp < current){
-        pthread_mutex_lock(&m_session);
-        if(session_timestamp < current){
+    GError *tmp_err = NULL;
+    char key[GFAL_URL_MAX_LEN];
+    time_t current = time(NULL);
+    struct gfal_lfc_session *session = gfal_lfc_get_session();
+
+    if (!gfal2_get_opt_boolean_with_default(ops->handle, LFC_ENV_VAR_GROUP_PLUGIN,
+            LFC_CONFIG_SESSION_REUSE, TRUE)) {
+        if (session->open)
             gfal_lfc_endSession(ops, NULL);
-            gfal_lfc_startSession(ops, err);
-            current = time(NULL);
-            session_timestamp = current + session_duration;
+        return;
+    }
+
+    gfal_lfc_session_key(ops, key, sizeof(key));
+    if (session->open) {
+        if (!session->broken && current < session->expires &&
+            strcmp(key, session->key) == 0) {
+            return;
         }
-        pthread_mutex_unlock(&m_session);
-    }*/
+        gfal2_log(G_LOG_LEVEL_DEBUG, "lfc plugin : %s session, restart it",
+            session->broken ? "broken" : "expired or different endpoint");
+        gfal_lfc_endSession(ops, NULL);
+    }
+
+    // Without a session, each call opens its own connection, so this is not fatal
+    if (gfal_lfc_startSession(ops, &tmp_err) < 0) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "lfc plugin : could not start a session: %s", tmp_err->message);
+        g_error_free(tmp_err);
+        return;
+    }
+
+    const long timeout = gfal2_get_opt_integer_with_default(ops->handle, LFC_ENV_VAR_GROUP_PLUGIN,
+        LFC_CONFIG_SESSION_TIMEOUT, g_atomic_int_get(&session_duration));
+
+    session->open = TRUE;
+    session->broken = FALSE;
+    session->endsess = ops->endsess;
+    session->expires = current + timeout;
+    g_strlcpy(session->key, key, sizeof(session->key));
 }
 
 void lfc_set_session_timeout(int timeout)
 {
-    pthread_mutex_lock(&m_session);
-    session_duration = timeout;
-    pthread_mutex_unlock(&m_session);
+    g_atomic_int_set(&session_duration, timeout);
 }
 
 
@@ -348,6 +441,7 @@ struct lfc_ops *gfal_load_lfc(const char *name, GError **err)
     lfc_sym->getpath = &lfc_getpath;
     lfc_sym->getlinks = &lfc_getlinks;
     lfc_sym->getreplica = &lfc_getreplica;
+    lfc_sym->getreplicas = &lfc_getreplicas;
     lfc_sym->lstat = &lfc_lstat;
     lfc_sym->mkdirg = &lfc_mkdirg;
     lfc_sym->seterrbuf = &lfc_seterrbuf;
@@ -535,6 +629,101 @@ char **gfal_lfc_getSURL(struct lfc_ops *ops, const char *path, GError **err)
 
 }
 
+/*
+ * statg a list of paths, on the session of the calling thread
+ * paths set to NULL are skipped
+ * return 0 if all succeeded, -1 otherwise, with errors set for each failure
+ */
+int gfal_lfc_statg_list(struct lfc_ops *ops, int nbfiles, const char *const *paths,
+    struct lfc_filestatg *statbufs, GError **errors)
+{
+    int i, ret = 0;
+    for (i = 0; i < nbfiles; ++i) {
+        if (paths[i] == NULL)
+            continue;
+        if (gfal_lfc_statg(ops, paths[i], &statbufs[i], &errors[i]) < 0)
+            ret = -1;
+    }
+    return ret;
+}
+
+/*
+ * return the list of surls of each path
+ * the guids are resolved with statg, and the replicas of all of them
+ * are retrieved with a single getreplicas request
+ * paths set to NULL are skipped
+ * return 0 if all succeeded, -1 otherwise, with errors set for each failure
+ */
+int gfal_lfc_getSURL_list(struct lfc_ops *ops, int nbfiles, const char *const *paths,
+    char ***replicas, GError **errors)
+{
+    struct lfc_filestatg *statbufs = g_new0(struct lfc_filestatg, nbfiles);
+    const char **guids = g_new0(const char *, nbfiles);
+    int nbguids = 0, nbentries = 0, i, ret = 0;
+    struct lfc_filereplicas *entries = NULL;
+
+    ret = gfal_lfc_statg_list(ops, nbfiles, paths, statbufs, errors);
+    for (i = 0; i < nbfiles; ++i) {
+        if (paths[i] != NULL && errors[i] == NULL)
+            guids[nbguids++] = statbufs[i].guid;
+    }
+
+    // guid -> GPtrArray of surls
+    GHashTable *by_guid = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+        (GDestroyNotify) g_ptr_array_unref);
+
+    if (nbguids > 0 && ops->getreplicas(nbguids, guids, NULL, &nbentries, &entries) < 0) {
+        int myerrno = gfal_lfc_get_errno(ops);
+        for (i = 0; i < nbfiles; ++i) {
+            if (paths[i] != NULL && errors[i] == NULL)
+                gfal2_set_error(&errors[i], gfal2_get_plugin_lfc_quark(), myerrno, __func__,
+                    "error reported from lfc : %s", gfal_lfc_get_strerror(ops));
+        }
+        ret = -1;
+        nbentries = 0;
+    }
+
+    GHashTable *failed = g_hash_table_new(g_str_hash, g_str_equal);
+    for (i = 0; i < nbentries; ++i) {
+        if (entries[i].errcode != 0) {
+            g_hash_table_insert(failed, entries[i].guid, GINT_TO_POINTER(entries[i].errcode));
+            continue;
+        }
+        GPtrArray *surls = g_hash_table_lookup(by_guid, entries[i].guid);
+        if (surls == NULL) {
+            surls = g_ptr_array_new();
+            g_hash_table_insert(by_guid, entries[i].guid, surls);
+        }
+        g_ptr_array_add(surls, entries[i].sfn);
+    }
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (paths[i] == NULL || errors[i] != NULL)
+            continue;
+        gpointer errcode = g_hash_table_lookup(failed, statbufs[i].guid);
+        if (errcode != NULL) {
+            gfal2_set_error(&errors[i], gfal2_get_plugin_lfc_quark(), GPOINTER_TO_INT(errcode),
+                __func__, "error reported from lfc : %s", ops->sstrerror(GPOINTER_TO_INT(errcode)));
+            ret = -1;
+            continue;
+        }
+        GPtrArray *surls = g_hash_table_lookup(by_guid, statbufs[i].guid);
+        int size = surls ? surls->len : 0, j;
+        replicas[i] = malloc(sizeof(char *) * (size + 1));
+        replicas[i][size] = NULL;
+        for (j = 0; j < size; ++j) {
+            replicas[i][j] = strndup(g_ptr_array_index(surls, j), GFAL_URL_MAX_LEN);
+        }
+    }
+
+    g_hash_table_destroy(failed);
+    g_hash_table_destroy(by_guid);
+    free(entries);
+    g_free(guids);
+    g_free(statbufs);
+    return ret;
+}
+
 /*
  * return the comment associated with this path
  *  follow the xattr behavior, if buff==NULL, return only the appropriate buffer size for the call
@@ -657,6 +846,20 @@ int gfal_lfc_get_errno(struct lfc_ops *ops)
 #else
     lfc_error = *ops->get_serrno ;
 #endif
+    // The connection of the session may be gone, so do not reuse it
+    // Authorization and namespace errors leave it usable
+    switch (lfc_error) {
+        case SECOMERR:
+        case SECONNDROP:
+        case SETIMEDOUT:
+        case ECOMM:
+        case ECONNRESET:
+        case ECONNREFUSED:
+        case ETIMEDOUT:
+        case EPIPE:
+            gfal_lfc_get_session()->broken = TRUE;
+            break;
+    }
     switch (lfc_error) {
         case ESEC_BAD_CREDENTIALS:
             lfc_error = EPERM;
@@ -42,6 +42,10 @@
 
 #define LFC_ENV_VAR_GROUP_PLUGIN "LFC PLUGIN"
 
+#define LFC_CONFIG_SESSION_REUSE "SESSION_REUSE"
+#define LFC_CONFIG_SESSION_TIMEOUT "SESSION_TIMEOUT"
+#define LFC_CONFIG_BULK_SIZE "BULK_SIZE"
+
 typedef struct _lfc_checksum{
     char type[255];
     char value[GFAL_URL_MAX_LEN];
@@ -75,6 +79,7 @@ struct lfc_ops {
     int (*getpath)(char *, u_signed64, char *);
     int (*getlinks)(const char *, const char *, int *, struct lfc_linkinfo **);
     int (*getreplica)(const char *, const char *, const char *, int *, struct lfc_filereplica **);
+    int (*getreplicas)(int, const char **, const char *, int *, struct lfc_filereplicas **);
     int (*setcomment) (const char * path, char * comment );
     int (*getcomment) (const char * path, char * comment);
     int (*lstat)(const char *, struct lfc_filestat *);
@@ -137,6 +142,12 @@ int gfal_lfc_ifce_mkdirpG(struct lfc_ops* ops,const char* path, mode_t mode, gbo
 
 char ** gfal_lfc_getSURL(struct lfc_ops* ops, const char* path, GError** err);
 
+int gfal_lfc_statg_list(struct lfc_ops* ops, int nbfiles, const char* const* paths,
+        struct lfc_filestatg* statbufs, GError** errors);
+
+int gfal_lfc_getSURL_list(struct lfc_ops* ops, int nbfiles, const char* const* paths,
+        char*** replicas, GError** errors);
+
 void gfal_lfc_init_thread(struct lfc_ops* ops);
 
 int gfal_lfc_startSession(struct lfc_ops* ops, GError ** err);
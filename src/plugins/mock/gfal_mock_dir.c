@@ -19,6 +19,7 @@
  */
 
 #include "gfal_mock_plugin.h"
+#include <stdio.h>
 #include <string.h>
 
 
@@ -31,6 +32,15 @@ typedef struct {
 typedef struct {
     GSList *list;
     GSList *item;
+    char *url;
+    // Generated listing, when "entries" is given instead of "list"
+    long long entries;
+    long long index;
+    off_t entry_size;
+    MockPluginDirEntry generated;
+    // Entries are served in pages, each one costing a round trip
+    long long page_size;
+    long long page_left;
 } MockPluginDirectory;
 
 
@@ -80,6 +90,13 @@ gfal_file_handle gfal_plugin_mock_opendir(plugin_handle plugin_data,
     }
 
     dir->item = dir->list;
+    dir->url = g_strdup(url);
+    char arg_buffer[64];
+    gfal_plugin_mock_get_value(url, "entries", arg_buffer, sizeof(arg_buffer));
+    dir->entries = gfal_plugin_mock_get_int_from_str(arg_buffer);
+    gfal_plugin_mock_get_value(url, "entry_size", arg_buffer, sizeof(arg_buffer));
+    dir->entry_size = gfal_plugin_mock_get_int_from_str(arg_buffer);
+    dir->page_size = gfal_plugin_mock_get_param(plugin_data, url, "page_size", "READDIR_PAGE_SIZE", 0);
     return gfal_file_handle_new2(gfal_mock_plugin_getName(), dir, NULL, url);
 }
 
@@ -90,6 +107,7 @@ int gfal_plugin_mock_closedir(plugin_handle plugin_data,
     MockPluginDirectory *dir = gfal_file_handle_get_fdesc(dir_desc);
     g_slist_foreach(dir->list, (GFunc) g_free, NULL);
     g_slist_free(dir->list);
+    g_free(dir->url);
     g_free(dir);
     gfal_file_handle_delete(dir_desc);
     return 0;
@@ -100,12 +118,33 @@ struct dirent *gfal_plugin_mock_readdirpp(plugin_handle plugin_data,
     gfal_file_handle dir_desc, struct stat *st, GError **err)
 {
     MockPluginDirectory *dir = gfal_file_handle_get_fdesc(dir_desc);
-    if (!dir->item) {
+    MockPluginDirEntry *entry;
+
+    if (dir->item) {
+        entry = (MockPluginDirEntry *) (dir->item->data);
+        dir->item = g_slist_next(dir->item);
+    }
+    else if (dir->index < dir->entries) {
+        entry = &dir->generated;
+        memset(entry, 0, sizeof(*entry));
+        snprintf(entry->de.d_name, sizeof(entry->de.d_name), "file%08lld", dir->index);
+        entry->de.d_reclen = strnlen(entry->de.d_name, 256);
+        entry->de.d_type = DT_REG;
+        entry->st.st_mode = S_IFREG | 0644;
+        entry->st.st_size = dir->entry_size;
+        ++dir->index;
+    }
+    else {
         return NULL;
     }
 
-    MockPluginDirEntry *entry = (MockPluginDirEntry *) (dir->item->data);
-    dir->item = g_slist_next(dir->item);
+    if (dir->page_size > 0) {
+        if (dir->page_left == 0) {
+            gfal_plugin_mock_delay(plugin_data, dir->url);
+            dir->page_left = dir->page_size;
+        }
+        --dir->page_left;
+    }
 
     memcpy(st, &entry->st, sizeof(struct stat));
     return &entry->de;
@@ -27,15 +27,19 @@
 #endif
 
 typedef struct {
-    const char *url;
+    char *url;
     int fd;
     off_t size;
     off_t offset;
+    MockPayload payload;
+    MockPacer pacer;
+    gboolean connected;
 } MockFile;
 
 
 gfal_file_handle gfal_plugin_mock_open(plugin_handle plugin_data, const char *url, int flag, mode_t mode, GError **err)
 {
+    MockPluginData *mdata = plugin_data;
     struct stat st;
     int ret = gfal_plugin_mock_stat(plugin_data, url, &st, err);
     if (ret < 0) {
@@ -50,33 +54,47 @@ gfal_file_handle gfal_plugin_mock_open(plugin_handle plugin_data, const char *ur
         return NULL;
     }
 
-    MockFile *fd = g_malloc(sizeof(MockFile));
-    fd->url = url;
+    MockFile *fd = g_new0(MockFile, 1);
     fd->size = st.st_size;
     fd->offset = 0;
+    fd->fd = -1;
+    fd->payload = gfal_plugin_mock_get_payload(mdata, url);
     if (flag == O_RDONLY) {
-        fd->fd = open("/dev/urandom", O_RDONLY);
+        if (fd->payload == MOCK_PAYLOAD_URANDOM) {
+            fd->fd = open("/dev/urandom", O_RDONLY);
+        }
     }
     else if (flag == O_WRONLY) {
         fd->fd = open("/dev/null", O_WRONLY);
     }
     else {
         gfal_plugin_mock_report_error("Mock plugin does not support read and write", ENOSYS, err);
+        g_free(fd);
         return NULL;
     }
 
-    if (fd->fd < 0) {
+    if (fd->fd < 0 && (flag == O_WRONLY || fd->payload == MOCK_PAYLOAD_URANDOM)) {
         gfal_plugin_mock_report_error("Could not open the file!", errno, err);
+        g_free(fd);
         return NULL;
     }
 
+    ret = gfal_plugin_mock_connect(mdata, url, err);
+    if (ret < 0) {
+        if (fd->fd >= 0)
+            close(fd->fd);
+        g_free(fd);
+        return NULL;
+    }
+    fd->connected = (ret > 0);
+    fd->url = g_strdup(url);
     return gfal_file_handle_new2(gfal_mock_plugin_getName(), fd, NULL, url);
 }
 
 
-ssize_t gfal_plugin_mock_read(plugin_handle plugin_data, gfal_file_handle fd, void *buff, size_t count, GError **err)
+static ssize_t gfal_plugin_mock_read_at(MockPluginData *mdata, MockFile *mfd, void *buff, size_t count,
+    off_t offset, GError **err)
 {
-    MockFile *mfd = gfal_file_handle_get_fdesc(fd);
     char arg_buffer[64] = {0};
 
     gfal_plugin_mock_get_value(mfd->url, "read_wait", arg_buffer, sizeof(arg_buffer));
@@ -92,36 +110,68 @@ ssize_t gfal_plugin_mock_read(plugin_handle plugin_data, gfal_file_handle fd, vo
         return -1;
     }
 
-    off_t remaining = mfd->size - mfd->offset;
-    if (count > remaining) {
-        count = remaining;
-    }
+    gfal_plugin_mock_delay(mdata, mfd->url);
 
-    if (count < 0) {
+    if (offset > mfd->size) {
         gfal_plugin_mock_report_error("Reading passed end of file", EBADFD, err);
         return -1;
     }
 
-    off_t nread = read(mfd->fd, buff, count);
-    if (nread < 0) {
-        gfal_plugin_mock_report_error("Failed to read file", errno, err);
-        return -1;
+    off_t remaining = mfd->size - offset;
+    if (count > remaining) {
+        count = remaining;
+    }
+
+    ssize_t nread = count;
+    if (mfd->payload == MOCK_PAYLOAD_URANDOM) {
+        nread = read(mfd->fd, buff, count);
+        if (nread < 0) {
+            gfal_plugin_mock_report_error("Failed to read file", errno, err);
+            return -1;
+        }
+    }
+    else {
+        gfal_plugin_mock_fill(mfd->payload, buff, count, offset);
     }
 
-    mfd->offset += nread;
+    gfal_plugin_mock_throttle(mdata, &mfd->pacer, mfd->url, nread);
     return nread;
 }
 
+
+ssize_t gfal_plugin_mock_read(plugin_handle plugin_data, gfal_file_handle fd, void *buff, size_t count, GError **err)
+{
+    MockFile *mfd = gfal_file_handle_get_fdesc(fd);
+    ssize_t nread = gfal_plugin_mock_read_at(plugin_data, mfd, buff, count, mfd->offset, err);
+    if (nread > 0) {
+        mfd->offset += nread;
+    }
+    return nread;
+}
+
+
+ssize_t gfal_plugin_mock_pread(plugin_handle plugin_data, gfal_file_handle fd, void *buff, size_t count,
+    off_t offset, GError **err)
+{
+    MockFile *mfd = gfal_file_handle_get_fdesc(fd);
+    return gfal_plugin_mock_read_at(plugin_data, mfd, buff, count, offset, err);
+}
+
+
 ssize_t gfal_plugin_mock_write(plugin_handle plugin_data, gfal_file_handle fd, const void *buff, size_t count,
     GError **err)
 {
     MockFile *mfd = gfal_file_handle_get_fdesc(fd);
 
+    gfal_plugin_mock_delay(plugin_data, mfd->url);
+
     off_t nwrite = write(mfd->fd, buff, count);
     if (nwrite < 0) {
         gfal_plugin_mock_report_error("Failed to write file", errno, err);
+        return -1;
     }
 
+    gfal_plugin_mock_throttle(plugin_data, &mfd->pacer, mfd->url, nwrite);
     mfd->offset += nwrite;
     return nwrite;
 }
@@ -130,7 +180,13 @@ ssize_t gfal_plugin_mock_write(plugin_handle plugin_data, gfal_file_handle fd, c
 int gfal_plugin_mock_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err)
 {
     MockFile *mfd = gfal_file_handle_get_fdesc(fd);
-    close(mfd->fd);
+    if (mfd->connected) {
+        gfal_plugin_mock_disconnect(plugin_data, mfd->url);
+    }
+    if (mfd->fd >= 0) {
+        close(mfd->fd);
+    }
+    g_free(mfd->url);
     g_free(mfd);
     return 0;
 }
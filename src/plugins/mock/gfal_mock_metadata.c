@@ -43,6 +43,8 @@ int gfal_plugin_mock_stat(plugin_handle plugin_data, const char *path, struct st
         sleep(wait_time);
     }
 
+    gfal_plugin_mock_delay(mdata, path);
+
     // Trigger signal
     gfal_plugin_mock_get_value(path, "signal", arg_buffer, sizeof(arg_buffer));
     signum = gfal_plugin_mock_get_int_from_str(arg_buffer);
@@ -94,8 +96,10 @@ int gfal_plugin_mock_stat(plugin_handle plugin_data, const char *path, struct st
     buf->st_size = size;
     buf->st_mode = 0755;
 
-    arg_buffer[0] = '\0';
     gfal_plugin_mock_get_value(path, "list", arg_buffer, sizeof(arg_buffer));
+    if (!arg_buffer[0]) {
+        gfal_plugin_mock_get_value(path, "entries", arg_buffer, sizeof(arg_buffer));
+    }
     if (arg_buffer[0]) {
         buf->st_mode |= S_IFDIR;
     }
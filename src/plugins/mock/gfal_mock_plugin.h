@@ -31,13 +31,31 @@ typedef enum {
 } StatStage;
 
 
+typedef enum {
+    MOCK_PAYLOAD_URANDOM = 0,
+    MOCK_PAYLOAD_ZERO,
+    MOCK_PAYLOAD_PATTERN
+} MockPayload;
+
+
 typedef struct {
     gfal2_context_t handle;
     StatStage stat_stage;
     char enable_signals;
+    // Shaping state, shared by all handles, see gfal_mock_shaping.c
+    GMutex *lock;
+    GCond *cond;
+    GHashTable *hosts;
+    GRand *rand;
 } MockPluginData;
 
 
+// Bandwidth pacer: monotonic time, in microseconds, at which the link is free again
+typedef struct {
+    gint64 next;
+} MockPacer;
+
+
 // Helpers
 const char *gfal_mock_plugin_getName();
 
@@ -49,6 +67,34 @@ void gfal_plugin_mock_get_value(const char *url, const char *key, char *value, s
 
 long long gfal_plugin_mock_get_int_from_str(const char* buff);
 
+// Shaping, see gfal_mock_shaping.c
+// Values given in the url query take precedence over the [MOCK PLUGIN] configuration
+void gfal_plugin_mock_shaping_init(MockPluginData *mdata);
+
+void gfal_plugin_mock_shaping_free(MockPluginData *mdata);
+
+long long gfal_plugin_mock_get_param(MockPluginData *mdata, const char *url,
+    const char *query_key, const char *config_key, long long default_value);
+
+// Sleep for the configured per operation latency, plus jitter
+void gfal_plugin_mock_delay(MockPluginData *mdata, const char *url);
+
+// Sleep as long as needed for count bytes to go through the handle and host bandwidth caps
+void gfal_plugin_mock_throttle(MockPluginData *mdata, MockPacer *pacer, const char *url, size_t count);
+
+// Take one of the max_connections slots of the host, waiting if none is free,
+// at most connect_timeout seconds and until the context is canceled.
+// Returns 1 if a slot was taken, and must be given back with gfal_plugin_mock_disconnect,
+// 0 if there is no limit, and -1 on error
+int gfal_plugin_mock_connect(MockPluginData *mdata, const char *url, GError **err);
+
+void gfal_plugin_mock_disconnect(MockPluginData *mdata, const char *url);
+
+MockPayload gfal_plugin_mock_get_payload(MockPluginData *mdata, const char *url);
+
+// Fill buffer with the zero or pattern payload, as found at offset
+void gfal_plugin_mock_fill(MockPayload payload, void *buffer, size_t count, off_t offset);
+
 // Metadata operations
 int gfal_plugin_mock_stat(plugin_handle plugin_data,
     const char *path, struct stat *buf, GError **err);
@@ -84,6 +130,9 @@ gfal_file_handle gfal_plugin_mock_open(plugin_handle plugin_data,
 ssize_t gfal_plugin_mock_read(plugin_handle, gfal_file_handle fd,
     void *buff, size_t count, GError **);
 
+ssize_t gfal_plugin_mock_pread(plugin_handle, gfal_file_handle fd,
+    void *buff, size_t count, off_t offset, GError **);
+
 ssize_t gfal_plugin_mock_write(plugin_handle, gfal_file_handle fd,
     const void *buff, size_t count, GError **);
 
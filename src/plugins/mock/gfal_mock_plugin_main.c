@@ -91,12 +91,10 @@ void gfal_plugin_mock_get_value(const char *url, const char *key, char *value, s
     char **args = g_strsplit(str + 1, "&", 0);
     int i;
     for (i = 0; args[i] != NULL; ++i) {
-        if (strncmp(args[i], key, key_len) == 0) {
-            char *p = strchr(args[i], '=');
-            if (p) {
-                g_strlcpy(value, p + 1, val_size);
-                break;
-            }
+        // Match the whole key, so "size" does not pick "size_pre"
+        if (strncmp(args[i], key, key_len) == 0 && args[i][key_len] == '=') {
+            g_strlcpy(value, args[i] + key_len + 1, val_size);
+            break;
         }
     }
 
@@ -127,6 +125,7 @@ gboolean gfal_plugin_mock_check_url_transfer(plugin_handle handle, gfal2_context
 
 void gfal_plugin_mock_delete(plugin_handle plugin_data)
 {
+    gfal_plugin_mock_shaping_free(plugin_data);
     free(plugin_data);
 }
 
@@ -182,6 +181,8 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
         gfal_mock_seppuku_hook();
     }
 
+    gfal_plugin_mock_shaping_init(mdata);
+
     mock_plugin.plugin_data = mdata;
     mock_plugin.plugin_delete = gfal_plugin_mock_delete;
     mock_plugin.check_plugin_url = &gfal_mock_check_url;
@@ -213,6 +214,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     mock_plugin.openG = gfal_plugin_mock_open;
     mock_plugin.closeG = gfal_plugin_mock_close;
     mock_plugin.readG = gfal_plugin_mock_read;
+    mock_plugin.preadG = gfal_plugin_mock_pread;
     mock_plugin.writeG = gfal_plugin_mock_write;
     mock_plugin.lseekG = gfal_plugin_mock_seek;
 
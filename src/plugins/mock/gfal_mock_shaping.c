@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gfal_mock_plugin.h"
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+// The pattern payload has the byte offset % MOCK_PATTERN_PERIOD at each offset.
+// A prime period keeps it from lining up with block sizes.
+#define MOCK_PATTERN_PERIOD 251
+
+static unsigned char mock_pattern[MOCK_PATTERN_PERIOD * 64];
+
+
+// Per host shared state
+typedef struct {
+    MockPacer pacer;
+    int connections;
+} MockHost;
+
+
+void gfal_plugin_mock_shaping_init(MockPluginData *mdata)
+{
+    static gsize pattern_initialized = 0;
+    if (g_once_init_enter(&pattern_initialized)) {
+        size_t i;
+        for (i = 0; i < sizeof(mock_pattern); ++i)
+            mock_pattern[i] = i % MOCK_PATTERN_PERIOD;
+        g_once_init_leave(&pattern_initialized, 1);
+    }
+
+    mdata->lock = g_mutex_new();
+    mdata->cond = g_cond_new();
+    mdata->hosts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+    // A fixed seed makes the jitter reproducible between runs
+    int seed = gfal2_get_opt_integer_with_default(mdata->handle, "MOCK PLUGIN", "SEED", 0);
+    if (seed)
+        mdata->rand = g_rand_new_with_seed(seed);
+    else
+        mdata->rand = g_rand_new();
+}
+
+
+void gfal_plugin_mock_shaping_free(MockPluginData *mdata)
+{
+    g_hash_table_destroy(mdata->hosts);
+    g_rand_free(mdata->rand);
+    g_cond_free(mdata->cond);
+    g_mutex_free(mdata->lock);
+}
+
+
+long long gfal_plugin_mock_get_param(MockPluginData *mdata, const char *url,
+    const char *query_key, const char *config_key, long long default_value)
+{
+    char arg_buffer[64];
+    gfal_plugin_mock_get_value(url, query_key, arg_buffer, sizeof(arg_buffer));
+    if (arg_buffer[0])
+        return gfal_plugin_mock_get_int_from_str(arg_buffer);
+    return gfal2_get_opt_integer_with_default(mdata->handle, "MOCK PLUGIN", config_key, default_value);
+}
+
+
+static void gfal_plugin_mock_get_string_param(MockPluginData *mdata, const char *url,
+    const char *query_key, const char *config_key, const char *default_value, char *value, size_t val_size)
+{
+    gfal_plugin_mock_get_value(url, query_key, value, val_size);
+    if (!value[0]) {
+        gchar *config_value = gfal2_get_opt_string_with_default(mdata->handle, "MOCK PLUGIN", config_key,
+            default_value);
+        g_strlcpy(value, config_value, val_size);
+        g_free(config_value);
+    }
+}
+
+
+// Must be called with the lock held
+static MockHost *gfal_plugin_mock_get_host(MockPluginData *mdata, const char *url)
+{
+    const char *host = url + 5;
+    if (strncmp(host, "//", 2) == 0)
+        host += 2;
+    size_t host_len = strcspn(host, "/?");
+
+    char *key = g_strndup(host, host_len);
+    MockHost *mhost = g_hash_table_lookup(mdata->hosts, key);
+    if (mhost) {
+        g_free(key);
+    }
+    else {
+        mhost = g_new0(MockHost, 1);
+        g_hash_table_insert(mdata->hosts, key, mhost);
+    }
+    return mhost;
+}
+
+
+void gfal_plugin_mock_delay(MockPluginData *mdata, const char *url)
+{
+    long long latency = gfal_plugin_mock_get_param(mdata, url, "latency", "LATENCY", 0);
+    long long jitter = gfal_plugin_mock_get_param(mdata, url, "jitter", "LATENCY_JITTER", 0);
+    double delay = latency;
+
+    if (jitter > 0) {
+        char distribution[32];
+        gfal_plugin_mock_get_string_param(mdata, url, "jitter_dist", "LATENCY_DISTRIBUTION", "uniform",
+            distribution, sizeof(distribution));
+
+        g_mutex_lock(mdata->lock);
+        double u1 = g_rand_double(mdata->rand);
+        double u2 = g_rand_double(mdata->rand);
+        g_mutex_unlock(mdata->lock);
+
+        if (strcmp(distribution, "normal") == 0) {
+            // Half normal, Box-Muller
+            delay += fabs(jitter * sqrt(-2.0 * log(1.0 - u1)) * cos(2 * G_PI * u2));
+        }
+        else if (strcmp(distribution, "exponential") == 0) {
+            delay += -jitter * log(1.0 - u1);
+        }
+        else {
+            delay += jitter * u1;
+        }
+    }
+
+    if (delay > 0)
+        g_usleep((gulong)(delay * 1000));
+}
+
+
+// Reserve the link for count bytes, and return when the reservation ends
+static gint64 gfal_plugin_mock_pacer_reserve(MockPacer *pacer, gint64 now, size_t count, long long rate)
+{
+    gint64 start = MAX(now, pacer->next);
+    pacer->next = start + (gint64)((double)count * G_USEC_PER_SEC / rate);
+    return pacer->next;
+}
+
+
+void gfal_plugin_mock_throttle(MockPluginData *mdata, MockPacer *pacer, const char *url, size_t count)
+{
+    long long handle_rate = gfal_plugin_mock_get_param(mdata, url, "bandwidth", "HANDLE_BANDWIDTH", 0);
+    long long host_rate = gfal_plugin_mock_get_param(mdata, url, "host_bandwidth", "HOST_BANDWIDTH", 0);
+    if ((handle_rate <= 0 && host_rate <= 0) || count == 0)
+        return;
+
+    const gint64 now = g_get_monotonic_time();
+    gint64 deadline = now;
+
+    g_mutex_lock(mdata->lock);
+    if (handle_rate > 0 && pacer)
+        deadline = MAX(deadline, gfal_plugin_mock_pacer_reserve(pacer, now, count, handle_rate));
+    if (host_rate > 0) {
+        MockHost *host = gfal_plugin_mock_get_host(mdata, url);
+        deadline = MAX(deadline, gfal_plugin_mock_pacer_reserve(&host->pacer, now, count, host_rate));
+    }
+    g_mutex_unlock(mdata->lock);
+
+    if (deadline > now)
+        g_usleep(deadline - now);
+}
+
+
+// Wakes up the opens waiting for a connection slot
+typedef struct {
+    MockPluginData *mdata;
+    gboolean canceled;
+} MockConnectWait;
+
+
+static void gfal_plugin_mock_connect_cancel(gfal2_context_t context, void *userdata)
+{
+    MockConnectWait *wait = userdata;
+    g_mutex_lock(wait->mdata->lock);
+    wait->canceled = TRUE;
+    g_cond_broadcast(wait->mdata->cond);
+    g_mutex_unlock(wait->mdata->lock);
+}
+
+
+int gfal_plugin_mock_connect(MockPluginData *mdata, const char *url, GError **err)
+{
+    long long max_connections = gfal_plugin_mock_get_param(mdata, url, "max_connections", "MAX_CONNECTIONS", 0);
+    if (max_connections <= 0)
+        return 0;
+
+    long long timeout = gfal_plugin_mock_get_param(mdata, url, "connect_timeout", "CONNECT_TIMEOUT",
+        gfal2_get_opt_integer_with_default(mdata->handle, CORE_CONFIG_GROUP, CORE_CONFIG_NAMESPACE_TIMEOUT, 300));
+    GTimeVal deadline;
+    g_get_current_time(&deadline);
+    g_time_val_add(&deadline, timeout * G_USEC_PER_SEC);
+
+    MockConnectWait wait = {mdata, FALSE};
+    gfal_cancel_token_t cancel_token = gfal2_register_cancel_callback(mdata->handle,
+        gfal_plugin_mock_connect_cancel, &wait);
+
+    int ret = 1;
+    g_mutex_lock(mdata->lock);
+    MockHost *host = gfal_plugin_mock_get_host(mdata, url);
+    while (host->connections >= max_connections) {
+        if (wait.canceled || gfal2_is_canceled(mdata->handle)) {
+            gfal_plugin_mock_report_error("Canceled while waiting for a connection", ECANCELED, err);
+            ret = -1;
+            break;
+        }
+        if (!g_cond_timed_wait(mdata->cond, mdata->lock, &deadline) && host->connections >= max_connections) {
+            gfal_plugin_mock_report_error("Timed out waiting for a connection", ETIMEDOUT, err);
+            ret = -1;
+            break;
+        }
+    }
+    if (ret > 0)
+        ++host->connections;
+    g_mutex_unlock(mdata->lock);
+
+    gfal2_remove_cancel_callback(mdata->handle, cancel_token);
+    return ret;
+}
+
+
+void gfal_plugin_mock_disconnect(MockPluginData *mdata, const char *url)
+{
+    g_mutex_lock(mdata->lock);
+    MockHost *host = gfal_plugin_mock_get_host(mdata, url);
+    --host->connections;
+    g_cond_broadcast(mdata->cond);
+    g_mutex_unlock(mdata->lock);
+}
+
+
+MockPayload gfal_plugin_mock_get_payload(MockPluginData *mdata, const char *url)
+{
+    char payload[32];
+    gfal_plugin_mock_get_string_param(mdata, url, "payload", "PAYLOAD", "urandom", payload, sizeof(payload));
+    if (strcmp(payload, "zero") == 0)
+        return MOCK_PAYLOAD_ZERO;
+    else if (strcmp(payload, "pattern") == 0)
+        return MOCK_PAYLOAD_PATTERN;
+    return MOCK_PAYLOAD_URANDOM;
+}
+
+
+void gfal_plugin_mock_fill(MockPayload payload, void *buffer, size_t count, off_t offset)
+{
+    if (payload == MOCK_PAYLOAD_ZERO) {
+        memset(buffer, 0, count);
+        return;
+    }
+
+    char *p = buffer;
+    while (count > 0) {
+        size_t start = offset % MOCK_PATTERN_PERIOD;
+        size_t chunk = MIN(count, sizeof(mock_pattern) - start);
+        memcpy(p, mock_pattern + start, chunk);
+        p += chunk;
+        offset += chunk;
+        count -= chunk;
+    }
+}
@@ -32,6 +32,7 @@
 #include "gfal_srm_copy.h"
 #include "gfal_srm_url_check.h"
 #include "gfal_srm_internal_ls.h"
+#include "gfal_srm_poll.h"
 
 #include <gssapi.h>
 #include <globus_gss_assist.h>
@@ -185,8 +186,9 @@ void gfal_srm_destroyG(plugin_handle ch)
     gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
     regfree(&opts->rexurl);
     regfree(&opts->rex_full);
-    g_static_rec_mutex_free(&opts->srm_context_mutex);
-    srm_context_free(opts->srm_context);
+    gfal_srm_context_pool_destroy(opts);
+    gfal_srm_poll_destroy(opts);
+    gfal_srm_ls_history_destroy(opts);
     gsimplecache_delete(opts->cache);
     free(opts);
 }
@@ -206,9 +208,11 @@ void gfal_srm_opt_initG(gfal_srmv2_opt *opts, gfal2_context_t handle)
     gfal_checker_compile(opts, NULL);
     opts->srm_proto_type = PROTO_SRMv2;
     opts->handle = handle;
-    opts->cache = gsimplecache_new(5000, &srm_internal_copy_stat,
+    opts->cache = gsimplecache_new(GFAL_SRM_CACHE_SIZE, &srm_internal_copy_stat,
         sizeof(struct extended_stat));
-    g_static_rec_mutex_init(&opts->srm_context_mutex);
+    gfal_srm_context_pool_init(opts);
+    gfal_srm_poll_init(opts);
+    gfal_srm_ls_history_init(opts);
 }
 
 
@@ -246,6 +250,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     srm_plugin.listxattrG = &gfal_srm_listxattrG;
     srm_plugin.checksum_calcG = &gfal_srm_checksumG;
     srm_plugin.copy_file = &srm_plugin_filecopy;
+    srm_plugin.copy_bulk = &srm_plugin_copy_bulk;
     srm_plugin.check_plugin_url_transfer = &plugin_url_check2;
     srm_plugin.bring_online = &gfal_srmv2_bring_onlineG;
     srm_plugin.bring_online_poll = &gfal_srmv2_bring_online_pollG;
@@ -35,6 +35,7 @@
 #define SRM_XATTR_GETURL "user.replicas"
 
 #define GFAL_SRM_LSTAT_PREFIX "lstat_"
+#define GFAL_SRM_CACHE_SIZE 5000
 
 //typedef struct srm_spacemd gfal_spacemd;
 enum status_type {DEFAULT_STATUS = 0, MD_STATUS, PIN_STATUS};
@@ -72,14 +73,18 @@ typedef struct _gfal_srmv2_opt{
 	gfal2_context_t handle;
 	GSimpleCache* cache;
 
-	char srm_ifce_error_buffer[GFAL_ERRMSG_LEN];
+	// Idle srm contexts, keyed on (endpoint, cert, key)
+	// A context is taken out of the pool while in use, so it is never shared between threads
+	GMutex* srm_context_pool_mutex;
+	GHashTable* srm_context_pool;
 
-	GStaticRecMutex srm_context_mutex; // Avoid same context being used from more than one thread at the time
-	srm_context_t srm_context;
+	// Directories listed recently, for the stat read-through
+	GMutex* ls_history_mutex;
+	GHashTable* ls_history;
 
-	// Used to know if the srm context must be cleaned
-	char x509_ucert[GFAL_URL_MAX_LEN], x509_ukey[GFAL_URL_MAX_LEN];
-	char endpoint[GFAL_URL_MAX_LEN];
+	// Outstanding asynchronous requests, see gfal_srm_poll.h
+	GMutex* poll_mutex;
+	GHashTable* poll_entries;
 } gfal_srmv2_opt;
 
 
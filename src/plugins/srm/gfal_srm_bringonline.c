@@ -24,6 +24,7 @@
 #include "gfal_srm_internal_layer.h"
 #include "gfal_srm_request.h"
 #include "gfal_srm_url_check.h"
+#include "gfal_srm_poll.h"
 
 
 // Sadly, this is quite inefficient, but has to be done since there might be duplicated
@@ -96,6 +97,12 @@ static int gfal_srmv2_bring_online_internal(srm_context_t context, gfal_srmv2_op
 
     gfal2_log(G_LOG_LEVEL_MESSAGE, "Got BRINGONLINE token %s", token);
 
+    // Track the queued files, so the polls are scheduled from now on
+    gfal_srm_poll_entry_t poll_entry = NULL;
+    if (async && token[0] != '\0') {
+        poll_entry = gfal_srm_poll_acquire(opts, surl[0], token);
+    }
+
     int nterminal = 0;
     for (i = 0; i < nbfiles; ++i) {
         int status_index = gfal_srmv2_bring_online_internal_status_index(nresponses, &output, surl[i]);
@@ -105,6 +112,11 @@ static int gfal_srmv2_bring_online_internal(srm_context_t context, gfal_srmv2_op
                     ++nterminal;
                     break;
                 case EAGAIN:
+                    if (poll_entry) {
+                        gfal_srm_poll_update(poll_entry, surl[i], EAGAIN,
+                            output.filestatuses[status_index].explanation,
+                            output.filestatuses[status_index].estimated_wait_time);
+                    }
                     break;
                 default:
                     gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(),
@@ -120,6 +132,11 @@ static int gfal_srmv2_bring_online_internal(srm_context_t context, gfal_srmv2_op
             ++nterminal;
         }
     }
+    if (poll_entry) {
+        gfal_srm_poll_schedule(opts->handle, poll_entry);
+        gfal_srm_poll_release(opts, poll_entry);
+    }
+
     gfal_srm_external_call.srm_srmv2_pinfilestatus_delete(output.filestatuses, nresponses);
     gfal_srm_external_call.srm_srm2__TReturnStatus_delete(output.retstatus);
     free(output.token);
@@ -191,62 +208,120 @@ int gfal_srmv2_bring_online_listG(plugin_handle ch, int nbfiles, const char *con
 }
 
 
-static int gfal_srmv2_bring_online_poll_internal(srm_context_t context,
-    int nbfiles, const char *const *surls, const char *token, GError **errors)
+// Query the endpoint for the status of the files, and record them in the poll entry
+static int gfal_srmv2_bring_online_status_query(gfal_srmv2_opt *opts, gfal_srm_poll_entry_t entry,
+    const char *surl, int nbfiles, char **decoded, const char *token, GError **err)
 {
     struct srm_bringonline_input input;
     struct srm_bringonline_output output;
+    GError *tmp_err = NULL;
     int i;
 
+    gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surl, &tmp_err);
+    if (easy == NULL) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+
     memset(&input, 0, sizeof(input));
     memset(&output, 0, sizeof(output));
 
     input.nbfiles = nbfiles;
-    input.surls = (char **) surls;
+    input.surls = decoded;
     output.token = (char *) token;
 
-    int nresponses = gfal_srm_external_call.srm_bring_online_status(context, &input, &output);
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Querying the status of %d files with token %s", nbfiles, token);
+
+    int nresponses = gfal_srm_external_call.srm_bring_online_status(easy->srm_context, &input, &output);
     if (nresponses < 0) {
-        GError *tmp_err = NULL;
-        gfal_srm_report_error(context->errbuf, &tmp_err);
+        gfal_srm_report_error(easy->srm_context->errbuf, &tmp_err);
+    }
+    else {
+        for (i = 0; i < nbfiles; ++i) {
+            int status_index = gfal_srmv2_bring_online_internal_status_index(nresponses, &output, decoded[i]);
+            if (status_index >= 0) {
+                gfal_srm_poll_update(entry, decoded[i],
+                    output.filestatuses[status_index].status,
+                    output.filestatuses[status_index].explanation,
+                    output.filestatuses[status_index].estimated_wait_time);
+            }
+            else {
+                gfal_srm_poll_update(entry, decoded[i], EPROTO, "missing surl on the response", 0);
+            }
+        }
+        gfal_srm_external_call.srm_srmv2_pinfilestatus_delete(output.filestatuses, nresponses);
+        gfal_srm_external_call.srm_srm2__TReturnStatus_delete(output.retstatus);
+        gfal_srm_poll_schedule(opts->handle, entry);
+    }
+    gfal_srm_ifce_easy_context_release(opts, easy);
+
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+// Answer a poll from the last known statuses, querying the endpoint only if the token is due
+// surl is the first of the original surls, used to find the endpoint
+static int gfal_srmv2_bring_online_poll_internal(gfal_srmv2_opt *opts, const char *surl,
+    int nbfiles, const char *const *decoded, const char *token, GError **errors)
+{
+    GError *tmp_err = NULL;
+    int i;
+
+    gfal_srm_poll_entry_t entry = gfal_srm_poll_acquire(opts, decoded[0], token);
+
+    if (gfal_srm_poll_is_due(entry, nbfiles, decoded)) {
+        // Coalesce with the other pending files of the same request
+        char **query = gfal_srm_poll_coalesce(entry, nbfiles, decoded);
+        gfal_srmv2_bring_online_status_query(opts, entry, surl, g_strv_length(query), query, token, &tmp_err);
+        g_strfreev(query);
+    }
+    else {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Status of %s not due yet, answering with the last known one", token);
+    }
+
+    if (tmp_err != NULL) {
         for (i = 0; i < nbfiles; ++i) {
             errors[i] = g_error_copy(tmp_err);
         }
         g_error_free(tmp_err);
+        gfal_srm_poll_release(opts, entry);
         return -1;
     }
 
     int nterminal = 0;
     for (i = 0; i < nbfiles; ++i) {
-        int status_index = gfal_srmv2_bring_online_internal_status_index(nresponses, &output, surls[i]);
-        if (status_index >= 0) {
-            switch (output.filestatuses[status_index].status) {
-                case 0:
-                    ++nterminal;
-                    break;
-                case EAGAIN:
-                    gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(),
-                        EAGAIN, __func__,
-                        "still queued: %s ",
-                        output.filestatuses[i].explanation);
-                    break;
-                default:
-                    gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(),
-                        output.filestatuses[status_index].status, __func__,
-                        "error on the bring online request: %s ",
-                        output.filestatuses[status_index].explanation);
-                    ++nterminal;
-                    break;
-            }
-        } else {
-            gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(),
-                EPROTO, __func__, "missing surl on the response: %s", surls[i]);
-            ++nterminal;
+        int status = EPROTO;
+        const char *explanation = "missing surl on the response";
+        gfal_srm_poll_get(entry, decoded[i], &status, &explanation);
+        switch (status) {
+            case 0:
+                ++nterminal;
+                break;
+            case EAGAIN:
+                gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(),
+                    EAGAIN, __func__,
+                    "still queued: %s ", explanation);
+                break;
+            default:
+                gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(),
+                    status, __func__,
+                    "error on the bring online request: %s ", explanation);
+                ++nterminal;
+                break;
         }
     }
 
-    gfal_srm_external_call.srm_srmv2_pinfilestatus_delete(output.filestatuses, nresponses);
-    gfal_srm_external_call.srm_srm2__TReturnStatus_delete(output.retstatus);
+    // The caller got the final status, no need to track these anymore
+    for (i = 0; i < nbfiles; ++i) {
+        if (errors[i] == NULL || errors[i]->code != EAGAIN) {
+            gfal_srm_poll_forget(entry, decoded[i]);
+        }
+    }
+    gfal_srm_poll_release(opts, entry);
 
     // Return will be 1 if all files are terminal
     return nterminal == nbfiles;
@@ -261,14 +336,10 @@ int gfal_srmv2_bring_online_pollG(plugin_handle ch, const char *surl,
     GError *tmp_err = NULL;
     gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
 
-    int ret = -1;
-
-    gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surl, &tmp_err);
-    if (easy != NULL) {
-        ret = gfal_srmv2_bring_online_poll_internal(easy->srm_context, 1, (const char *const *) &easy->path, token,
-            &tmp_err);
-    }
-    gfal_srm_ifce_easy_context_release(opts, easy);
+    char *decoded = gfal2_srm_get_decoded_path(surl);
+    int ret = gfal_srmv2_bring_online_poll_internal(opts, surl, 1, (const char *const *) &decoded, token,
+        &tmp_err);
+    g_free(decoded);
 
     if (tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
@@ -283,26 +354,15 @@ int gfal_srmv2_bring_online_poll_listG(plugin_handle ch, int nbfiles,
     const char *const *surls, const char *token, GError **errors)
 {
     int i;
-    GError *tmp_err = NULL;
     gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
 
-    gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, *surls, &tmp_err);
-    if (easy == NULL) {
-        for (i = 0; i < nbfiles; ++i) {
-            errors[i] = g_error_copy(tmp_err);
-        }
-        g_error_free(tmp_err);
-        return -1;
-    }
-
     char *decoded[nbfiles];
     for (i = 0; i < nbfiles; ++i) {
         decoded[i] = gfal2_srm_get_decoded_path(surls[i]);
     }
 
-    int ret = gfal_srmv2_bring_online_poll_internal(easy->srm_context, nbfiles, (const char *const *) decoded,
+    int ret = gfal_srmv2_bring_online_poll_internal(opts, surls[0], nbfiles, (const char *const *) decoded,
         token, errors);
-    gfal_srm_ifce_easy_context_release(opts, easy);
 
     for (i = 0; i < nbfiles; ++i) {
         g_free(decoded[i]);
@@ -22,9 +22,11 @@
 #include <uri/gfal2_uri.h>
 
 #include "gfal_srm_getput.h"
+#include "gfal_srm_request.h"
 #include "gfal_srm_namespace.h"
 #include "gfal_srm_url_check.h"
 #include "gfal_srm_internal_layer.h"
+#include "gfal_srm_internal_ls.h"
 #include "gfal_srm_bringonline.h"
 
 
@@ -127,9 +129,17 @@ static int srm_plugin_prepare_dest_put(plugin_handle handle,
 {
     GError *tmp_err = NULL;
     int res;
+    // The destination is about to be replaced
+    gfal_srm_cache_stat_remove(handle, surl);
+    gfalt_trace_span_t span = gfalt_trace_begin(params, srm_domain(), GFAL_EVENT_DESTINATION, "overwrite");
     res = srm_plugin_delete_existing_copy(handle, params, surl, &tmp_err);
+    gfalt_trace_end(params, span, -1, tmp_err);
     if (res == 0) {
+        span = NULL;
+        if (gfalt_get_create_parent_dir(params, NULL))
+            span = gfalt_trace_begin(params, srm_domain(), GFAL_EVENT_DESTINATION, "mkdir_parent");
         res = srm_plugin_create_parent_copy(handle, params, surl, &tmp_err);
+        gfalt_trace_end(params, span, -1, tmp_err);
         if (res < 0)
             gfalt_propagate_prefixed_error(err, tmp_err, __func__, GFALT_ERROR_DESTINATION, GFALT_ERROR_PARENT);
     }
@@ -421,11 +431,8 @@ static void srm_release_get(plugin_handle handle, const char *surl, const char *
 }
 
 
-static int srm_resolve_turls(plugin_handle handle, gfal2_context_t context,
-    gfalt_params_t params,
-    const char *source, char *turl_source, char *token_source,
-    const char *dest, char *turl_destination, char *token_destination,
-    GError **err)
+// Get the size of the source, and make sure it is online if COPY_FAIL_NEARLINE is set
+static int srm_check_source(gfal2_context_t context, const char *source, off_t *size, GError **err)
 {
     GError *tmp_err = NULL;
     char buffer[1024];
@@ -439,6 +446,7 @@ static int srm_resolve_turls(plugin_handle handle, gfal2_context_t context,
         g_clear_error(&tmp_err);
         tmp_err = NULL;
     }
+    *size = stat_source.st_size;
 
     //check if the source file is online in case the SRM_COPY_FAIL_NEARLINE is set
     gboolean fail_nearline = gfal2_get_opt_boolean_with_default(context, "SRM PLUGIN", "COPY_FAIL_NEARLINE", FALSE);
@@ -463,6 +471,23 @@ static int srm_resolve_turls(plugin_handle handle, gfal2_context_t context,
         }
     }
 
+    return 0;
+}
+
+
+static int srm_resolve_turls(plugin_handle handle, gfal2_context_t context,
+    gfalt_params_t params,
+    const char *source, char *turl_source, char *token_source,
+    const char *dest, char *turl_destination, char *token_destination,
+    GError **err)
+{
+    GError *tmp_err = NULL;
+    off_t source_size = 0;
+
+    if (srm_check_source(context, source, &source_size, err) < 0) {
+        return -1;
+    }
+
     srm_resolve_get_turl(handle, params, source, dest,
         turl_source, GFAL_URL_MAX_LEN,
         token_source, GFAL_URL_MAX_LEN,
@@ -473,7 +498,7 @@ static int srm_resolve_turls(plugin_handle handle, gfal2_context_t context,
     }
 
     srm_resolve_put_turl(handle, context, params,
-        dest, source, stat_source.st_size,
+        dest, source, source_size,
         turl_destination, GFAL_URL_MAX_LEN,
         token_destination, GFAL_URL_MAX_LEN,
         &tmp_err);
@@ -651,3 +676,610 @@ int srm_plugin_filecopy(plugin_handle handle, gfal2_context_t context,
         *err = NULL;
     return (*err == NULL) ? 0 : -1;
 }
+
+
+// Bulk copy
+// Files are copied in windows of BULK_REQUEST_SIZE, so TURLs do not expire while waiting for
+// the previous transfers. In each window, TURLs are resolved with one request per endpoint,
+// the transfers are delegated to the bulk copy of the TURL protocol,
+// and the destinations are closed with one PutDone per request
+
+struct srm_bulk_file {
+    const char *source;
+    const char *destination;
+    char checksum_algorithm[64];
+    char checksum_user[GFAL_URL_MAX_LEN];
+    char checksum_source[GFAL_URL_MAX_LEN];
+    char turl_source[GFAL_URL_MAX_LEN];
+    char token_source[GFAL_URL_MAX_LEN];
+    char turl_destination[GFAL_URL_MAX_LEN];
+    char token_destination[GFAL_URL_MAX_LEN];
+    off_t size;
+    gboolean transfer_finished;
+    // Points to the file error reported to the caller
+    GError **error;
+};
+
+typedef gboolean (*srm_bulk_match)(const struct srm_bulk_file *a, const struct srm_bulk_file *b);
+
+
+static gboolean srm_bulk_pending(const struct srm_bulk_file *file)
+{
+    return *file->error == NULL;
+}
+
+// Length of the scheme and authority of the url
+static size_t srm_bulk_endpoint_len(const char *url)
+{
+    const char *authority = strstr(url, "://");
+    if (authority == NULL)
+        return strlen(url);
+    const char *path = strchr(authority + 3, '/');
+    return path ? (size_t) (path - url) : strlen(url);
+}
+
+static gboolean srm_bulk_same_endpoint(const char *a, const char *b)
+{
+    size_t a_len = srm_bulk_endpoint_len(a);
+    return a_len == srm_bulk_endpoint_len(b) && g_ascii_strncasecmp(a, b, a_len) == 0;
+}
+
+static gboolean srm_bulk_same_scheme(const char *a, const char *b)
+{
+    const char *a_end = strstr(a, "://");
+    const char *b_end = strstr(b, "://");
+    if (a_end == NULL || b_end == NULL)
+        return a_end == b_end;
+    return (a_end - a) == (b_end - b) && g_ascii_strncasecmp(a, b, a_end - a) == 0;
+}
+
+static gboolean srm_bulk_match_source(const struct srm_bulk_file *a, const struct srm_bulk_file *b)
+{
+    return srm_bulk_same_endpoint(a->source, b->source);
+}
+
+static gboolean srm_bulk_match_destination(const struct srm_bulk_file *a, const struct srm_bulk_file *b)
+{
+    return srm_bulk_same_endpoint(a->destination, b->destination);
+}
+
+static gboolean srm_bulk_match_get_request(const struct srm_bulk_file *a, const struct srm_bulk_file *b)
+{
+    return srm_bulk_match_source(a, b) && strcmp(a->token_source, b->token_source) == 0;
+}
+
+static gboolean srm_bulk_match_put_request(const struct srm_bulk_file *a, const struct srm_bulk_file *b)
+{
+    return srm_bulk_match_destination(a, b) && strcmp(a->token_destination, b->token_destination) == 0;
+}
+
+static gboolean srm_bulk_match_transfer(const struct srm_bulk_file *a, const struct srm_bulk_file *b)
+{
+    return srm_bulk_same_scheme(a->turl_source, b->turl_source) &&
+           srm_bulk_same_scheme(a->turl_destination, b->turl_destination) &&
+           srm_check_url(a->destination) == srm_check_url(b->destination);
+}
+
+// Collect in group up to max_size selected files matching files[first], which must be selected
+// The collected files are unselected
+static size_t srm_bulk_collect(const struct srm_bulk_file *files, gboolean *selected, size_t nbfiles,
+    size_t first, srm_bulk_match match, size_t max_size, size_t *group)
+{
+    size_t n = 0;
+    size_t i;
+    for (i = first; i < nbfiles && n < max_size; ++i) {
+        if (selected[i] && match(&files[first], &files[i])) {
+            group[n++] = i;
+            selected[i] = FALSE;
+        }
+    }
+    return n;
+}
+
+
+static void srm_bulk_init_file(struct srm_bulk_file *file, const char *source, const char *destination,
+    const char *checksum, const char *checksum_algorithm, const char *checksum_user, GError **error)
+{
+    file->source = source;
+    file->destination = destination;
+    file->error = error;
+
+    g_strlcpy(file->checksum_algorithm, checksum_algorithm, sizeof(file->checksum_algorithm));
+    g_strlcpy(file->checksum_user, checksum_user, sizeof(file->checksum_user));
+    // Per file checksum, as algorithm:value or value
+    if (checksum && checksum[0]) {
+        const char *colon = strchr(checksum, ':');
+        if (colon) {
+            size_t algorithm_len = colon - checksum + 1;
+            g_strlcpy(file->checksum_algorithm, checksum,
+                MIN(algorithm_len, sizeof(file->checksum_algorithm)));
+            g_strlcpy(file->checksum_user, colon + 1, sizeof(file->checksum_user));
+        }
+        else {
+            g_strlcpy(file->checksum_user, checksum, sizeof(file->checksum_user));
+        }
+    }
+
+    // No resolution needed for non SRM urls
+    if (!srm_check_url(source))
+        g_strlcpy(file->turl_source, source, sizeof(file->turl_source));
+    if (!srm_check_url(destination))
+        g_strlcpy(file->turl_destination, destination, sizeof(file->turl_destination));
+}
+
+
+// Everything that can not be batched on the source: checksum and size
+static void srm_bulk_prepare_file(plugin_handle handle, gfal2_context_t context, gfalt_params_t params,
+    gfalt_checksum_mode_t checksum_mode, struct srm_bulk_file *file)
+{
+    GError *tmp_err = NULL;
+
+    if (checksum_mode) {
+        srm_validate_source_checksum(handle, context, params, file->source,
+            checksum_mode,
+            file->checksum_algorithm, file->checksum_user,
+            file->checksum_source, sizeof(file->checksum_source),
+            &tmp_err);
+    }
+    if (tmp_err == NULL) {
+        srm_check_source(context, file->source, &file->size, &tmp_err);
+    }
+
+    if (tmp_err != NULL)
+        gfal2_propagate_prefixed_error(file->error, tmp_err, __func__);
+}
+
+
+// Overwrite and create the parent of the SRM destinations of the files still pending,
+// so a destination is only touched once its source is resolved
+static void srm_bulk_prepare_destinations(plugin_handle handle, gfal2_context_t context,
+    gfalt_params_t params, struct srm_bulk_file *files, size_t nbfiles)
+{
+    size_t i;
+    for (i = 0; i < nbfiles; ++i) {
+        struct srm_bulk_file *file = &files[i];
+        if (!srm_bulk_pending(file) || !srm_check_url(file->destination))
+            continue;
+        if (gfal_srm_check_cancel(context, file->error))
+            continue;
+
+        GError *tmp_err = NULL;
+        gfal2_log(G_LOG_LEVEL_DEBUG, "\t\tPrepare destination %s", file->destination);
+        srm_plugin_prepare_dest_put(handle, context, params, file->destination, &tmp_err);
+        if (tmp_err != NULL)
+            gfal2_propagate_prefixed_error(file->error, tmp_err, __func__);
+    }
+}
+
+
+// Resolve the TURLs of one side of the pending files, grouped by endpoint
+static void srm_bulk_resolve(plugin_handle handle, gfalt_params_t params,
+    struct srm_bulk_file *files, size_t nbfiles, srm_req_type req_type)
+{
+    gfal_srmv2_opt *opts = (gfal_srmv2_opt *) handle;
+    const gboolean is_get = (req_type == SRM_GET);
+    const char *side = is_get ? GFALT_ERROR_SOURCE : GFALT_ERROR_DESTINATION;
+    const char *note = is_get ? "SRM_GET_TURL" : "SRM_PUT_TURL";
+    GQuark event_side = is_get ? GFAL_EVENT_SOURCE : GFAL_EVENT_DESTINATION;
+    GQuark event_stage = is_get ? gfal2_get_srm_get_quark() : gfal2_get_srm_put_quark();
+
+    gboolean *selected = g_new0(gboolean, nbfiles);
+    size_t *group = g_new0(size_t, nbfiles);
+    const char **surls = g_new0(const char *, nbfiles);
+    SRM_LONG64 *filesizes = g_new0(SRM_LONG64, nbfiles);
+    size_t i, j, n;
+
+    for (i = 0; i < nbfiles; ++i) {
+        selected[i] = srm_bulk_pending(&files[i]) &&
+                      srm_check_url(is_get ? files[i].source : files[i].destination);
+    }
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (!selected[i])
+            continue;
+
+        n = srm_bulk_collect(files, selected, nbfiles, i,
+            is_get ? srm_bulk_match_source : srm_bulk_match_destination, nbfiles, group);
+        for (j = 0; j < n; ++j) {
+            surls[j] = is_get ? files[group[j]].source : files[group[j]].destination;
+            filesizes[j] = files[group[j]].size;
+        }
+
+        gfal2_log(G_LOG_LEVEL_DEBUG, "\t\t%s surl -> turl resolution start for %zu files",
+            is_get ? "GET" : "PUT", n);
+
+        GError *tmp_err = NULL;
+        gfal_srm_result *resu = NULL;
+        int ret = -1;
+
+        gfal_srm_params_t srm_params = gfal_srm_params_new(opts);
+        if (srm_params != NULL) {
+            char **sup_protocols = srm_get_3rdparty_turls_sup_protocol(opts->handle);
+            // The whole group is prioritized on the protocol of the first file
+            const struct srm_bulk_file *first = &files[group[0]];
+            reorder_rd3_sup_protocols(sup_protocols, is_get ? first->destination : first->source);
+            gfal_srm_params_set_protocols(srm_params, sup_protocols);
+
+            if (is_get) {
+                gfal_srm_params_set_spacetoken(srm_params, gfalt_get_src_spacetoken(params, NULL));
+                ret = gfal_srm_getTURLS_list(opts, srm_params, n, surls, &resu, &tmp_err);
+            }
+            else {
+                gfal_srm_params_set_spacetoken(srm_params, gfalt_get_dst_spacetoken(params, NULL));
+                ret = gfal_srm_putTURLS_list(opts, srm_params, n, surls, filesizes, &resu, &tmp_err);
+            }
+            gfal_srm_params_free(srm_params);
+        }
+        else {
+            gfal2_set_error(&tmp_err, gfal2_get_plugin_srm_quark(), ENOMEM, __func__,
+                "Could not allocate the SRM parameters");
+        }
+
+        if (ret < 0) {
+            for (j = 0; j < n; ++j) {
+                gfalt_propagate_prefixed_error(files[group[j]].error, g_error_copy(tmp_err),
+                    __func__, side, note);
+            }
+            g_error_free(tmp_err);
+            continue;
+        }
+
+        // resu[j] is the result of surls[j], whatever the order of the response
+        for (j = 0; j < n; ++j) {
+            struct srm_bulk_file *file = &files[group[j]];
+            char *turl = is_get ? file->turl_source : file->turl_destination;
+            char *token = is_get ? file->token_source : file->token_destination;
+
+            // The file may still be part of the request, even if it was rejected or got no status,
+            // so keep the token to abort or release it
+            g_strlcpy(token, resu[j].reqtoken ? resu[j].reqtoken : "", GFAL_URL_MAX_LEN);
+            if (resu[j].turl[0] != '\0')
+                g_strlcpy(turl, resu[j].turl, GFAL_URL_MAX_LEN);
+
+            if (resu[j].err_code == 0) {
+                gfal2_log(G_LOG_LEVEL_DEBUG, "\t\t%s surl -> turl resolution finished: %s -> %s (%s)",
+                    is_get ? "GET" : "PUT", surls[j], turl, token);
+                plugin_trigger_event(params, gfal2_get_plugin_srm_quark(),
+                    event_side, event_stage, "Got TURL %s => %s", surls[j], turl);
+            }
+            else {
+                gfalt_set_error(file->error, gfal2_get_plugin_srm_quark(), resu[j].err_code, __func__,
+                    side, note, "error on the turl %s request : %s ", surls[j], resu[j].err_str);
+            }
+        }
+        for (j = 0; j < (size_t) ret; ++j) {
+            g_free(resu[j].reqtoken);
+        }
+        free(resu);
+    }
+
+    g_free(filesizes);
+    g_free(surls);
+    g_free(group);
+    g_free(selected);
+}
+
+
+// Delegate the transfers to the bulk copy of the TURL protocols
+static void srm_bulk_transfer(gfal2_context_t context, gfalt_params_t params,
+    struct srm_bulk_file *files, size_t nbfiles)
+{
+    gboolean *selected = g_new0(gboolean, nbfiles);
+    size_t *group = g_new0(size_t, nbfiles);
+    const char **turl_sources = g_new0(const char *, nbfiles);
+    const char **turl_destinations = g_new0(const char *, nbfiles);
+    size_t i, j, n;
+
+    for (i = 0; i < nbfiles; ++i) {
+        selected[i] = srm_bulk_pending(&files[i]);
+    }
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (!selected[i])
+            continue;
+
+        if (gfal_srm_check_cancel(context, files[i].error)) {
+            selected[i] = FALSE;
+            continue;
+        }
+
+        n = srm_bulk_collect(files, selected, nbfiles, i, srm_bulk_match_transfer, nbfiles, group);
+        for (j = 0; j < n; ++j) {
+            turl_sources[j] = files[group[j]].turl_source;
+            turl_destinations[j] = files[group[j]].turl_destination;
+        }
+
+        gfalt_params_t params_turl = gfalt_params_handle_copy(params, NULL);
+        // checksum check done here!
+        gfalt_set_checksum(params_turl, GFALT_CHECKSUM_NONE, NULL, NULL, NULL);
+        if (srm_check_url(files[group[0]].destination)) { // srm destination
+            gfalt_set_replace_existing_file(params_turl, FALSE, NULL);
+            gfalt_set_strict_copy_mode(params_turl, TRUE, NULL);
+        }
+
+        GError *op_error = NULL;
+        GError **turl_errors = NULL;
+        gfalt_copy_bulk(context, params_turl, n, turl_sources, turl_destinations, NULL,
+            &op_error, &turl_errors);
+
+        for (j = 0; j < n; ++j) {
+            GError **file_error = files[group[j]].error;
+            GError *turl_error = turl_errors ? turl_errors[j] : NULL;
+            // We assume the underlying copy tagged properly
+            if (op_error != NULL) {
+                gfal2_propagate_prefixed_error(file_error, g_error_copy(op_error), __func__);
+                g_clear_error(&turl_error);
+            }
+            else if (turl_error != NULL) {
+                gfal2_propagate_prefixed_error(file_error, turl_error, __func__);
+            }
+        }
+
+        g_clear_error(&op_error);
+        g_free(turl_errors);
+        gfalt_params_handle_delete(params_turl, NULL);
+    }
+
+    g_free(turl_destinations);
+    g_free(turl_sources);
+    g_free(group);
+    g_free(selected);
+}
+
+
+// One PutDone per PUT request for the transferred files
+static void srm_bulk_putdone(plugin_handle handle, gfalt_params_t params,
+    struct srm_bulk_file *files, size_t nbfiles)
+{
+    gfal_srmv2_opt *opts = (gfal_srmv2_opt *) handle;
+    gboolean *selected = g_new0(gboolean, nbfiles);
+    size_t *group = g_new0(size_t, nbfiles);
+    const char **surls = g_new0(const char *, nbfiles);
+    GError **errors = g_new0(GError *, nbfiles);
+    size_t i, j, n;
+
+    for (i = 0; i < nbfiles; ++i) {
+        selected[i] = srm_bulk_pending(&files[i]) && srm_check_url(files[i].destination);
+    }
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (!selected[i])
+            continue;
+
+        n = srm_bulk_collect(files, selected, nbfiles, i, srm_bulk_match_put_request, nbfiles, group);
+        for (j = 0; j < n; ++j) {
+            surls[j] = files[group[j]].destination;
+            plugin_trigger_event(params, srm_domain(), GFAL_EVENT_DESTINATION,
+                GFAL_EVENT_CLOSE_ENTER, "%s", surls[j]);
+        }
+
+        memset(errors, 0, sizeof(GError *) * n);
+        gfal_srm_putdone_list(opts, n, surls, files[group[0]].token_destination, errors);
+
+        for (j = 0; j < n; ++j) {
+            if (errors[j] != NULL) {
+                gfalt_propagate_prefixed_error(files[group[j]].error, errors[j], __func__,
+                    GFALT_ERROR_DESTINATION, "SRM_PUTDONE");
+            }
+            plugin_trigger_event(params, srm_domain(), GFAL_EVENT_DESTINATION,
+                GFAL_EVENT_CLOSE_EXIT, "%s", surls[j]);
+        }
+    }
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (srm_bulk_pending(&files[i]))
+            files[i].transfer_finished = TRUE;
+    }
+
+    g_free(errors);
+    g_free(surls);
+    g_free(group);
+    g_free(selected);
+}
+
+
+// Abort the unfinished PUT of the failed files, grouped by request, and remove what is left behind
+static void srm_bulk_rollback_put(plugin_handle handle, gfal2_context_t context,
+    struct srm_bulk_file *files, size_t nbfiles)
+{
+    gboolean *selected = g_new0(gboolean, nbfiles);
+    size_t *group = g_new0(size_t, nbfiles);
+    const char **surls = g_new0(const char *, nbfiles);
+    GError **errors = g_new0(GError *, nbfiles);
+    size_t i, j, n;
+
+    for (i = 0; i < nbfiles; ++i) {
+        struct srm_bulk_file *file = &files[i];
+        if (srm_bulk_pending(file))
+            continue;
+        // If the transfer finished, or the destination is not an SRM, remove the destination
+        if ((*file->error)->code != EEXIST && (file->transfer_finished || !srm_check_url(file->destination))) {
+            GError *unlink_error = NULL;
+            gfal2_unlink(context, file->destination, &unlink_error);
+            // It may not be there, so be gentle
+            g_clear_error(&unlink_error);
+        }
+        else if (!file->transfer_finished && file->token_destination[0] != '\0') {
+            selected[i] = TRUE;
+        }
+    }
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (!selected[i])
+            continue;
+
+        n = srm_bulk_collect(files, selected, nbfiles, i, srm_bulk_match_put_request, nbfiles, group);
+        for (j = 0; j < n; ++j) {
+            surls[j] = files[group[j]].destination;
+        }
+
+        gfal2_log(G_LOG_LEVEL_MESSAGE, "Rolling back PUT of %zu files", n);
+        memset(errors, 0, sizeof(GError *) * n);
+        gfal_srm2_abort_filesG(handle, n, surls, files[group[0]].token_destination, errors);
+
+        for (j = 0; j < n; ++j) {
+            if (errors[j] != NULL) {
+                gfal2_log(G_LOG_LEVEL_WARNING,
+                    "Got an error when canceling the PUT request for %s: %s", surls[j], errors[j]->message);
+                g_clear_error(&errors[j]);
+            }
+            // Some endpoints may not remove the file after an abort (i.e. Castor),
+            // so do it ourselves if it is still there (see LCGUTIL-358)
+            // Only when the endpoint gave a TURL, otherwise the file may not be ours
+            if (files[group[j]].turl_destination[0] != '\0')
+                srm_force_unlink(handle, context, surls[j], files[group[j]].error);
+        }
+    }
+
+    g_free(errors);
+    g_free(surls);
+    g_free(group);
+    g_free(selected);
+}
+
+
+// Release all the pinned sources, grouped by request
+static void srm_bulk_release_get(plugin_handle handle,
+    struct srm_bulk_file *files, size_t nbfiles)
+{
+    gboolean *selected = g_new0(gboolean, nbfiles);
+    size_t *group = g_new0(size_t, nbfiles);
+    const char **surls = g_new0(const char *, nbfiles);
+    GError **errors = g_new0(GError *, nbfiles);
+    size_t i, j, n;
+
+    for (i = 0; i < nbfiles; ++i) {
+        selected[i] = (files[i].token_source[0] != '\0');
+    }
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (!selected[i])
+            continue;
+
+        n = srm_bulk_collect(files, selected, nbfiles, i, srm_bulk_match_get_request, nbfiles, group);
+        for (j = 0; j < n; ++j) {
+            surls[j] = files[group[j]].source;
+        }
+
+        gfal2_log(G_LOG_LEVEL_MESSAGE, "Releasing GET of %zu files", n);
+        memset(errors, 0, sizeof(GError *) * n);
+        gfal_srmv2_release_file_listG(handle, n, surls, files[group[0]].token_source, errors);
+
+        for (j = 0; j < n; ++j) {
+            if (errors[j] != NULL) {
+                gfal2_log(G_LOG_LEVEL_WARNING,
+                    "Got an error when releasing the source file %s: %s", surls[j], errors[j]->message);
+                gfal2_log(G_LOG_LEVEL_WARNING, "It will be ignored!");
+                g_clear_error(&errors[j]);
+            }
+        }
+    }
+
+    g_free(errors);
+    g_free(surls);
+    g_free(group);
+    g_free(selected);
+}
+
+
+// Copy one window of files, from the TURL resolution to the release of the requests
+// Return 0, or minus the number of failed files
+static int srm_bulk_copy_window(plugin_handle handle, gfal2_context_t context, gfalt_params_t params,
+    gfalt_checksum_mode_t checksum_mode, struct srm_bulk_file *files, size_t nbfiles)
+{
+    size_t i;
+    int ret = 0;
+
+    plugin_trigger_event(params, srm_domain(), GFAL_EVENT_NONE,
+        GFAL_EVENT_PREPARE_ENTER, "");
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (!gfal_srm_check_cancel(context, files[i].error))
+            srm_bulk_prepare_file(handle, context, params, checksum_mode, &files[i]);
+    }
+
+    srm_bulk_resolve(handle, params, files, nbfiles, SRM_GET);
+    srm_bulk_prepare_destinations(handle, context, params, files, nbfiles);
+    srm_bulk_resolve(handle, params, files, nbfiles, SRM_PUT);
+
+    plugin_trigger_event(params, srm_domain(), GFAL_EVENT_NONE,
+        GFAL_EVENT_PREPARE_EXIT, "");
+
+    srm_bulk_transfer(context, params, files, nbfiles);
+    srm_bulk_putdone(handle, params, files, nbfiles);
+
+    // Destination checksum validation
+    if (checksum_mode & GFALT_CHECKSUM_TARGET) {
+        for (i = 0; i < nbfiles; ++i) {
+            if (srm_bulk_pending(&files[i])) {
+                srm_validate_destination_checksum(handle, context, params, files[i].destination,
+                    files[i].checksum_algorithm, files[i].checksum_user, files[i].checksum_source,
+                    files[i].error);
+            }
+        }
+    }
+
+    // Cleanup
+    for (i = 0; i < nbfiles; ++i) {
+        if (!srm_bulk_pending(&files[i])) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Transfer %s => %s failed with: %s",
+                files[i].source, files[i].destination, (*files[i].error)->message);
+            ret -= 1;
+        }
+    }
+    srm_bulk_rollback_put(handle, context, files, nbfiles);
+    srm_bulk_release_get(handle, files, nbfiles);
+
+    return ret;
+}
+
+
+int srm_plugin_copy_bulk(plugin_handle handle, gfal2_context_t context, gfalt_params_t params,
+    size_t nbfiles, const char *const *srcs, const char *const *dsts, const char *const *checksums,
+    GError **op_error, GError ***file_errors)
+{
+    GError *nested_error = NULL;
+    char checksum_algorithm[64] = {0};
+    char checksum_user[GFAL_URL_MAX_LEN] = {0};
+    gfalt_checksum_mode_t checksum_mode;
+    size_t i;
+    int ret = 0;
+
+    *file_errors = g_new0(GError *, nbfiles);
+
+    const gint request_size = gfal2_get_opt_integer_with_default(context, srm_config_group,
+        srm_config_bulk_request_size, 100);
+    if (request_size <= 0) {
+        gfal2_set_error(op_error, gfal2_get_plugin_srm_quark(), EINVAL, __func__,
+            "Invalid %s value", srm_config_bulk_request_size);
+        return -1;
+    }
+
+    // Check if any of the endpoints is castor
+    // In that case, disable GridFTP session reuse (see LCGUTIL-448)
+    castor_gridftp_session_hack(handle, context, srcs[0], dsts[0]);
+
+    srm_get_checksum_config(context, params,
+        &checksum_mode,
+        checksum_algorithm, sizeof(checksum_algorithm),
+        checksum_user, sizeof(checksum_user),
+        &nested_error);
+    if (nested_error != NULL) {
+        gfal2_propagate_prefixed_error(op_error, nested_error, __func__);
+        return -1;
+    }
+
+    struct srm_bulk_file *files = g_new0(struct srm_bulk_file, nbfiles);
+    for (i = 0; i < nbfiles; ++i) {
+        srm_bulk_init_file(&files[i], srcs[i], dsts[i], checksums ? checksums[i] : NULL,
+            checksum_algorithm, checksum_user, &(*file_errors)[i]);
+    }
+
+    for (i = 0; i < nbfiles; i += (size_t) request_size) {
+        ret += srm_bulk_copy_window(handle, context, params, checksum_mode,
+            files + i, MIN((size_t) request_size, nbfiles - i));
+    }
+
+    g_free(files);
+    return ret;
+}
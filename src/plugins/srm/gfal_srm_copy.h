@@ -37,4 +37,14 @@ int srm_plugin_filecopy(plugin_handle handle, gfal2_context_t context,
     gfalt_params_t params,
     const char *src, const char *dst, GError **err);
 
+/**
+ * Bulk copy of nbfiles files
+ *  srm implementation of the plugin copy_bulk
+ *  TURLs are resolved and put done with one SRM request per endpoint,
+ *  and the transfers are done by the bulk copy of the TURL protocol
+ */
+int srm_plugin_copy_bulk(plugin_handle handle, gfal2_context_t context, gfalt_params_t params,
+    size_t nbfiles, const char *const *srcs, const char *const *dsts, const char *const *checksums,
+    GError **op_error, GError ***file_errors);
+
 #endif
@@ -26,74 +26,114 @@
 #include "gfal_srm_request.h"
 #include "gfal_srm_internal_layer.h"
 #include "gfal_srm_endpoint.h"
+#include "gfal_srm_internal_ls.h"
+#include "gfal_srm_url_check.h"
 #include "gfal_srm_getput.h"
 
 
 // Make sure the TURL returned by the endpoint is one of the requested protocols
-static int validate_turls(int n_results, gfal_srm_result **resu,
-    gfal_srm_params_t params, GError **tmp_err)
+static int validate_turl(const gfal_srm_result *resu, gfal_srm_params_t params, GError **tmp_err)
 {
-    int failed = 0;
+    const char *turl = resu->turl;
     int n_protocols = g_strv_length(params->protocols);
-    int i, j;
+    int j;
 
-    for (i = 0; i < n_results && !failed; ++i) {
-        const char *turl = (*resu)[i].turl;
+    if (turl[0] == '/') {
+        gfal2_set_error(tmp_err, gfal2_get_plugin_srm_quark(), EBADMSG, __func__,
+            "A turl can not start with /");
+        return -1;
+    }
 
-        if (turl[0] == '/') {
-            failed = -1;
-            gfal2_set_error(tmp_err, gfal2_get_plugin_srm_quark(), EBADMSG, __func__,
-                "A turl can not start with /");
-            break;
-        }
+    // If error is set, skip the check
+    if (resu->err_code != 0)
+        return 0;
+
+    // Check the turl protocol is in the request list
+    for (j = 0; j < n_protocols; ++j) {
+        size_t proto_len = strlen(params->protocols[j]);
+        if (strncmp(params->protocols[j], turl, proto_len) == 0 && turl[proto_len] == ':')
+            return 0;
+    }
+
+    gfal2_set_error(tmp_err, gfal2_get_plugin_srm_quark(), EBADMSG, __func__,
+        "The SRM endpoint returned a protocol that wasn't requested: %s",
+        turl);
+    return -1;
+}
 
-        // If error is set, skip the check
-        if ((*resu)[i].err_code != 0)
-            continue;
 
-        // Check the turl protocol is in the request list
-        int matching_protocol = 0;
-        for (j = 0; j < n_protocols; ++j) {
-            size_t proto_len = strlen(params->protocols[j]);
-            if (strncmp(params->protocols[j], turl, proto_len) == 0 && turl[proto_len] == ':') {
-                matching_protocol = 1;
-                break;
+static int validate_turls(int n_results, gfal_srm_result **resu,
+    gfal_srm_params_t params, GError **tmp_err)
+{
+    int i;
+    for (i = 0; i < n_results; ++i) {
+        if (validate_turl(&(*resu)[i], params, tmp_err) < 0) {
+            // Didn't match, so free and set an error
+            for (i = 0; i < n_results; ++i) {
+                g_free((*resu)[i].reqtoken);
             }
+            free(*resu);
+            *resu = NULL;
+            return -1;
         }
+    }
+    return 0;
+}
 
-        // If no matching protocol, fail already
-        if (!matching_protocol) {
-            failed = -1;
-            gfal2_set_error(tmp_err, gfal2_get_plugin_srm_quark(), EBADMSG, __func__,
-                "The SRM endpoint returned a protocol that wasn't requested: %s",
-                turl);
+
+// Index of the status of surl, among the ones not taken yet.
+// The response order doesn't have to be the same as when requested, and the request
+// may have duplicated surls
+static int gfal_srm_status_index(const char *surl, char *const *status_surls, gboolean *taken, int n_statuses)
+{
+    int i;
+    for (i = 0; i < n_statuses; ++i) {
+        if (!taken[i] && status_surls[i] != NULL && gfal2_srm_surl_cmp(status_surls[i], surl) == 0) {
+            taken[i] = TRUE;
+            return i;
         }
     }
-    // Didn't match, so free and set an error
-    if (failed) {
-        free(*resu);
-        *resu = NULL;
-    }
-    return failed;
+    return -1;
 }
 
 
-static int gfal_srm_convert_filestatuses_to_srm_result(struct srmv2_pinfilestatus *statuses, char *reqtoken, int n,
-    gfal_srm_result **resu, GError **err)
+// One result per requested surl, in the order of the request
+// The surls without a status are failed with EIO
+static int gfal_srm_convert_filestatuses_to_srm_result(struct srmv2_pinfilestatus *statuses, int n_statuses,
+    char **surls, int nbfiles, char *reqtoken, gfal_srm_result **resu, GError **err)
 {
-    g_return_val_err_if_fail(statuses && n && resu, -1, err,
+    g_return_val_err_if_fail(surls && nbfiles && resu, -1, err,
         "[gfal_srm_convert_filestatuses_to_srm_result] args invalids");
-    *resu = calloc(n, sizeof(gfal_srm_result));
-    int i = 0;
-    for (i = 0; i < n; ++i) {
-        if (statuses[i].turl)
-            g_strlcpy((*resu)[i].turl, statuses[i].turl, GFAL_URL_MAX_LEN);
-        if (statuses[i].explanation)
-            g_strlcpy((*resu)[i].err_str, statuses[i].explanation, GFAL_URL_MAX_LEN);
-        (*resu)[i].err_code = statuses[i].status;
-        (*resu)[i].reqtoken = g_strdup(reqtoken);
+    char *status_surls[n_statuses + 1];
+    gboolean taken[n_statuses + 1];
+    int i;
+
+    for (i = 0; i < n_statuses; ++i) {
+        status_surls[i] = statuses[i].surl;
+        taken[i] = FALSE;
     }
-    return 0;
+
+    *resu = calloc(nbfiles, sizeof(gfal_srm_result));
+    for (i = 0; i < nbfiles; ++i) {
+        gfal_srm_result *result = &(*resu)[i];
+        int status_index = gfal_srm_status_index(surls[i], status_surls, taken, n_statuses);
+
+        // The file may still be part of the request, so keep the token to abort or release it
+        result->reqtoken = g_strdup(reqtoken);
+        if (status_index < 0) {
+            result->err_code = EIO;
+            g_snprintf(result->err_str, sizeof(result->err_str), "No status returned for the surl %s", surls[i]);
+            continue;
+        }
+
+        struct srmv2_pinfilestatus *status = &statuses[status_index];
+        if (status->turl)
+            g_strlcpy(result->turl, status->turl, GFAL_URL_MAX_LEN);
+        if (status->explanation)
+            g_strlcpy(result->err_str, status->explanation, GFAL_URL_MAX_LEN);
+        result->err_code = status->status;
+    }
+    return nbfiles;
 }
 
 
@@ -105,6 +145,7 @@ int gfal_srmv2_get_global(gfal_srmv2_opt *opts, gfal_srm_params_t params, srm_co
 
     GError *tmp_err = NULL;
     int ret = 0;
+    int n_statuses = 0;
     struct srm_preparetoget_output preparetoget_output;
 
     memset(&preparetoget_output, 0, sizeof(preparetoget_output));
@@ -112,14 +153,18 @@ int gfal_srmv2_get_global(gfal_srmv2_opt *opts, gfal_srm_params_t params, srm_co
     ret = gfal_srm_external_call.srm_prepare_to_get(context, input, &preparetoget_output);
     if (ret < 0) {
         gfal_srm_report_error(context->errbuf, &tmp_err);
+        // The request may still be queued on the endpoint, do not leave it behind
+        if (preparetoget_output.token != NULL)
+            gfal_srm_external_call.srm_abort_request(context, preparetoget_output.token);
     } else {
         gfal2_log(G_LOG_LEVEL_MESSAGE, "Got GET token for %s: %s", input->surls[0], preparetoget_output.token);
-        gfal_srm_convert_filestatuses_to_srm_result(preparetoget_output.filestatuses, preparetoget_output.token, ret,
-            resu, &tmp_err);
+        n_statuses = ret;
+        ret = gfal_srm_convert_filestatuses_to_srm_result(preparetoget_output.filestatuses, n_statuses,
+            input->surls, input->nbfiles, preparetoget_output.token, resu, &tmp_err);
     }
 
     if (preparetoget_output.filestatuses != NULL)
-        gfal_srm_external_call.srm_srmv2_pinfilestatus_delete(preparetoget_output.filestatuses, ret);
+        gfal_srm_external_call.srm_srmv2_pinfilestatus_delete(preparetoget_output.filestatuses, n_statuses);
     if (preparetoget_output.retstatus != NULL)
         gfal_srm_external_call.srm_srm2__TReturnStatus_delete(preparetoget_output.retstatus);
     free(preparetoget_output.token);
@@ -136,6 +181,7 @@ int gfal_srmv2_put_global(gfal_srmv2_opt *opts, gfal_srm_params_t params, srm_co
 
     GError *tmp_err = NULL;
     int ret = 0;
+    int n_statuses = 0;
     struct srm_preparetoput_output preparetoput_output;
 
     memset(&preparetoput_output, 0, sizeof(preparetoput_output));
@@ -143,15 +189,19 @@ int gfal_srmv2_put_global(gfal_srmv2_opt *opts, gfal_srm_params_t params, srm_co
     ret = gfal_srm_external_call.srm_prepare_to_put(context, input, &preparetoput_output);
     if (ret < 0) {
         gfal_srm_report_error(context->errbuf, &tmp_err);
+        // The request may still be queued on the endpoint, do not leave it behind
+        if (preparetoput_output.token != NULL)
+            gfal_srm_external_call.srm_abort_request(context, preparetoput_output.token);
     }
     else {
         gfal2_log(G_LOG_LEVEL_MESSAGE, "Got PUT token for %s: %s", input->surls[0], preparetoput_output.token);
-        gfal_srm_convert_filestatuses_to_srm_result(preparetoput_output.filestatuses, preparetoput_output.token, ret,
-            resu, &tmp_err);
+        n_statuses = ret;
+        ret = gfal_srm_convert_filestatuses_to_srm_result(preparetoput_output.filestatuses, n_statuses,
+            input->surls, input->nbfiles, preparetoput_output.token, resu, &tmp_err);
     }
 
     if (preparetoput_output.filestatuses != NULL)
-        gfal_srm_external_call.srm_srmv2_pinfilestatus_delete(preparetoput_output.filestatuses, ret);
+        gfal_srm_external_call.srm_srmv2_pinfilestatus_delete(preparetoput_output.filestatuses, n_statuses);
     if (preparetoput_output.retstatus != NULL)
         gfal_srm_external_call.srm_srm2__TReturnStatus_delete(preparetoput_output.retstatus);
     free(preparetoput_output.token);
@@ -216,6 +266,10 @@ static int gfal_srm_mTURLS_internal(gfal_srmv2_opt *opts, gfal_srm_params_t para
     GError *tmp_err = NULL;
     int ret = -1;
 
+    // A PUT creates the file, even before it is done
+    if (req_type == SRM_PUT)
+        gfal_srm_cache_stat_remove(opts, surl);
+
     gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surl, &tmp_err);
     if (easy != NULL) {
         if (req_type == SRM_GET)
@@ -238,6 +292,88 @@ static int gfal_srm_mTURLS_internal(gfal_srmv2_opt *opts, gfal_srm_params_t para
     return ret;
 }
 
+// Same as gfal_srm_mTURLS_internal, but for a group of surls sharing the same endpoint,
+// sent as a single request
+static int gfal_srm_mTURLS_list_internal(gfal_srmv2_opt *opts, gfal_srm_params_t params,
+    srm_req_type req_type, int nbfiles, const char *const *surls, SRM_LONG64 *filesizes,
+    gfal_srm_result **resu, GError **err)
+{
+    GError *tmp_err = NULL;
+    int ret = -1;
+    int i;
+
+    // A PUT creates the files, even before they are done
+    if (req_type == SRM_PUT) {
+        for (i = 0; i < nbfiles; ++i) {
+            gfal_srm_cache_stat_remove(opts, surls[i]);
+        }
+    }
+
+    gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surls[0], &tmp_err);
+    if (easy != NULL) {
+        char *decoded[nbfiles];
+        for (i = 0; i < nbfiles; ++i) {
+            decoded[i] = gfal2_srm_get_decoded_path(surls[i]);
+        }
+
+        if (req_type == SRM_GET) {
+            struct srm_preparetoget_input preparetoget_input;
+            preparetoget_input.desiredpintime = 0;
+            preparetoget_input.nbfiles = nbfiles;
+            preparetoget_input.protocols = gfal_srm_params_get_protocols(params);
+            preparetoget_input.spacetokendesc = gfal_srm_params_get_spacetoken(params);
+            preparetoget_input.surls = decoded;
+            ret = gfal_srmv2_get_global(opts, params, easy->srm_context, &preparetoget_input, resu, &tmp_err);
+        }
+        else {
+            struct srm_preparetoput_input preparetoput_input;
+            preparetoput_input.desiredpintime = 0;
+            preparetoput_input.nbfiles = nbfiles;
+            preparetoput_input.protocols = gfal_srm_params_get_protocols(params);
+            preparetoput_input.spacetokendesc = gfal_srm_params_get_spacetoken(params);
+            preparetoput_input.surls = decoded;
+            preparetoput_input.filesizes = filesizes;
+            ret = gfal_srmv2_put_global(opts, params, easy->srm_context, &preparetoput_input, resu, &tmp_err);
+        }
+
+        for (i = 0; i < nbfiles; ++i) {
+            g_free(decoded[i]);
+        }
+    }
+    gfal_srm_ifce_easy_context_release(opts, easy);
+
+    if (ret < 0) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+    }
+    else {
+        // Each TURL is checked on its own, so a bad one only fails its file
+        for (i = 0; i < ret; ++i) {
+            if (validate_turl(&(*resu)[i], params, &tmp_err) < 0) {
+                (*resu)[i].err_code = tmp_err->code;
+                g_strlcpy((*resu)[i].err_str, tmp_err->message, sizeof((*resu)[i].err_str));
+                g_clear_error(&tmp_err);
+            }
+        }
+    }
+
+    return ret;
+}
+
+
+int gfal_srm_getTURLS_list(gfal_srmv2_opt *opts, gfal_srm_params_t params,
+    int nbfiles, const char *const *surls, gfal_srm_result **resu, GError **err)
+{
+    return gfal_srm_mTURLS_list_internal(opts, params, SRM_GET, nbfiles, surls, NULL, resu, err);
+}
+
+
+int gfal_srm_putTURLS_list(gfal_srmv2_opt *opts, gfal_srm_params_t params,
+    int nbfiles, const char *const *surls, SRM_LONG64 *filesizes, gfal_srm_result **resu, GError **err)
+{
+    return gfal_srm_mTURLS_list_internal(opts, params, SRM_PUT, nbfiles, surls, filesizes, resu, err);
+}
+
+
 //  simple wrapper to getTURLs for the gfal_module layer
 int gfal_srm_getTURLS_plugin(plugin_handle ch, const char *surl, char *buff_turl, int size_turl, char **reqtoken,
     GError **err)
@@ -512,6 +648,7 @@ int gfal_srm_putdone(gfal_srmv2_opt *opts, const char *surl, const char *token,
     int ret = -1;
 
     gfal2_log(G_LOG_LEVEL_DEBUG, "   -> [gfal_srm_putdone] ");
+    gfal_srm_cache_stat_remove(opts, surl);
 
     gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surl, &tmp_err);
     if (easy != NULL) {
@@ -526,6 +663,99 @@ int gfal_srm_putdone(gfal_srmv2_opt *opts, const char *surl, const char *token,
 }
 
 
+static int gfal_srm_putdone_list_srmv2_internal(srm_context_t context, int nbfiles, char **surls,
+    const char *token, GError **errors)
+{
+    GError *tmp_err = NULL;
+    int ret = 0;
+    int i;
+    struct srm_putdone_input putdone_input;
+    struct srmv2_filestatus *statuses = NULL;
+
+    putdone_input.nbfiles = nbfiles;
+    putdone_input.reqtoken = (char *) token;
+    putdone_input.surls = surls;
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "    [gfal_srm_putdone_list_srmv2_internal] start srm put done on %d files (%s)",
+        nbfiles, token);
+    ret = gfal_srm_external_call.srm_put_done(context, &putdone_input, &statuses);
+    if (ret < 0) {
+        gfal2_set_error(&tmp_err, gfal2_get_plugin_srm_quark(), errno, __func__,
+            "call to srm_ifce error: %s", context->errbuf);
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+    }
+    else {
+        int n_statuses = ret;
+        char *status_surls[n_statuses + 1];
+        gboolean taken[n_statuses + 1];
+
+        for (i = 0; i < n_statuses; ++i) {
+            status_surls[i] = statuses[i].surl;
+            taken[i] = FALSE;
+        }
+
+        ret = 0;
+        for (i = 0; i < nbfiles; ++i) {
+            int status_index = gfal_srm_status_index(surls[i], status_surls, taken, n_statuses);
+            if (status_index < 0) {
+                gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(), EIO, __func__,
+                    "No status returned for the surl %s while putdone", surls[i]);
+                ret -= 1;
+            }
+            else if (statuses[status_index].status != 0) {
+                gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(), statuses[status_index].status,
+                    __func__, "Error on the surl %s while putdone : %s", surls[i],
+                    statuses[status_index].explanation);
+                ret -= 1;
+            }
+        }
+        if (statuses != NULL)
+            gfal_srm_external_call.srm_srmv2_filestatus_delete(statuses, n_statuses);
+    }
+
+    return ret;
+}
+
+
+int gfal_srm_putdone_list(gfal_srmv2_opt *opts, int nbfiles, const char *const *surls,
+    const char *token, GError **errors)
+{
+    GError *tmp_err = NULL;
+    int i;
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "   -> [gfal_srm_putdone_list] ");
+    for (i = 0; i < nbfiles; ++i) {
+        gfal_srm_cache_stat_remove(opts, surls[i]);
+    }
+
+    gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surls[0], &tmp_err);
+    if (easy == NULL) {
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+        return -1;
+    }
+
+    char *decoded[nbfiles];
+    for (i = 0; i < nbfiles; ++i) {
+        decoded[i] = gfal2_srm_get_decoded_path(surls[i]);
+    }
+
+    int ret = gfal_srm_putdone_list_srmv2_internal(easy->srm_context, nbfiles, decoded, token, errors);
+    gfal_srm_ifce_easy_context_release(opts, easy);
+
+    for (i = 0; i < nbfiles; ++i) {
+        g_free(decoded[i]);
+    }
+
+    return ret;
+}
+
+
 static int srmv2_abort_request_internal(srm_context_t context, const char *surl,
     const char *req_token, GError **err)
 {
@@ -17,6 +17,7 @@
 
 
 #include <glib.h>
+#include <gfal_srm_ifce_types.h>
 #include "gfal_srm.h"
 
 
@@ -33,6 +34,22 @@ int gfal_srm_get_rd3_turl(plugin_handle ch, gfalt_params_t params,
 int gfal_srm_getTURL_checksum(plugin_handle ch, const char *surl,
     char *buff_turl, int size_turl, GError **err);
 
+// Resolve the TURLs of nbfiles surls, all on the same endpoint, with a single request
+// Return nbfiles, with resu[i] holding the result of surls[i], or -1 if the whole request failed.
+// The statuses are matched to the surls whatever the order of the response, and a surl without
+// a status fails with EIO. A TURL with a protocol that was not requested only fails its own entry.
+// Failed entries keep the request token, so the file can still be aborted or released.
+// The caller frees the tokens and resu
+int gfal_srm_getTURLS_list(gfal_srmv2_opt *opts, gfal_srm_params_t params,
+    int nbfiles, const char *const *surls, gfal_srm_result **resu, GError **err);
+
+int gfal_srm_putTURLS_list(gfal_srmv2_opt *opts, gfal_srm_params_t params,
+    int nbfiles, const char *const *surls, SRM_LONG64 *filesizes, gfal_srm_result **resu, GError **err);
+
+// Put done on nbfiles surls belonging to the same request, errors must have space for nbfiles
+int gfal_srm_putdone_list(gfal_srmv2_opt *opts, int nbfiles, const char *const *surls,
+    const char *token, GError **errors);
+
 int reorder_rd3_sup_protocols(char **sup_protocols, const char *other_surl);
 
 int srm_abort_request_plugin(plugin_handle *handle, const char *surl,
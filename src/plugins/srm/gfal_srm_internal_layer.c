@@ -26,6 +26,15 @@ const char *srm_config_turl_protocols = "TURL_PROTOCOLS";
 const char *srm_config_3rd_party_turl_protocols = "TURL_3RD_PARTY_PROTOCOLS";
 const char *srm_config_keep_alive = "KEEP_ALIVE";
 const char *srm_spacetokendesc = "SPACETOKENDESC";
+const char *srm_config_context_pool_size = "CONTEXT_POOL_SIZE";
+const char *srm_config_bulk_request_size = "BULK_REQUEST_SIZE";
+const char *srm_config_ls_cache_ttl = "LS_CACHE_TTL";
+const char *srm_config_ls_read_through = "LS_READ_THROUGH";
+const char *srm_config_ls_page_size = "LS_PAGE_SIZE";
+const char *srm_config_ls_page_max_size = "LS_PAGE_MAX_SIZE";
+const char *srm_config_ls_page_target_time = "LS_PAGE_TARGET_TIME";
+const char *srm_config_ls_prefetch_pages = "LS_PREFETCH_PAGES";
+const char *srm_config_ls_names_only = "LS_NAMES_ONLY";
 
 #include "gfal_srm_internal_layer.h"
 #include "gfal_srm_url_check.h"
@@ -137,15 +146,94 @@ static srm_context_t gfal_srm_ifce_context_setup(gfal2_context_t handle,
 }
 
 
-static int is_same_context(gfal_srmv2_opt *opts, const char *endpoint, const char *ucert, const char *ukey)
+struct gfal_srm_pooled_context {
+    srm_context_t context;
+    gchar *key;
+    // srm-ifce writes the error messages of the context here
+    char errbuf[GFAL_ERRMSG_LEN];
+};
+
+
+static void gfal_srm_pooled_context_free(gpointer data)
+{
+    struct gfal_srm_pooled_context *pooled = (struct gfal_srm_pooled_context *) data;
+    if (pooled) {
+        srm_context_free(pooled->context);
+        g_free(pooled->key);
+        g_free(pooled);
+    }
+}
+
+
+static void gfal_srm_pooled_context_free_foreach(gpointer data, gpointer user_data)
+{
+    gfal_srm_pooled_context_free(data);
+}
+
+
+static void gfal_srm_context_pool_queue_free(gpointer data)
+{
+    GQueue *idle = (GQueue *) data;
+    g_queue_foreach(idle, gfal_srm_pooled_context_free_foreach, NULL);
+    g_queue_free(idle);
+}
+
+
+void gfal_srm_context_pool_init(gfal_srmv2_opt *opts)
+{
+    opts->srm_context_pool_mutex = g_mutex_new();
+    opts->srm_context_pool = g_hash_table_new_full(g_str_hash, g_str_equal,
+        g_free, gfal_srm_context_pool_queue_free);
+}
+
+
+void gfal_srm_context_pool_destroy(gfal_srmv2_opt *opts)
 {
-    if (strcmp(opts->endpoint, endpoint) != 0)
-        return 0;
-    if ((ucert && strcmp(opts->x509_ucert, ucert) != 0) || (!ucert && opts->x509_ucert[0]))
-        return 0;
-    if ((ukey && strcmp(opts->x509_ukey, ukey) != 0) || (!ukey && opts->x509_ukey[0]))
-        return 0;
-    return 1;
+    g_hash_table_destroy(opts->srm_context_pool);
+    g_mutex_free(opts->srm_context_pool_mutex);
+}
+
+
+// Take an idle context for the given key out of the pool, if there is any
+static struct gfal_srm_pooled_context *gfal_srm_context_pool_get(gfal_srmv2_opt *opts, const char *key)
+{
+    struct gfal_srm_pooled_context *pooled = NULL;
+
+    g_mutex_lock(opts->srm_context_pool_mutex);
+    GQueue *idle = g_hash_table_lookup(opts->srm_context_pool, key);
+    if (idle) {
+        pooled = g_queue_pop_head(idle);
+    }
+    g_mutex_unlock(opts->srm_context_pool_mutex);
+
+    return pooled;
+}
+
+
+// Give back a context to the pool, or free it if there are already enough idle ones for its key
+static void gfal_srm_context_pool_put(gfal_srmv2_opt *opts, struct gfal_srm_pooled_context *pooled)
+{
+    const guint max_idle = (guint) gfal2_get_opt_integer_with_default(opts->handle,
+        srm_config_group, srm_config_context_pool_size, 4);
+
+    g_mutex_lock(opts->srm_context_pool_mutex);
+    GQueue *idle = g_hash_table_lookup(opts->srm_context_pool, pooled->key);
+    if (idle == NULL && max_idle > 0) {
+        idle = g_queue_new();
+        g_hash_table_insert(opts->srm_context_pool, g_strdup(pooled->key), idle);
+    }
+    // Most recently used first, so the warmest connection is picked up next
+    if (idle && g_queue_get_length(idle) < max_idle) {
+        g_queue_push_head(idle, pooled);
+        pooled = NULL;
+    }
+    g_mutex_unlock(opts->srm_context_pool_mutex);
+
+    // Closing the connection may block, so do it outside of the lock
+    if (pooled) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "SRM context pool full, releasing context");
+        gfal_srm_pooled_context_free(pooled);
+    }
 }
 
 
@@ -162,6 +250,19 @@ gfal_srm_easy_t gfal_srm_ifce_easy_context(gfal_srmv2_opt *opts,
         return NULL;
     }
 
+    switch (srm_types) {
+        case PROTO_SRMv2:
+            break;
+        case PROTO_SRM:
+            gfal2_set_error(err, gfal2_get_plugin_srm_quark(), EPROTONOSUPPORT,
+                __func__, "SRM v1 is not supported, failure");
+            return NULL;
+        default:
+            gfal2_set_error(err, gfal2_get_plugin_srm_quark(), EPROTONOSUPPORT,
+                __func__, "Unknown version of the protocol SRM, failure");
+            return NULL;
+    }
+
     gchar *ucert = gfal2_cred_get(opts->handle, GFAL_CRED_X509_CERT, surl, &baseurl, err);
     if (*err) {
         return NULL;
@@ -169,78 +270,49 @@ gfal_srm_easy_t gfal_srm_ifce_easy_context(gfal_srmv2_opt *opts,
 
     gchar *ukey = gfal2_cred_get(opts->handle, GFAL_CRED_X509_KEY, surl, &baseurl, err);
     if (*err) {
+        g_free(ucert);
         return NULL;
     }
 
-    if (!baseurl || !*baseurl) {
-        baseurl = full_endpoint;
-    }
-
-    g_static_rec_mutex_lock(&opts->srm_context_mutex);
+    gchar *key = g_strdup_printf("%s\n%s\n%s", full_endpoint, ucert ? ucert : "", ukey ? ukey : "");
 
-    // Try with existing one
-    if (opts->srm_context) {
-        if (is_same_context(opts, baseurl, ucert, ukey)) {
-            gfal2_log(G_LOG_LEVEL_DEBUG, "SRM context recycled for %s", baseurl);
-        }
-        else {
-            gfal2_log(G_LOG_LEVEL_DEBUG, "SRM context invalidated for %s", baseurl);
-            srm_context_free(opts->srm_context);
-            opts->srm_context = NULL;
-        }
+    // Try with an idle one
+    struct gfal_srm_pooled_context *pooled = gfal_srm_context_pool_get(opts, key);
+    if (pooled) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "SRM context recycled for %s", full_endpoint);
+        g_free(key);
     }
-    else {
-        gfal2_log(G_LOG_LEVEL_DEBUG, "SRM context not available");
-    }
-
     // Instantiate if we haven't got any
-    if (opts->srm_context == NULL) {
-        switch (srm_types) {
-            case PROTO_SRMv2:
-                opts->srm_context = gfal_srm_ifce_context_setup(opts->handle, full_endpoint,
-                    ucert, ukey,
-                    opts->srm_ifce_error_buffer, sizeof(opts->srm_ifce_error_buffer),
-                    &nested_error);
-                if (nested_error)
-                    gfal2_propagate_prefixed_error(err, nested_error, __func__);
-                break;
-            case PROTO_SRM:
-                gfal2_set_error(err, gfal2_get_plugin_srm_quark(), EPROTONOSUPPORT,
-                    __func__, "SRM v1 is not supported, failure");
-                return NULL;
-            default:
-                gfal2_set_error(err, gfal2_get_plugin_srm_quark(), EPROTONOSUPPORT,
-                    __func__, "Unknown version of the protocol SRM, failure");
-                return NULL;
+    else {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "SRM context not available for %s, creating a new one", full_endpoint);
+        pooled = g_new0(struct gfal_srm_pooled_context, 1);
+        pooled->key = key;
+        pooled->context = gfal_srm_ifce_context_setup(opts->handle, full_endpoint,
+            ucert, ukey, pooled->errbuf, sizeof(pooled->errbuf), &nested_error);
+        if (pooled->context == NULL) {
+            gfal2_propagate_prefixed_error(err, nested_error, __func__);
+            gfal_srm_pooled_context_free(pooled);
+            pooled = NULL;
         }
     }
 
-    // Configure
-    gfal_srm_easy_t easy = g_malloc0(sizeof(struct gfal_srm_easy));
-
-    easy->path = gfal2_srm_get_decoded_path(surl);
-
-    if (opts->srm_context) {
-        g_strlcpy(opts->endpoint, full_endpoint, GFAL_URL_MAX_LEN);
-        if (ucert) {
-            g_strlcpy(opts->x509_ucert, ucert, GFAL_URL_MAX_LEN);
-        }
-        if (ukey) {
-            g_strlcpy(opts->x509_ukey, ukey, sizeof(opts->x509_ukey));
-        }
+    g_free(ucert);
+    g_free(ukey);
 
-        time_t request_lifetime = gfal2_get_opt_integer_with_default(opts->handle,
-            srm_config_group, srm_desired_request_lifetime, 3600);
-        srm_set_desired_request_time(opts->srm_context, request_lifetime);
-    }
-    else {
-        g_static_rec_mutex_unlock(&opts->srm_context_mutex);
+    if (pooled == NULL) {
+        return NULL;
     }
 
-    g_free(ucert);
-    g_free(ukey);
+    // Configure
+    time_t request_lifetime = gfal2_get_opt_integer_with_default(opts->handle,
+        srm_config_group, srm_desired_request_lifetime, 3600);
+    srm_set_desired_request_time(pooled->context, request_lifetime);
+    pooled->errbuf[0] = '\0';
 
-    easy->srm_context = opts->srm_context;
+    gfal_srm_easy_t easy = g_malloc0(sizeof(struct gfal_srm_easy));
+    easy->path = gfal2_srm_get_decoded_path(surl);
+    easy->srm_context = pooled->context;
+    easy->pooled = pooled;
     return easy;
 }
 
@@ -248,10 +320,13 @@ gfal_srm_easy_t gfal_srm_ifce_easy_context(gfal_srmv2_opt *opts,
 void gfal_srm_ifce_easy_context_release(gfal_srmv2_opt *opts,
     gfal_srm_easy_t easy)
 {
-    if (opts) {
-        g_static_rec_mutex_unlock(&opts->srm_context_mutex);
-    }
     if (easy) {
+        if (opts && easy->pooled) {
+            gfal_srm_context_pool_put(opts, easy->pooled);
+        }
+        else {
+            gfal_srm_pooled_context_free(easy->pooled);
+        }
         g_free(easy->path);
         g_free(easy);
     }
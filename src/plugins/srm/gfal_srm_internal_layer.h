@@ -34,6 +34,14 @@ extern const char *srm_config_transfer_checksum;
 extern const char *srm_config_turl_protocols;
 extern const char *srm_config_3rd_party_turl_protocols;
 extern const char *srm_spacetokendesc;
+extern const char *srm_config_bulk_request_size;
+extern const char *srm_config_ls_cache_ttl;
+extern const char *srm_config_ls_read_through;
+extern const char *srm_config_ls_page_size;
+extern const char *srm_config_ls_page_max_size;
+extern const char *srm_config_ls_page_target_time;
+extern const char *srm_config_ls_prefetch_pages;
+extern const char *srm_config_ls_names_only;
 
 // request type for surl <-> turl translation
 typedef enum _srm_req_type {
@@ -42,9 +50,13 @@ typedef enum _srm_req_type {
 } srm_req_type;
 
 
+struct gfal_srm_pooled_context;
+
 struct gfal_srm_easy {
     srm_context_t srm_context;
     char *path;
+    // Pool entry owning srm_context, given back on release
+    struct gfal_srm_pooled_context *pooled;
 };
 
 typedef struct gfal_srm_easy *gfal_srm_easy_t;
@@ -144,6 +156,10 @@ int gfal_srm_putdone(gfal_srmv2_opt *opts, const char *surl, const char *token,
 
 void gfal_srm_report_error(char *errbuff, GError **err);
 
+void gfal_srm_context_pool_init(gfal_srmv2_opt *opts);
+
+void gfal_srm_context_pool_destroy(gfal_srmv2_opt *opts);
+
 gfal_srm_easy_t gfal_srm_ifce_easy_context(gfal_srmv2_opt *opts,
     const char *surl, GError **err);
 
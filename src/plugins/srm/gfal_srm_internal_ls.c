@@ -20,6 +20,8 @@
 
 #include "gfal_srm_internal_ls.h"
 #include "gfal_srm_endpoint.h"
+#include "gfal_srm_opendir.h"
+#include "gfal_srm_url_check.h"
 
 
 /*
@@ -126,11 +128,27 @@ int gfal_statG_srmv2__generic_internal(srm_context_t context, struct stat *buf,
     G_RETURN_ERR(ret, tmp_err, err);
 }
 
+// Keys are built on the decoded surl, so an entry is found whatever the form of the surl
+void gfal_srm_cache_stat_key(const char *surl, char *buff, size_t s_buff)
+{
+    char *decoded = gfal2_srm_get_decoded_path(surl);
+    gfal_srm_construct_key(decoded, GFAL_SRM_LSTAT_PREFIX, buff, s_buff);
+    g_free(decoded);
+}
+
+int gfal_srm_cache_stat_get(plugin_handle ch, const char *surl, struct extended_stat *xstat)
+{
+    char buff_key[GFAL_URL_MAX_LEN];
+    gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
+    gfal_srm_cache_stat_key(surl, buff_key, GFAL_URL_MAX_LEN);
+    return gsimplecache_take_one_kstr(opts->cache, buff_key, xstat);
+}
+
 int gfal_srm_cache_stat_add(plugin_handle ch, const char *surl, const struct stat *value, const TFileLocality *loc)
 {
     char buff_key[GFAL_URL_MAX_LEN];
     gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
-    gfal_srm_construct_key(surl, GFAL_SRM_LSTAT_PREFIX, buff_key, GFAL_URL_MAX_LEN);
+    gfal_srm_cache_stat_key(surl, buff_key, GFAL_URL_MAX_LEN);
 
     struct extended_stat xstat;
     xstat.stat = *value;
@@ -140,10 +158,38 @@ int gfal_srm_cache_stat_add(plugin_handle ch, const char *surl, const struct sta
     return 0;
 }
 
-void gfal_srm_cache_stat_remove(plugin_handle ch, const char *surl)
+char *gfal_srm_get_decoded_parent(const char *surl)
+{
+    char *parent = gfal2_srm_get_decoded_path(surl);
+    char *p = strrchr(parent, '/');
+    // Nothing to do for the root, or anything that does not look like a path
+    if (p == NULL || p == parent || *(p - 1) == '/') {
+        g_free(parent);
+        return NULL;
+    }
+    for (; p > parent && *p == '/'; --p) {
+        *p = '\0';
+    }
+    return parent;
+}
+
+static void gfal_srm_cache_stat_remove_entry(gfal_srmv2_opt *opts, const char *surl)
 {
     char buff_key[GFAL_URL_MAX_LEN];
-    gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
-    gfal_srm_construct_key(surl, GFAL_SRM_LSTAT_PREFIX, buff_key, GFAL_URL_MAX_LEN);
+    gfal_srm_cache_stat_key(surl, buff_key, GFAL_URL_MAX_LEN);
     gsimplecache_remove_kstr(opts->cache, buff_key);
+    gfal_srm_ls_history_remove(opts, surl);
+}
+
+// Anything changing surl changes its parent listing as well
+void gfal_srm_cache_stat_remove(plugin_handle ch, const char *surl)
+{
+    gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
+    gfal_srm_cache_stat_remove_entry(opts, surl);
+
+    char *parent = gfal_srm_get_decoded_parent(surl);
+    if (parent != NULL) {
+        gfal_srm_cache_stat_remove_entry(opts, parent);
+        g_free(parent);
+    }
 }
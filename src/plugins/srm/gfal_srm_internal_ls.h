@@ -18,6 +18,8 @@
  * limitations under the License.
  */
 
+#pragma once
+
 #include "gfal_srm.h"
 #include "gfal_srm_internal_layer.h"
 
@@ -30,6 +32,18 @@ struct extended_stat {
 int gfal_statG_srmv2__generic_internal(srm_context_t context, struct stat *buf, TFileLocality *loc,
     const char *surl, GError **err);
 
+void gfal_srm_ls_memory_management(struct srm_ls_input *input, struct srm_ls_output *output);
+
+void gfal_srm_cache_stat_key(const char *surl, char *buff, size_t s_buff);
+
+// Return 0 and fill xstat if surl is in the stat cache
+int gfal_srm_cache_stat_get(plugin_handle ch, const char *surl, struct extended_stat *xstat);
+
 int gfal_srm_cache_stat_add(plugin_handle ch, const char *surl, const struct stat *value, const TFileLocality *loc);
 
+// Return the decoded surl of the parent of surl, or NULL for the root
+char *gfal_srm_get_decoded_parent(const char *surl);
+
+// Invalidate the cached stat and listing of surl, and of its parent
+// Must be called by any operation that modifies surl
 void gfal_srm_cache_stat_remove(plugin_handle ch, const char *surl);
@@ -22,6 +22,7 @@
 #include "gfal_srm_namespace.h"
 #include "gfal_srm_internal_layer.h"
 #include "gfal_srm_endpoint.h"
+#include "gfal_srm_internal_ls.h"
 
 
 static int gfal_mkdir_srmv2_internal(srm_context_t context, const char *path, mode_t mode, GError **err)
@@ -51,6 +52,7 @@ int gfal_srm_mkdir_recG(plugin_handle ch, const char *surl, mode_t mode, GError
     int ret = -1;
 
     gfal2_log(G_LOG_LEVEL_DEBUG, "  ->  [gfal_srm_mkdir_recG] ");
+    gfal_srm_cache_stat_remove(ch, surl);
     gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surl, &tmp_err);
     if (easy != NULL) {
         gfal2_log(G_LOG_LEVEL_DEBUG, "   [gfal_srm_mkdir_recG] try to create directory %s", surl);
@@ -89,6 +91,8 @@ int gfal_srm_mkdirG(plugin_handle ch, const char *surl, mode_t mode, gboolean pf
 
     int ret = -1;
 
+    gfal_srm_cache_stat_remove(ch, surl);
+
     if (pflag) { // pflag set : behavior similar to mkdir -p requested
         ret = gfal_srm_mkdir_recG(ch, surl, mode, &tmp_err);
     }
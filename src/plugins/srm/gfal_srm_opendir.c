@@ -77,7 +77,34 @@ static void _parse_opendir_parameters(char *parameters, gfal_srm_opendir_handle
     }
 }
 
-static gfal_file_handle gfal_srm_opendir_internal(gfal_srm_easy_t easy, GError **err)
+// Page sizes and prefetch depth for chunked listings
+static void _set_paging_parameters(gfal_srmv2_opt *opts, gfal_srm_opendir_handle h)
+{
+    const int page_size = gfal2_get_opt_integer_with_default(opts->handle,
+        srm_config_group, srm_config_ls_page_size, 1000);
+
+    h->chunk_min = MIN(100, page_size > 0 ? page_size : 1000);
+    h->chunk_max = MAX(gfal2_get_opt_integer_with_default(opts->handle,
+        srm_config_group, srm_config_ls_page_max_size, 10000), h->chunk_min);
+    h->chunk_target_time = ((gint64) gfal2_get_opt_integer_with_default(opts->handle,
+        srm_config_group, srm_config_ls_page_target_time, 5)) * G_USEC_PER_SEC;
+    h->max_pages = MAX(gfal2_get_opt_integer_with_default(opts->handle,
+        srm_config_group, srm_config_ls_prefetch_pages, 2), 1);
+
+    // Page size given by the user, keep it
+    if (h->chunk_size > 0) {
+        h->chunk_fixed = 1;
+        h->chunk_confirmed = h->chunk_size;
+    }
+    // Paged by default, otherwise try the whole directory first
+    else if (h->is_chunked_listing || page_size > 0) {
+        h->is_chunked_listing = 1;
+        h->chunk_size = MIN(page_size > 0 ? page_size : 1000, h->chunk_max);
+        h->chunk_confirmed = h->chunk_size;
+    }
+}
+
+static gfal_file_handle gfal_srm_opendir_internal(gfal_srmv2_opt *opts, gfal_srm_easy_t easy, GError **err)
 {
     // As extra parameters may be passed separated with ';',
     // we need to remove those from the surl, and then process them
@@ -92,7 +119,12 @@ static gfal_file_handle gfal_srm_opendir_internal(gfal_srm_easy_t easy, GError *
     if (exist == 0) {
         if (S_ISDIR(st.st_mode)) {
             gfal_srm_opendir_handle h = g_new0(struct _gfal_srm_opendir_handle, 1);
+            h->opts = opts;
             h->easy = easy;
+            h->cache_ttl = gfal2_get_opt_integer_with_default(opts->handle,
+                srm_config_group, srm_config_ls_cache_ttl, 60);
+            h->names_only = gfal2_get_opt_boolean_with_default(opts->handle,
+                srm_config_group, srm_config_ls_names_only, FALSE);
 
             char *p = stpncpy(h->surl, real_path, GFAL_URL_MAX_LEN);
             // remove trailing '/'
@@ -101,6 +133,7 @@ static gfal_file_handle gfal_srm_opendir_internal(gfal_srm_easy_t easy, GError *
             }
 
             _parse_opendir_parameters(parameters, h);
+            _set_paging_parameters(opts, h);
             resu = gfal_file_handle_new2(gfal_srm_getName(), (gpointer) h, NULL, real_path);
         }
         else {
@@ -127,7 +160,7 @@ gfal_file_handle gfal_srm_opendirG(plugin_handle handle, const char *surl, GErro
 
     gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surl, &tmp_err);
     if (easy) {
-        resu = gfal_srm_opendir_internal(easy, &tmp_err);
+        resu = gfal_srm_opendir_internal(opts, easy, &tmp_err);
     }
     if (tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
@@ -143,6 +176,7 @@ int gfal_srm_closedirG(plugin_handle handle, gfal_file_handle fh, GError **err)
     gfal_srmv2_opt *opts = (gfal_srmv2_opt *) handle;
     gfal_srm_opendir_handle oh = (gfal_srm_opendir_handle)gfal_file_handle_get_fdesc(fh);
 
+    gfal_srm_readdir_stop_prefetch(oh);
     gfal_srm_external_call.srm_srmv2_mdfilestatus_delete(oh->srm_file_statuses, 1);
     gfal_srm_ifce_easy_context_release(opts, oh->easy);
 
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "gfal_srm_internal_layer.h"
+#include "gfal_srm_internal_ls.h"
 #include <gfal_srm_ifce_types.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -29,6 +30,7 @@
 
 
 typedef struct _gfal_srm_opendir_handle {
+    gfal_srmv2_opt *opts;
     gfal_srm_easy_t easy;
 
     // SURL we are listing
@@ -45,6 +47,31 @@ typedef struct _gfal_srm_opendir_handle {
     int chunk_offset;
     int chunk_size;
 
+    // The page size adapts to the response time of the server, unless it was given by the user
+    int chunk_fixed;
+    int chunk_min, chunk_max;
+    gint64 chunk_target_time;
+    // Largest page the server answered in full
+    int chunk_confirmed;
+
+    // Pages are requested in the background, up to max_pages ahead of the reader.
+    // Once the prefetch thread is started, it owns the context and the chunk fields
+    GThread *prefetch_thread;
+    GMutex *prefetch_mutex;
+    GCond *prefetch_cond;
+    GQueue *pages;
+    guint max_pages;
+    gboolean prefetch_stop;
+    gboolean prefetch_done;
+    // The page being read is the last one
+    gboolean last_page;
+
+    // Do not cache the metadata of the entries when only names are read
+    gboolean names_only;
+
+    // How long the listed entries are kept in the stat cache, 0 to use the reference counted cache
+    time_t cache_ttl;
+
     // Array of file statuses as returned by srm-ifce
     struct srmv2_mdfilestatus *srm_file_statuses;
     // Array position inside srm_file_statuses while iterating
@@ -58,3 +85,17 @@ int gfal_srm_closedirG(plugin_handle handle, gfal_file_handle fh, GError **err);
 struct dirent *gfal_srm_readdirG(plugin_handle handle, gfal_file_handle fh, GError **err);
 
 struct dirent *gfal_srm_readdirppG(plugin_handle ch, gfal_file_handle fh, struct stat *st, GError **err);
+
+// Stop the prefetch thread, if any, and free the pages not read
+void gfal_srm_readdir_stop_prefetch(gfal_srm_opendir_handle oh);
+
+void gfal_srm_ls_history_init(gfal_srmv2_opt *opts);
+
+void gfal_srm_ls_history_destroy(gfal_srmv2_opt *opts);
+
+// Forget that surl was listed, so its listing is not read through anymore
+void gfal_srm_ls_history_remove(gfal_srmv2_opt *opts, const char *surl);
+
+// If the parent of surl was listed recently, list it again into the stat cache,
+// instead of stating surl on its own. Return 0 and fill xstat if surl is then in the cache
+int gfal_srm_readdir_read_through(plugin_handle ch, const char *surl, struct extended_stat *xstat);
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <uri/gfal2_uri.h>
+
+#include "gfal_srm_internal_layer.h"
+#include "gfal_srm_poll.h"
+
+const char *srm_config_poll_min_interval = "POLL_MIN_INTERVAL";
+const char *srm_config_poll_max_interval = "POLL_MAX_INTERVAL";
+
+// Entries not polled for this long are considered abandoned
+#define GFAL_SRM_POLL_EXPIRATION ((gint64) G_USEC_PER_SEC * 3600 * 24)
+
+
+struct gfal_srm_poll_status {
+    int status;
+    char *explanation;
+    int estimated_wait;
+};
+
+struct gfal_srm_poll_entry {
+    char *key;
+    GMutex *mutex;
+    int refcount;
+    // Monotonic time, in microseconds
+    gint64 next_poll;
+    gint64 last_used;
+    // Seconds
+    gint interval;
+    // surl -> struct gfal_srm_poll_status
+    GHashTable *files;
+};
+
+
+static void gfal_srm_poll_status_free(gpointer data)
+{
+    struct gfal_srm_poll_status *status = (struct gfal_srm_poll_status *) data;
+    g_free(status->explanation);
+    g_free(status);
+}
+
+
+static void gfal_srm_poll_entry_free(gpointer data)
+{
+    struct gfal_srm_poll_entry *entry = (struct gfal_srm_poll_entry *) data;
+    g_hash_table_destroy(entry->files);
+    g_mutex_free(entry->mutex);
+    g_free(entry->key);
+    g_free(entry);
+}
+
+
+void gfal_srm_poll_init(gfal_srmv2_opt *opts)
+{
+    opts->poll_mutex = g_mutex_new();
+    opts->poll_entries = g_hash_table_new_full(g_str_hash, g_str_equal,
+        NULL, gfal_srm_poll_entry_free);
+}
+
+
+void gfal_srm_poll_destroy(gfal_srmv2_opt *opts)
+{
+    g_hash_table_destroy(opts->poll_entries);
+    g_mutex_free(opts->poll_mutex);
+}
+
+
+// Request tokens are only unique per endpoint
+static char *gfal_srm_poll_key(const char *surl, const char *token)
+{
+    GError *error = NULL;
+    gfal2_uri *parsed = gfal2_parse_uri(surl, &error);
+    if (error != NULL) {
+        g_error_free(error);
+        return g_strdup_printf("%s|%s", surl, token);
+    }
+    char *key = g_strdup_printf("%s:%d|%s", parsed->host, parsed->port, token);
+    gfal2_free_uri(parsed);
+    return key;
+}
+
+
+static gboolean gfal_srm_poll_is_expired(gpointer key, gpointer value, gpointer user_data)
+{
+    struct gfal_srm_poll_entry *entry = (struct gfal_srm_poll_entry *) value;
+    gint64 now = *((gint64 *) user_data);
+    return entry->refcount == 0 && (now - entry->last_used) > GFAL_SRM_POLL_EXPIRATION;
+}
+
+
+gfal_srm_poll_entry_t gfal_srm_poll_acquire(gfal_srmv2_opt *opts, const char *surl, const char *token)
+{
+    char *key = gfal_srm_poll_key(surl, token);
+    gint64 now = g_get_monotonic_time();
+
+    g_mutex_lock(opts->poll_mutex);
+    g_hash_table_foreach_remove(opts->poll_entries, gfal_srm_poll_is_expired, &now);
+
+    struct gfal_srm_poll_entry *entry = g_hash_table_lookup(opts->poll_entries, key);
+    if (entry == NULL) {
+        entry = g_new0(struct gfal_srm_poll_entry, 1);
+        entry->key = key;
+        entry->mutex = g_mutex_new();
+        entry->files = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, gfal_srm_poll_status_free);
+        g_hash_table_insert(opts->poll_entries, entry->key, entry);
+    }
+    else {
+        g_free(key);
+    }
+    entry->refcount += 1;
+    entry->last_used = now;
+    g_mutex_unlock(opts->poll_mutex);
+
+    g_mutex_lock(entry->mutex);
+    return entry;
+}
+
+
+void gfal_srm_poll_release(gfal_srmv2_opt *opts, gfal_srm_poll_entry_t entry)
+{
+    if (entry == NULL)
+        return;
+
+    g_mutex_unlock(entry->mutex);
+
+    g_mutex_lock(opts->poll_mutex);
+    entry->refcount -= 1;
+    if (entry->refcount == 0 && g_hash_table_size(entry->files) == 0) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Stop tracking %s", entry->key);
+        g_hash_table_remove(opts->poll_entries, entry->key);
+    }
+    g_mutex_unlock(opts->poll_mutex);
+}
+
+
+gboolean gfal_srm_poll_is_due(gfal_srm_poll_entry_t entry, int nbfiles, const char *const *surls)
+{
+    int i;
+    if (g_get_monotonic_time() >= entry->next_poll)
+        return TRUE;
+    for (i = 0; i < nbfiles; ++i) {
+        if (g_hash_table_lookup(entry->files, surls[i]) == NULL)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+
+char **gfal_srm_poll_coalesce(gfal_srm_poll_entry_t entry, int nbfiles, const char *const *surls)
+{
+    GPtrArray *query = g_ptr_array_new();
+    GHashTable *included = g_hash_table_new(g_str_hash, g_str_equal);
+    GHashTableIter iter;
+    gpointer key, value;
+    int i;
+
+    for (i = 0; i < nbfiles; ++i) {
+        if (!g_hash_table_lookup(included, surls[i])) {
+            g_hash_table_insert(included, (gpointer) surls[i], (gpointer) surls[i]);
+            g_ptr_array_add(query, g_strdup(surls[i]));
+        }
+    }
+
+    g_hash_table_iter_init(&iter, entry->files);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        struct gfal_srm_poll_status *status = (struct gfal_srm_poll_status *) value;
+        if (status->status == EAGAIN && !g_hash_table_lookup(included, key)) {
+            g_ptr_array_add(query, g_strdup((const char *) key));
+        }
+    }
+
+    g_hash_table_destroy(included);
+    g_ptr_array_add(query, NULL);
+    return (char **) g_ptr_array_free(query, FALSE);
+}
+
+
+void gfal_srm_poll_update(gfal_srm_poll_entry_t entry, const char *surl, int status,
+    const char *explanation, int estimated_wait)
+{
+    struct gfal_srm_poll_status *file_status = g_new0(struct gfal_srm_poll_status, 1);
+    file_status->status = status;
+    file_status->explanation = g_strdup(explanation ? explanation : "");
+    file_status->estimated_wait = estimated_wait;
+    g_hash_table_replace(entry->files, g_strdup(surl), file_status);
+}
+
+
+gint gfal_srm_poll_next_interval(gint interval, gint estimated_wait, gint min_interval, gint max_interval)
+{
+    if (estimated_wait > 0) {
+        interval = estimated_wait;
+    }
+    else if (interval <= 0) {
+        interval = min_interval;
+    }
+    else {
+        interval = (interval > max_interval / 2) ? max_interval : interval * 2;
+    }
+    return CLAMP(interval, min_interval, max_interval);
+}
+
+
+gint64 gfal_srm_poll_jittered_delay(gint interval, gdouble random)
+{
+    gdouble jitter = 1.0 - GFAL_SRM_POLL_JITTER + 2 * GFAL_SRM_POLL_JITTER * CLAMP(random, 0.0, 1.0);
+    return (gint64) (interval * jitter * G_USEC_PER_SEC);
+}
+
+
+void gfal_srm_poll_schedule(gfal2_context_t context, gfal_srm_poll_entry_t entry)
+{
+    const gint min_interval = MAX(1, gfal2_get_opt_integer_with_default(context,
+        srm_config_group, srm_config_poll_min_interval, 2));
+    const gint max_interval = MAX(min_interval, gfal2_get_opt_integer_with_default(context,
+        srm_config_group, srm_config_poll_max_interval, 600));
+
+    GHashTableIter iter;
+    gpointer value;
+    gint estimated_wait = 0;
+
+    // The smallest estimation of the server for the pending files, if any
+    g_hash_table_iter_init(&iter, entry->files);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        struct gfal_srm_poll_status *status = (struct gfal_srm_poll_status *) value;
+        if (status->status == EAGAIN && status->estimated_wait > 0 &&
+            (estimated_wait == 0 || status->estimated_wait < estimated_wait)) {
+            estimated_wait = status->estimated_wait;
+        }
+    }
+
+    entry->interval = gfal_srm_poll_next_interval(entry->interval, estimated_wait,
+        min_interval, max_interval);
+    gint64 delay = gfal_srm_poll_jittered_delay(entry->interval, g_random_double());
+    entry->next_poll = g_get_monotonic_time() + delay;
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Next status query for %s in %.1f seconds",
+        entry->key, (double) delay / G_USEC_PER_SEC);
+}
+
+
+gboolean gfal_srm_poll_get(gfal_srm_poll_entry_t entry, const char *surl, int *status,
+    const char **explanation)
+{
+    struct gfal_srm_poll_status *file_status = g_hash_table_lookup(entry->files, surl);
+    if (file_status == NULL)
+        return FALSE;
+    *status = file_status->status;
+    *explanation = file_status->explanation;
+    return TRUE;
+}
+
+
+void gfal_srm_poll_forget(gfal_srm_poll_entry_t entry, const char *surl)
+{
+    g_hash_table_remove(entry->files, surl);
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include "gfal_srm.h"
+
+/*
+ * Client side scheduling of the status polls of asynchronous requests
+ *
+ * Outstanding request tokens are tracked per endpoint, together with the last known
+ * status of their files. A poll arriving before the token is due is answered from
+ * the last known statuses, and a due poll queries all the pending files of the token
+ * at once. The delay between queries grows exponentially, is driven by the
+ * estimatedWaitTime of the server when there is one, and is jittered so requests
+ * submitted together do not keep hitting the endpoint at the same time.
+ */
+
+// Relative jitter applied to the delay between queries
+#define GFAL_SRM_POLL_JITTER 0.2
+
+typedef struct gfal_srm_poll_entry *gfal_srm_poll_entry_t;
+
+void gfal_srm_poll_init(gfal_srmv2_opt *opts);
+
+void gfal_srm_poll_destroy(gfal_srmv2_opt *opts);
+
+// Get, creating it if needed, and lock the tracking entry of the token
+// surl is used to identify the endpoint
+gfal_srm_poll_entry_t gfal_srm_poll_acquire(gfal_srmv2_opt *opts, const char *surl, const char *token);
+
+// Unlock the entry. It is forgotten once it doesn't track any file
+void gfal_srm_poll_release(gfal_srmv2_opt *opts, gfal_srm_poll_entry_t entry);
+
+// TRUE if the endpoint must be queried for these surls: the token is due, or one of them is unknown
+gboolean gfal_srm_poll_is_due(gfal_srm_poll_entry_t entry, int nbfiles, const char *const *surls);
+
+// Surls to query: the requested ones, plus the pending ones tracked under the same token
+// Free with g_strfreev
+char **gfal_srm_poll_coalesce(gfal_srm_poll_entry_t entry, int nbfiles, const char *const *surls);
+
+// Record the status of a file, as returned by the endpoint (0, EAGAIN, or an error code)
+// estimated_wait is the estimatedWaitTime in seconds, <= 0 if unknown
+void gfal_srm_poll_update(gfal_srm_poll_entry_t entry, const char *surl, int status,
+    const char *explanation, int estimated_wait);
+
+// Next interval between queries, in seconds: the estimation of the server if known (> 0),
+// else the previous interval doubled, or min_interval for the first one. Clamped to [min_interval, max_interval]
+gint gfal_srm_poll_next_interval(gint interval, gint estimated_wait, gint min_interval, gint max_interval);
+
+// Delay before the next query, in microseconds: interval jittered by GFAL_SRM_POLL_JITTER
+// random is uniformly distributed in [0, 1)
+gint64 gfal_srm_poll_jittered_delay(gint interval, gdouble random);
+
+// Schedule the next query after an update
+void gfal_srm_poll_schedule(gfal2_context_t context, gfal_srm_poll_entry_t entry);
+
+// Last known status of the file. Return FALSE if unknown
+gboolean gfal_srm_poll_get(gfal_srm_poll_entry_t entry, const char *surl, int *status,
+    const char **explanation);
+
+// Stop tracking the file
+void gfal_srm_poll_forget(gfal_srm_poll_entry_t entry, const char *surl);
@@ -28,6 +28,10 @@
 #include "gfal_srm_opendir.h"
 #include "gfal_srm_internal_layer.h"
 #include "gfal_srm_internal_ls.h"
+#include "gfal_srm_url_check.h"
+
+
+static void gfal_srm_ls_history_add(plugin_handle ch, const char *surl, time_t ttl);
 
 
 /**
@@ -57,30 +61,75 @@ static void gfal_srm_stat64_to_stat(const struct stat64 *st64, struct stat *st)
 }
 
 
+/**
+ * Builds the full surl of an entry returned by srm_ls from the surl of its parent
+ * Returns the name of the entry
+ */
+static const char *gfal_srm_readdir_child_surl(const char *parent_surl,
+    const struct srmv2_mdfilestatus *srm_status, char *buff_surlfull, size_t s_buff)
+{
+    const char *name = strrchr(srm_status->surl, '/');
+    if (name != NULL)
+        ++name;
+    else
+        name = srm_status->surl;
+
+    g_strlcpy(buff_surlfull, parent_surl, s_buff);
+    g_strlcat(buff_surlfull, "/", s_buff);
+    g_strlcat(buff_surlfull, name, s_buff);
+    return name;
+}
+
+
+/**
+ * Stores a whole chunk of a listing in the stat cache, so stats that follow the listing
+ * of a directory are answered locally, as many times as needed until ttl expires
+ */
+static void gfal_srm_cache_stat_add_listing(plugin_handle ch, const char *parent_surl,
+    const struct srmv2_mdfilestatus *listing, time_t ttl)
+{
+    gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
+    const int n_items = listing->nbsubpaths;
+    if (n_items <= 0)
+        return;
+
+    char **keys = g_new0(char*, n_items);
+    struct extended_stat *xstats = g_new0(struct extended_stat, n_items);
+    char buff_surlfull[GFAL_URL_MAX_LEN];
+    char buff_key[GFAL_URL_MAX_LEN];
+    int i;
+
+    for (i = 0; i < n_items; ++i) {
+        const struct srmv2_mdfilestatus *entry = &listing->subpaths[i];
+        gfal_srm_readdir_child_surl(parent_surl, entry, buff_surlfull, sizeof(buff_surlfull));
+        gfal_srm_cache_stat_key(buff_surlfull, buff_key, sizeof(buff_key));
+        keys[i] = g_strdup(buff_key);
+        gfal_srm_stat64_to_stat(&entry->stat, &xstats[i].stat);
+        xstats[i].locality = entry->locality;
+    }
+
+    gsimplecache_add_items_ttl_kstr(opts->cache, n_items, (const char* const*) keys, xstats, ttl);
+
+    for (i = 0; i < n_items; ++i)
+        g_free(keys[i]);
+    g_free(keys);
+    g_free(xstats);
+}
+
+
 /**
  * Converts a SRM status into a dirent + struct stat
  * Returns, for convenience, the same pointer passed as dir_ent
  */
 static struct dirent *gfal_srm_readdir_convert_result(plugin_handle ch,
-    const char *parent_surl, const struct srmv2_mdfilestatus *srm_status,
+    gfal_srm_opendir_handle oh, const struct srmv2_mdfilestatus *srm_status,
     struct dirent *dir_ent, struct stat *st, GError **err)
 {
     char buff_surlfull[GFAL_URL_MAX_LEN];
 
-    char *p = strrchr(srm_status->surl, '/');
-    if (p != NULL) {
-        g_strlcpy(buff_surlfull, parent_surl, GFAL_URL_MAX_LEN);
-        g_strlcat(buff_surlfull, p, GFAL_URL_MAX_LEN);
-
-        dir_ent->d_reclen = g_strlcpy(dir_ent->d_name, p + 1, GFAL_URL_MAX_LEN);
-    }
-    else {
-        g_strlcpy(buff_surlfull, parent_surl, GFAL_URL_MAX_LEN);
-        g_strlcat(buff_surlfull, "/", GFAL_URL_MAX_LEN);
-        g_strlcat(buff_surlfull, p, GFAL_URL_MAX_LEN);
-
-        dir_ent->d_reclen = g_strlcpy(dir_ent->d_name, srm_status->surl, GFAL_URL_MAX_LEN);
-    }
+    const char *name = gfal_srm_readdir_child_surl(oh->surl, srm_status,
+        buff_surlfull, sizeof(buff_surlfull));
+    dir_ent->d_reclen = g_strlcpy(dir_ent->d_name, name, sizeof(dir_ent->d_name));
 
     if (S_ISDIR(srm_status->stat.st_mode))
         dir_ent->d_type = DT_DIR;
@@ -90,8 +139,10 @@ static struct dirent *gfal_srm_readdir_convert_result(plugin_handle ch,
         dir_ent->d_type = DT_REG;
 
     gfal_srm_stat64_to_stat(&srm_status->stat, st);
-    // Stores cache information
-    gfal_srm_cache_stat_add(ch, buff_surlfull, st, &srm_status->locality);
+    // Stores cache information, unless the whole chunk has been cached already,
+    // or only the names are wanted
+    if (oh->cache_ttl <= 0 && !oh->names_only)
+        gfal_srm_cache_stat_add(ch, buff_surlfull, st, &srm_status->locality);
 
     return dir_ent;
 }
@@ -99,16 +150,17 @@ static struct dirent *gfal_srm_readdir_convert_result(plugin_handle ch,
 
 /**
  * Wraps the actual call to srm-ifce
+ * Returns the number of entries in the page, or -1 on error.
+ * On success, statuses must be freed by the caller
  */
-static int gfal_srm_readdir_internal(plugin_handle ch,
-    gfal_srm_opendir_handle oh, GError **err)
+static int gfal_srm_readdir_fetch(plugin_handle ch, gfal_srm_opendir_handle oh,
+    int offset, int count, struct srmv2_mdfilestatus **statuses, GError **err)
 {
-    g_return_val_err_if_fail(ch && oh, -1, err, "[gfal_srmv2_opendir_internal] invaldi args");
+    g_return_val_err_if_fail(ch && oh, -1, err, "[gfal_srm_readdir_fetch] invalid args");
     GError *tmp_err = NULL;
     int resu = -1;
     struct srm_ls_input input;
     struct srm_ls_output output;
-    struct srmv2_mdfilestatus *srmv2_mdstatuses = NULL;
     int ret = -1;
 
     memset(&input, 0, sizeof(input));
@@ -119,27 +171,30 @@ static int gfal_srm_readdir_internal(plugin_handle ch,
     input.nbfiles = 1;
     input.surls = tab_surl;
     input.numlevels = 1;
-    input.count = oh->chunk_size;
+    input.count = count;
     // Mind that srm_ls may - or may not - modify the value pointed by input.offset
-    int offset_buffer = oh->chunk_offset;
+    int offset_buffer = offset;
     input.offset = &offset_buffer;
 
-    oh->response_index = 0;
     ret = gfal_srm_external_call.srm_ls(oh->easy->srm_context, &input, &output);
 
     if (ret >= 0) {
-        srmv2_mdstatuses = output.statuses;
-        if (srmv2_mdstatuses[0].status != 0) {
-            gfal2_set_error(err, gfal2_get_plugin_srm_quark(),
-                srmv2_mdstatuses->status, __func__,
+        if (output.statuses[0].status != 0) {
+            gfal2_set_error(&tmp_err, gfal2_get_plugin_srm_quark(),
+                output.statuses[0].status, __func__,
                 "Error reported from srm_ifce : %d %s",
-                srmv2_mdstatuses->status, srmv2_mdstatuses->explanation);
+                output.statuses[0].status, output.statuses[0].explanation);
+            gfal_srm_external_call.srm_srmv2_mdfilestatus_delete(output.statuses, 1);
             resu = -1;
-
         }
         else {
-            oh->srm_file_statuses = &srmv2_mdstatuses[0];
-            resu = 0;
+            *statuses = output.statuses;
+            if (oh->cache_ttl > 0 && !oh->names_only) {
+                gfal_srm_cache_stat_add_listing(ch, oh->surl, *statuses, oh->cache_ttl);
+                if (offset == 0)
+                    gfal_srm_ls_history_add(ch, oh->surl, oh->cache_ttl);
+            }
+            resu = (*statuses)->nbsubpaths;
         }
     }
     else {
@@ -152,6 +207,195 @@ static int gfal_srm_readdir_internal(plugin_handle ch,
 }
 
 
+/**
+ * A page of a paged listing, as queued by the prefetch thread
+ */
+struct gfal_srm_ls_page {
+    struct srmv2_mdfilestatus *statuses;
+    GError *error;
+    // Nothing comes after this page
+    gboolean last;
+};
+
+
+static void gfal_srm_ls_page_free(gpointer data)
+{
+    struct gfal_srm_ls_page *page = (struct gfal_srm_ls_page *) data;
+    if (page->statuses)
+        gfal_srm_external_call.srm_srmv2_mdfilestatus_delete(page->statuses, 1);
+    g_clear_error(&page->error);
+    g_free(page);
+}
+
+
+/**
+ * Page size for the next request.
+ * Grows while the server answers well within the target time, shrinks when it does not
+ */
+static void gfal_srm_readdir_adapt_chunk(gfal_srm_opendir_handle oh, gint64 elapsed)
+{
+    if (oh->chunk_fixed)
+        return;
+    int previous = oh->chunk_size;
+    if (elapsed > oh->chunk_target_time)
+        oh->chunk_size = MAX(oh->chunk_size / 2, oh->chunk_min);
+    else if (elapsed < oh->chunk_target_time / 2)
+        oh->chunk_size = MIN(oh->chunk_size * 2, oh->chunk_max);
+    if (previous != oh->chunk_size)
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Listing %s: page of %d entries took %" G_GINT64_FORMAT " ms, next page of %d",
+            oh->surl, previous, elapsed / 1000, oh->chunk_size);
+}
+
+
+/**
+ * Requests the pages of a chunked listing in the background, so the next page
+ * is on its way while the reader consumes the current one.
+ * Keeps at most max_pages pages queued.
+ */
+static gpointer gfal_srm_readdir_prefetch(gpointer data)
+{
+    gfal_srm_opendir_handle oh = (gfal_srm_opendir_handle) data;
+
+    g_mutex_lock(oh->prefetch_mutex);
+    while (!oh->prefetch_stop) {
+        while (!oh->prefetch_stop && g_queue_get_length(oh->pages) >= oh->max_pages)
+            g_cond_wait(oh->prefetch_cond, oh->prefetch_mutex);
+        if (oh->prefetch_stop)
+            break;
+        g_mutex_unlock(oh->prefetch_mutex);
+
+        struct gfal_srm_ls_page *page = g_new0(struct gfal_srm_ls_page, 1);
+        const int count = oh->chunk_size;
+        const gint64 start = g_get_monotonic_time();
+        int n = gfal_srm_readdir_fetch(oh->opts, oh, oh->chunk_offset, count,
+            &page->statuses, &page->error);
+        const gint64 elapsed = g_get_monotonic_time() - start;
+
+        if (n < 0 && page->error->code == EFBIG && !oh->chunk_fixed && count > oh->chunk_min) {
+            // Too much for the server, do not grow this big again
+            oh->chunk_size = oh->chunk_max = MAX(count / 2, oh->chunk_min);
+            gfal2_log(G_LOG_LEVEL_DEBUG, "EFBIG while listing %s, retrying with pages of %d",
+                oh->surl, oh->chunk_size);
+            gfal_srm_ls_page_free(page);
+            g_mutex_lock(oh->prefetch_mutex);
+            continue;
+        }
+
+        if (n < 0) {
+            page->last = TRUE;
+        }
+        else if (n == 0 || (n < count && count <= oh->chunk_confirmed)) {
+            page->last = TRUE;
+        }
+        else if (n < count) {
+            // The server may cap pages below what was asked, so this is not necessarily the end
+            oh->chunk_size = oh->chunk_max = oh->chunk_confirmed = n;
+        }
+        else {
+            oh->chunk_confirmed = MAX(oh->chunk_confirmed, count);
+            gfal_srm_readdir_adapt_chunk(oh, elapsed);
+        }
+        if (n > 0)
+            oh->chunk_offset += n;
+
+        g_mutex_lock(oh->prefetch_mutex);
+        g_queue_push_tail(oh->pages, page);
+        g_cond_broadcast(oh->prefetch_cond);
+        if (page->last)
+            break;
+    }
+    oh->prefetch_done = TRUE;
+    g_cond_broadcast(oh->prefetch_cond);
+    g_mutex_unlock(oh->prefetch_mutex);
+    return NULL;
+}
+
+
+void gfal_srm_readdir_stop_prefetch(gfal_srm_opendir_handle oh)
+{
+    if (oh->prefetch_thread == NULL)
+        return;
+
+    g_mutex_lock(oh->prefetch_mutex);
+    oh->prefetch_stop = TRUE;
+    g_cond_broadcast(oh->prefetch_cond);
+    g_mutex_unlock(oh->prefetch_mutex);
+    g_thread_join(oh->prefetch_thread);
+    oh->prefetch_thread = NULL;
+
+    g_queue_free_full(oh->pages, gfal_srm_ls_page_free);
+    g_cond_free(oh->prefetch_cond);
+    g_mutex_free(oh->prefetch_mutex);
+}
+
+
+static int gfal_srm_readdir_start_prefetch(gfal_srm_opendir_handle oh, GError **err)
+{
+    GError *tmp_err = NULL;
+
+    if (oh->chunk_size <= 0)
+        oh->chunk_size = oh->chunk_min;
+    if (oh->chunk_confirmed <= 0)
+        oh->chunk_confirmed = oh->chunk_size;
+
+    oh->pages = g_queue_new();
+    oh->prefetch_mutex = g_mutex_new();
+    oh->prefetch_cond = g_cond_new();
+    oh->prefetch_thread = g_thread_create(gfal_srm_readdir_prefetch, oh, TRUE, &tmp_err);
+    if (oh->prefetch_thread == NULL) {
+        g_queue_free(oh->pages);
+        g_cond_free(oh->prefetch_cond);
+        g_mutex_free(oh->prefetch_mutex);
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+/**
+ * Releases the current page, and waits for the next one, if any
+ */
+static int gfal_srm_readdir_next_page(gfal_srm_opendir_handle oh, GError **err)
+{
+    if (oh->srm_file_statuses != NULL) {
+        gfal_srm_external_call.srm_srmv2_mdfilestatus_delete(oh->srm_file_statuses, 1);
+        oh->srm_file_statuses = NULL;
+    }
+    oh->response_index = 0;
+
+    if (oh->last_page)
+        return 0;
+    if (oh->prefetch_thread == NULL && gfal_srm_readdir_start_prefetch(oh, err) < 0)
+        return -1;
+
+    g_mutex_lock(oh->prefetch_mutex);
+    while (g_queue_is_empty(oh->pages) && !oh->prefetch_done)
+        g_cond_wait(oh->prefetch_cond, oh->prefetch_mutex);
+    struct gfal_srm_ls_page *page = g_queue_pop_head(oh->pages);
+    // There is room in the queue now
+    g_cond_broadcast(oh->prefetch_cond);
+    g_mutex_unlock(oh->prefetch_mutex);
+
+    if (page == NULL) {
+        oh->last_page = TRUE;
+        return 0;
+    }
+
+    oh->last_page = page->last;
+    if (page->error) {
+        g_propagate_error(err, page->error);
+        page->error = NULL;
+        gfal_srm_ls_page_free(page);
+        return -1;
+    }
+    oh->srm_file_statuses = page->statuses;
+    page->statuses = NULL;
+    gfal_srm_ls_page_free(page);
+    return 1;
+}
+
+
 /**
  * Wraps the SRM request.
  * Request each chunks, then iterates through the responses as readdir is called
@@ -161,14 +405,23 @@ static struct dirent *gfal_srm_readdir_pipeline(plugin_handle ch,
 {
     GError *tmp_err = NULL;
 
-    // Nothing yet, so get the bulk
-    if (oh->srm_file_statuses == NULL) {
-        gfal_srm_readdir_internal(ch, oh, &tmp_err);
-        if (tmp_err) {
-            gfal2_propagate_prefixed_error(err, tmp_err, __func__);
-            return NULL;
+    if (oh->is_chunked_listing) {
+        // Current page consumed, so get the next one
+        if (oh->srm_file_statuses == NULL ||
+            oh->response_index >= oh->srm_file_statuses->nbsubpaths) {
+            gfal_srm_readdir_next_page(oh, &tmp_err);
         }
     }
+    // Nothing yet, so get the bulk
+    else if (oh->srm_file_statuses == NULL) {
+        oh->response_index = 0;
+        gfal_srm_readdir_fetch(ch, oh, oh->chunk_offset, oh->chunk_size,
+            &oh->srm_file_statuses, &tmp_err);
+    }
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return NULL;
+    }
 
     // Empty directory
     if (oh->srm_file_statuses == NULL || oh->srm_file_statuses->nbsubpaths == 0) {
@@ -181,47 +434,23 @@ static struct dirent *gfal_srm_readdir_pipeline(plugin_handle ch,
     }
 
     // Iterate and return statuses
-    struct dirent *ret = gfal_srm_readdir_convert_result(ch, oh->surl,
+    struct dirent *ret = gfal_srm_readdir_convert_result(ch, oh,
         &oh->srm_file_statuses->subpaths[oh->response_index], &oh->dirent_buffer,
         st, &tmp_err);
     oh->response_index++;
 
-    // If chunk listing, and the index passed the last entry in the buffer,
-    // release, and prepare next bulk
-    if (oh->is_chunked_listing && oh->response_index >= oh->chunk_size) {
-        oh->chunk_offset += oh->chunk_size;
-        gfal_srm_external_call.srm_srmv2_mdfilestatus_delete(oh->srm_file_statuses, 1);
-        oh->srm_file_statuses = NULL;
-    }
-
     return ret;
 }
 
 
 /**
- * Only read.
- * SRM listing returns the file stat anyway, so wrap Read + Stat and discard the stat
+ * Read, falling back to a chunked listing if the directory is too big for a single request
  */
-struct dirent *gfal_srm_readdirG(plugin_handle ch, gfal_file_handle fh, GError **err)
-{
-    g_return_val_err_if_fail(ch && fh, NULL, err, "[gfal_srm_readdirG] Invalid args");
-    struct stat _; // Ignore this
-    return gfal_srm_readdirppG(ch, fh, &_, err);
-}
-
-
-/**
- * Read + Stat
- */
-struct dirent *gfal_srm_readdirppG(plugin_handle ch,
-    gfal_file_handle fh, struct stat *st, GError **err)
+static struct dirent *gfal_srm_readdir_delegate(plugin_handle ch,
+    gfal_srm_opendir_handle oh, struct stat *st, GError **err)
 {
-    g_return_val_err_if_fail(ch && fh, NULL, err, "[gfal_srm_readdirppG] Invalid args");
     GError *tmp_err = NULL;
-
-    struct dirent *ret = NULL;
-    gfal_srm_opendir_handle oh = (gfal_srm_opendir_handle)gfal_file_handle_get_fdesc(fh);
-    ret = gfal_srm_readdir_pipeline(ch, oh, st, &tmp_err);
+    struct dirent *ret = gfal_srm_readdir_pipeline(ch, oh, st, &tmp_err);
 
     // Directory too big, so prepare to read in chunks and delegate
     if (tmp_err && tmp_err->code == EFBIG) {
@@ -253,3 +482,203 @@ struct dirent *gfal_srm_readdirppG(plugin_handle ch,
     }
     return ret;
 }
+
+
+/**
+ * Only read.
+ * SRM listing returns the file stat anyway, so wrap Read + Stat and discard the stat
+ */
+struct dirent *gfal_srm_readdirG(plugin_handle ch, gfal_file_handle fh, GError **err)
+{
+    g_return_val_err_if_fail(ch && fh, NULL, err, "[gfal_srm_readdirG] Invalid args");
+    struct stat _; // Ignore this
+    gfal_srm_opendir_handle oh = (gfal_srm_opendir_handle)gfal_file_handle_get_fdesc(fh);
+    return gfal_srm_readdir_delegate(ch, oh, &_, err);
+}
+
+
+/**
+ * Read + Stat
+ */
+struct dirent *gfal_srm_readdirppG(plugin_handle ch,
+    gfal_file_handle fh, struct stat *st, GError **err)
+{
+    g_return_val_err_if_fail(ch && fh, NULL, err, "[gfal_srm_readdirppG] Invalid args");
+    gfal_srm_opendir_handle oh = (gfal_srm_opendir_handle)gfal_file_handle_get_fdesc(fh);
+    // The stat is wanted, whatever the configuration says
+    if (oh->prefetch_thread == NULL)
+        oh->names_only = FALSE;
+    return gfal_srm_readdir_delegate(ch, oh, st, err);
+}
+
+
+/**
+ * Listing history
+ * Remembers which directories have been listed recently, so a stat on one of their entries,
+ * once the cached value is gone, can list the parent again instead of stating each entry
+ */
+struct gfal_srm_ls_history_entry {
+    gint64 expires;
+    // Only one read-through per listing, so a directory is not listed over and over
+    gboolean read_through;
+};
+
+// Prefetch by chunks, and never more than what fits in the stat cache
+#define GFAL_SRM_PREFETCH_CHUNK 1000
+#define GFAL_SRM_PREFETCH_MAX (GFAL_SRM_CACHE_SIZE - GFAL_SRM_PREFETCH_CHUNK)
+
+
+void gfal_srm_ls_history_init(gfal_srmv2_opt *opts)
+{
+    opts->ls_history_mutex = g_mutex_new();
+    opts->ls_history = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+}
+
+
+void gfal_srm_ls_history_destroy(gfal_srmv2_opt *opts)
+{
+    g_hash_table_destroy(opts->ls_history);
+    g_mutex_free(opts->ls_history_mutex);
+}
+
+
+static void gfal_srm_ls_history_add(plugin_handle ch, const char *surl, time_t ttl)
+{
+    gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
+    struct gfal_srm_ls_history_entry *entry = g_new0(struct gfal_srm_ls_history_entry, 1);
+    entry->expires = g_get_monotonic_time() + ((gint64) ttl) * G_USEC_PER_SEC;
+
+    g_mutex_lock(opts->ls_history_mutex);
+    // Do not let the history grow further than the cache it is there for
+    if (g_hash_table_size(opts->ls_history) >= GFAL_SRM_CACHE_SIZE)
+        g_hash_table_remove_all(opts->ls_history);
+    g_hash_table_replace(opts->ls_history, gfal2_srm_get_decoded_path(surl), entry);
+    g_mutex_unlock(opts->ls_history_mutex);
+}
+
+
+void gfal_srm_ls_history_remove(gfal_srmv2_opt *opts, const char *surl)
+{
+    char *decoded = gfal2_srm_get_decoded_path(surl);
+    g_mutex_lock(opts->ls_history_mutex);
+    g_hash_table_remove(opts->ls_history, decoded);
+    g_mutex_unlock(opts->ls_history_mutex);
+    g_free(decoded);
+}
+
+
+// Return TRUE if the parent was listed recently, and nobody read through it yet
+static gboolean gfal_srm_ls_history_claim(gfal_srmv2_opt *opts, const char *parent)
+{
+    gboolean claimed = FALSE;
+    g_mutex_lock(opts->ls_history_mutex);
+    struct gfal_srm_ls_history_entry *entry = g_hash_table_lookup(opts->ls_history, parent);
+    if (entry != NULL) {
+        if (entry->expires < g_get_monotonic_time()) {
+            g_hash_table_remove(opts->ls_history, parent);
+        }
+        else if (!entry->read_through) {
+            entry->read_through = TRUE;
+            claimed = TRUE;
+        }
+    }
+    g_mutex_unlock(opts->ls_history_mutex);
+    return claimed;
+}
+
+
+/**
+ * List surl by chunks into the stat cache
+ */
+static int gfal_srm_ls_prefetch(plugin_handle ch, const char *surl, time_t ttl, GError **err)
+{
+    gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
+    GError *tmp_err = NULL;
+    int offset = 0;
+    int ret = 0;
+
+    gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surl, &tmp_err);
+    if (easy == NULL) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+
+    char *tab_surl[] = {easy->path, NULL};
+
+    while (ret == 0 && offset < GFAL_SRM_PREFETCH_MAX) {
+        struct srm_ls_input input;
+        struct srm_ls_output output;
+        memset(&input, 0, sizeof(input));
+        memset(&output, 0, sizeof(output));
+
+        input.nbfiles = 1;
+        input.surls = tab_surl;
+        input.numlevels = 1;
+        input.count = GFAL_SRM_PREFETCH_CHUNK;
+        int offset_buffer = offset;
+        input.offset = &offset_buffer;
+
+        if (gfal_srm_external_call.srm_ls(easy->srm_context, &input, &output) < 0) {
+            gfal_srm_report_error(easy->srm_context->errbuf, &tmp_err);
+            ret = -1;
+        }
+        else if (output.statuses[0].status != 0) {
+            gfal2_set_error(&tmp_err, gfal2_get_plugin_srm_quark(),
+                output.statuses[0].status, __func__,
+                "Error reported from srm_ifce : %d %s",
+                output.statuses[0].status, output.statuses[0].explanation);
+            ret = -1;
+        }
+        else {
+            const int n_entries = output.statuses[0].nbsubpaths;
+            gfal_srm_cache_stat_add_listing(ch, easy->path, &output.statuses[0], ttl);
+            offset += n_entries;
+            if (n_entries < GFAL_SRM_PREFETCH_CHUNK)
+                ret = 1;
+        }
+        gfal_srm_ls_memory_management(&input, &output);
+    }
+
+    gfal_srm_ifce_easy_context_release(opts, easy);
+
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Prefetched %d entries of %s into the stat cache", offset, surl);
+    return 0;
+}
+
+
+int gfal_srm_readdir_read_through(plugin_handle ch, const char *surl, struct extended_stat *xstat)
+{
+    gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
+
+    if (!gfal2_get_opt_boolean_with_default(opts->handle, srm_config_group,
+            srm_config_ls_read_through, FALSE))
+        return -1;
+    time_t ttl = gfal2_get_opt_integer_with_default(opts->handle, srm_config_group,
+        srm_config_ls_cache_ttl, 60);
+    if (ttl <= 0)
+        return -1;
+
+    char *parent = gfal_srm_get_decoded_parent(surl);
+    if (parent == NULL)
+        return -1;
+
+    int ret = -1;
+    if (gfal_srm_ls_history_claim(opts, parent)) {
+        GError *tmp_err = NULL;
+        if (gfal_srm_ls_prefetch(ch, parent, ttl, &tmp_err) == 0) {
+            ret = gfal_srm_cache_stat_get(ch, surl, xstat);
+        }
+        else {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Read-through listing of %s failed: %s",
+                parent, tmp_err->message);
+            g_error_free(tmp_err);
+        }
+    }
+
+    g_free(parent);
+    return ret;
+}
@@ -23,6 +23,7 @@
 #include "gfal_srm_namespace.h"
 #include "gfal_srm_internal_layer.h"
 #include "gfal_srm_endpoint.h"
+#include "gfal_srm_opendir.h"
 
 
 int gfal_statG_srmv2_internal(srm_context_t context, struct stat *buf, TFileLocality *loc, const char *surl,
@@ -40,14 +41,13 @@ int gfal_srm_statG(plugin_handle ch, const char *surl, struct stat *buf, GError
     g_return_val_err_if_fail(ch && surl && buf, -1, err, "[gfal_srm_statG] Invalid args in handle/surl/buf");
     GError *tmp_err = NULL;
     int ret = -1;
-    char key_buff[GFAL_URL_MAX_LEN];
     gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
     TFileLocality loc;
     struct extended_stat xstat;
 
-    // Try cache first
-    gfal_srm_construct_key(surl, GFAL_SRM_LSTAT_PREFIX, key_buff, GFAL_URL_MAX_LEN);
-    if (gsimplecache_take_one_kstr(opts->cache, key_buff, &xstat) == 0) {
+    // Try cache first, then a listing of the parent if it was listed recently
+    if (gfal_srm_cache_stat_get(ch, surl, &xstat) == 0 ||
+        gfal_srm_readdir_read_through(ch, surl, &xstat) == 0) {
         gfal2_log(G_LOG_LEVEL_DEBUG,
             " srm_statG -> value taken from the cache");
         ret = 0;
@@ -54,7 +54,8 @@ gboolean plugin_url_check2(plugin_handle handle, gfal2_context_t context,
     gboolean src_valid_url = src_srm || srm_has_schema(src);
     gboolean dst_valid_url = dst_srm || srm_has_schema(dst);
 
-    return (type == GFAL_FILE_COPY && ((src_srm && dst_valid_url) || (dst_srm && src_valid_url)));
+    return ((type == GFAL_FILE_COPY || type == GFAL_BULK_COPY) &&
+        ((src_srm && dst_valid_url) || (dst_srm && src_valid_url)));
 }
 
 
@@ -21,13 +21,17 @@
 #include <ctype.h>
 #include <gfal_plugins_api.h>
 #include "gfal_xrootd_plugin_interface.h"
+#include "gfal_xrootd_plugin_parallelism.h"
 #include "gfal_xrootd_plugin_utils.h"
 #include "uri/gfal2_parsing.h"
 
 #undef TRUE
 #undef FALSE
 
+#include <map>
 #include <memory>
+#include <mutex>
+#include <sstream>
 #include <XrdCl/XrdClCopyProcess.hh>
 #include <XrdCl/XrdClFileSystem.hh>
 #include <XrdVersion.hh>
@@ -36,8 +40,10 @@
 class CopyFeedback: public XrdCl::CopyProgressHandler
 {
 public:
-    CopyFeedback(gfal2_context_t context, gfalt_params_t p, bool isThirdParty) :
-            context(context), params(p), startTime(0), isThirdParty(isThirdParty)
+    CopyFeedback(gfal2_context_t context, gfalt_params_t p, bool isThirdParty,
+            std::atomic<uint64_t>* bytesCounter = NULL) :
+            context(context), params(p), startTime(0), isThirdParty(isThirdParty),
+            bytesCounter(bytesCounter)
     {
         memset(&status, 0x00, sizeof(status));
     }
@@ -92,6 +98,15 @@ public:
     void JobProgress(uint16_t jobNum, uint64_t bytesProcessed,
             uint64_t bytesTotal)
     {
+        {
+            std::lock_guard<std::mutex> lock(this->bytesMutex);
+            uint64_t& previous = this->jobBytes[jobNum];
+            if (this->bytesCounter && bytesProcessed > previous) {
+                *this->bytesCounter += bytesProcessed - previous;
+            }
+            previous = bytesProcessed;
+        }
+
         time_t now = time(NULL);
         time_t elapsed = now - this->startTime;
 
@@ -119,6 +134,11 @@ private:
 
     std::string source, destination;
     bool isThirdParty;
+
+    // Bytes processed by each job, as last reported, and their sum
+    std::mutex bytesMutex;
+    std::map<uint16_t, uint64_t> jobBytes;
+    std::atomic<uint64_t>* bytesCounter;
 };
 
 
@@ -235,6 +255,83 @@ static void gfal_xrootd_evict_cache(gfal2_context_t context, const char* src)
     }
 }
 
+/// Key used to group the copy jobs
+static std::string gfal_xrootd_endpoint_pair(const XrdCl::URL& src, const XrdCl::URL& dst)
+{
+    std::ostringstream key;
+    key << src.GetProtocol() << "://" << src.GetHostName() << ":" << src.GetPort()
+        << " => "
+        << dst.GetProtocol() << "://" << dst.GetHostName() << ":" << dst.GetPort();
+    return key.str();
+}
+
+/// Run the given subset of jobs in a single CopyProcess
+/// Returns -1 only if the process could not be prepared, setting op_error
+static int gfal_xrootd_run_jobs(gfal2_context_t context, gfalt_params_t params,
+        std::vector<XrdCl::PropertyList>& jobs, std::vector<XrdCl::PropertyList>& results,
+        const std::vector<size_t>& indexes, int parallel, bool isThirdParty,
+        XrdCl::XRootDStatus& status, std::atomic<uint64_t>* bytesCounter, GError** op_error)
+{
+    XrdCl::CopyProcess copy_process;
+    std::vector<size_t>::const_iterator i;
+    for (i = indexes.begin(); i != indexes.end(); ++i) {
+        copy_process.AddJob(jobs[*i], &(results[*i]));
+    }
+
+    // Configuration job
+    XrdCl::PropertyList config_job;
+    config_job.Set("jobType", "configuration");
+    config_job.Set("parallel", parallel);
+    copy_process.AddJob(config_job, NULL);
+
+    status = copy_process.Prepare();
+    if (!status.IsOK()) {
+        xrootd2gliberr(op_error, __func__, "Error on XrdCl::CopyProcess::Prepare(): %s", status);
+        return -1;
+    }
+
+    CopyFeedback feedback(context, params, isThirdParty, bytesCounter);
+    status = copy_process.Run(&feedback);
+    return 0;
+}
+
+/// Run the jobs grouped by endpoint pair, all the pairs at the same time, adapting
+/// the number of parallel copies of each pair to its throughput
+static void gfal_xrootd_run_adaptive(gfal2_context_t context, gfalt_params_t params,
+        std::vector<XrdCl::PropertyList>& jobs, std::vector<XrdCl::PropertyList>& results,
+        const std::vector<std::string>& endpoints, int initial, int max, int interval, bool isThirdParty)
+{
+    AdaptiveScheduler scheduler(initial, max, std::chrono::seconds(std::max(1, interval)));
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        scheduler.Add(endpoints[i], i);
+    }
+
+    // One job per CopyProcess, so each one can start as soon as a slot is free
+    AdaptiveScheduler::RunFunc run = [&](size_t index, std::atomic<uint64_t>* bytes) -> bool {
+        XrdCl::XRootDStatus status;
+        GError* error = NULL;
+        std::vector<size_t> job(1, index);
+        if (gfal_xrootd_run_jobs(context, params, jobs, results, job, 1, isThirdParty,
+                status, bytes, &error) < 0) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "%s", error->message);
+            g_error_free(error);
+            results[index].Set("status", status);
+            return false;
+        }
+        return results[index].Get<XrdCl::XRootDStatus>("status").IsOK();
+    };
+    AdaptiveScheduler::SkipFunc skip = [&](size_t index) {
+        results[index].Set("status",
+            XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errOperationInterrupted, ECANCELED));
+    };
+    AdaptiveScheduler::CancelFunc canceled = [context]() -> bool {
+        return gfal2_is_canceled(context);
+    };
+
+    scheduler.Run(run, skip, canceled);
+}
+
+
 int gfal_xrootd_3rd_copy_bulk(plugin_handle plugin_data,
         gfal2_context_t context, gfalt_params_t params, size_t nbfiles,
         const char* const * srcs, const char* const * dsts,
@@ -250,11 +347,9 @@ int gfal_xrootd_3rd_copy_bulk(plugin_handle plugin_data,
         _checksumType, sizeof(_checksumType),
         _checksumValue, sizeof(_checksumValue), NULL);
 
-    XrdCl::CopyProcess copy_process;
-    std::vector<XrdCl::PropertyList> results;
-    for (size_t i = 0; i < nbfiles; ++i) {
-        results.push_back(XrdCl::PropertyList());
-    }
+    std::vector<XrdCl::PropertyList> jobs(nbfiles);
+    std::vector<XrdCl::PropertyList> results(nbfiles);
+    std::vector<std::string> endpoints(nbfiles);
 
     const char* src_spacetoken =  gfalt_get_src_spacetoken(params, NULL);
     const char* dst_spacetoken =  gfalt_get_dst_spacetoken(params, NULL);
@@ -264,7 +359,8 @@ int gfal_xrootd_3rd_copy_bulk(plugin_handle plugin_data,
         gfal_xrootd_3rd_init_url(context, source_url, srcs[i], src_spacetoken);
         gfal_xrootd_3rd_init_url(context, dest_url, dsts[i], dst_spacetoken);
 
-        XrdCl::PropertyList job;
+        XrdCl::PropertyList& job = jobs[i];
+        endpoints[i] = gfal_xrootd_endpoint_pair(source_url, dest_url);
         job.Set("source", source_url.GetURL());
         job.Set("target", dest_url.GetURL());
         job.Set("force", gfalt_get_replace_existing_file(params, NULL));
@@ -333,29 +429,35 @@ int gfal_xrootd_3rd_copy_bulk(plugin_handle plugin_data,
             job.Set("checkSumType", sChecksumType);
             job.Set("checkSumPreset", sChecksumValue);
         }
-
-        copy_process.AddJob(job, &(results[i]));
     }
 
-    // Configuration job
+    // Upper limit for the parallel copies
     int parallel = gfal2_get_opt_integer_with_default(context,
             XROOTD_CONFIG_GROUP, XROOTD_PARALLEL_COPIES,
             20);
 
-    XrdCl::PropertyList config_job;
-    config_job.Set("jobType", "configuration");
-    config_job.Set("parallel", parallel);
-    copy_process.AddJob(config_job, NULL);
-
-
-    XrdCl::XRootDStatus status = copy_process.Prepare();
-    if (!status.IsOK()) {
-        xrootd2gliberr(op_error, __func__, "Error on XrdCl::CopyProcess::Prepare(): %s", status);
-        return -1;
+    gboolean adaptive = gfal2_get_opt_boolean_with_default(context,
+            XROOTD_CONFIG_GROUP, XROOTD_ADAPTIVE_PARALLEL_COPIES, false);
+
+    XrdCl::XRootDStatus status;
+    if (adaptive && nbfiles > 1) {
+        int initial = gfal2_get_opt_integer_with_default(context,
+                XROOTD_CONFIG_GROUP, XROOTD_PARALLEL_COPIES_INITIAL, 2);
+        int interval = gfal2_get_opt_integer_with_default(context,
+                XROOTD_CONFIG_GROUP, XROOTD_PARALLEL_COPIES_INTERVAL, 5);
+        gfal_xrootd_run_adaptive(context, params, jobs, results, endpoints,
+                initial, parallel, interval, isThirdParty);
+    }
+    else {
+        std::vector<size_t> all(nbfiles);
+        for (size_t i = 0; i < nbfiles; ++i) {
+            all[i] = i;
+        }
+        if (gfal_xrootd_run_jobs(context, params, jobs, results, all,
+                parallel, isThirdParty, status, NULL, op_error) < 0) {
+            return -1;
+        }
     }
-
-    CopyFeedback feedback(context, params, isThirdParty);
-    status = copy_process.Run(&feedback);
 
     // On bulk operations, even if there is one single failure we will get it
     // here, so ignore!
@@ -0,0 +1,568 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <fcntl.h>
+#include <string.h>
+
+#include <XrdCl/XrdClFile.hh>
+#include <XrdCl/XrdClXRootDResponses.hh>
+
+// TRUE and FALSE are defined in Glib and xrootd headers
+#ifdef TRUE
+#undef TRUE
+#endif
+#ifdef FALSE
+#undef FALSE
+#endif
+
+#include <gfal_plugins_api.h>
+#include "gfal_xrootd_plugin_interface.h"
+#include "gfal_xrootd_plugin_utils.h"
+
+// XrdCl requests are limited to 32 bits
+#define XROOTD_MAX_REQUEST_SIZE (1 << 30)
+
+
+static void gfal_xrootd_file_set_error(GError** err, const XrdCl::XRootDStatus& status,
+        const char* func, const char* msg)
+{
+    errno = xrootd_status_to_posix_errno(status);
+    gfal2_xrootd_set_error(err, errno, func, "%s: %s", msg, status.ToStr().c_str());
+}
+
+
+static XrdCl::OpenFlags::Flags posix_flags_to_xrdcl_open_flags(int flag)
+{
+    XrdCl::OpenFlags::Flags xflags = XrdCl::OpenFlags::Read;
+
+    if (flag & (O_WRONLY | O_RDWR | O_APPEND)) {
+        xflags = XrdCl::OpenFlags::Update;
+        if (flag & O_CREAT) {
+            xflags |= (flag & O_EXCL) ? XrdCl::OpenFlags::New : XrdCl::OpenFlags::Delete;
+        }
+        else if (flag & O_TRUNC) {
+            xflags |= XrdCl::OpenFlags::Delete;
+        }
+    }
+    return xflags;
+}
+
+// Asynchronous read issued ahead of a sequential reader
+class ReadAheadBlock: public XrdCl::ResponseHandler
+{
+public:
+    uint64_t offset;
+    std::vector<char> buffer;
+    uint32_t bytesRead;
+    XrdCl::XRootDStatus status;
+
+    ReadAheadBlock(uint64_t offset, uint32_t size): offset(offset), buffer(size), bytesRead(0), done(false)
+    {
+    }
+
+    void HandleResponse(XrdCl::XRootDStatus* st, XrdCl::AnyObject* response)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        status = *st;
+        if (st->IsOK() && response) {
+            XrdCl::ChunkInfo* chunk = NULL;
+            response->Get(chunk);
+            if (chunk) {
+                bytesRead = chunk->length;
+            }
+        }
+        delete st;
+        delete response;
+        done = true;
+        cv.notify_all();
+    }
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return done; });
+    }
+
+    uint64_t End() const
+    {
+        return offset + bytesRead;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done;
+};
+
+
+class XrootdFile;
+
+// Asynchronous write that keeps its own copy of the data
+class WriteBehindRequest: public XrdCl::ResponseHandler
+{
+public:
+    WriteBehindRequest(XrootdFile* owner, const void* data, size_t size):
+        owner(owner), buffer((const char*)data, (const char*)data + size)
+    {
+    }
+
+    void HandleResponse(XrdCl::XRootDStatus* st, XrdCl::AnyObject* response);
+
+    XrootdFile* owner;
+    std::vector<char> buffer;
+};
+
+
+// File opened through XrdCl::File
+// Reads and writes at an explicit offset are sent as they come, so preadG and pwriteG
+// can be used concurrently. readG and writeG work on the shared offset, and when done
+// sequentially, they are backed by the read-ahead and write-behind windows.
+class XrootdFile
+{
+public:
+    XrootdFile(size_t readAheadSize, size_t writeBehindSize):
+        offset(0), lastReadEnd(0), readAheadSize(readAheadSize),
+        writeBehindSize(writeBehindSize), bytesInFlight(0)
+    {
+    }
+
+    ~XrootdFile()
+    {
+        DropReadAhead();
+        WaitForWrites();
+    }
+
+    XrdCl::XRootDStatus Open(const std::string& url, int flag, mode_t mode)
+    {
+        XrdCl::Access::Mode xmode = XrdCl::Access::None;
+        if (flag & O_CREAT) {
+            xmode = file_mode_to_xrdcl_access(mode);
+        }
+        return file.Open(url, posix_flags_to_xrdcl_open_flags(flag), xmode);
+    }
+
+    ssize_t Read(void* buff, size_t count, XrdCl::XRootDStatus& status)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (count > XROOTD_MAX_REQUEST_SIZE) {
+            count = XROOTD_MAX_REQUEST_SIZE;
+        }
+
+        // Reads must see the data written before
+        WaitForWrites();
+
+        bool sequential = (offset == lastReadEnd);
+        size_t copied = ReadFromReadAhead((char*)buff, count);
+
+        if (copied < count) {
+            DropReadAhead();
+            uint32_t bytesRead = 0;
+            status = file.Read(offset + copied, count - copied, (char*)buff + copied, bytesRead);
+            if (!status.IsOK() && copied == 0) {
+                return -1;
+            }
+            copied += bytesRead;
+        }
+
+        offset += copied;
+        lastReadEnd = offset;
+
+        // A short read means we reached the end of the file
+        if (sequential && readAheadSize > 0 && copied == count) {
+            ScheduleReadAhead();
+        }
+        return copied;
+    }
+
+    ssize_t PRead(void* buff, size_t count, off_t pos, XrdCl::XRootDStatus& status)
+    {
+        if (count > XROOTD_MAX_REQUEST_SIZE) {
+            count = XROOTD_MAX_REQUEST_SIZE;
+        }
+        WaitForWrites();
+        uint32_t bytesRead = 0;
+        status = file.Read(pos, count, buff, bytesRead);
+        if (!status.IsOK()) {
+            return -1;
+        }
+        return bytesRead;
+    }
+
+    ssize_t Write(const void* buff, size_t count, XrdCl::XRootDStatus& status)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        DropReadAhead();
+        ssize_t written = PWriteInternal(buff, count, offset, status);
+        if (written > 0) {
+            offset += written;
+        }
+        return written;
+    }
+
+    ssize_t PWrite(const void* buff, size_t count, off_t pos, XrdCl::XRootDStatus& status)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            DropReadAhead();
+        }
+        return PWriteInternal(buff, count, pos, status);
+    }
+
+    off_t Seek(off_t pos, int whence, XrdCl::XRootDStatus& status)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        off_t newOffset;
+        switch (whence) {
+            case SEEK_SET:
+                newOffset = pos;
+                break;
+            case SEEK_CUR:
+                newOffset = offset + pos;
+                break;
+            case SEEK_END: {
+                // Pending writes may change the size
+                WaitForWrites();
+                XrdCl::StatInfo* info = NULL;
+                status = file.Stat(true, info);
+                if (!status.IsOK()) {
+                    return -1;
+                }
+                newOffset = info->GetSize() + pos;
+                delete info;
+                break;
+            }
+            default:
+                status = XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errInvalidArgs, EINVAL);
+                return -1;
+        }
+        if (newOffset < 0) {
+            status = XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errInvalidArgs, EINVAL);
+            return -1;
+        }
+        offset = newOffset;
+        return offset;
+    }
+
+    XrdCl::XRootDStatus Close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        DropReadAhead();
+        WaitForWrites();
+        XrdCl::XRootDStatus status = file.Close();
+        TakeWriteError(status);
+        return status;
+    }
+
+    void WriteDone(WriteBehindRequest* request, const XrdCl::XRootDStatus& status)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        bytesInFlight -= request->buffer.size();
+        if (!status.IsOK() && writeError.IsOK()) {
+            writeError = status;
+        }
+        // Notify while holding the lock, so the file can not go away under our feet
+        writeCv.notify_all();
+    }
+
+private:
+    XrdCl::File file;
+
+    // Protects the shared offset and the read-ahead blocks
+    std::mutex mutex;
+    uint64_t offset;
+    uint64_t lastReadEnd;
+
+    size_t readAheadSize;
+    std::deque<std::unique_ptr<ReadAheadBlock>> readAhead;
+
+    size_t writeBehindSize;
+    std::mutex writeMutex;
+    std::condition_variable writeCv;
+    size_t bytesInFlight;
+    XrdCl::XRootDStatus writeError;
+
+    // Serve as much as possible from the blocks already requested
+    size_t ReadFromReadAhead(char* buff, size_t count)
+    {
+        size_t copied = 0;
+        while (copied < count && !readAhead.empty()) {
+            ReadAheadBlock* block = readAhead.front().get();
+            block->Wait();
+
+            uint64_t pos = offset + copied;
+            if (!block->status.IsOK() || pos < block->offset || pos >= block->End()) {
+                break;
+            }
+
+            size_t available = block->End() - pos;
+            size_t n = std::min<size_t>(available, count - copied);
+            memcpy(buff + copied, block->buffer.data() + (pos - block->offset), n);
+            copied += n;
+
+            if (pos + n >= block->End()) {
+                readAhead.pop_front();
+            }
+        }
+        return copied;
+    }
+
+    // Keep the window full with two half-window blocks, so one can be consumed
+    // while the next one is on the wire
+    void ScheduleReadAhead()
+    {
+        uint32_t blockSize = std::max<size_t>(readAheadSize / 2, 1);
+        if (blockSize > XROOTD_MAX_REQUEST_SIZE) {
+            blockSize = XROOTD_MAX_REQUEST_SIZE;
+        }
+
+        while (readAhead.size() < 2) {
+            uint64_t next = offset;
+            if (!readAhead.empty()) {
+                next = readAhead.back()->offset + readAhead.back()->buffer.size();
+            }
+
+            std::unique_ptr<ReadAheadBlock> block(new ReadAheadBlock(next, blockSize));
+            XrdCl::XRootDStatus status = file.Read(next, blockSize, block->buffer.data(), block.get());
+            if (!status.IsOK()) {
+                gfal2_log(G_LOG_LEVEL_DEBUG, "Could not schedule read-ahead: %s", status.ToStr().c_str());
+                break;
+            }
+            readAhead.push_back(std::move(block));
+        }
+    }
+
+    void DropReadAhead()
+    {
+        // The handlers are owned by us, so wait for them before releasing
+        for (auto i = readAhead.begin(); i != readAhead.end(); ++i) {
+            (*i)->Wait();
+        }
+        readAhead.clear();
+    }
+
+    void WaitForWrites()
+    {
+        std::unique_lock<std::mutex> lock(writeMutex);
+        writeCv.wait(lock, [this] { return bytesInFlight == 0; });
+    }
+
+    // Report a failure of the write-behind once, to whoever writes or closes next
+    bool TakeWriteError(XrdCl::XRootDStatus& status)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        if (writeError.IsOK()) {
+            return false;
+        }
+        status = writeError;
+        writeError = XrdCl::XRootDStatus();
+        return true;
+    }
+
+    ssize_t PWriteInternal(const void* buff, size_t count, off_t pos, XrdCl::XRootDStatus& status)
+    {
+        if (count > XROOTD_MAX_REQUEST_SIZE) {
+            count = XROOTD_MAX_REQUEST_SIZE;
+        }
+
+        if (writeBehindSize == 0 || count > writeBehindSize) {
+            WaitForWrites();
+            if (TakeWriteError(status)) {
+                return -1;
+            }
+            status = file.Write(pos, count, buff);
+            if (!status.IsOK()) {
+                return -1;
+            }
+            return count;
+        }
+
+        std::unique_lock<std::mutex> lock(writeMutex);
+        writeCv.wait(lock, [this, count] {
+            return !writeError.IsOK() || bytesInFlight + count <= writeBehindSize;
+        });
+        // Report asynchronous failures on the next write
+        if (!writeError.IsOK()) {
+            status = writeError;
+            writeError = XrdCl::XRootDStatus();
+            return -1;
+        }
+
+        WriteBehindRequest* request = new WriteBehindRequest(this, buff, count);
+        bytesInFlight += count;
+        status = file.Write(pos, count, request->buffer.data(), request);
+        if (!status.IsOK()) {
+            bytesInFlight -= count;
+            delete request;
+            return -1;
+        }
+        return count;
+    }
+};
+
+
+void WriteBehindRequest::HandleResponse(XrdCl::XRootDStatus* st, XrdCl::AnyObject* response)
+{
+    owner->WriteDone(this, *st);
+    delete st;
+    delete response;
+    delete this;
+}
+
+
+static XrootdFile* gfal_xrootd_get_file(gfal_file_handle fd, GError** err)
+{
+    XrootdFile* file = (XrootdFile*) (gfal_file_handle_get_fdesc(fd));
+    if (!file) {
+        errno = EBADF;
+        gfal2_xrootd_set_error(err, errno, __func__, "Bad file handle");
+    }
+    return file;
+}
+
+
+gfal_file_handle gfal_xrootd_openG(plugin_handle handle, const char *path,
+        int flag, mode_t mode, GError ** err)
+{
+    gfal2_context_t context = (gfal2_context_t) handle;
+    std::string sanitizedUrl = prepare_url(context, path);
+
+    // Negative values disable them, as 0 does
+    size_t readAhead = std::max(0, gfal2_get_opt_integer_with_default(context,
+            XROOTD_CONFIG_GROUP, XROOTD_READ_AHEAD_SIZE, XROOTD_DEFAULT_READ_AHEAD_SIZE));
+    size_t writeBehind = std::max(0, gfal2_get_opt_integer_with_default(context,
+            XROOTD_CONFIG_GROUP, XROOTD_WRITE_BEHIND_SIZE, XROOTD_DEFAULT_WRITE_BEHIND_SIZE));
+
+    XrootdFile* file = new XrootdFile(readAhead, writeBehind);
+    XrdCl::XRootDStatus status = file->Open(sanitizedUrl, flag, mode);
+    if (!status.IsOK()) {
+        gfal_xrootd_file_set_error(err, status, __func__, "Failed to open file");
+        delete file;
+        return NULL;
+    }
+    return gfal_file_handle_new(gfal_xrootd_getName(), (gpointer) file);
+}
+
+
+ssize_t gfal_xrootd_readG(plugin_handle handle, gfal_file_handle fd, void *buff,
+        size_t count, GError ** err)
+{
+    XrootdFile* file = gfal_xrootd_get_file(fd, err);
+    if (!file) {
+        return -1;
+    }
+    XrdCl::XRootDStatus status;
+    ssize_t l = file->Read(buff, count, status);
+    if (l < 0) {
+        gfal_xrootd_file_set_error(err, status, __func__, "Failed while reading from file");
+        return -1;
+    }
+    return l;
+}
+
+
+ssize_t gfal_xrootd_preadG(plugin_handle handle, gfal_file_handle fd, void *buff,
+        size_t count, off_t offset, GError ** err)
+{
+    XrootdFile* file = gfal_xrootd_get_file(fd, err);
+    if (!file) {
+        return -1;
+    }
+    XrdCl::XRootDStatus status;
+    ssize_t l = file->PRead(buff, count, offset, status);
+    if (l < 0) {
+        gfal_xrootd_file_set_error(err, status, __func__, "Failed while reading from file");
+        return -1;
+    }
+    return l;
+}
+
+
+ssize_t gfal_xrootd_writeG(plugin_handle handle, gfal_file_handle fd,
+        const void *buff, size_t count, GError ** err)
+{
+    XrootdFile* file = gfal_xrootd_get_file(fd, err);
+    if (!file) {
+        return -1;
+    }
+    XrdCl::XRootDStatus status;
+    ssize_t l = file->Write(buff, count, status);
+    if (l < 0) {
+        gfal_xrootd_file_set_error(err, status, __func__, "Failed while writing to file");
+        return -1;
+    }
+    return l;
+}
+
+
+ssize_t gfal_xrootd_pwriteG(plugin_handle handle, gfal_file_handle fd,
+        const void *buff, size_t count, off_t offset, GError ** err)
+{
+    XrootdFile* file = gfal_xrootd_get_file(fd, err);
+    if (!file) {
+        return -1;
+    }
+    XrdCl::XRootDStatus status;
+    ssize_t l = file->PWrite(buff, count, offset, status);
+    if (l < 0) {
+        gfal_xrootd_file_set_error(err, status, __func__, "Failed while writing to file");
+        return -1;
+    }
+    return l;
+}
+
+
+off_t gfal_xrootd_lseekG(plugin_handle handle, gfal_file_handle fd,
+        off_t offset, int whence, GError **err)
+{
+    XrootdFile* file = gfal_xrootd_get_file(fd, err);
+    if (!file) {
+        return -1;
+    }
+    XrdCl::XRootDStatus status;
+    off_t l = file->Seek(offset, whence, status);
+    if (l < 0) {
+        gfal_xrootd_file_set_error(err, status, __func__, "Failed to seek within file");
+        return -1;
+    }
+    return l;
+}
+
+
+int gfal_xrootd_closeG(plugin_handle handle, gfal_file_handle fd, GError ** err)
+{
+    int r = 0;
+    XrootdFile* file = (XrootdFile*) (gfal_file_handle_get_fdesc(fd));
+    if (file) {
+        XrdCl::XRootDStatus status = file->Close();
+        if (!status.IsOK()) {
+            gfal_xrootd_file_set_error(err, status, __func__, "Failed to close file");
+            r = -1;
+        }
+        delete file;
+    }
+    gfal_file_handle_delete(fd);
+    return r;
+}
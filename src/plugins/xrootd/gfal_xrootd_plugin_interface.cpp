@@ -18,8 +18,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <sys/stat.h>
 
@@ -82,89 +85,6 @@ int gfal_xrootd_statG(plugin_handle handle, const char* path, struct stat* buff,
 }
 
 
-gfal_file_handle gfal_xrootd_openG(plugin_handle handle, const char *path,
-        int flag, mode_t mode, GError ** err)
-{
-    std::string sanitizedUrl = prepare_url((gfal2_context_t) handle, path);
-
-    int *fd = new int;
-    *fd = XrdPosixXrootd::Open(sanitizedUrl.c_str(), flag, mode);
-    if (*fd == -1) {
-        gfal2_xrootd_set_error(err, errno, __func__, "Failed to open file");
-        delete fd;
-        return NULL;
-    }
-    return gfal_file_handle_new(gfal_xrootd_getName(), (gpointer) fd);
-}
-
-
-ssize_t gfal_xrootd_readG(plugin_handle handle, gfal_file_handle fd, void *buff,
-        size_t count, GError ** err)
-{
-    int * fdesc = (int*) (gfal_file_handle_get_fdesc(fd));
-    if (!fdesc) {
-        gfal2_xrootd_set_error(err, errno, __func__, "Bad file handle");
-        return -1;
-    }
-    ssize_t l = XrdPosixXrootd::Read(*fdesc, buff, count);
-    if (l < 0) {
-        gfal2_xrootd_set_error(err, errno, __func__, "Failed while reading from file");
-        return -1;
-    }
-    return l;
-}
-
-
-ssize_t gfal_xrootd_writeG(plugin_handle handle, gfal_file_handle fd,
-        const void *buff, size_t count, GError ** err)
-{
-    int * fdesc = (int*) (gfal_file_handle_get_fdesc(fd));
-    if (!fdesc) {
-        gfal2_xrootd_set_error(err, errno, __func__, "Bad file handle");
-        return -1;
-    }
-    ssize_t l = XrdPosixXrootd::Write(*fdesc, buff, count);
-    if (l < 0) {
-        gfal2_xrootd_set_error(err, errno, __func__, "Failed while writing to file");
-        return -1;
-    }
-    return l;
-}
-
-
-off_t gfal_xrootd_lseekG(plugin_handle handle, gfal_file_handle fd,
-        off_t offset, int whence, GError **err)
-{
-    int * fdesc = (int*) (gfal_file_handle_get_fdesc(fd));
-    if (!fdesc) {
-        gfal2_xrootd_set_error(err, errno, __func__, "Bad file handle");
-        return -1;
-    }
-    off_t l = XrdPosixXrootd::Lseek(*fdesc, offset, whence);
-    if (l < 0) {
-        gfal2_xrootd_set_error(err, errno, __func__, "Failed to seek within file");
-        return -1;
-    }
-    return l;
-}
-
-
-int gfal_xrootd_closeG(plugin_handle handle, gfal_file_handle fd, GError ** err)
-{
-    int r = 0;
-    int * fdesc = (int*) (gfal_file_handle_get_fdesc(fd));
-    if (fdesc) {
-        r = XrdPosixXrootd::Close(*fdesc);
-        if (r != 0) {
-            gfal2_xrootd_set_error(err, errno, __func__, "Failed to close file");
-        }
-        delete (int*) (gfal_file_handle_get_fdesc(fd));
-    }
-    gfal_file_handle_delete(fd);
-    return r;
-}
-
-
 int gfal_xrootd_mkdirpG(plugin_handle handle, const char *url, mode_t mode,
         gboolean pflag, GError **err)
 {
@@ -314,123 +234,307 @@ void StatInfo2Xattr(const XrdCl::StatInfo* stinfo,  char * buff)
     }
 }
 
+static void StatInfo2Stat(const XrdCl::StatInfo* stinfo, struct stat* st)
+{
+    reset_stat(*st);
+    st->st_size = stinfo->GetSize();
+    st->st_mtime = stinfo->GetModTime();
+    st->st_mode = 0;
+    if (stinfo->TestFlags(XrdCl::StatInfo::IsDir))
+        st->st_mode |= S_IFDIR;
+    if (stinfo->TestFlags(XrdCl::StatInfo::IsReadable))
+        st->st_mode |= (S_IRUSR | S_IRGRP | S_IROTH);
+    if (stinfo->TestFlags(XrdCl::StatInfo::IsWritable))
+        st->st_mode |= (S_IWUSR | S_IWGRP | S_IWOTH);
+    if (stinfo->TestFlags(XrdCl::StatInfo::XBitSet))
+        st->st_mode |= (S_IXUSR | S_IXGRP | S_IXOTH);
+}
+
+// Seconds the listing reader waits for the next entries, or for a stat answer
+static const int dirListWaitTimeout = 60;
+
+// Result of a stat sent for an entry the server did not give stat information for
+struct DirEntryStat
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done;
+    XrdCl::XRootDStatus status;
+    struct stat st;
+
+    DirEntryStat(): done(false)
+    {
+    }
+
+    // Returns false if the answer did not arrive in time
+    bool Wait(int timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(timeout), [this] { return done; });
+    }
+};
+
+// Callback for the stat of a single entry. Deletes itself once the answer arrives,
+// so the listing can be closed with requests still in flight.
+class DirEntryStatHandler: public XrdCl::ResponseHandler
+{
+private:
+    std::shared_ptr<DirEntryStat> result;
+
+public:
+    DirEntryStatHandler(std::shared_ptr<DirEntryStat> result): result(result)
+    {
+    }
+
+    void HandleResponse(XrdCl::XRootDStatus* status, XrdCl::AnyObject* response)
+    {
+        {
+            std::lock_guard<std::mutex> lock(result->mutex);
+            result->status = *status;
+            if (status->IsOK() && response) {
+                XrdCl::StatInfo* stinfo = NULL;
+                response->Get(stinfo);
+                if (stinfo) {
+                    StatInfo2Stat(stinfo, &result->st);
+                }
+            }
+            result->done = true;
+            result->cv.notify_all();
+        }
+        delete status;
+        delete response;
+        delete this;
+    }
+};
+
+// Directory entry as buffered by the listing
+// Only what readdir and readdirpp need is kept, so the listing replies can be released
+// as soon as they arrive
+struct DirEntry
+{
+    std::string name;
+    bool hasStat;
+    struct stat st;
+    std::shared_ptr<DirEntryStat> pendingStat;
+};
+
 // Callback class for directory listing
+// The listing is requested in chunks. Entries are handed to the reader as chunks arrive,
+// and at most maxBuffered are kept: past that, the callback waits for the reader to
+// consume them. The stats of entries listed without stat information are only sent
+// as the reader gets close to them.
+// A waiting callback holds an XrdCl thread, which the stat answers may need as well,
+// so the reader never waits for longer than dirListWaitTimeout for any of them.
 class DirListHandler: public XrdCl::ResponseHandler
 {
 private:
     XrdCl::URL url;
     XrdCl::FileSystem fs;
-    std::list<XrdCl::DirectoryList::ListEntry*> entries;
+    std::deque<DirEntry> entries;
 
     struct dirent dbuffer;
 
     std::mutex mutex;
     std::condition_variable cv;
     bool done;
+    bool released;
+
+    size_t maxBuffered;
+    size_t statConcurrency;
+    bool chunked;
+
+    bool HasRoom() const
+    {
+        return maxBuffered == 0 || entries.size() < maxBuffered;
+    }
+
+    void Fail(const XrdCl::XRootDStatus& status)
+    {
+        errcode = xrootd_status_to_posix_errno(status);
+        errstr = status.ToString();
+    }
+
+    // Send the stat for the first entries that come without it, so by the time
+    // the reader gets to them the answer is, hopefully, there
+    void PrefetchStats()
+    {
+        size_t n = std::min(statConcurrency, entries.size());
+        for (size_t i = 0; i < n; ++i) {
+            DirEntry& entry = entries[i];
+            if (entry.hasStat || entry.pendingStat) {
+                continue;
+            }
+            std::shared_ptr<DirEntryStat> result = std::make_shared<DirEntryStat>();
+            DirEntryStatHandler* handler = new DirEntryStatHandler(result);
+            XrdCl::XRootDStatus status = fs.Stat(url.GetPath() + "/" + entry.name, handler);
+            if (!status.IsOK()) {
+                // Will be retried synchronously when the reader gets there
+                delete handler;
+                break;
+            }
+            entry.pendingStat = result;
+        }
+    }
 
 public:
     int errcode;
     std::string errstr;
 
-    DirListHandler(const XrdCl::URL& url): url(url), fs(url), done(false), errcode(0)
+    DirListHandler(const XrdCl::URL& url, size_t maxBuffered, size_t statConcurrency, bool chunked):
+        url(url), fs(url), done(false), released(false), maxBuffered(maxBuffered),
+        statConcurrency(statConcurrency), chunked(chunked), errcode(0)
     {
         memset(&dbuffer, 0, sizeof(dbuffer));
     }
 
     int List()
     {
-        XrdCl::XRootDStatus status = fs.DirList(url.GetPath(), XrdCl::DirListFlags::Stat, this);
+        XrdCl::DirListFlags::Flags flags = XrdCl::DirListFlags::Stat;
+        if (chunked) {
+            flags |= XrdCl::DirListFlags::Chunked;
+        }
+        XrdCl::XRootDStatus status = fs.DirList(url.GetPath(), flags, this);
         if (!status.IsOK()) {
-            errcode = status.code;
-            errstr = status.ToString();
+            Fail(status);
             return -1;
         }
         return 0;
     }
 
-    // AFAIK, this is called only once
+    // With chunked listings, this is called once per chunk, with suContinue
+    // as status code for all but the last one
     void HandleResponse(XrdCl::XRootDStatus* status, XrdCl::AnyObject* response)
     {
-        std::lock_guard<std::mutex> lock(mutex);
-        if (status->IsOK()) {
-            XrdCl::DirectoryList* list;
-            response->Get<XrdCl::DirectoryList*>(list);
-            if (list) {
-                XrdCl::DirectoryList::ConstIterator i;
-                for (i = list->Begin(); i != list->End(); ++i) {
-                    entries.push_back(*i);
+        bool last = !status->IsOK() || status->code != XrdCl::suContinue;
+        bool selfDelete = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (status->IsOK() && !released) {
+                XrdCl::DirectoryList* list = NULL;
+                if (response) {
+                    response->Get<XrdCl::DirectoryList*>(list);
                 }
+                if (list) {
+                    XrdCl::DirectoryList::ConstIterator i;
+                    for (i = list->Begin(); i != list->End(); ++i) {
+                        if (!HasRoom()) {
+                            cv.notify_all();
+                            cv.wait(lock, [this] { return released || HasRoom(); });
+                        }
+                        if (released) {
+                            break;
+                        }
+                        DirEntry entry;
+                        entry.name = (*i)->GetName();
+                        XrdCl::StatInfo* stinfo = (*i)->GetStatInfo();
+                        entry.hasStat = (stinfo != NULL);
+                        if (stinfo) {
+                            StatInfo2Stat(stinfo, &entry.st);
+                        }
+                        entries.push_back(std::move(entry));
+                    }
+                    cv.notify_all();
+                }
+            }
+            else if (!status->IsOK()) {
+                Fail(*status);
+            }
+
+            if (last) {
+                done = true;
+                selfDelete = released;
+                cv.notify_all();
             }
         }
-        else {
-            errcode = status->code;
-            errstr = status->ToString();
+        delete status;
+        delete response;
+        if (selfDelete) {
+            delete this;
         }
-        done = true;
-        cv.notify_all();
     }
 
-    void StatInfo2Stat(const XrdCl::StatInfo* stinfo, struct stat* st)
+    // Called on closedir. If the listing is still running, the last response will free us
+    void Release()
     {
-        st->st_size = stinfo->GetSize();
-        st->st_mtime = stinfo->GetModTime();
-        st->st_mode = 0;
-        if (stinfo->TestFlags(XrdCl::StatInfo::IsDir))
-            st->st_mode |= S_IFDIR;
-        if (stinfo->TestFlags(XrdCl::StatInfo::IsReadable))
-            st->st_mode |= (S_IRUSR | S_IRGRP | S_IROTH);
-        if (stinfo->TestFlags(XrdCl::StatInfo::IsWritable))
-            st->st_mode |= (S_IWUSR | S_IWGRP | S_IWOTH);
-        if (stinfo->TestFlags(XrdCl::StatInfo::XBitSet))
-            st->st_mode |= (S_IXUSR | S_IXGRP | S_IXOTH);
+        bool canDelete;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            released = true;
+            canDelete = done;
+            entries.clear();
+            cv.notify_all();
+        }
+        if (canDelete) {
+            delete this;
+        }
     }
 
     struct dirent* Get(struct stat* st = NULL)
     {
-        if (!done) {
-            std::unique_lock<std::mutex> lock(mutex);
-            cv.wait_for(lock, std::chrono::seconds(60));
-            if (!done) {
-                return NULL;
-            }
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!cv.wait_for(lock, std::chrono::seconds(dirListWaitTimeout), [this] { return done || !entries.empty(); })) {
+            errcode = ETIMEDOUT;
+            errstr = "Timed out waiting for the directory listing";
+            return NULL;
         }
 
         if (entries.empty())
             return NULL;
 
-        XrdCl::DirectoryList::ListEntry* entry = entries.front();
-        entries.pop_front();
+        if (st != NULL) {
+            PrefetchStats();
+        }
 
-        XrdCl::StatInfo* stinfo = entry->GetStatInfo();
+        DirEntry entry = std::move(entries.front());
+        entries.pop_front();
+        // Wake up the callback, if it is waiting for room
+        cv.notify_all();
+        lock.unlock();
 
-        g_strlcpy(dbuffer.d_name, entry->GetName().c_str(), sizeof(dbuffer.d_name));
+        g_strlcpy(dbuffer.d_name, entry.name.c_str(), sizeof(dbuffer.d_name));
         dbuffer.d_reclen = strnlen(dbuffer.d_name, sizeof(dbuffer.d_reclen));
 
-        if (stinfo && stinfo->TestFlags(XrdCl::StatInfo::IsDir))
+        if (entry.hasStat && S_ISDIR(entry.st.st_mode))
             dbuffer.d_type = DT_DIR;
         else
             dbuffer.d_type = DT_REG;
 
         if (st != NULL) {
-            if (stinfo != NULL) {
-                StatInfo2Stat(stinfo, st);
+            XrdCl::XRootDStatus status;
+            if (entry.hasStat) {
+                memcpy(st, &entry.st, sizeof(struct stat));
+            }
+            else if (entry.pendingStat) {
+                if (entry.pendingStat->Wait(dirListWaitTimeout)) {
+                    status = entry.pendingStat->status;
+                    if (status.IsOK())
+                        memcpy(st, &entry.pendingStat->st, sizeof(struct stat));
+                }
+                else {
+                    status = XrdCl::XRootDStatus(XrdCl::stError, XrdCl::errOperationExpired);
+                }
             }
             else {
-
-                stinfo = new XrdCl::StatInfo();
+                XrdCl::StatInfo* stinfo = NULL;
                 std::string fullPath = url.GetPath() + "/" + dbuffer.d_name;
-                XrdCl::XRootDStatus status = this->fs.Stat(fullPath, stinfo);
-                if (!status.IsOK()) {
-                    errcode = status.code;
-                    errstr = status.ToString();
-                    return NULL;
-                }
-                StatInfo2Stat(stinfo, st);
+                status = this->fs.Stat(fullPath, stinfo, dirListWaitTimeout);
+                if (status.IsOK())
+                    StatInfo2Stat(stinfo, st);
                 delete stinfo;
             }
+
+            // The entry exists, even if it could not be stat'ed (i.e. removed since the listing)
+            // so it is returned without stat information rather than ending the listing
+            if (!status.IsOK()) {
+                gfal2_log(G_LOG_LEVEL_DEBUG, "Could not stat %s: %s", dbuffer.d_name, status.ToString().c_str());
+                reset_stat(*st);
+                dbuffer.d_type = DT_UNKNOWN;
+            }
+            else if (S_ISDIR(st->st_mode)) {
+                dbuffer.d_type = DT_DIR;
+            }
         }
 
-        delete entry;
         return &dbuffer;
     }
 };
@@ -454,11 +558,25 @@ gfal_file_handle gfal_xrootd_opendirG(plugin_handle handle,
         return NULL;
     }
 
-    DirListHandler* handler = new DirListHandler(parsed);
+    gfal2_context_t context = (gfal2_context_t) handle;
+    // Clamp before converting, so a negative value does not wrap around
+    int maxBuffered = gfal2_get_opt_integer_with_default(context,
+            XROOTD_CONFIG_GROUP, XROOTD_DIRLIST_MAX_BUFFERED, XROOTD_DEFAULT_DIRLIST_MAX_BUFFERED);
+    maxBuffered = std::max(0, maxBuffered);
+    int statConcurrency = gfal2_get_opt_integer_with_default(context,
+            XROOTD_CONFIG_GROUP, XROOTD_DIRLIST_STAT_CONCURRENCY, XROOTD_DEFAULT_DIRLIST_STAT_CONCURRENCY);
+    statConcurrency = std::max(1, std::min(statConcurrency, XROOTD_MAX_DIRLIST_STAT_CONCURRENCY));
+    gboolean chunked = gfal2_get_opt_boolean_with_default(context,
+            XROOTD_CONFIG_GROUP, XROOTD_DIRLIST_CHUNKED, TRUE);
+
+    DirListHandler* handler = new DirListHandler(parsed, static_cast<size_t>(maxBuffered),
+            static_cast<size_t>(statConcurrency), chunked);
 
     if (handler->List() != 0) {
-        gfal2_xrootd_set_error(err, handler->errcode, __func__, "Failed to open dir: %s",
+        errno = handler->errcode;
+        gfal2_xrootd_set_error(err, errno, __func__, "Failed to open dir: %s",
                 handler->errstr.c_str());
+        delete handler;
         return NULL;
     }
 
@@ -476,7 +594,8 @@ struct dirent* gfal_xrootd_readdirG(plugin_handle plugin_data,
     }
     dirent* entry = handler->Get();
     if (!entry && handler->errcode != 0) {
-        gfal2_xrootd_set_error(err, handler->errcode, __func__, "Failed reading directory: %s",
+        errno = handler->errcode;
+        gfal2_xrootd_set_error(err, errno, __func__, "Failed reading directory: %s",
                 handler->errstr.c_str());
         return NULL;
     }
@@ -494,7 +613,8 @@ struct dirent* gfal_xrootd_readdirppG(plugin_handle plugin_data,
     }
     dirent* entry = handler->Get(st);
     if (!entry && handler->errcode != 0) {
-        gfal2_xrootd_set_error(err, handler->errcode, __func__, "Failed reading directory: %s",
+        errno = handler->errcode;
+        gfal2_xrootd_set_error(err, errno, __func__, "Failed reading directory: %s",
                 handler->errstr.c_str());
         return NULL;
     }
@@ -508,7 +628,7 @@ int gfal_xrootd_closedirG(plugin_handle plugin_data, gfal_file_handle dir_desc,
     // Free all objects associated with this client
     DirListHandler* handler = (DirListHandler*)(gfal_file_handle_get_fdesc(dir_desc));
     if (handler) {
-        delete handler;
+        handler->Release();
     }
     gfal_file_handle_delete(dir_desc);
     return 0;
@@ -27,7 +27,21 @@
 #define XROOTD_DEFAULT_CHECKSUM "COPY_CHECKSUM_TYPE"
 #define XROOTD_CHECKSUM_MODE    "COPY_CHECKSUM_MODE"
 #define XROOTD_PARALLEL_COPIES  "PARALLEL_COPIES"
+#define XROOTD_ADAPTIVE_PARALLEL_COPIES "ADAPTIVE_PARALLEL_COPIES"
+#define XROOTD_PARALLEL_COPIES_INITIAL "PARALLEL_COPIES_INITIAL"
+#define XROOTD_PARALLEL_COPIES_INTERVAL "PARALLEL_COPIES_INTERVAL"
 #define XROOTD_NORMALIZE_PATH   "NORMALIZE_PATH"
+#define XROOTD_READ_AHEAD_SIZE  "READ_AHEAD_SIZE"
+#define XROOTD_WRITE_BEHIND_SIZE "WRITE_BEHIND_SIZE"
+#define XROOTD_DIRLIST_CHUNKED  "DIRLIST_CHUNKED"
+#define XROOTD_DIRLIST_MAX_BUFFERED "DIRLIST_MAX_BUFFERED"
+#define XROOTD_DIRLIST_STAT_CONCURRENCY "DIRLIST_STAT_CONCURRENCY"
+
+#define XROOTD_DEFAULT_READ_AHEAD_SIZE   (8 * 1024 * 1024)
+#define XROOTD_DEFAULT_WRITE_BEHIND_SIZE (8 * 1024 * 1024)
+#define XROOTD_DEFAULT_DIRLIST_MAX_BUFFERED 65536
+#define XROOTD_DEFAULT_DIRLIST_STAT_CONCURRENCY 16
+#define XROOTD_MAX_DIRLIST_STAT_CONCURRENCY 1024
 
 extern "C" {
 
@@ -38,8 +52,12 @@ gfal_file_handle gfal_xrootd_openG(plugin_handle handle, const char *path, int f
 
 ssize_t gfal_xrootd_readG(plugin_handle handle, gfal_file_handle fd, void *buff, size_t count, GError ** err);
 
+ssize_t gfal_xrootd_preadG(plugin_handle handle, gfal_file_handle fd, void *buff, size_t count, off_t offset, GError ** err);
+
 ssize_t gfal_xrootd_writeG(plugin_handle handle, gfal_file_handle fd, const void *buff, size_t count, GError ** err);
 
+ssize_t gfal_xrootd_pwriteG(plugin_handle handle, gfal_file_handle fd, const void *buff, size_t count, off_t offset, GError ** err);
+
 off_t gfal_xrootd_lseekG(plugin_handle handle, gfal_file_handle fd, off_t offset, int whence, GError **err);
 
 int gfal_xrootd_closeG(plugin_handle handle, gfal_file_handle fd, GError ** err);
@@ -53,8 +53,8 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
     xrootd_plugin.statG = &gfal_xrootd_statG;
     xrootd_plugin.lstatG = &gfal_xrootd_statG;
 
-    xrootd_plugin.preadG = NULL; // &gfal_xrootd_preadG;
-    xrootd_plugin.pwriteG = NULL; // &gfal_xrootd_pwriteG;
+    xrootd_plugin.preadG = &gfal_xrootd_preadG;
+    xrootd_plugin.pwriteG = &gfal_xrootd_pwriteG;
 
     xrootd_plugin.mkdirpG = &gfal_xrootd_mkdirpG;
     xrootd_plugin.chmodG = &gfal_xrootd_chmodG;
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gfal_api.h>
+#include "gfal_xrootd_plugin_parallelism.h"
+
+#include <algorithm>
+
+// A level must do this much better than the previous one to be kept
+#define TUNER_IMPROVEMENT 1.1
+// Samples at a settled level before probing a higher one
+#define TUNER_PROBE_AFTER 3
+
+std::mutex ParallelismTuner::knownMutex;
+std::map<std::string, int> ParallelismTuner::known;
+
+
+ParallelismTuner::ParallelismTuner(const std::string& key, int initial, int max):
+    key(key), max(std::max(1, max)), phase(RAMP), baseThroughput(0), baseLevel(0), stableSamples(0)
+{
+    level = std::max(1, initial);
+
+    std::lock_guard<std::mutex> lock(knownMutex);
+    std::map<std::string, int>::const_iterator i = known.find(key);
+    if (i != known.end()) {
+        // Already tuned, so do not ramp again from scratch, but keep probing
+        level = i->second;
+        phase = SETTLED;
+    }
+    level = std::min(level, this->max);
+}
+
+
+void ParallelismTuner::Feedback(double throughput, bool errors)
+{
+    int previous = level;
+
+    if (errors) {
+        level = std::max(1, level / 2);
+        phase = SETTLED;
+        stableSamples = 0;
+        // Measure again at the new level
+        baseThroughput = 0;
+    }
+    else switch (phase) {
+        case RAMP:
+            if (throughput <= 0 || throughput > baseThroughput * TUNER_IMPROVEMENT) {
+                // Nothing transferred (i.e. empty files) counts as an improvement
+                baseThroughput = std::max(throughput, 0.0);
+                baseLevel = level;
+                if (level >= max) {
+                    phase = SETTLED;
+                }
+                level = std::min(max, level * 2);
+            }
+            else {
+                level = std::max(1, baseLevel);
+                phase = SETTLED;
+            }
+            break;
+        case PROBE:
+            if (throughput > baseThroughput * TUNER_IMPROVEMENT) {
+                baseThroughput = throughput;
+                baseLevel = level;
+            }
+            else {
+                level = std::max(1, baseLevel);
+            }
+            phase = SETTLED;
+            stableSamples = 0;
+            break;
+        case SETTLED:
+            // The link may change, so compare against the most recent sample
+            baseThroughput = throughput;
+            baseLevel = level;
+            if (++stableSamples >= TUNER_PROBE_AFTER && level < max) {
+                level = std::min(max, level + std::max(1, level / 4));
+                phase = PROBE;
+            }
+            break;
+    }
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Parallel copies for %s: %d => %d (%.0f bytes/s%s%s)",
+            key.c_str(), previous, level, throughput,
+            errors ? ", errors" : "", phase == RAMP ? "" : ", settled");
+
+    std::lock_guard<std::mutex> lock(knownMutex);
+    known[key] = (phase == PROBE) ? baseLevel : level;
+}
+
+
+AdaptiveScheduler::Pair::Pair(const std::string& key, int initial, int max):
+    tuner(key, initial, max), next(0), active(0), errors(false), bytes(0), sampledBytes(0)
+{
+}
+
+
+AdaptiveScheduler::AdaptiveScheduler(int initial, int max, std::chrono::milliseconds interval):
+    initial(initial), max(std::max(1, max)), interval(interval), totalActive(0), canceled(false)
+{
+}
+
+
+AdaptiveScheduler::~AdaptiveScheduler()
+{
+}
+
+
+void AdaptiveScheduler::Add(const std::string& key, size_t index)
+{
+    std::unique_ptr<Pair>& pair = pairs[key];
+    if (!pair) {
+        pair.reset(new Pair(key, initial, max));
+    }
+    pair->indexes.push_back(index);
+}
+
+
+void AdaptiveScheduler::Worker(Pair* pair, RunFunc run, size_t index)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        lock.unlock();
+        bool ok = run(index, &pair->bytes);
+        lock.lock();
+        if (!ok) {
+            pair->errors = true;
+        }
+        // Leave when the window of the pair shrunk
+        if (canceled || pair->next >= pair->indexes.size() || pair->active > pair->tuner.GetLevel()) {
+            break;
+        }
+        index = pair->indexes[pair->next++];
+    }
+    --pair->active;
+    --totalActive;
+    finished.push_back(std::this_thread::get_id());
+    cond.notify_all();
+}
+
+
+void AdaptiveScheduler::JoinFinished(std::unique_lock<std::mutex>& lock)
+{
+    std::vector<std::thread> done;
+    std::vector<std::thread::id>::const_iterator id;
+    for (id = finished.begin(); id != finished.end(); ++id) {
+        std::map<std::thread::id, std::thread>::iterator worker = workers.find(*id);
+        done.push_back(std::move(worker->second));
+        workers.erase(worker);
+    }
+    finished.clear();
+
+    lock.unlock();
+    std::vector<std::thread>::iterator thread;
+    for (thread = done.begin(); thread != done.end(); ++thread) {
+        thread->join();
+    }
+    lock.lock();
+}
+
+
+void AdaptiveScheduler::Run(RunFunc run, SkipFunc skip, CancelFunc isCanceled)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    std::chrono::steady_clock::time_point lastSample = std::chrono::steady_clock::now();
+
+    while (true) {
+        if (!canceled && isCanceled()) {
+            canceled = true;
+            std::map<std::string, std::unique_ptr<Pair> >::iterator p;
+            for (p = pairs.begin(); p != pairs.end(); ++p) {
+                Pair* pair = p->second.get();
+                for (; pair->next < pair->indexes.size(); ++pair->next) {
+                    skip(pair->indexes[pair->next]);
+                }
+            }
+        }
+
+        // Fill the windows one slot at a time, so no pair starves the others
+        bool pending = false, started = true;
+        while (started) {
+            started = false;
+            pending = false;
+            std::map<std::string, std::unique_ptr<Pair> >::iterator p;
+            for (p = pairs.begin(); p != pairs.end(); ++p) {
+                Pair* pair = p->second.get();
+                if (pair->next >= pair->indexes.size()) {
+                    continue;
+                }
+                pending = true;
+                if (pair->active < pair->tuner.GetLevel() && totalActive < max) {
+                    ++pair->active;
+                    ++totalActive;
+                    std::thread worker(&AdaptiveScheduler::Worker, this, pair, run,
+                        pair->indexes[pair->next++]);
+                    workers[worker.get_id()] = std::move(worker);
+                    started = true;
+                }
+            }
+        }
+
+        JoinFinished(lock);
+        if (totalActive == 0 && !pending) {
+            break;
+        }
+
+        std::chrono::steady_clock::time_point deadline = lastSample + interval;
+        cond.wait_until(lock, deadline, [this] { return !finished.empty(); });
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now < deadline) {
+            continue;
+        }
+        double elapsed = std::chrono::duration<double>(now - lastSample).count();
+        lastSample = now;
+
+        std::map<std::string, std::unique_ptr<Pair> >::iterator p;
+        for (p = pairs.begin(); p != pairs.end(); ++p) {
+            Pair* pair = p->second.get();
+            uint64_t bytes = pair->bytes.load();
+            // Once everything is started, fewer jobs run, so nothing to learn
+            if (!canceled && pair->next < pair->indexes.size()) {
+                pair->tuner.Feedback((bytes - pair->sampledBytes) / elapsed, pair->errors);
+            }
+            pair->sampledBytes = bytes;
+            pair->errors = false;
+        }
+    }
+
+    JoinFinished(lock);
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GFAL_XROOTD_PLUGIN_PARALLELISM_H_
+#define GFAL_XROOTD_PLUGIN_PARALLELISM_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/// Tune the number of parallel copies between a pair of endpoints
+/// Start low and double the level while the aggregated throughput keeps improving,
+/// settle when it does not, and halve it on errors.
+/// Once settled, a higher level is probed every few samples, so the level can
+/// recover from errors or from a link that got better.
+/// The level reached is remembered for the next batches going between the same endpoints.
+class ParallelismTuner
+{
+public:
+    ParallelismTuner(const std::string& key, int initial, int max);
+
+    int GetLevel() const
+    {
+        return level;
+    }
+
+    bool IsRamping() const
+    {
+        return phase == RAMP;
+    }
+
+    /// Throughput, in bytes/s, observed at the current level since the last feedback
+    void Feedback(double throughput, bool errors);
+
+private:
+    enum Phase {RAMP, SETTLED, PROBE};
+
+    std::string key;
+    int level, max;
+    Phase phase;
+    // Throughput observed at baseLevel
+    double baseThroughput;
+    int baseLevel;
+    int stableSamples;
+
+    static std::mutex knownMutex;
+    static std::map<std::string, int> known;
+};
+
+
+/// Run jobs grouped by endpoint pair. All the pairs run at the same time, each one
+/// with a rolling window of ParallelismTuner::GetLevel() jobs: a job starts as soon
+/// as another one of the same pair finishes. The throughput of each pair is sampled
+/// every interval, and fed back to its tuner.
+class AdaptiveScheduler
+{
+public:
+    /// Run the job index, adding the bytes transferred to bytes as they go.
+    /// Returns false on failure
+    typedef std::function<bool (size_t index, std::atomic<uint64_t>* bytes)> RunFunc;
+    /// Called for the jobs not started because of a cancellation
+    typedef std::function<void (size_t index)> SkipFunc;
+    typedef std::function<bool ()> CancelFunc;
+
+    /// max is the limit for each pair, and for all of them together
+    AdaptiveScheduler(int initial, int max, std::chrono::milliseconds interval);
+    ~AdaptiveScheduler();
+
+    void Add(const std::string& key, size_t index);
+
+    void Run(RunFunc run, SkipFunc skip, CancelFunc canceled);
+
+private:
+    struct Pair {
+        Pair(const std::string& key, int initial, int max);
+
+        ParallelismTuner tuner;
+        std::vector<size_t> indexes;
+        size_t next;
+        int active;
+        bool errors;
+        std::atomic<uint64_t> bytes;
+        uint64_t sampledBytes;
+    };
+
+    int initial, max;
+    std::chrono::milliseconds interval;
+    std::map<std::string, std::unique_ptr<Pair> > pairs;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    int totalActive;
+    bool canceled;
+    std::map<std::thread::id, std::thread> workers;
+    std::vector<std::thread::id> finished;
+
+    void Worker(Pair* pair, RunFunc run, size_t index);
+    void JoinFinished(std::unique_lock<std::mutex>& lock);
+};
+
+#endif /* GFAL_XROOTD_PLUGIN_PARALLELISM_H_ */
@@ -33,6 +33,8 @@ static const guint64 max_list_len = MAX_LIST_LEN;
 
 typedef struct _Internal_item{
 	int ref_count;
+	// monotonic time after which the item is dropped, 0 for reference counted items
+	gint64 expires;
 	char item[];
 } Internal_item;
 
@@ -83,6 +85,10 @@ void gsimplecache_delete(GSimpleCache* cache){
 Internal_item* gsimplecache_find_kstr_internal(GSimpleCache* cache, const char* key){
 	Internal_item* ret = (Internal_item*) g_hash_table_lookup(cache->table, (gconstpointer) key);
 	if(ret != NULL ){
+		if(ret->expires != 0 && ret->expires < g_get_monotonic_time()){
+			g_hash_table_remove(cache->table, (gconstpointer) key);
+			return NULL;
+		}
 		return ret;
 	}	
 	return NULL;
@@ -92,10 +98,21 @@ static gboolean gsimplecache_remove_internal_kstr(GSimpleCache* cache, const cha
 		return g_hash_table_remove(cache->table, (gconstpointer) key);	
 }
 
+static gboolean gsimplecache_is_expired(gpointer key, gpointer value, gpointer user_data){
+	Internal_item* i = (Internal_item*) value;
+	return i->expires != 0 && i->expires < *((gint64*) user_data);
+}
+
 // simple lazy space maker, can be improved
-static void gsimplecache_manage_space(GSimpleCache* cache){
+// Make room for n_new items, so they are never wiped by their own insertion
+static void gsimplecache_manage_space(GSimpleCache* cache, size_t n_new){
     size_t len = (size_t) g_hash_table_size (cache->table);
-    if(len >= cache->max_number_item){
+    if(len + n_new > cache->max_number_item){
+        gint64 now = g_get_monotonic_time();
+        g_hash_table_foreach_remove(cache->table, gsimplecache_is_expired, &now);
+    }
+    len = (size_t) g_hash_table_size (cache->table);
+    if(len + n_new > cache->max_number_item){
         g_hash_table_remove_all(cache->table);
     }
 }
@@ -105,9 +122,10 @@ static void gsimplecache_manage_space(GSimpleCache* cache){
 void gsimplecache_add_item_internal(GSimpleCache* cache, const char* key, void* item){
 	Internal_item* ret = gsimplecache_find_kstr_internal(cache, key);	
 	if(ret == NULL){
-        gsimplecache_manage_space(cache);
+        gsimplecache_manage_space(cache, 1);
 		ret = malloc(sizeof(struct _Internal_item) + cache->size_item);
 		ret->ref_count = 2;
+		ret->expires = 0;
 		cache->do_copy(item, ret->item);
 		g_hash_table_insert(cache->table, strdup(key), ret);
 	}else{
@@ -127,6 +145,36 @@ void gsimplecache_add_item_kstr(GSimpleCache* cache, const char* key, void* item
 
 
 
+/**
+ * Add n_items items, stored contiguously in items, under one lock.
+ * These items are kept for ttl seconds, whatever the number of times they are taken,
+ * and replace any existing item with the same key.
+ * Only the first items that fit in the cache are added
+ * */
+void gsimplecache_add_items_ttl_kstr(GSimpleCache* cache, size_t n_items, const char* const* keys,
+        void* items, time_t ttl){
+	size_t i;
+	gint64 expires = g_get_monotonic_time() + ((gint64) ttl) * G_USEC_PER_SEC;
+	// A larger batch would fill the cache past its limit
+	if(n_items > cache->max_number_item)
+		n_items = cache->max_number_item;
+	pthread_mutex_lock(&cache->mux);
+	// Space is made once for the whole batch, so it can not wipe the items of the batch
+	gsimplecache_manage_space(cache, n_items);
+	for(i = 0; i < n_items; ++i){
+		Internal_item* ret = (Internal_item*) g_hash_table_lookup(cache->table, (gconstpointer) keys[i]);
+		if(ret == NULL){
+			ret = malloc(sizeof(struct _Internal_item) + cache->size_item);
+			g_hash_table_insert(cache->table, strdup(keys[i]), ret);
+		}
+		ret->ref_count = 1;
+		ret->expires = expires;
+		cache->do_copy(((char*) items) + i * cache->size_item, ret->item);
+	}
+	pthread_mutex_unlock(&cache->mux);
+}
+
+
 /**
  * remove the item in the cache, return TRUE if removed else FALSE
  * destroy the internal item automatically
@@ -147,9 +195,9 @@ int gsimplecache_take_one_kstr(GSimpleCache* cache, const char* key, void* res){
 	pthread_mutex_lock(&cache->mux);	
 	Internal_item* ret = gsimplecache_find_kstr_internal(cache, key);
 	if(ret){
-		(ret->ref_count)--;
 		cache->do_copy(ret->item, res);
-		if(ret->ref_count <= 0)
+		// items with a ttl stay until they expire
+		if(ret->expires == 0 && --(ret->ref_count) <= 0)
 			gsimplecache_remove_internal_kstr(cache, key);
 	}
 	pthread_mutex_unlock(&cache->mux);	
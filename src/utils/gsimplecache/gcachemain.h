@@ -21,6 +21,7 @@
 #pragma once
 
 #include <glib.h>
+#include <time.h>
 
 
 #define MAX_LIST_LEN 20000
@@ -38,6 +39,9 @@ void gsimplecache_delete(GSimpleCache* cache);
 
 void gsimplecache_add_item_kstr(GSimpleCache* cache, const char* key, void* item);
 
+void gsimplecache_add_items_ttl_kstr(GSimpleCache* cache, size_t n_items, const char* const* keys,
+        void* items, time_t ttl);
+
 int gsimplecache_take_one_kstr(GSimpleCache* cache, const char* key, void* res);
 
 gboolean gsimplecache_remove_kstr(GSimpleCache* cache, const char* key);
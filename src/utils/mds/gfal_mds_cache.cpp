@@ -18,15 +18,25 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cstring>
 #include <errno.h>
 #include <fcntl.h>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <pugixml.hpp>
+#include <stdint.h>
 #include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
 #include "gfal_mds_internal.h"
 
 
 const char* bdii_cache_file = "CACHE_FILE";
+const char* bdii_cache_snapshot = "CACHE_SNAPSHOT";
 
 static mds_type_endpoint gfal_mds_cache_type(const std::string& type,
                                 const std::string &version)
@@ -47,24 +57,371 @@ static mds_type_endpoint gfal_mds_cache_type(const std::string& type,
     }
 }
 
-static void gfal_mds_cache_insert(gfal_mds_endpoint* endpoints, size_t s_endpoints,
-                                  size_t index, const pugi::xml_node& entry)
+/// Extract the host name from an endpoint (i.e. httpg://host:port/path => host), lowercased
+static std::string gfal_mds_cache_endpoint_host(const char* endpoint)
 {
-    if (index > s_endpoints)
-        return;
+    const char* hostname = strstr(endpoint, "://");
+    if (hostname) hostname += 3;
+    else hostname = endpoint;
+
+    size_t len = strcspn(hostname, ":/");
+    std::string host(hostname, len);
+    std::transform(host.begin(), host.end(), host.begin(), ::tolower);
+    return host;
+}
+
+
+/// Version of the cache file an index was built from. A file replaced within
+/// the same second, and with the same size, still differs by the nanoseconds or the inode
+struct BdiiCacheSource
+{
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime;
+    long mtime_nsec;
+
+    BdiiCacheSource(): dev(0), ino(0), size(0), mtime(0), mtime_nsec(0)
+    {
+    }
+
+    explicit BdiiCacheSource(const struct stat& st): dev(st.st_dev), ino(st.st_ino), size(st.st_size),
+        mtime(st.st_mtim.tv_sec), mtime_nsec(st.st_mtim.tv_nsec)
+    {
+    }
+
+    bool operator == (const BdiiCacheSource& other) const
+    {
+        return dev == other.dev && ino == other.ino && size == other.size &&
+               mtime == other.mtime && mtime_nsec == other.mtime_nsec;
+    }
+};
 
-    std::string endpoint = entry.child("endpoint").last_child().value();
-    std::string type     = entry.child("type").last_child().value();
-    std::string version  = entry.child("version").last_child().value();
 
-    mds_type_endpoint typeEnum = gfal_mds_cache_type(type, version);
+/// Index of the cache file, host => endpoints
+class BdiiCacheIndex
+{
+public:
+    BdiiCacheSource source;
+
+    BdiiCacheIndex()
+    {
+    }
 
-    if (!endpoint.empty() && typeEnum != UnknownEndpointType) {
-        g_strlcpy(endpoints[index].url, endpoint.c_str(), sizeof(endpoints[index].url));
-        endpoints[index].type = typeEnum;
+    virtual ~BdiiCacheIndex()
+    {
+    }
+
+    /// Fill up to s_endpoints entries for host, and return how many
+    virtual size_t Lookup(const std::string& host, gfal_mds_endpoint* endpoints, size_t s_endpoints) const = 0;
+};
+
+
+struct BdiiCacheEntry
+{
+    std::string url;
+    mds_type_endpoint type;
+};
+
+
+/// Index built from the XML cache file
+class XmlBdiiCacheIndex: public BdiiCacheIndex
+{
+public:
+    std::map<std::string, std::vector<BdiiCacheEntry> > byHost;
+
+    /// Single pass over the entries
+    bool Load(const char* path)
+    {
+        pugi::xml_document cache;
+        pugi::xml_parse_result loadResult = cache.load_file(path);
+        if (loadResult.status != pugi::status_ok) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Could not load BDII CACHE_FILE: %s",
+                    loadResult.description());
+            return false;
+        }
+
+        for (pugi::xml_node entry = cache.child("entry"); entry; entry = entry.next_sibling("entry")) {
+            BdiiCacheEntry item;
+            item.url = entry.child("endpoint").last_child().value();
+            std::string type = entry.child("type").last_child().value();
+            std::string version = entry.child("version").last_child().value();
+            item.type = gfal_mds_cache_type(type, version);
+
+            if (!item.url.empty() && item.type != UnknownEndpointType) {
+                byHost[gfal_mds_cache_endpoint_host(item.url.c_str())].push_back(item);
+            }
+        }
+        return true;
     }
+
+    size_t Lookup(const std::string& host, gfal_mds_endpoint* endpoints, size_t s_endpoints) const
+    {
+        std::map<std::string, std::vector<BdiiCacheEntry> >::const_iterator i = byHost.find(host);
+        if (i == byHost.end())
+            return 0;
+
+        size_t n = std::min(s_endpoints, i->second.size());
+        for (size_t j = 0; j < n; ++j) {
+            g_strlcpy(endpoints[j].url, i->second[j].url.c_str(), sizeof(endpoints[j].url));
+            endpoints[j].type = i->second[j].type;
+        }
+        return n;
+    }
+};
+
+
+// Binary snapshot of the index, so processes do not need to parse the XML file again
+// Layout: header, records sorted by host, string table. Offsets are relative to the string table.
+#define BDII_SNAPSHOT_MAGIC   "GFALBDII"
+#define BDII_SNAPSHOT_VERSION 2
+
+struct BdiiSnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    int64_t source_mtime;
+    int64_t source_mtime_nsec;
+    int64_t source_size;
+    uint64_t source_ino;
+};
+
+struct BdiiSnapshotRecord
+{
+    uint32_t host;
+    uint32_t url;
+    uint32_t type;
+};
+
+
+/// Index backed by a memory mapped snapshot
+class SnapshotBdiiCacheIndex: public BdiiCacheIndex
+{
+private:
+    void* data;
+    size_t length;
+    const BdiiSnapshotRecord* records;
+    const char* strings;
+    size_t stringsLength;
+    uint32_t count;
+
+    /// The snapshot may be corrupted, so nothing in it is trusted before being checked
+    /// against the size of the mapping
+    bool Validate(const BdiiSnapshotHeader* header)
+    {
+        count = header->count;
+        size_t available = length - sizeof(BdiiSnapshotHeader);
+        if (count > available / sizeof(BdiiSnapshotRecord)) {
+            return false;
+        }
+        records = reinterpret_cast<const BdiiSnapshotRecord*>(header + 1);
+        strings = reinterpret_cast<const char*>(records + count);
+        stringsLength = available - count * sizeof(BdiiSnapshotRecord);
+
+        // So any string starting within the table ends within it too
+        if (stringsLength == 0 || strings[stringsLength - 1] != '\0') {
+            return false;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            if (records[i].host >= stringsLength || records[i].url >= stringsLength ||
+                records[i].type > UnknownEndpointType) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    SnapshotBdiiCacheIndex(): data(MAP_FAILED), length(0), records(NULL), strings(NULL),
+        stringsLength(0), count(0)
+    {
+    }
+
+    ~SnapshotBdiiCacheIndex()
+    {
+        if (data != MAP_FAILED) {
+            munmap(data, length);
+        }
+    }
+
+    /// Map the snapshot, if it matches the given source file
+    bool Load(const char* path, const BdiiCacheSource& source)
+    {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(BdiiSnapshotHeader)) {
+            close(fd);
+            return false;
+        }
+        length = st.st_size;
+        data = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+
+        const BdiiSnapshotHeader* header = static_cast<const BdiiSnapshotHeader*>(data);
+        if (memcmp(header->magic, BDII_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != BDII_SNAPSHOT_VERSION ||
+            header->source_mtime != source.mtime || header->source_mtime_nsec != source.mtime_nsec ||
+            header->source_size != source.size || header->source_ino != (uint64_t)source.ino) {
+            return false;
+        }
+        if (!Validate(header)) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Ignoring corrupted BDII cache snapshot %s", path);
+            return false;
+        }
+        return true;
+    }
+
+    size_t Lookup(const std::string& host, gfal_mds_endpoint* endpoints, size_t s_endpoints) const
+    {
+        const char* strings = this->strings;
+        const BdiiSnapshotRecord* first = std::lower_bound(records, records + count, host,
+            [strings](const BdiiSnapshotRecord& r, const std::string& h) {
+                return strcmp(strings + r.host, h.c_str()) < 0;
+            });
+
+        size_t n = 0;
+        for (const BdiiSnapshotRecord* r = first;
+             r != records + count && n < s_endpoints && host == strings + r->host; ++r, ++n) {
+            g_strlcpy(endpoints[n].url, strings + r->url, sizeof(endpoints[n].url));
+            endpoints[n].type = static_cast<mds_type_endpoint>(r->type);
+        }
+        return n;
+    }
+
+    /// Write the snapshot of index atomically into path
+    static void Write(const char* path, const XmlBdiiCacheIndex& index)
+    {
+        std::vector<BdiiSnapshotRecord> records;
+        std::string strings;
+
+        std::map<std::string, std::vector<BdiiCacheEntry> >::const_iterator i;
+        for (i = index.byHost.begin(); i != index.byHost.end(); ++i) {
+            uint32_t host = strings.size();
+            strings.append(i->first.c_str(), i->first.size() + 1);
+            std::vector<BdiiCacheEntry>::const_iterator j;
+            for (j = i->second.begin(); j != i->second.end(); ++j) {
+                BdiiSnapshotRecord record;
+                record.host = host;
+                record.url = strings.size();
+                record.type = j->type;
+                strings.append(j->url.c_str(), j->url.size() + 1);
+                records.push_back(record);
+            }
+        }
+
+        BdiiSnapshotHeader header;
+        memcpy(header.magic, BDII_SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = BDII_SNAPSHOT_VERSION;
+        header.count = records.size();
+        header.source_mtime = index.source.mtime;
+        header.source_mtime_nsec = index.source.mtime_nsec;
+        header.source_size = index.source.size;
+        header.source_ino = index.source.ino;
+
+        std::string tmp_path(path);
+        tmp_path += ".XXXXXX";
+        int fd = mkstemp(&tmp_path[0]);
+        if (fd < 0) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Could not write the BDII cache snapshot %s: %s",
+                    path, strerror(errno));
+            return;
+        }
+
+        bool ok = write(fd, &header, sizeof(header)) == sizeof(header);
+        ssize_t recordsSize = records.size() * sizeof(BdiiSnapshotRecord);
+        ok = ok && write(fd, records.data(), recordsSize) == recordsSize;
+        ok = ok && write(fd, strings.data(), strings.size()) == (ssize_t)strings.size();
+        fchmod(fd, 0644);
+        close(fd);
+
+        if (!ok || rename(tmp_path.c_str(), path) < 0) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Could not write the BDII cache snapshot %s: %s",
+                    path, strerror(errno));
+            unlink(tmp_path.c_str());
+        }
+        else {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "BDII cache snapshot written into %s", path);
+        }
+    }
+};
+
+
+static std::mutex bdii_cache_mutex;
+static std::map<std::string, std::shared_ptr<BdiiCacheIndex> > bdii_cache_indexes;
+
+
+/// Load the index of the cache file, from the snapshot if it is up to date
+static std::shared_ptr<BdiiCacheIndex> gfal_mds_cache_load_index(gfal2_context_t handle,
+    const char* cache_file, const BdiiCacheSource& source)
+{
+    std::shared_ptr<BdiiCacheIndex> index;
+
+    gchar *snapshot_file = gfal2_get_opt_string(handle, bdii_config_group, bdii_cache_snapshot, NULL);
+    if (snapshot_file) {
+        SnapshotBdiiCacheIndex* snapshot = new SnapshotBdiiCacheIndex();
+        if (snapshot->Load(snapshot_file, source)) {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Using BDII cache snapshot %s", snapshot_file);
+            snapshot->source = source;
+            index.reset(snapshot);
+            g_free(snapshot_file);
+            return index;
+        }
+        delete snapshot;
+    }
+
+    XmlBdiiCacheIndex* xml = new XmlBdiiCacheIndex();
+    if (!xml->Load(cache_file)) {
+        delete xml;
+        g_free(snapshot_file);
+        return index;
+    }
+    xml->source = source;
+    index.reset(xml);
+
+    if (snapshot_file) {
+        SnapshotBdiiCacheIndex::Write(snapshot_file, *xml);
+        g_free(snapshot_file);
+    }
+    return index;
+}
+
+
+/// Return the index for the cache file, loading it only if it is new or has changed
+static std::shared_ptr<BdiiCacheIndex> gfal_mds_cache_get_index(gfal2_context_t handle,
+    const char* cache_file)
+{
+    struct stat st;
+    if (stat(cache_file, &st) < 0) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Could not load BDII CACHE_FILE: %s", strerror(errno));
+        return std::shared_ptr<BdiiCacheIndex>();
+    }
+    BdiiCacheSource source(st);
+
+    {
+        std::lock_guard<std::mutex> lock(bdii_cache_mutex);
+        std::map<std::string, std::shared_ptr<BdiiCacheIndex> >::const_iterator i =
+            bdii_cache_indexes.find(cache_file);
+        if (i != bdii_cache_indexes.end() && i->second && i->second->source == source) {
+            return i->second;
+        }
+    }
+
+    // Parsing a big file takes a while, so do not hold the lookups of other files meanwhile
+    std::shared_ptr<BdiiCacheIndex> index = gfal_mds_cache_load_index(handle, cache_file, source);
+
+    std::lock_guard<std::mutex> lock(bdii_cache_mutex);
+    bdii_cache_indexes[cache_file] = index;
+    return index;
 }
 
+
 int gfal_mds_cache_resolve_endpoint(gfal2_context_t handle, const char* host,
                                     gfal_mds_endpoint* endpoints, size_t s_endpoints,
                                     GError** err)
@@ -76,43 +433,15 @@ int gfal_mds_cache_resolve_endpoint(gfal2_context_t handle, const char* host,
 
     gfal2_log(G_LOG_LEVEL_DEBUG, "BDII CACHE_FILE set to %s", cache_file);
 
-    // Open the file, but do not fail if it can not be open
+    // Do not fail if the file can not be open
     // (A cache may not be present!)
-    pugi::xml_document cache;
-    pugi::xml_parse_result loadResult = cache.load_file(cache_file);
-
+    std::shared_ptr<BdiiCacheIndex> index = gfal_mds_cache_get_index(handle, cache_file);
     g_free(cache_file);
 
-    if (loadResult.status != pugi::status_ok) {
-        gfal2_log(G_LOG_LEVEL_DEBUG, "Could not load BDII CACHE_FILE: %s",
-                loadResult.description());
+    if (!index)
         return 0;
-    }
-
-    // Iterate. Get all endpoints and check if the contain the requested host
-    size_t hostLen = strlen(host);
-
-    pugi::xpath_node_set allEndpoints = cache.document_element().select_nodes("/entry/endpoint");
-    pugi::xpath_node_set::const_iterator i;
-    size_t endpointIndex = 0;
-    for (i = allEndpoints.begin();
-         i != allEndpoints.end() && endpointIndex < s_endpoints;
-         ++i) {
-        const char* endpoint = i->node().child_value();
-        const char* hostname = strstr(endpoint, "://");
-        if (hostname) hostname += 3;
-        else hostname = endpoint;
-
-        if (strncasecmp(hostname, host, hostLen) == 0) {
-            std::string xpathQuery("/entry[endpoint='");
-            xpathQuery += endpoint;
-            xpathQuery += "']";
-
-            pugi::xpath_node entry = cache.document_element().select_single_node(xpathQuery.c_str());
-            gfal_mds_cache_insert(endpoints, s_endpoints, endpointIndex++, entry.node());
-        }
-    }
 
-    // Done here
-    return endpointIndex;
+    std::string lowerHost(host);
+    std::transform(lowerHost.begin(), lowerHost.end(), lowerHost.begin(), ::tolower);
+    return index->Lookup(lowerHost, endpoints, s_endpoints);
 }
@@ -24,6 +24,7 @@
 #include <glib.h>
 #include <string.h>
 #include <pthread.h>
+#include <time.h>
 #include <lber.h>
 #include <ldap.h>
 #include "gfal_mds_internal.h"
@@ -44,6 +45,37 @@ static const char* SRM_PREFIX_NAME="SRM";
 
 static pthread_mutex_t mux_init_lap = PTHREAD_MUTEX_INITIALIZER;
 
+const char* bdii_config_cache_ttl = "RESOLUTION_CACHE_TTL";
+const char* bdii_config_negative_cache_ttl = "RESOLUTION_NEGATIVE_CACHE_TTL";
+
+#define GFAL_MDS_DEFAULT_CACHE_TTL 600
+#define GFAL_MDS_DEFAULT_NEGATIVE_CACHE_TTL 60
+
+/*
+ * Result of a resolution, kept for the configured TTL
+ * Misses (no entry in the bdii) are kept as well, with their error
+ */
+typedef struct _gfal_mds_cached_resolution {
+	time_t expires;
+	int n_endpoints;
+	gfal_mds_endpoint *endpoints;
+	int err_code;
+	char *err_msg;
+} gfal_mds_cached_resolution;
+
+/*
+ * Connection to a bdii, kept open between resolutions
+ * The mutex serializes the queries sent through it
+ */
+typedef struct _gfal_mds_ldap_connection {
+	LDAP *ld;
+	pthread_mutex_t mutex;
+} gfal_mds_ldap_connection;
+
+static pthread_mutex_t mds_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static GHashTable *mds_resolution_cache = NULL;
+static GHashTable *mds_connections = NULL;
+
 
 LDAP *gfal_mds_ldap_connect(gfal2_context_t context, const char *uri, GError **err)
 {
@@ -86,7 +118,6 @@ int gfal_mds_ldap_search(LDAP *ld, const char *basedn, const char *filter, char
 		GError **err)
 {
 	GError *tmp_err = NULL;
-	int ret = -1;
 	int rc;
 
 	if ((rc = gfal_mds_ldap.ldap_search_ext_s(ld, basedn, LDAP_SCOPE_SUBTREE,
@@ -94,11 +125,10 @@ int gfal_mds_ldap_search(LDAP *ld, const char *basedn, const char *filter, char
 			LDAP_NO_LIMIT, res)) != LDAP_SUCCESS) {
 		g_set_error(&tmp_err, gfal2_get_core_quark(), ECOMM, "Error while request %s to bdii : %s", filter,
 				ldap_err2string(rc));
-	} else
-		ret = 0;
+	}
 	if (tmp_err)
 		g_propagate_prefixed_error(err, tmp_err, "[%s]", __func__);
-	return ret;
+	return rc;
 
 }
 
@@ -283,8 +313,173 @@ void gfal_mds_ldap_disconnect(LDAP *ld)
 	gfal_mds_ldap.ldap_unbind_ext_s(ld, NULL, NULL);
 }
 
+static void gfal_mds_cached_resolution_free(gpointer data)
+{
+	gfal_mds_cached_resolution *cached = (gfal_mds_cached_resolution *) data;
+	g_free(cached->endpoints);
+	g_free(cached->err_msg);
+	g_free(cached);
+}
+
+
+static void gfal_mds_ldap_connection_free(gpointer data)
+{
+	gfal_mds_ldap_connection *conn = (gfal_mds_ldap_connection *) data;
+	if (conn->ld)
+		gfal_mds_ldap_disconnect(conn->ld);
+	pthread_mutex_destroy(&conn->mutex);
+	g_free(conn);
+}
+
+
+void gfal_mds_bdii_cache_clear(void)
+{
+	pthread_mutex_lock(&mds_cache_mutex);
+	if (mds_resolution_cache)
+		g_hash_table_remove_all(mds_resolution_cache);
+	if (mds_connections)
+		g_hash_table_remove_all(mds_connections);
+	pthread_mutex_unlock(&mds_cache_mutex);
+}
+
+/*
+ * look for a non expired resolution in the cache
+ * @return the number of endpoints set, -1 if a miss was cached, or -2 if not in the cache
+ */
+static int gfal_mds_bdii_cache_lookup(const char *key, gfal_mds_endpoint *endpoints, size_t s_endpoint,
+		GError **err)
+{
+	int ret = -2;
+
+	pthread_mutex_lock(&mds_cache_mutex);
+	if (mds_resolution_cache) {
+		gfal_mds_cached_resolution *cached = g_hash_table_lookup(mds_resolution_cache, key);
+		if (cached && cached->expires < time(NULL)) {
+			g_hash_table_remove(mds_resolution_cache, key);
+		}
+		else if (cached && cached->n_endpoints < 0) {
+			g_set_error(err, gfal2_get_core_quark(), cached->err_code, "%s", cached->err_msg);
+			ret = -1;
+		}
+		else if (cached) {
+			ret = MIN((size_t) cached->n_endpoints, s_endpoint);
+			memcpy(endpoints, cached->endpoints, ret * sizeof(gfal_mds_endpoint));
+		}
+	}
+	pthread_mutex_unlock(&mds_cache_mutex);
+	return ret;
+}
+
+/*
+ * store a resolution in the cache
+ * only successes and definitive misses are stored, not connection errors
+ */
+static void gfal_mds_bdii_cache_store(gfal2_context_t context, const char *key, int n_endpoints,
+		const gfal_mds_endpoint *endpoints, const GError *error)
+{
+	int ttl;
+	if (n_endpoints >= 0) {
+		ttl = gfal2_get_opt_integer_with_default(context, bdii_config_group, bdii_config_cache_ttl,
+				GFAL_MDS_DEFAULT_CACHE_TTL);
+	}
+	else if (error && error->code == ENXIO) {
+		ttl = gfal2_get_opt_integer_with_default(context, bdii_config_group, bdii_config_negative_cache_ttl,
+				GFAL_MDS_DEFAULT_NEGATIVE_CACHE_TTL);
+	}
+	else {
+		return;
+	}
+	if (ttl <= 0)
+		return;
+
+	gfal_mds_cached_resolution *cached = g_new0(gfal_mds_cached_resolution, 1);
+	cached->expires = time(NULL) + ttl;
+	cached->n_endpoints = n_endpoints;
+	if (n_endpoints > 0) {
+		cached->endpoints = g_new(gfal_mds_endpoint, n_endpoints);
+		memcpy(cached->endpoints, endpoints, n_endpoints * sizeof(gfal_mds_endpoint));
+	}
+	if (error) {
+		cached->err_code = error->code;
+		cached->err_msg = g_strdup(error->message);
+	}
+
+	pthread_mutex_lock(&mds_cache_mutex);
+	if (!mds_resolution_cache) {
+		mds_resolution_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+				gfal_mds_cached_resolution_free);
+	}
+	g_hash_table_replace(mds_resolution_cache, g_strdup(key), cached);
+	pthread_mutex_unlock(&mds_cache_mutex);
+}
+
+/*
+ * get the connection for the given uri, locked
+ * it may not be connected yet
+ */
+static gfal_mds_ldap_connection *gfal_mds_ldap_get_connection(const char *uri)
+{
+	pthread_mutex_lock(&mds_cache_mutex);
+	if (!mds_connections) {
+		mds_connections = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+				gfal_mds_ldap_connection_free);
+	}
+	gfal_mds_ldap_connection *conn = g_hash_table_lookup(mds_connections, uri);
+	if (!conn) {
+		conn = g_new0(gfal_mds_ldap_connection, 1);
+		pthread_mutex_init(&conn->mutex, NULL);
+		g_hash_table_insert(mds_connections, g_strdup(uri), conn);
+	}
+	pthread_mutex_unlock(&mds_cache_mutex);
+
+	pthread_mutex_lock(&conn->mutex);
+	return conn;
+}
+
+/*
+ * run the query through the persistent connection to uri
+ * if the query fails, the connection may have been dropped by the server, so reconnect once
+ */
+static int gfal_mds_bdii_query(gfal2_context_t context, const char *uri, const char *filter,
+		gfal_mds_endpoint *endpoints, size_t s_endpoint, GError **err)
+{
+	int ret = -1;
+	int attempt;
+	GError *tmp_err = NULL;
+	gfal_mds_ldap_connection *conn = gfal_mds_ldap_get_connection(uri);
+
+	for (attempt = 0; attempt < 2; ++attempt) {
+		g_clear_error(&tmp_err);
+		if (conn->ld == NULL) {
+			conn->ld = gfal_mds_ldap_connect(context, uri, &tmp_err);
+			if (conn->ld == NULL)
+				break;
+		}
+
+		LDAPMessage *res = NULL;
+		int rc = gfal_mds_ldap_search(conn->ld, sbasedn, filter, tabattr, &res, &tmp_err);
+		if (rc == LDAP_SUCCESS) {
+			ret = gfal_mds_get_srm_types_endpoint(conn->ld, res, endpoints, s_endpoint, &tmp_err);
+			gfal_mds_ldap.ldap_msgfree(res);
+			break;
+		}
+		if (res)
+			gfal_mds_ldap.ldap_msgfree(res);
+
+		gfal2_log(G_LOG_LEVEL_DEBUG, " bdii query failed, drop the connection to %s", uri);
+		gfal_mds_ldap_disconnect(conn->ld);
+		conn->ld = NULL;
+	}
+
+	pthread_mutex_unlock(&conn->mutex);
+	if (tmp_err)
+		g_propagate_error(err, tmp_err);
+	return ret;
+}
+
 /*
  * resolve the SRM endpoint associated with a given base_url with the bdii
+ * resolutions are cached, and the connections to the bdii are kept open between calls
  * @param base_url : basic url to resolve
  * @param endpoints : table of gfal_mds_endpoint to set with a size of s_endpoint
  * @param s_endpoint : maximum number of endpoints to set
@@ -297,19 +492,27 @@ int gfal_mds_bdii_get_srm_endpoint(gfal2_context_t context, const char *base_url
 	int ret = -1;
 	GError *tmp_err = NULL;
 	char uri[GFAL_URL_MAX_LEN];
-	LDAP *ld;
 	gfal2_log(G_LOG_LEVEL_DEBUG, " gfal_mds_bdii_get_srm_endpoint ->");
 	if (gfal_mds_get_ldapuri(context, uri, GFAL_URL_MAX_LEN, &tmp_err) >= 0) {
-		if ((ld = gfal_mds_ldap_connect(context, uri, &tmp_err)) != NULL) {
-			LDAPMessage *res;
+		char *key = g_strconcat(uri, "|", base_url, NULL);
+
+		ret = gfal_mds_bdii_cache_lookup(key, endpoints, s_endpoint, &tmp_err);
+		if (ret >= -1) {
+			gfal2_log(G_LOG_LEVEL_DEBUG, " %s resolution found in the cache", base_url);
+		}
+		else {
+			gfal_mds_endpoint resolved[GFAL_MDS_MAX_SRM_ENDPOINT];
 			char buff_filter[GFAL_URL_MAX_LEN];
 			snprintf(buff_filter, GFAL_URL_MAX_LEN, srm_endpoint_filter, base_url, base_url); // construct the request
-			if (gfal_mds_ldap_search(ld, sbasedn, buff_filter, tabattr, &res, &tmp_err) >= 0) {
-				ret = gfal_mds_get_srm_types_endpoint(ld, res, endpoints, s_endpoint, &tmp_err);
-				gfal_mds_ldap.ldap_msgfree(res);
+
+			ret = gfal_mds_bdii_query(context, uri, buff_filter, resolved, GFAL_MDS_MAX_SRM_ENDPOINT, &tmp_err);
+			gfal_mds_bdii_cache_store(context, key, ret, resolved, tmp_err);
+			if (ret > 0) {
+				ret = MIN((size_t) ret, s_endpoint);
+				memcpy(endpoints, resolved, ret * sizeof(gfal_mds_endpoint));
 			}
-			gfal_mds_ldap_disconnect(ld);
 		}
+		g_free(key);
 	}
 
 	gfal2_log(G_LOG_LEVEL_DEBUG, " gfal_mds_bdii_get_srm_endpoint <-");
@@ -0,0 +1,707 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+#include <json.h>
+#include <zlib.h>
+#include <gfal_api.h>
+#include <common/gfal_handle.h>
+#include <common/gfal_plugin.h>
+#include <common/gfal_file_handler_container.h>
+#include <checksums/checksums.h>
+#include <uri/gfal2_uri.h>
+
+//
+// Reproducible micro and macro benchmarks of the gfal2 core, the file plugin and
+// the mock plugin. Each benchmark is run as a fixed number of samples of a fixed
+// number of operations, after one warm up sample, and reports operations per second,
+// p50/p99 latency per operation and bytes per second as JSON, so results from
+// different releases can be compared.
+// Benchmarks using the mock plugin are skipped if it can not be loaded.
+//
+// usage: gfal2-bench [-l] [-f pattern] [-s scale] [-S copy size in MiB] [-d workdir] [-o output.json]
+//
+
+#define BENCH_SEED 0x6fa12
+
+typedef struct {
+    gfal2_context_t context;
+    gfalt_params_t params;
+    char *workdir;
+    double scale;
+    size_t copy_size;
+    // Deterministic content, shared by the checksum kernels and the copies
+    char *buffer;
+    size_t buffer_size;
+    // Per benchmark state
+    void *state;
+} BenchEnv;
+
+typedef struct {
+    const char *name;
+    const char *group;
+    // Operations timed together as one sample, so cheap calls are not dominated by the clock
+    unsigned batch;
+    unsigned samples;
+    // Items (files, urls) processed by a single operation
+    unsigned items;
+    int (*setup)(BenchEnv *env, GError **err);
+    // Returns the number of bytes moved, or < 0 on error
+    gint64 (*op)(BenchEnv *env, GError **err);
+    void (*teardown)(BenchEnv *env);
+} BenchCase;
+
+
+static gint64 now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (gint64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+static int compare_double(const void *a, const void *b)
+{
+    double da = *(const double*)a, db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+
+// Nearest rank percentile over sorted values
+static double percentile(const double *sorted, unsigned n, double p)
+{
+    unsigned rank = (unsigned)ceil(p * n);
+    if (rank < 1)
+        rank = 1;
+    return sorted[rank - 1];
+}
+
+
+static int write_file(const char *path, const char *buffer, size_t buffer_size, size_t size, GError **err)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        g_set_error(err, g_quark_from_static_string("gfal2-bench"), errno, "Could not create %s: %s",
+            path, strerror(errno));
+        return -1;
+    }
+    size_t done = 0;
+    while (done < size) {
+        size_t chunk = MIN(buffer_size, size - done);
+        ssize_t ret = write(fd, buffer, chunk);
+        if (ret < 0) {
+            g_set_error(err, g_quark_from_static_string("gfal2-bench"), errno, "Could not write %s: %s",
+                path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        done += ret;
+    }
+    close(fd);
+    return 0;
+}
+
+
+static gboolean mock_available(BenchEnv *env, GError **err)
+{
+    return gfal_find_plugin(env->context, "mock://bench/probe", GFAL_PLUGIN_STAT, err) != NULL;
+}
+
+//
+// Plugin dispatch
+//
+
+static gint64 op_dispatch_file(BenchEnv *env, GError **err)
+{
+    return gfal_find_plugin(env->context, "file:///tmp/gfal2-bench", GFAL_PLUGIN_STAT, err) ? 0 : -1;
+}
+
+
+static int setup_mock(BenchEnv *env, GError **err)
+{
+    return mock_available(env, err) ? 0 : -1;
+}
+
+
+static gint64 op_dispatch_mock(BenchEnv *env, GError **err)
+{
+    return gfal_find_plugin(env->context, "mock://bench/path?size=1", GFAL_PLUGIN_STAT, err) ? 0 : -1;
+}
+
+//
+// File descriptor table
+//
+
+typedef struct {
+    gfal_file_handle fh;
+    int key;
+} FdState;
+
+
+static int setup_fd_bind(BenchEnv *env, GError **err)
+{
+    FdState *state = g_new0(FdState, 1);
+    state->fh = gfal_file_handle_new2("gfal2-bench", NULL, NULL, NULL);
+    state->key = gfal_add_new_file_desc(env->context->fdescs, state->fh, err);
+    env->state = state;
+    return state->key > 0 ? 0 : -1;
+}
+
+
+static gint64 op_fd_bind(BenchEnv *env, GError **err)
+{
+    FdState *state = env->state;
+    return gfal_file_handle_bind(env->context->fdescs, state->key, err) ? 0 : -1;
+}
+
+
+static void teardown_fd_bind(BenchEnv *env)
+{
+    FdState *state = env->state;
+    if (state->key > 0)
+        gfal_remove_file_desc(env->context->fdescs, state->key, NULL);
+    gfal_file_handle_delete(state->fh);
+    g_free(state);
+}
+
+//
+// URI parsing
+//
+
+static gint64 op_uri_parse(BenchEnv *env, GError **err)
+{
+    gfal2_uri *parsed = gfal2_parse_uri(
+        "davs://user@storage.example.org:8443/dpm/example.org/home/vo/file.root?checksum=adler32#frag", err);
+    if (!parsed)
+        return -1;
+    gfal2_free_uri(parsed);
+    return 0;
+}
+
+//
+// Configuration
+//
+
+static gint64 op_config_hit(BenchEnv *env, GError **err)
+{
+    gfal2_get_opt_integer_with_default(env->context, "CORE", "NAMESPACE_TIMEOUT", 300);
+    return 0;
+}
+
+
+static gint64 op_config_miss(BenchEnv *env, GError **err)
+{
+    gfal2_get_opt_integer_with_default(env->context, "GFAL2 BENCH", "MISSING", 42);
+    return 0;
+}
+
+//
+// Checksum kernels, over the shared buffer
+//
+
+static gint64 op_checksum_md5(BenchEnv *env, GError **err)
+{
+    GFAL_MD5_CTX ctx;
+    unsigned char digest[16];
+    gfal2_md5_init(&ctx);
+    gfal2_md5_update(&ctx, env->buffer, env->buffer_size);
+    gfal2_md5_final(digest, &ctx);
+    return env->buffer_size;
+}
+
+
+static gint64 op_checksum_adler32(BenchEnv *env, GError **err)
+{
+    adler32(adler32(0L, Z_NULL, 0), (const Bytef*)env->buffer, env->buffer_size);
+    return env->buffer_size;
+}
+
+
+static gint64 op_checksum_crc32(BenchEnv *env, GError **err)
+{
+    crc32(crc32(0L, Z_NULL, 0), (const Bytef*)env->buffer, env->buffer_size);
+    return env->buffer_size;
+}
+
+//
+// Copies, streamed by the core or native to the plugin
+//
+
+typedef struct {
+    char *src;
+    char *dst;
+    char *src_path;
+    char *dst_path;
+} CopyState;
+
+
+static void teardown_copy(BenchEnv *env)
+{
+    CopyState *state = env->state;
+    if (state->src_path)
+        unlink(state->src_path);
+    if (state->dst_path)
+        unlink(state->dst_path);
+    g_free(state->src);
+    g_free(state->dst);
+    g_free(state->src_path);
+    g_free(state->dst_path);
+    g_free(state);
+}
+
+
+static int setup_copy_file_file_mode(BenchEnv *env, gboolean native, GError **err)
+{
+    CopyState *state = g_new0(CopyState, 1);
+    env->state = state;
+    // With NATIVE_COPY, the file plugin copies by itself instead of the core streamed copy
+    gfal2_set_opt_boolean(env->context, "FILE PLUGIN", "NATIVE_COPY", native, NULL);
+    state->src_path = g_build_filename(env->workdir, "copy.src", NULL);
+    state->dst_path = g_build_filename(env->workdir, "copy.dst", NULL);
+    state->src = g_strconcat("file://", state->src_path, NULL);
+    state->dst = g_strconcat("file://", state->dst_path, NULL);
+    return write_file(state->src_path, env->buffer, env->buffer_size, env->copy_size, err);
+}
+
+
+static int setup_copy_file_file(BenchEnv *env, GError **err)
+{
+    return setup_copy_file_file_mode(env, FALSE, err);
+}
+
+
+static int setup_copy_file_file_native(BenchEnv *env, GError **err)
+{
+    return setup_copy_file_file_mode(env, TRUE, err);
+}
+
+
+static void teardown_copy_file_file(BenchEnv *env)
+{
+    gfal2_remove_opt(env->context, "FILE PLUGIN", "NATIVE_COPY", NULL);
+    teardown_copy(env);
+}
+
+
+static int setup_copy_mock_file(BenchEnv *env, GError **err)
+{
+    CopyState *state = g_new0(CopyState, 1);
+    env->state = state;
+    state->dst_path = g_build_filename(env->workdir, "copy.dst", NULL);
+    state->src = g_strdup_printf("mock://bench/copy.src?size=%zu&payload=pattern", env->copy_size);
+    state->dst = g_strconcat("file://", state->dst_path, NULL);
+    return mock_available(env, err) ? 0 : -1;
+}
+
+
+static gint64 op_copy(BenchEnv *env, GError **err)
+{
+    CopyState *state = env->state;
+    if (gfalt_copy_file(env->context, env->params, state->src, state->dst, err) < 0)
+        return -1;
+    return env->copy_size;
+}
+
+//
+// Bulk operations
+//
+
+#define BENCH_BULK_COPY_FILES 64
+#define BENCH_BULK_STAT_FILES 256
+
+typedef struct {
+    int nbfiles;
+    char **srcs;
+    char **dsts;
+    struct stat *stats;
+    GError **errors;
+    gboolean local;
+} BulkState;
+
+
+static BulkState *bulk_state_new(int nbfiles)
+{
+    BulkState *state = g_new0(BulkState, 1);
+    state->nbfiles = nbfiles;
+    state->srcs = g_new0(char*, nbfiles + 1);
+    state->dsts = g_new0(char*, nbfiles + 1);
+    state->stats = g_new0(struct stat, nbfiles);
+    state->errors = g_new0(GError*, nbfiles);
+    return state;
+}
+
+
+static void teardown_bulk(BenchEnv *env)
+{
+    BulkState *state = env->state;
+    int i;
+    for (i = 0; i < state->nbfiles; ++i) {
+        if (state->local)
+            unlink(state->srcs[i] + 7);
+        g_clear_error(&state->errors[i]);
+    }
+    g_strfreev(state->srcs);
+    g_strfreev(state->dsts);
+    g_free(state->stats);
+    g_free(state->errors);
+    g_free(state);
+}
+
+
+static int setup_bulk_copy(BenchEnv *env, GError **err)
+{
+    BulkState *state = bulk_state_new(BENCH_BULK_COPY_FILES);
+    env->state = state;
+    int i;
+    // No plugin implements bulk copies between mock urls, so this goes through the fallback
+    for (i = 0; i < state->nbfiles; ++i) {
+        state->srcs[i] = g_strdup_printf("mock://bench/bulk/src%04d?size=1048576", i);
+        state->dsts[i] = g_strdup_printf("mock://bench/bulk/dst%04d?time=0&size_pre=0&size_post=1048576", i);
+    }
+    return mock_available(env, err) ? 0 : -1;
+}
+
+
+static gint64 op_bulk_copy(BenchEnv *env, GError **err)
+{
+    BulkState *state = env->state;
+    GError **file_errors = NULL;
+    int i, ret;
+
+    ret = gfalt_copy_bulk(env->context, env->params, state->nbfiles,
+        (const char* const*)state->srcs, (const char* const*)state->dsts, NULL, err, &file_errors);
+    if (file_errors) {
+        for (i = 0; i < state->nbfiles; ++i) {
+            if (file_errors[i] && !*err)
+                g_propagate_error(err, file_errors[i]);
+            else
+                g_clear_error(&file_errors[i]);
+        }
+        g_free(file_errors);
+    }
+    return ret < 0 || *err ? -1 : 0;
+}
+
+
+static int setup_bulk_stat_mock(BenchEnv *env, GError **err)
+{
+    BulkState *state = bulk_state_new(BENCH_BULK_STAT_FILES);
+    env->state = state;
+    int i;
+    for (i = 0; i < state->nbfiles; ++i)
+        state->srcs[i] = g_strdup_printf("mock://bench/stat/file%04d?size=%d", i, i);
+    return mock_available(env, err) ? 0 : -1;
+}
+
+
+static int setup_bulk_stat_file(BenchEnv *env, GError **err)
+{
+    BulkState *state = bulk_state_new(BENCH_BULK_STAT_FILES);
+    env->state = state;
+    state->local = TRUE;
+    int i;
+    for (i = 0; i < state->nbfiles; ++i) {
+        state->srcs[i] = g_strdup_printf("file://%s/stat%04d", env->workdir, i);
+        if (write_file(state->srcs[i] + 7, env->buffer, env->buffer_size, i, err) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+
+static gint64 op_bulk_stat(BenchEnv *env, GError **err)
+{
+    BulkState *state = env->state;
+    int i;
+    int ret = gfal2_stat_list(env->context, state->nbfiles, (const char* const*)state->srcs,
+        state->stats, state->errors);
+    for (i = 0; i < state->nbfiles; ++i) {
+        if (state->errors[i]) {
+            g_propagate_error(err, state->errors[i]);
+            state->errors[i] = NULL;
+            return -1;
+        }
+    }
+    return ret < 0 ? -1 : 0;
+}
+
+
+static const BenchCase bench_cases[] = {
+    {"dispatch.file",          "micro", 10000, 100, 1, NULL, op_dispatch_file, NULL},
+    {"dispatch.mock",          "micro", 10000, 100, 1, setup_mock, op_dispatch_mock, NULL},
+    {"fd.bind",                "micro", 10000, 100, 1, setup_fd_bind, op_fd_bind, teardown_fd_bind},
+    {"uri.parse",              "micro", 1000,  100, 1, NULL, op_uri_parse, NULL},
+    {"config.hit",             "micro", 10000, 100, 1, NULL, op_config_hit, NULL},
+    {"config.miss",            "micro", 10000, 100, 1, NULL, op_config_miss, NULL},
+    {"checksum.md5",           "micro", 1,     256, 1, NULL, op_checksum_md5, NULL},
+    {"checksum.adler32",       "micro", 1,     256, 1, NULL, op_checksum_adler32, NULL},
+    {"checksum.crc32",         "micro", 1,     256, 1, NULL, op_checksum_crc32, NULL},
+    {"copy.file_to_file",      "macro", 1,     10,  1, setup_copy_file_file, op_copy, teardown_copy_file_file},
+    {"copy.file_native",       "macro", 1,     10,  1, setup_copy_file_file_native, op_copy, teardown_copy_file_file},
+    {"copy.mock_to_file",      "macro", 1,     10,  1, setup_copy_mock_file, op_copy, teardown_copy},
+    {"copy.bulk_fallback",     "macro", 1,     20,  BENCH_BULK_COPY_FILES, setup_bulk_copy, op_bulk_copy, teardown_bulk},
+    {"stat.bulk_mock",         "macro", 1,     50,  BENCH_BULK_STAT_FILES, setup_bulk_stat_mock, op_bulk_stat, teardown_bulk},
+    {"stat.bulk_file",         "macro", 1,     50,  BENCH_BULK_STAT_FILES, setup_bulk_stat_file, op_bulk_stat, teardown_bulk},
+};
+
+static const int bench_count = sizeof(bench_cases) / sizeof(bench_cases[0]);
+
+
+// Runs one sample of batch operations, returns the elapsed nanoseconds or -1
+static gint64 run_sample(BenchEnv *env, const BenchCase *bench, gint64 *bytes, GError **err)
+{
+    unsigned i;
+    const gint64 start = now_ns();
+    for (i = 0; i < bench->batch; ++i) {
+        gint64 ret = bench->op(env, err);
+        if (ret < 0)
+            return -1;
+        *bytes += ret;
+    }
+    return now_ns() - start;
+}
+
+
+static json_object *run_bench(BenchEnv *env, const BenchCase *bench)
+{
+    GError *error = NULL;
+    json_object *result = json_object_new_object();
+    json_object_object_add(result, "name", json_object_new_string(bench->name));
+    json_object_object_add(result, "group", json_object_new_string(bench->group));
+
+    env->state = NULL;
+    unsigned samples = MAX(1, (unsigned)(bench->samples * env->scale));
+    double *latencies = g_new0(double, samples);
+    gint64 bytes = 0, elapsed = 0;
+    unsigned i;
+
+    if (bench->setup && bench->setup(env, &error) < 0) {
+        json_object_object_add(result, "skipped", json_object_new_string(error->message));
+        goto done;
+    }
+
+    // Warm up caches, lazy plugin loading and the page cache
+    if (run_sample(env, bench, &bytes, &error) < 0)
+        goto done;
+    bytes = 0;
+
+    for (i = 0; i < samples; ++i) {
+        gint64 sample = run_sample(env, bench, &bytes, &error);
+        if (sample < 0)
+            goto done;
+        elapsed += sample;
+        latencies[i] = (double)sample / bench->batch;
+    }
+
+    qsort(latencies, samples, sizeof(double), compare_double);
+
+    const double seconds = elapsed / 1e9;
+    const gint64 ops = (gint64)samples * bench->batch;
+    json_object *latency = json_object_new_object();
+
+    json_object_object_add(result, "samples", json_object_new_int(samples));
+    json_object_object_add(result, "batch", json_object_new_int(bench->batch));
+    json_object_object_add(result, "operations", json_object_new_int64(ops));
+    json_object_object_add(result, "seconds", json_object_new_double(seconds));
+    json_object_object_add(result, "ops_per_sec", json_object_new_double(ops / seconds));
+    if (bench->items > 1)
+        json_object_object_add(result, "items_per_sec", json_object_new_double(ops * bench->items / seconds));
+    json_object_object_add(result, "bytes_per_sec", json_object_new_double(bytes / seconds));
+    json_object_object_add(latency, "min", json_object_new_double(latencies[0]));
+    json_object_object_add(latency, "p50", json_object_new_double(percentile(latencies, samples, 0.50)));
+    json_object_object_add(latency, "p99", json_object_new_double(percentile(latencies, samples, 0.99)));
+    json_object_object_add(latency, "max", json_object_new_double(latencies[samples - 1]));
+    json_object_object_add(result, "latency_ns", latency);
+
+done:
+    if (error) {
+        if (!json_object_object_get_ex(result, "skipped", NULL))
+            json_object_object_add(result, "error", json_object_new_string(error->message));
+        g_error_free(error);
+    }
+    if (bench->teardown && env->state)
+        bench->teardown(env);
+    g_free(latencies);
+    return result;
+}
+
+
+static json_object *describe_host(void)
+{
+    json_object *host = json_object_new_object();
+    struct utsname uts;
+    if (uname(&uts) == 0) {
+        json_object_object_add(host, "sysname", json_object_new_string(uts.sysname));
+        json_object_object_add(host, "release", json_object_new_string(uts.release));
+        json_object_object_add(host, "machine", json_object_new_string(uts.machine));
+    }
+    json_object_object_add(host, "cpus", json_object_new_int(sysconf(_SC_NPROCESSORS_ONLN)));
+    return host;
+}
+
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "usage: %s [-l] [-f pattern] [-s scale] [-S copy size in MiB] [-d workdir] [-o output.json]\n"
+        "\t-l\tlist the benchmarks and exit\n"
+        "\t-f\trun only the benchmarks matching this glob pattern (e.g. 'copy.*')\n"
+        "\t-s\tmultiply the number of samples (default 1.0)\n"
+        "\t-S\tsize of the files used for the copies (default 64)\n"
+        "\t-d\tdirectory for the local files (default: a temporary directory)\n"
+        "\t-o\twrite the report here instead of stdout\n", prog);
+}
+
+
+int main(int argc, char **argv)
+{
+    GError *error = NULL;
+    const char *pattern = NULL, *output = NULL, *workdir = NULL;
+    gboolean list = FALSE;
+    char *tmpdir = NULL;
+    int opt, i;
+
+    BenchEnv env;
+    memset(&env, 0, sizeof(env));
+    env.scale = 1.0;
+    env.copy_size = 64 * 1024 * 1024;
+    env.buffer_size = 1024 * 1024;
+
+    while ((opt = getopt(argc, argv, "lf:s:S:d:o:h")) != -1) {
+        switch (opt) {
+            case 'l':
+                list = TRUE;
+                break;
+            case 'f':
+                pattern = optarg;
+                break;
+            case 's':
+                env.scale = atof(optarg);
+                break;
+            case 'S':
+                env.copy_size = (size_t)atol(optarg) * 1024 * 1024;
+                break;
+            case 'd':
+                workdir = optarg;
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (list) {
+        for (i = 0; i < bench_count; ++i)
+            printf("%-24s %s\n", bench_cases[i].name, bench_cases[i].group);
+        return 0;
+    }
+
+    if (env.scale <= 0 || env.copy_size == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!workdir) {
+        tmpdir = g_build_filename(g_get_tmp_dir(), "gfal2-bench-XXXXXX", NULL);
+        if (!g_mkdtemp(tmpdir)) {
+            fprintf(stderr, "Could not create a temporary directory: %s\n", strerror(errno));
+            return 1;
+        }
+        workdir = tmpdir;
+    }
+    env.workdir = g_strdup(workdir);
+
+    // Same seed on every run: same data, and the same choices in the mock plugin
+    srand(BENCH_SEED);
+    GRand *generator = g_rand_new_with_seed(BENCH_SEED);
+    env.buffer = g_malloc(env.buffer_size);
+    for (i = 0; i < (int)(env.buffer_size / sizeof(guint32)); ++i)
+        ((guint32*)env.buffer)[i] = g_rand_int(generator);
+    g_rand_free(generator);
+
+    env.context = gfal2_context_new(&error);
+    if (!env.context) {
+        fprintf(stderr, "%s\n", error->message);
+        return 1;
+    }
+    env.params = gfalt_params_handle_new(NULL);
+    gfalt_set_replace_existing_file(env.params, TRUE, NULL);
+
+    json_object *report = json_object_new_object();
+    json_object *config = json_object_new_object();
+    json_object *results = json_object_new_array();
+
+    json_object_object_add(report, "gfal2_version", json_object_new_string(gfal2_version()));
+    json_object_object_add(report, "timestamp", json_object_new_int64(time(NULL)));
+    json_object_object_add(report, "host", describe_host());
+    json_object_object_add(config, "seed", json_object_new_int(BENCH_SEED));
+    json_object_object_add(config, "scale", json_object_new_double(env.scale));
+    json_object_object_add(config, "copy_size", json_object_new_int64(env.copy_size));
+    json_object_object_add(config, "checksum_buffer_size", json_object_new_int64(env.buffer_size));
+    if (pattern)
+        json_object_object_add(config, "filter", json_object_new_string(pattern));
+    json_object_object_add(report, "config", config);
+
+    for (i = 0; i < bench_count; ++i) {
+        if (pattern && !g_pattern_match_simple(pattern, bench_cases[i].name))
+            continue;
+        fprintf(stderr, "Running %s\n", bench_cases[i].name);
+        json_object_array_add(results, run_bench(&env, &bench_cases[i]));
+    }
+    json_object_object_add(report, "benchmarks", results);
+
+    const char *serialized = json_object_to_json_string_ext(report, JSON_C_TO_STRING_PRETTY);
+    int ret = 0;
+    if (output) {
+        FILE *fd = fopen(output, "w");
+        if (!fd) {
+            fprintf(stderr, "Could not open %s: %s\n", output, strerror(errno));
+            ret = 1;
+        }
+        else {
+            fprintf(fd, "%s\n", serialized);
+            fclose(fd);
+        }
+    }
+    else {
+        printf("%s\n", serialized);
+    }
+
+    json_object_put(report);
+    gfalt_params_handle_delete(env.params, NULL);
+    gfal2_context_free(env.context);
+    if (tmpdir)
+        rmdir(tmpdir);
+    g_free(tmpdir);
+    g_free(env.workdir);
+    g_free(env.buffer);
+    return ret;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gfal_api.h>
+
+//
+// Per-call cost of the hot path configuration getters, against a raw GKeyFile
+// lookup holding the same values: hits, and misses falling back to the default
+//
+// usage: gfal_config_lookup_bench [iterations]
+//
+
+typedef gint (*lookup_func)(gpointer data, const gchar *key);
+
+
+static gint context_lookup(gpointer data, const gchar *key)
+{
+    return gfal2_get_opt_integer_with_default((gfal2_context_t) data, "CORE", key, 42);
+}
+
+
+static gint keyfile_lookup(gpointer data, const gchar *key)
+{
+    GError *tmp_err = NULL;
+    gint value = g_key_file_get_integer((GKeyFile*) data, "CORE", key, &tmp_err);
+    if (tmp_err) {
+        g_clear_error(&tmp_err);
+        value = 42;
+    }
+    return value;
+}
+
+
+static double run(lookup_func func, gpointer data, const gchar *key, long iterations)
+{
+    long i;
+    gint64 sum = 0;
+    const gint64 start = g_get_monotonic_time();
+    for (i = 0; i < iterations; ++i)
+        sum += func(data, key);
+    const gint64 elapsed = g_get_monotonic_time() - start;
+    if (sum == 0)
+        printf(" ");
+    return (elapsed * 1000.0) / iterations;
+}
+
+
+int main(int argc, char **argv)
+{
+    long iterations = 1000000;
+    GError *error = NULL;
+    if (argc > 1)
+        iterations = atol(argv[1]);
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    gfal2_context_t context = gfal2_context_new(&error);
+    if (!context) {
+        fprintf(stderr, "%s\n", error->message);
+        return 1;
+    }
+    gfal2_set_opt_integer(context, "CORE", "COPY_BUFFERSIZE", 4194304, NULL);
+
+    GKeyFile *keyfile = g_key_file_new();
+    gsize n_keys = 0, i;
+    gchar **keys = gfal2_get_opt_keys(context, "CORE", &n_keys, NULL);
+    for (i = 0; i < n_keys; ++i) {
+        gchar *value = gfal2_get_opt_string(context, "CORE", keys[i], NULL);
+        g_key_file_set_string(keyfile, "CORE", keys[i], value);
+        g_free(value);
+    }
+    g_strfreev(keys);
+
+    printf("iterations:         %ld\n", iterations);
+    printf("hit  (ns per call): keyfile %.1f snapshot %.1f\n",
+        run(keyfile_lookup, keyfile, "COPY_BUFFERSIZE", iterations),
+        run(context_lookup, context, "COPY_BUFFERSIZE", iterations));
+    printf("miss (ns per call): keyfile %.1f snapshot %.1f\n",
+        run(keyfile_lookup, keyfile, "NOT_DEFINED", iterations),
+        run(context_lookup, context, "NOT_DEFINED", iterations));
+
+    g_key_file_free(keyfile);
+    gfal2_context_free(context);
+    return 0;
+}
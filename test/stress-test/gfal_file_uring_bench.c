@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <gfal_api.h>
+
+//
+// Throughput of the file plugin with plain syscalls, and with io_uring at
+// several queue depths: adler32 checksums (pipelined reads), and sequential
+// 1 MiB preads (one request at a time).
+// The file is evicted from the page cache before each run, so the device is measured.
+//
+// usage: gfal_file_uring_bench file:///path/to/big/file [runs]
+//
+
+static const int depths[] = {0, 1, 2, 4, 8, 16, 32};
+static const size_t block_size = 1024 * 1024;
+
+
+static void drop_cache(const char *url)
+{
+    int fd = open(url + 7, O_RDONLY);
+    if (fd >= 0) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+
+static double run_checksum(gfal2_context_t context, const char *url, GError **error)
+{
+    char checksum[64];
+    drop_cache(url);
+    const gint64 start = g_get_monotonic_time();
+    if (gfal2_checksum(context, url, "ADLER32", 0, 0, checksum, sizeof(checksum), error) < 0)
+        return -1;
+    return (g_get_monotonic_time() - start) / 1000000.0;
+}
+
+
+static double run_pread(gfal2_context_t context, const char *url, GError **error)
+{
+    char *buffer = g_malloc(block_size);
+    off_t offset = 0;
+    ssize_t ret;
+
+    drop_cache(url);
+    const gint64 start = g_get_monotonic_time();
+    int fd = gfal2_open(context, url, O_RDONLY, error);
+    if (fd < 0) {
+        g_free(buffer);
+        return -1;
+    }
+    while ((ret = gfal2_pread(context, fd, buffer, block_size, offset, error)) > 0)
+        offset += ret;
+    gfal2_close(context, fd, NULL);
+    g_free(buffer);
+    if (ret < 0)
+        return -1;
+    return (g_get_monotonic_time() - start) / 1000000.0;
+}
+
+
+int main(int argc, char **argv)
+{
+    GError *error = NULL;
+    int runs = 3, i, run;
+
+    if (argc < 2 || strncmp(argv[1], "file://", 7) != 0) {
+        fprintf(stderr, "usage: %s file:///path/to/big/file [runs]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2)
+        runs = atoi(argv[2]);
+
+    gfal2_context_t context = gfal2_context_new(&error);
+    if (!context) {
+        fprintf(stderr, "%s\n", error->message);
+        return 1;
+    }
+
+    struct stat st;
+    if (gfal2_stat(context, argv[1], &st, &error) < 0) {
+        fprintf(stderr, "%s\n", error->message);
+        return 1;
+    }
+    const double mbytes = st.st_size / (1024.0 * 1024.0);
+
+    printf("file: %s (%.1f MiB), best of %d runs\n", argv[1], mbytes, runs);
+    printf("%-10s %18s %18s\n", "backend", "checksum (MiB/s)", "pread (MiB/s)");
+
+    for (i = 0; i < (int)(sizeof(depths) / sizeof(depths[0])); ++i) {
+        double best_checksum = 0, best_pread = 0;
+
+        gfal2_set_opt_boolean(context, "FILE PLUGIN", "IO_URING", depths[i] > 0, NULL);
+        if (depths[i] > 0)
+            gfal2_set_opt_integer(context, "FILE PLUGIN", "IO_URING_QUEUE_DEPTH", depths[i], NULL);
+
+        for (run = 0; run < runs; ++run) {
+            double elapsed = run_checksum(context, argv[1], &error);
+            if (elapsed < 0)
+                break;
+            best_checksum = MAX(best_checksum, mbytes / elapsed);
+
+            elapsed = run_pread(context, argv[1], &error);
+            if (elapsed < 0)
+                break;
+            best_pread = MAX(best_pread, mbytes / elapsed);
+        }
+        if (error) {
+            fprintf(stderr, "%s\n", error->message);
+            return 1;
+        }
+
+        if (depths[i] == 0)
+            printf("%-10s %18.1f %18.1f\n", "syscalls", best_checksum, best_pread);
+        else
+            printf("uring qd%-2d %18.1f %18.1f\n", depths[i], best_checksum, best_pread);
+    }
+
+    gfal2_context_free(context);
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <gfal_api.h>
+
+//
+// Measures what a worker thread pays for its first POSIX call:
+// latency of the first call in each thread, total wall time, and resident memory growth
+//
+// usage: gfal_posix_thread_startup_bench [nthreads] [url]
+//
+
+static const char *bench_url = "file:///tmp";
+
+static long resident_kb()
+{
+    long size = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f) {
+        if (fscanf(f, "%ld %ld", &size, &resident) != 2)
+            resident = 0;
+        fclose(f);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+
+static void *worker(void *data)
+{
+    double *first_call = (double *) data;
+    gint64 start = g_get_monotonic_time();
+    if (gfal_access(bench_url, F_OK) < 0) {
+        char buff[1024];
+        fprintf(stderr, "%s\n", gfal_posix_strerror_r(buff, sizeof(buff)));
+    }
+    *first_call = (g_get_monotonic_time() - start) / 1000.0;
+    return NULL;
+}
+
+
+int main(int argc, char **argv)
+{
+    int nthreads = 16, i;
+    if (argc > 1)
+        nthreads = atoi(argv[1]);
+    if (argc > 2)
+        bench_url = argv[2];
+    if (nthreads <= 0) {
+        fprintf(stderr, "usage: %s [nthreads] [url]\n", argv[0]);
+        return 1;
+    }
+
+    pthread_t *threads = g_new0(pthread_t, nthreads);
+    double *first_call = g_new0(double, nthreads);
+
+    const long rss_before = resident_kb();
+    const gint64 start = g_get_monotonic_time();
+
+    for (i = 0; i < nthreads; ++i)
+        pthread_create(&threads[i], NULL, worker, &first_call[i]);
+    for (i = 0; i < nthreads; ++i)
+        pthread_join(threads[i], NULL);
+
+    const double wall = (g_get_monotonic_time() - start) / 1000.0;
+    const long rss_after = resident_kb();
+
+    double min = first_call[0], max = first_call[0], sum = 0;
+    for (i = 0; i < nthreads; ++i) {
+        min = MIN(min, first_call[i]);
+        max = MAX(max, first_call[i]);
+        sum += first_call[i];
+    }
+
+    printf("threads:            %d\n", nthreads);
+    printf("wall time:          %.2f ms\n", wall);
+    printf("first call (ms):    min %.2f avg %.2f max %.2f\n", min, sum / nthreads, max);
+    printf("resident growth:    %ld kB (%.1f kB per thread)\n",
+        rss_after - rss_before, (double) (rss_after - rss_before) / nthreads);
+
+    g_free(threads);
+    g_free(first_call);
+    return 0;
+}
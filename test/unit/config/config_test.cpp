@@ -22,6 +22,8 @@
 #include <gtest/gtest.h>
 #include <common/gfal_gtest_asserts.h>
 #include <utils/exceptions/gerror_to_cpp.h>
+#include <thread>
+#include <vector>
 
 
 class ConfigFixture: public testing::Test {
@@ -119,4 +121,130 @@ TEST_F(ConfigFixture, KeyList)
     EXPECT_EQ(NULL, keys[2]);
 
     g_strfreev(keys);
-}
\ No newline at end of file
+}
+
+TEST_F(ConfigFixture, GenerationChangesOnUpdate)
+{
+    GError *error = NULL;
+
+    gint generation = gfal2_get_opt_generation(context);
+    gfal2_set_opt_integer(context, "GROUP1", "KEY1", 1, &error);
+    EXPECT_NE(generation, gfal2_get_opt_generation(context));
+
+    generation = gfal2_get_opt_generation(context);
+    EXPECT_EQ(1, gfal2_get_opt_integer_with_default(context, "GROUP1", "KEY1", 0));
+    EXPECT_EQ(generation, gfal2_get_opt_generation(context));
+
+    gfal2_remove_opt(context, "GROUP1", "KEY1", &error);
+    g_clear_error(&error);
+    EXPECT_NE(generation, gfal2_get_opt_generation(context));
+}
+
+
+TEST_F(ConfigFixture, TypedValuesFollowUpdates)
+{
+    GError *error = NULL;
+
+    gfal2_set_opt_string(context, "GROUP1", "KEY1", "12", &error);
+    EXPECT_EQ(12, gfal2_get_opt_integer_with_default(context, "GROUP1", "KEY1", 0));
+    EXPECT_FALSE(gfal2_get_opt_boolean_with_default(context, "GROUP1", "KEY1", FALSE));
+
+    gfal2_set_opt_string(context, "GROUP1", "KEY1", "true", &error);
+    EXPECT_EQ(5, gfal2_get_opt_integer_with_default(context, "GROUP1", "KEY1", 5));
+    EXPECT_TRUE(gfal2_get_opt_boolean_with_default(context, "GROUP1", "KEY1", FALSE));
+
+    gfal2_get_opt_integer(context, "GROUP1", "KEY1", &error);
+    EXPECT_NE((void*)NULL, error);
+    g_clear_error(&error);
+
+    gfal2_remove_opt(context, "GROUP1", "KEY1", &error);
+    EXPECT_EQ(7, gfal2_get_opt_integer_with_default(context, "GROUP1", "KEY1", 7));
+    gchar *value = gfal2_get_opt_string(context, "GROUP1", "KEY1", &error);
+    EXPECT_EQ(NULL, value);
+    EXPECT_NE((void*)NULL, error);
+    g_clear_error(&error);
+}
+
+
+// Getters running while the configuration changes always see a consistent value
+TEST_F(ConfigFixture, ConcurrentReadersAndWriter)
+{
+    gfal2_set_opt_integer(context, "GROUP1", "KEY1", 1, NULL);
+
+    std::vector<std::thread> readers;
+    std::vector<int> bad(4, 0);
+    for (size_t i = 0; i < bad.size(); ++i) {
+        readers.push_back(std::thread([this, &bad, i]() {
+            for (int j = 0; j < 20000; ++j) {
+                gint value = gfal2_get_opt_integer_with_default(context, "GROUP1", "KEY1", -1);
+                if (value < 1 || value > 500) {
+                    ++bad[i];
+                }
+            }
+        }));
+    }
+    for (int value = 1; value <= 500; ++value) {
+        gfal2_set_opt_integer(context, "GROUP1", "KEY1", value, NULL);
+    }
+    for (size_t i = 0; i < readers.size(); ++i) {
+        readers[i].join();
+        EXPECT_EQ(0, bad[i]);
+    }
+
+    EXPECT_EQ(500, gfal2_get_opt_integer_with_default(context, "GROUP1", "KEY1", -1));
+}
+
+
+// String lists and key lists are served from the snapshot too, while it is being replaced
+TEST_F(ConfigFixture, ConcurrentListReadersAndWriter)
+{
+    const gchar *const first[] = {"a", "b"};
+    const gchar *const second[] = {"c", "d", "e"};
+    gfal2_set_opt_string_list(context, "GROUP1", "LIST", first, 2, NULL);
+
+    std::vector<std::thread> readers;
+    std::vector<int> bad(4, 0);
+    for (size_t i = 0; i < bad.size(); ++i) {
+        readers.push_back(std::thread([this, &bad, i]() {
+            for (int j = 0; j < 20000; ++j) {
+                gsize length = 0;
+                gchar **list = gfal2_get_opt_string_list(context, "GROUP1", "LIST", &length, NULL);
+                if (list == NULL || length != g_strv_length(list) || (length != 2 && length != 3)) {
+                    ++bad[i];
+                }
+                g_strfreev(list);
+
+                gchar **keys = gfal2_get_opt_keys(context, "GROUP1", &length, NULL);
+                if (keys == NULL || length != 1 || g_strcmp0(keys[0], "LIST") != 0) {
+                    ++bad[i];
+                }
+                g_strfreev(keys);
+            }
+        }));
+    }
+    for (int n = 0; n < 500; ++n) {
+        if (n % 2) {
+            gfal2_set_opt_string_list(context, "GROUP1", "LIST", first, 2, NULL);
+        }
+        else {
+            gfal2_set_opt_string_list(context, "GROUP1", "LIST", second, 3, NULL);
+        }
+    }
+    for (size_t i = 0; i < readers.size(); ++i) {
+        readers[i].join();
+        EXPECT_EQ(0, bad[i]);
+    }
+
+    gsize length = 0;
+    gchar **list = gfal2_get_opt_string_list(context, "GROUP1", "LIST", &length, NULL);
+    ASSERT_NE((void*)NULL, list);
+    EXPECT_EQ(2, length);
+    EXPECT_STREQ("a", list[0]);
+    g_strfreev(list);
+
+    GError *error = NULL;
+    gchar **keys = gfal2_get_opt_keys(context, "MISSING", &length, &error);
+    EXPECT_EQ(NULL, keys);
+    EXPECT_NE((void*)NULL, error);
+    g_clear_error(&error);
+}
@@ -16,6 +16,7 @@
 
 #include <gfal_api.h>
 #include <gtest/gtest.h>
+#include <string>
 #include "common/gfal_gtest_asserts.h"
 
 class CredTest: public testing::Test {
@@ -258,3 +259,111 @@ TEST_F(CredTest, set_get_prefix)
     ASSERT_EQ(resp, (void*) NULL);
     ASSERT_STREQ("", baseurl);
 }
+
+static void collect_prefix(const char* url_prefix, const gfal2_cred_t* cred, void* user_data)
+{
+    std::string* collected = static_cast<std::string*>(user_data);
+    *collected += std::string(url_prefix) + ":" + cred->type + ";";
+}
+
+static gboolean collect_match(const char* url_prefix, const gfal2_cred_t* cred, void* user_data)
+{
+    std::string* collected = static_cast<std::string*>(user_data);
+    *collected += std::string(url_prefix) + ";";
+    return FALSE;
+}
+
+TEST_F(CredTest, foreach_order)
+{
+    GError* error = NULL;
+    gfal2_cred_set(context, "https://host.com/path", token, &error);
+    gfal2_cred_set(context, "https://host.com/path/sub", token, &error);
+    gfal2_cred_set(context, "https://host.com/pathological", token, &error);
+    gfal2_cred_set(context, "https://host.com/path", x509, &error);
+    gfal2_cred_set(context, "gsiftp://host.com/path", x509, &error);
+
+    std::string collected;
+    gfal2_cred_foreach(context, collect_prefix, &collected);
+    ASSERT_EQ("https://host.com/pathological:BEARER;"
+              "https://host.com/path/sub:BEARER;"
+              "https://host.com/path:BEARER;"
+              "https://host.com/path:X509_CERT;"
+              "gsiftp://host.com/path:X509_CERT;", collected);
+}
+
+TEST_F(CredTest, foreach_match)
+{
+    GError* error = NULL;
+    gfal2_cred_set(context, "https://host.com", token, &error);
+    gfal2_cred_set(context, "https://host.com/path", token, &error);
+    gfal2_cred_set(context, "https://host.com/path/sub/file", token, &error);
+    gfal2_cred_set(context, "https://host.com/path/subdir", token, &error);
+    gfal2_cred_set(context, "https://host.com/pathological", token, &error);
+    gfal2_cred_set(context, "https://host.com/path/sub", x509, &error);
+
+    std::string collected;
+    gfal2_cred_foreach_match(context, GFAL_CRED_BEARER, "https://host.com/path/sub", FALSE,
+        collect_match, &collected);
+    ASSERT_EQ("https://host.com/path;https://host.com;", collected);
+
+    collected.clear();
+    gfal2_cred_foreach_match(context, GFAL_CRED_BEARER, "https://host.com/path/sub", TRUE,
+        collect_match, &collected);
+    ASSERT_EQ("https://host.com/path/sub/file;https://host.com/path;https://host.com;", collected);
+}
+
+struct RenewData {
+    gfal2_context_t context;
+    int count;
+};
+
+static gboolean renew_match(const char* url_prefix, const gfal2_cred_t* cred, void* user_data)
+{
+    RenewData* data = static_cast<RenewData*>(user_data);
+    gfal2_cred_t* renewed = gfal2_cred_new(cred->type, "renewed");
+    gfal2_cred_set(data->context, url_prefix, renewed, NULL);
+    gfal2_cred_free(renewed);
+    ++data->count;
+    return FALSE;
+}
+
+// Callbacks can change the mapping they are iterating
+TEST_F(CredTest, foreach_match_reentrant)
+{
+    GError* error = NULL;
+    gfal2_cred_set(context, "https://host.com", token, &error);
+    gfal2_cred_set(context, "https://host.com/path", token, &error);
+
+    RenewData data = {context, 0};
+    gfal2_cred_foreach_match(context, GFAL_CRED_BEARER, "https://host.com/path/file", TRUE,
+        renew_match, &data);
+    ASSERT_EQ(2, data.count);
+
+    char* resp = gfal2_cred_get(context, GFAL_CRED_BEARER, "https://host.com/path/file", NULL, &error);
+    ASSERT_STREQ("renewed", resp);
+    g_free(resp);
+}
+
+TEST_F(CredTest, many_prefixes)
+{
+    GError* error = NULL;
+    char prefix[128], url[128];
+
+    for (int i = 0; i < 2000; ++i) {
+        snprintf(prefix, sizeof(prefix), "https://host.com/data/%d", i);
+        gfal2_cred_t* cred = gfal2_cred_new(GFAL_CRED_BEARER, prefix);
+        gfal2_cred_set(context, prefix, cred, &error);
+        gfal2_cred_free(cred);
+    }
+
+    for (int i = 0; i < 2000; i += 7) {
+        snprintf(url, sizeof(url), "https://host.com/data/%d/file", i);
+        snprintf(prefix, sizeof(prefix), "https://host.com/data/%d", i);
+        char* resp = gfal2_cred_get(context, GFAL_CRED_BEARER, url, NULL, &error);
+        ASSERT_STREQ(prefix, resp);
+        g_free(resp);
+    }
+
+    char* resp = gfal2_cred_get(context, GFAL_CRED_BEARER, "https://host.com/data/12345/file", NULL, &error);
+    ASSERT_EQ(NULL, resp);
+}
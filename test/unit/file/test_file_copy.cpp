@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <gfal_api.h>
+#include <gtest/gtest.h>
+#include <common/gfal_gtest_asserts.h>
+#include <utils/exceptions/gerror_to_cpp.h>
+
+extern "C" {
+#include "plugins/file/gfal_file_plugin.h"
+}
+
+
+static int clone_calls, copy_range_calls, sendfile_calls;
+
+
+static int mock_clone_unsupported(int fd_dst, int fd_src)
+{
+    ++clone_calls;
+    errno = EOPNOTSUPP;
+    return -1;
+}
+
+
+static ssize_t mock_copy_range_exdev(int fd_in, off_t *off_in, int fd_out, size_t len)
+{
+    ++copy_range_calls;
+    errno = EXDEV;
+    return -1;
+}
+
+
+static ssize_t mock_sendfile_unsupported(int fd_out, int fd_in, off_t *offset, size_t len)
+{
+    ++sendfile_calls;
+    errno = EINVAL;
+    return -1;
+}
+
+
+// Copies a few bytes, then fails as if the destination filesystem changed
+static ssize_t mock_copy_range_partial(int fd_in, off_t *off_in, int fd_out, size_t len)
+{
+    if (copy_range_calls++ > 0) {
+        errno = EXDEV;
+        return -1;
+    }
+    char buffer[16];
+    ssize_t n = pread(fd_in, buffer, sizeof(buffer), *off_in);
+    if (n > 0) {
+        n = write(fd_out, buffer, n);
+        *off_in += n;
+    }
+    return n;
+}
+
+
+class FileCopyTest: public testing::Test {
+public:
+    FileCopyTest() {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        Gfal::gerror_to_cpp(&error);
+        params = gfalt_params_handle_new(&error);
+        Gfal::gerror_to_cpp(&error);
+        gfalt_set_replace_existing_file(params, TRUE, NULL);
+    }
+
+    virtual ~FileCopyTest() {
+        gfalt_params_handle_delete(params, NULL);
+        gfal2_context_free(context);
+    }
+
+    virtual void SetUp() {
+        syscalls_backup = gfal_file_copy_syscalls;
+        clone_calls = copy_range_calls = sendfile_calls = 0;
+
+        char dir_template[] = "/tmp/gfal2-file-copy-XXXXXX";
+        ASSERT_NE((char*) NULL, mkdtemp(dir_template));
+        dir = dir_template;
+        src_path = dir + "/src";
+        dst_path = dir + "/dst";
+        src = "file://" + src_path;
+        dst = "file://" + dst_path;
+
+        content.clear();
+        for (int i = 0; i < 100000; ++i)
+            content.push_back('a' + i % 26);
+        write_file(src_path, content);
+    }
+
+    virtual void TearDown() {
+        gfal_file_copy_syscalls = syscalls_backup;
+        unlink(src_path.c_str());
+        unlink(dst_path.c_str());
+        rmdir(dir.c_str());
+    }
+
+protected:
+    gfal2_context_t context;
+    gfalt_params_t params;
+    struct _gfal_file_copy_syscalls syscalls_backup;
+    std::string dir, src_path, dst_path, src, dst, content;
+
+    static void write_file(const std::string &path, const std::string &data) {
+        FILE *f = fopen(path.c_str(), "w");
+        ASSERT_NE((FILE*) NULL, f);
+        ASSERT_EQ(data.size(), fwrite(data.data(), 1, data.size(), f));
+        fclose(f);
+    }
+
+    static std::string read_file(const std::string &path) {
+        std::string data;
+        char buffer[4096];
+        size_t n;
+        FILE *f = fopen(path.c_str(), "r");
+        if (f == NULL)
+            return data;
+        while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+            data.append(buffer, n);
+        fclose(f);
+        return data;
+    }
+
+    int copy(GError **error) {
+        return gfal_plugin_file_copy(NULL, context, params, src.c_str(), dst.c_str(), error);
+    }
+};
+
+
+TEST_F(FileCopyTest, NativeCopy)
+{
+    GError *error = NULL;
+    // Longer than the source, so a left over tail would show
+    write_file(dst_path, content + content);
+
+    int ret = copy(&error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    EXPECT_EQ(content, read_file(dst_path));
+}
+
+
+TEST_F(FileCopyTest, FallbackToSendfile)
+{
+    GError *error = NULL;
+    gfal_file_copy_syscalls.clone = mock_clone_unsupported;
+    gfal_file_copy_syscalls.copy_range = mock_copy_range_exdev;
+
+    int ret = copy(&error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    EXPECT_EQ(content, read_file(dst_path));
+    EXPECT_EQ(1, clone_calls);
+    EXPECT_EQ(1, copy_range_calls);
+}
+
+
+TEST_F(FileCopyTest, FallbackToReadWrite)
+{
+    GError *error = NULL;
+    gfal_file_copy_syscalls.clone = mock_clone_unsupported;
+    gfal_file_copy_syscalls.copy_range = mock_copy_range_exdev;
+    gfal_file_copy_syscalls.sendfile = mock_sendfile_unsupported;
+
+    int ret = copy(&error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    EXPECT_EQ(content, read_file(dst_path));
+    EXPECT_EQ(1, copy_range_calls);
+    EXPECT_EQ(1, sendfile_calls);
+}
+
+
+// Without a reflink, copy_file_range is the first method tried
+TEST_F(FileCopyTest, ReflinkDisabled)
+{
+    GError *error = NULL;
+    gfal2_set_opt_boolean(context, "FILE PLUGIN", "COPY_REFLINK", FALSE, NULL);
+    gfal_file_copy_syscalls.clone = mock_clone_unsupported;
+    gfal_file_copy_syscalls.copy_range = mock_copy_range_exdev;
+
+    int ret = copy(&error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    EXPECT_EQ(content, read_file(dst_path));
+    EXPECT_EQ(0, clone_calls);
+    EXPECT_EQ(1, copy_range_calls);
+}
+
+
+// Once something was written, a failing method is an error, not a fallback
+TEST_F(FileCopyTest, NoFallbackHalfway)
+{
+    GError *error = NULL;
+    gfal_file_copy_syscalls.clone = mock_clone_unsupported;
+    gfal_file_copy_syscalls.copy_range = mock_copy_range_partial;
+    gfal_file_copy_syscalls.sendfile = mock_sendfile_unsupported;
+
+    int ret = copy(&error);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, EXDEV);
+    EXPECT_EQ(0, sendfile_calls);
+}
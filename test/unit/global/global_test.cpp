@@ -22,6 +22,14 @@
 #include <gfal_plugins_api.h>
 #include <utils/uri/gfal2_uri.h>
 #include <gtest/gtest.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
 
 
 TEST(gfalGlobal, testVerbose)
@@ -100,3 +108,451 @@ TEST(gfalGlobal, registerPlugin)
 
     gfal2_context_free(c);
 }
+
+
+TEST(gfalGlobal, operationStats)
+{
+    GError *tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_NE((void *) NULL, c);
+
+    gfal_plugin_interface test_plugin;
+    memset(&test_plugin, 0, sizeof(test_plugin));
+
+    test_plugin.getName = test_plugin_get_name;
+    test_plugin.check_plugin_url = test_plugin_url;
+    test_plugin.statG = test_plugin_stat;
+
+    int ret = gfal2_register_plugin(c, &test_plugin, &tmp_err);
+    ASSERT_EQ(0, ret);
+    gfal2_reset_stats(c);
+
+    struct stat st;
+    for (int i = 0; i < 3; ++i) {
+        ret = gfal2_stat(c, "test://blah", &st, &tmp_err);
+        ASSERT_EQ(0, ret);
+    }
+    ret = gfal2_stat(c, "unknown://blah", &st, &tmp_err);
+    ASSERT_NE(0, ret);
+    g_clear_error(&tmp_err);
+
+    gfal2_stats_t stats = gfal2_get_stats(c, &tmp_err);
+    ASSERT_NE((void *) NULL, stats);
+    ASSERT_EQ(2, gfal2_stats_size(stats));
+
+    // Sorted by plugin name
+    const gfal2_op_stats_t *entry = gfal2_stats_get(stats, 0);
+    ASSERT_STREQ("TEST PLUGIN", entry->plugin);
+    ASSERT_STREQ("stat", entry->operation);
+    ASSERT_EQ(3, entry->calls);
+    ASSERT_EQ(0, entry->errors);
+    ASSERT_LE(gfal2_stats_get_latency_percentile(stats, 0, 0.5), entry->latency_max_ns);
+
+    entry = gfal2_stats_get(stats, 1);
+    ASSERT_STREQ("none", entry->plugin);
+    ASSERT_EQ(1, entry->calls);
+    ASSERT_EQ(1, entry->errors);
+    ASSERT_EQ(1, gfal2_stats_get_error_count(stats, 1, EPROTONOSUPPORT));
+
+    ASSERT_EQ(NULL, gfal2_stats_get(stats, 2));
+
+    gchar *json = gfal2_stats_to_json(stats);
+    ASSERT_NE((void *) NULL, strstr(json, "\"TEST PLUGIN\""));
+    g_free(json);
+
+    gchar *prometheus = gfal2_stats_to_prometheus(stats);
+    ASSERT_NE((void *) NULL, strstr(prometheus, "gfal2_operations_total"));
+    g_free(prometheus);
+
+    gfal2_stats_free(stats);
+
+    gfal2_reset_stats(c);
+    stats = gfal2_get_stats(c, &tmp_err);
+    ASSERT_EQ(0, gfal2_stats_size(stats));
+    gfal2_stats_free(stats);
+
+    gfal2_context_free(c);
+}
+
+
+static void counting_log_handler(const gchar *log_domain, GLogLevelFlags log_level,
+    const gchar *message, gpointer user_data)
+{
+    std::vector<std::string> *messages = static_cast<std::vector<std::string>*>(user_data);
+    messages->push_back(message);
+}
+
+
+static gpointer async_log_thread(gpointer data)
+{
+    for (int i = 0; i < 100; ++i)
+        gfal2_log(G_LOG_LEVEL_MESSAGE, "thread %d", i);
+    return NULL;
+}
+
+
+TEST(gfalGlobal, asyncLog)
+{
+    std::vector<std::string> messages;
+    GLogLevelFlags previous_level = gfal2_log_get_level();
+    gfal2_log_set_level(G_LOG_LEVEL_MESSAGE);
+    guint handler = gfal2_log_set_handler(counting_log_handler, &messages);
+
+    ASSERT_EQ(0, gfal2_log_set_async(TRUE, NULL));
+    for (int i = 0; i < 100; ++i)
+        gfal2_log(G_LOG_LEVEL_MESSAGE, "main %d", i);
+    GThread *thread = g_thread_create(async_log_thread, NULL, TRUE, NULL);
+    g_thread_join(thread);
+    // Below the level, never formatted nor delivered
+    gfal2_log(G_LOG_LEVEL_DEBUG, "debug %d", 0);
+    ASSERT_EQ(0, gfal2_log_set_async(FALSE, NULL));
+
+    ASSERT_EQ(200, messages.size());
+    int main_next = 0, thread_next = 0;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        if (messages[i].compare(0, 5, "main ") == 0)
+            ASSERT_EQ(main_next++, atoi(messages[i].c_str() + 5));
+        else
+            ASSERT_EQ(thread_next++, atoi(messages[i].c_str() + 7));
+    }
+
+    // Synchronous again
+    messages.clear();
+    gfal2_log(G_LOG_LEVEL_MESSAGE, "sync");
+    ASSERT_EQ(1, messages.size());
+
+    g_log_remove_handler("GFAL2", handler);
+    gfal2_log_set_level(previous_level);
+}
+
+
+TEST(gfalGlobal, logRateLimit)
+{
+    std::vector<std::string> messages;
+    GLogLevelFlags previous_level = gfal2_log_get_level();
+    gfal2_log_set_level(G_LOG_LEVEL_MESSAGE);
+    guint handler = gfal2_log_set_handler(counting_log_handler, &messages);
+
+    gfal2_log_set_rate_limit(5);
+    for (int i = 0; i < 20; ++i)
+        gfal2_log(G_LOG_LEVEL_MESSAGE, "repeated %d", i);
+    gfal2_log(G_LOG_LEVEL_MESSAGE, "other");
+    gfal2_log_set_rate_limit(0);
+
+    int repeated = 0, other = 0;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        repeated += (messages[i].compare(0, 9, "repeated ") == 0);
+        other += (messages[i] == "other");
+    }
+    ASSERT_EQ(5, repeated);
+    ASSERT_EQ(1, other);
+    ASSERT_EQ("repeated 4", messages[4]);
+
+    g_log_remove_handler("GFAL2", handler);
+    gfal2_log_set_level(previous_level);
+}
+
+
+static gpointer rate_limited_log_thread(gpointer data)
+{
+    for (int i = 0; i < 20; ++i)
+        gfal2_log(G_LOG_LEVEL_MESSAGE, "exited %d", i);
+    return NULL;
+}
+
+
+// Suppressed messages are reported even if the thread does not log them again
+TEST(gfalGlobal, logRateLimitFlush)
+{
+    std::vector<std::string> messages;
+    GLogLevelFlags previous_level = gfal2_log_get_level();
+    gfal2_log_set_level(G_LOG_LEVEL_MESSAGE);
+    guint handler = gfal2_log_set_handler(counting_log_handler, &messages);
+
+    gfal2_log_set_rate_limit(5);
+
+    // The thread is gone, so no need to wait for the end of the second
+    GThread *thread = g_thread_create(rate_limited_log_thread, NULL, TRUE, NULL);
+    g_thread_join(thread);
+    gfal2_log_flush();
+    ASSERT_EQ(1, std::count(messages.begin(), messages.end(),
+        "15 messages suppressed by the rate limit: exited %d"));
+
+    for (int i = 0; i < 20; ++i)
+        gfal2_log(G_LOG_LEVEL_MESSAGE, "flushed %d", i);
+    // Still within the second
+    gfal2_log_flush();
+    ASSERT_EQ(0, std::count(messages.begin(), messages.end(),
+        "15 messages suppressed by the rate limit: flushed %d"));
+    usleep(1100000);
+    gfal2_log_flush();
+    ASSERT_EQ(1, std::count(messages.begin(), messages.end(),
+        "15 messages suppressed by the rate limit: flushed %d"));
+
+    gfal2_log_set_rate_limit(0);
+    g_log_remove_handler("GFAL2", handler);
+    gfal2_log_set_level(previous_level);
+}
+
+
+static std::string cache_test_content;
+static time_t cache_test_mtime = 0;
+static int cache_test_fetches = 0;
+
+
+static gboolean cache_test_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    return strncmp(url, "cached://", 9) == 0 &&
+        (operation == GFAL_PLUGIN_STAT || operation == GFAL_PLUGIN_OPEN);
+}
+
+
+static int cache_test_plugin_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    memset(buf, 0, sizeof(*buf));
+    buf->st_mode = S_IFREG | 0644;
+    buf->st_size = cache_test_content.size();
+    buf->st_mtime = cache_test_mtime;
+    return 0;
+}
+
+
+static gfal_file_handle cache_test_plugin_open(plugin_handle plugin_data, const char *url, int flag,
+    mode_t mode, GError **err)
+{
+    return gfal_file_handle_new(test_plugin_get_name(), NULL);
+}
+
+
+static ssize_t cache_test_plugin_pread(plugin_handle plugin_data, gfal_file_handle fd, void *buff,
+    size_t count, off_t offset, GError **err)
+{
+    ++cache_test_fetches;
+    if (offset >= (off_t)cache_test_content.size())
+        return 0;
+    size_t n = std::min(count, cache_test_content.size() - offset);
+    memcpy(buff, cache_test_content.data() + offset, n);
+    return n;
+}
+
+
+static int cache_test_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err)
+{
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+static gint64 cache_test_disk_usage = 0;
+
+static int cache_test_du(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+    if (flag == FTW_F && strstr(path, ".lock") == NULL)
+        cache_test_disk_usage += st->st_size;
+    return 0;
+}
+
+
+static int cache_test_rm(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+    return remove(path);
+}
+
+
+static std::string cache_test_read_all(gfal2_context_t c, const char *url, size_t chunk)
+{
+    GError *tmp_err = NULL;
+    int fd = gfal2_open(c, url, O_RDONLY, &tmp_err);
+    EXPECT_GT(fd, 0);
+
+    std::string content;
+    std::vector<char> buffer(chunk);
+    ssize_t ret;
+    while ((ret = gfal2_read(c, fd, buffer.data(), buffer.size(), &tmp_err)) > 0)
+        content.append(buffer.data(), ret);
+    EXPECT_EQ(0, ret);
+    EXPECT_EQ(NULL, tmp_err);
+
+    gfal2_close(c, fd, &tmp_err);
+    return content;
+}
+
+
+TEST(gfalGlobal, readCache)
+{
+    GError *tmp_err = NULL;
+    char cache_dir[] = "/tmp/gfal2-read-cache-XXXXXX";
+    ASSERT_NE((char*) NULL, mkdtemp(cache_dir));
+
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_NE((void *) NULL, c);
+    gfal2_set_opt_string(c, "CORE", "READ_CACHE_DIR", cache_dir, NULL);
+    gfal2_set_opt_integer(c, "CORE", "READ_CACHE_BLOCK_SIZE", 16, NULL);
+
+    gfal_plugin_interface test_plugin;
+    memset(&test_plugin, 0, sizeof(test_plugin));
+    test_plugin.getName = test_plugin_get_name;
+    test_plugin.check_plugin_url = cache_test_plugin_url;
+    test_plugin.statG = cache_test_plugin_stat;
+    test_plugin.openG = cache_test_plugin_open;
+    test_plugin.preadG = cache_test_plugin_pread;
+    test_plugin.closeG = cache_test_plugin_close;
+    ASSERT_EQ(0, gfal2_register_plugin(c, &test_plugin, &tmp_err));
+
+    cache_test_content.clear();
+    for (int i = 0; i < 100; ++i)
+        cache_test_content.push_back('a' + i % 26);
+    cache_test_mtime = 1000;
+
+    // Cold: one fetch per block
+    cache_test_fetches = 0;
+    ASSERT_EQ(cache_test_content, cache_test_read_all(c, "cached://host/file", 10));
+    ASSERT_EQ(7, cache_test_fetches);
+
+    // Warm: nothing is fetched
+    ASSERT_EQ(cache_test_content, cache_test_read_all(c, "cached://host/file", 33));
+    ASSERT_EQ(7, cache_test_fetches);
+
+    int fd = gfal2_open(c, "cached://host/file", O_RDONLY, &tmp_err);
+    ASSERT_GT(fd, 0);
+    char buffer[20];
+    ASSERT_EQ(20, gfal2_pread(c, fd, buffer, sizeof(buffer), 50, &tmp_err));
+    ASSERT_EQ(cache_test_content.substr(50, 20), std::string(buffer, 20));
+    ASSERT_EQ(90, gfal2_lseek(c, fd, -10, SEEK_END, &tmp_err));
+    ASSERT_EQ(10, gfal2_read(c, fd, buffer, sizeof(buffer), &tmp_err));
+    ASSERT_EQ(cache_test_content.substr(90), std::string(buffer, 10));
+    gfal2_close(c, fd, &tmp_err);
+    ASSERT_EQ(7, cache_test_fetches);
+
+    // Modified: fetched again
+    cache_test_content[0] = 'Z';
+    cache_test_mtime = 2000;
+    ASSERT_EQ(cache_test_content, cache_test_read_all(c, "cached://host/file", 100));
+    ASSERT_EQ(14, cache_test_fetches);
+
+    // Over the maximum size, least recently used blocks go away
+    gfal2_set_opt_integer(c, "CORE", "READ_CACHE_MAX_SIZE", 1, NULL);
+    gfal2_set_opt_integer(c, "CORE", "READ_CACHE_BLOCK_SIZE", 256 * 1024, NULL);
+    cache_test_content.assign(4 * 1024 * 1024, 'x');
+    ASSERT_EQ(cache_test_content, cache_test_read_all(c, "cached://host/big", 1024 * 1024));
+
+    cache_test_disk_usage = 0;
+    nftw(cache_dir, cache_test_du, 16, FTW_PHYS);
+    ASSERT_LE(cache_test_disk_usage, 1024 * 1024 + 256 * 1024);
+
+    gfal2_context_free(c);
+    nftw(cache_dir, cache_test_rm, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+
+// A cache directory writable by others is not used
+TEST(gfalGlobal, readCacheUnsafeDir)
+{
+    GError *tmp_err = NULL;
+    char cache_dir[] = "/tmp/gfal2-read-cache-XXXXXX";
+    ASSERT_NE((char*) NULL, mkdtemp(cache_dir));
+    char user_dir[64];
+    snprintf(user_dir, sizeof(user_dir), "%s/%u", cache_dir, (unsigned) geteuid());
+    ASSERT_EQ(0, mkdir(user_dir, 0700));
+    ASSERT_EQ(0, chmod(user_dir, 0777));
+
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_NE((void *) NULL, c);
+    gfal2_set_opt_string(c, "CORE", "READ_CACHE_DIR", cache_dir, NULL);
+    gfal2_set_opt_integer(c, "CORE", "READ_CACHE_BLOCK_SIZE", 16, NULL);
+
+    gfal_plugin_interface test_plugin;
+    memset(&test_plugin, 0, sizeof(test_plugin));
+    test_plugin.getName = test_plugin_get_name;
+    test_plugin.check_plugin_url = cache_test_plugin_url;
+    test_plugin.statG = cache_test_plugin_stat;
+    test_plugin.openG = cache_test_plugin_open;
+    test_plugin.preadG = cache_test_plugin_pread;
+    test_plugin.closeG = cache_test_plugin_close;
+    ASSERT_EQ(0, gfal2_register_plugin(c, &test_plugin, &tmp_err));
+
+    cache_test_content.assign(100, 'u');
+    cache_test_mtime = 1000;
+    cache_test_fetches = 0;
+    char buffer[100];
+    for (int i = 0; i < 2; ++i) {
+        int fd = gfal2_open(c, "cached://host/file", O_RDONLY, &tmp_err);
+        ASSERT_GT(fd, 0);
+        ASSERT_EQ(100, gfal2_pread(c, fd, buffer, sizeof(buffer), 0, &tmp_err));
+        gfal2_close(c, fd, &tmp_err);
+    }
+    // Straight to the plugin every time
+    ASSERT_EQ(2, cache_test_fetches);
+
+    // Nothing was written into the unsafe directory
+    cache_test_disk_usage = 0;
+    nftw(cache_dir, cache_test_du, 16, FTW_PHYS);
+    ASSERT_EQ(0, cache_test_disk_usage);
+
+    gfal2_context_free(c);
+    nftw(cache_dir, cache_test_rm, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+
+// With LAZY_PLUGIN_LOADING, the mock plugin is only loaded on first use,
+// and threads racing for it all find it
+TEST(gfalGlobal, lazyPluginLoading)
+{
+#ifdef GFAL2_TEST_PLUGIN_DIR
+    const std::string plugin_dir = GFAL2_TEST_PLUGIN_DIR;
+    if (access((plugin_dir + "/libgfal_plugin_mock.manifest").c_str(), R_OK) != 0) {
+        printf("Mock plugin not built, skipping\n");
+        return;
+    }
+
+    char config_dir[] = "/tmp/gfal2-lazy-XXXXXX";
+    ASSERT_NE((char*) NULL, mkdtemp(config_dir));
+    std::string config_file = std::string(config_dir) + "/lazy.conf";
+    FILE *fconfig = fopen(config_file.c_str(), "w");
+    ASSERT_NE((FILE*) NULL, fconfig);
+    fprintf(fconfig, "[CORE]\nLAZY_PLUGIN_LOADING=true\n");
+    fclose(fconfig);
+
+    GError *tmp_err = NULL;
+    setenv("GFAL_CONFIG_DIR", config_dir, 1);
+    setenv("GFAL_PLUGIN_DIR", plugin_dir.c_str(), 1);
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    unsetenv("GFAL_CONFIG_DIR");
+    unsetenv("GFAL_PLUGIN_DIR");
+    unlink(config_file.c_str());
+    rmdir(config_dir);
+    ASSERT_EQ(NULL, tmp_err);
+    ASSERT_NE((void *) NULL, c);
+
+    const int n_threads = 8;
+    long long sizes[n_threads];
+    std::vector<std::thread> threads;
+    for (int i = 0; i < n_threads; ++i) {
+        sizes[i] = -1;
+        threads.push_back(std::thread([c, &sizes, i]() {
+            GError *error = NULL;
+            struct stat st;
+            if (gfal2_stat(c, "mock://host/lazy?size=42", &st, &error) == 0)
+                sizes[i] = st.st_size;
+            g_clear_error(&error);
+        }));
+    }
+    for (int i = 0; i < n_threads; ++i) {
+        threads[i].join();
+        EXPECT_EQ(42, sizes[i]);
+    }
+
+    gchar **names = gfal2_get_plugin_names(c);
+    ASSERT_NE((gchar**) NULL, names);
+    int n_mock = 0;
+    for (gchar **name = names; *name != NULL; ++name) {
+        if (strncmp(*name, "mock", 4) == 0)
+            ++n_mock;
+    }
+    g_strfreev(names);
+    EXPECT_EQ(1, n_mock);
+
+    gfal2_context_free(c);
+#endif
+}
@@ -20,6 +20,10 @@
 
 #include <utils/mds/gfal_mds_internal.h>
 #include <gtest/gtest.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <fstream>
 
 
@@ -86,3 +90,161 @@ TEST_F(MdsTestFixture, test_cache_found)
     ASSERT_EQ(endpoints[0].type, SRMv2);
     ASSERT_STREQ(endpoints[0].url, "httpg://test.domain.com:8442/srm/managerv2");
 }
+
+
+TEST_F(MdsTestFixture, test_cache_reload_on_change)
+{
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+    int ret = gfal_mds_cache_resolve_endpoint(context, "test.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(ret, 1);
+
+    std::ofstream cache(MDS_CACHE_FILE, std::ios_base::out | std::ios_base::trunc);
+    cache
+        << "<?xml version=\"1.0\"?>" << std::endl
+        << "<entry>" << std::endl
+        << "    <endpoint>https://other.domain.com:443/webdav</endpoint>" << std::endl
+        << "    <type>webdav</type>" << std::endl
+        << "    <version>1.0</version>" << std::endl
+        << "</entry>" << std::endl;
+    cache.close();
+
+    ret = gfal_mds_cache_resolve_endpoint(context, "test.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(err, (void*)NULL);
+    ASSERT_EQ(ret, 0);
+
+    ret = gfal_mds_cache_resolve_endpoint(context, "OTHER.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(err, (void*)NULL);
+    ASSERT_EQ(ret, 1);
+    ASSERT_EQ(endpoints[0].type, WebDav);
+    ASSERT_STREQ(endpoints[0].url, "https://other.domain.com:443/webdav");
+}
+
+
+// Rewritten within the same second, with the same size
+TEST_F(MdsTestFixture, test_cache_reload_same_size)
+{
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+    int ret = gfal_mds_cache_resolve_endpoint(context, "test.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(ret, 1);
+
+    struct stat st;
+    ASSERT_EQ(stat(MDS_CACHE_FILE, &st), 0);
+
+    std::ofstream cache(MDS_CACHE_FILE, std::ios_base::out | std::ios_base::trunc);
+    cache
+        << "<?xml version=\"1.0\"?>" << std::endl
+        << "<entry>" << std::endl
+        << "    <endpoint>httpg://same.domain.com:8442/srm/managerv2</endpoint>" << std::endl
+        << "    <sitename>TEST-PROD</sitename>" << std::endl
+        << "    <type>SRM</type>" << std::endl
+        << "    <version>2.2.0</version>" << std::endl
+        << "</entry>" << std::endl;
+    cache.close();
+
+    struct timespec times[2];
+    times[0] = times[1] = st.st_mtim;
+    times[1].tv_nsec = (st.st_mtim.tv_nsec + 1) % 1000000000;
+    ASSERT_EQ(utimensat(AT_FDCWD, MDS_CACHE_FILE, times, 0), 0);
+
+    ret = gfal_mds_cache_resolve_endpoint(context, "same.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(err, (void*)NULL);
+    ASSERT_EQ(ret, 1);
+    ASSERT_STREQ(endpoints[0].url, "httpg://same.domain.com:8442/srm/managerv2");
+}
+
+
+TEST_F(MdsTestFixture, test_cache_snapshot)
+{
+    // Use a different cache file, so it is not already indexed by a previous test
+    const char *cache_file = "/tmp/mds_cache_snapshot.xml";
+    const char *snapshot = "/tmp/mds_cache.snapshot";
+    unlink(snapshot);
+
+    std::ofstream cache(cache_file, std::ios_base::out | std::ios_base::trunc);
+    cache
+        << "<?xml version=\"1.0\"?>" << std::endl
+        << "<entry>" << std::endl
+        << "    <endpoint>httpg://snapshot.domain.com:8446/srm/managerv2</endpoint>" << std::endl
+        << "    <type>SRM</type>" << std::endl
+        << "    <version>2.2.0</version>" << std::endl
+        << "</entry>" << std::endl;
+    cache.close();
+
+    gfal2_set_opt_string(context, "BDII", "CACHE_FILE", cache_file, NULL);
+    gfal2_set_opt_string(context, "BDII", "CACHE_SNAPSHOT", snapshot, NULL);
+
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+    int ret = gfal_mds_cache_resolve_endpoint(context, "snapshot.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(err, (void*)NULL);
+    ASSERT_EQ(ret, 1);
+    ASSERT_EQ(access(snapshot, R_OK), 0);
+    ASSERT_EQ(endpoints[0].type, SRMv2);
+    ASSERT_STREQ(endpoints[0].url, "httpg://snapshot.domain.com:8446/srm/managerv2");
+
+    unlink(snapshot);
+    unlink(cache_file);
+}
+
+
+TEST_F(MdsTestFixture, test_cache_snapshot_corrupted)
+{
+    const char *cache_file = "/tmp/mds_cache_corrupted.xml";
+    const char *snapshot = "/tmp/mds_cache_corrupted.snapshot";
+
+    std::ofstream cache(cache_file, std::ios_base::out | std::ios_base::trunc);
+    cache
+        << "<?xml version=\"1.0\"?>" << std::endl
+        << "<entry>" << std::endl
+        << "    <endpoint>httpg://corrupted.domain.com:8446/srm/managerv2</endpoint>" << std::endl
+        << "    <type>SRM</type>" << std::endl
+        << "    <version>2.2.0</version>" << std::endl
+        << "</entry>" << std::endl;
+    cache.close();
+
+    struct stat st;
+    ASSERT_EQ(stat(cache_file, &st), 0);
+
+    // A snapshot matching the cache file, with offsets pointing out of the file
+    struct {
+        char magic[8];
+        uint32_t version;
+        uint32_t count;
+        int64_t source_mtime;
+        int64_t source_mtime_nsec;
+        int64_t source_size;
+        uint64_t source_ino;
+        uint32_t host, url, type;
+        char strings[4];
+    } corrupted;
+    memset(&corrupted, 0, sizeof(corrupted));
+    memcpy(corrupted.magic, "GFALBDII", sizeof(corrupted.magic));
+    corrupted.version = 2;
+    corrupted.count = 1;
+    corrupted.source_mtime = st.st_mtim.tv_sec;
+    corrupted.source_mtime_nsec = st.st_mtim.tv_nsec;
+    corrupted.source_size = st.st_size;
+    corrupted.source_ino = st.st_ino;
+    corrupted.host = 0x7FFFFFFF;
+    corrupted.url = 0x7FFFFFFF;
+
+    std::ofstream out(snapshot, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+    out.write(reinterpret_cast<const char*>(&corrupted), sizeof(corrupted));
+    out.close();
+
+    gfal2_set_opt_string(context, "BDII", "CACHE_FILE", cache_file, NULL);
+    gfal2_set_opt_string(context, "BDII", "CACHE_SNAPSHOT", snapshot, NULL);
+
+    // Falls back to the XML file
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+    int ret = gfal_mds_cache_resolve_endpoint(context, "corrupted.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(err, (void*)NULL);
+    ASSERT_EQ(ret, 1);
+    ASSERT_STREQ(endpoints[0].url, "httpg://corrupted.domain.com:8446/srm/managerv2");
+
+    unlink(snapshot);
+    unlink(cache_file);
+}
@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Copyright (c) Members of the EMI Collaboration. 2010-2013
+ *  See  http://www.eu-emi.eu/partners for details on the copyright
+ *  holders.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <utils/mds/gfal_mds_internal.h>
+extern "C" {
+#include <utils/mds/gfal_mds_ldap_internal_layer.h>
+}
+#include <gtest/gtest.h>
+#include <errno.h>
+
+// Mocked ldap layer, answering with a single srm endpoint, or nothing
+static int n_initialize, n_search, n_unbind;
+static int search_failures;
+static bool has_entries;
+
+static LDAP* fake_ld = reinterpret_cast<LDAP*>(0x1);
+static LDAPMessage* fake_result = reinterpret_cast<LDAPMessage*>(0x2);
+static LDAPMessage* fake_entry = reinterpret_cast<LDAPMessage*>(0x3);
+
+static const char* attributes[] = {"GlueServiceVersion", "GlueServiceEndpoint", "GlueServiceType"};
+static const char* values[] = {"2.2.0", "httpg://mocked.domain.com:8446/srm/managerv2", "SRM"};
+static size_t attribute_index;
+
+static int mock_initialize(LDAP **ldp, const char *uri)
+{
+    ++n_initialize;
+    *ldp = fake_ld;
+    return LDAP_SUCCESS;
+}
+
+static int mock_sasl_bind_s(LDAP *ld, const char *dn, const char *mechanism, struct berval *cred,
+    LDAPControl *sctrls[], LDAPControl *cctrls[], struct berval **servercredp)
+{
+    return LDAP_SUCCESS;
+}
+
+static int mock_search_ext_s(LDAP *ld, LDAP_CONST char *base, int scope, LDAP_CONST char *filter,
+    char **attrs, int attrsonly, LDAPControl **serverctrls, LDAPControl **clientctrls,
+    struct timeval *timeout, int sizelimit, LDAPMessage **res)
+{
+    ++n_search;
+    if (search_failures > 0) {
+        --search_failures;
+        *res = NULL;
+        return LDAP_SERVER_DOWN;
+    }
+    *res = fake_result;
+    return LDAP_SUCCESS;
+}
+
+static int mock_unbind_ext_s(LDAP *ld, LDAPControl **serverctrls, LDAPControl **clientctrls)
+{
+    ++n_unbind;
+    return LDAP_SUCCESS;
+}
+
+static LDAPMessage* mock_first_entry(LDAP *ld, LDAPMessage *result)
+{
+    return fake_entry;
+}
+
+static LDAPMessage* mock_next_entry(LDAP *ld, LDAPMessage *entry)
+{
+    return NULL;
+}
+
+static int mock_count_entries(LDAP *ld, LDAPMessage *result)
+{
+    return has_entries ? 1 : 0;
+}
+
+static char* mock_first_attribute(LDAP *ld, LDAPMessage *entry, BerElement **berptr)
+{
+    *berptr = NULL;
+    attribute_index = 0;
+    return const_cast<char*>(attributes[attribute_index]);
+}
+
+static char* mock_next_attribute(LDAP *ld, LDAPMessage *entry, BerElement *ber)
+{
+    if (++attribute_index >= sizeof(attributes) / sizeof(attributes[0]))
+        return NULL;
+    return const_cast<char*>(attributes[attribute_index]);
+}
+
+static struct berval **mock_get_values_len(LDAP *ld, LDAPMessage *entry, const char *attr)
+{
+    static struct berval value;
+    static struct berval *vals[] = {&value, NULL};
+    value.bv_val = const_cast<char*>(values[attribute_index]);
+    value.bv_len = strlen(value.bv_val);
+    return vals;
+}
+
+static void mock_value_free_len(struct berval **vals)
+{
+}
+
+static void mock_memfree(void *p)
+{
+}
+
+static int mock_msgfree(LDAPMessage *msg)
+{
+    return 0;
+}
+
+static void mock_ber_free(BerElement *ber, int freebuf)
+{
+}
+
+static int mock_set_option(LDAP *ld, int option, const void *invalue)
+{
+    return LDAP_OPT_SUCCESS;
+}
+
+
+class MdsLdapTestFixture : public ::testing::Test {
+protected:
+    gfal2_context_t context;
+    struct _gfal_mds_ldap original;
+
+public:
+    MdsLdapTestFixture() {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        assert(context != NULL);
+
+        gfal2_set_opt_string(context, "BDII", "LCG_GFAL_INFOSYS", "mocked.bdii:2170", NULL);
+        unsetenv("LCG_GFAL_INFOSYS");
+    }
+
+    ~MdsLdapTestFixture() {
+        gfal2_context_free(context);
+    }
+
+    virtual void SetUp() {
+        original = gfal_mds_ldap;
+        gfal_mds_ldap.ldap_initialize = mock_initialize;
+        gfal_mds_ldap.ldap_sasl_bind_s = mock_sasl_bind_s;
+        gfal_mds_ldap.ldap_search_ext_s = mock_search_ext_s;
+        gfal_mds_ldap.ldap_unbind_ext_s = mock_unbind_ext_s;
+        gfal_mds_ldap.ldap_first_entry = mock_first_entry;
+        gfal_mds_ldap.ldap_next_entry = mock_next_entry;
+        gfal_mds_ldap.ldap_count_entries = mock_count_entries;
+        gfal_mds_ldap.ldap_first_attribute = mock_first_attribute;
+        gfal_mds_ldap.ldap_next_attribute = mock_next_attribute;
+        gfal_mds_ldap.ldap_get_values_len = mock_get_values_len;
+        gfal_mds_ldap.ldap_value_free_len = mock_value_free_len;
+        gfal_mds_ldap.ldap_memfree = mock_memfree;
+        gfal_mds_ldap.ldap_msgfree = mock_msgfree;
+        gfal_mds_ldap.ber_free = mock_ber_free;
+        gfal_mds_ldap.ldap_set_option = mock_set_option;
+
+        n_initialize = n_search = n_unbind = 0;
+        search_failures = 0;
+        has_entries = true;
+        gfal_mds_bdii_cache_clear();
+    }
+
+    virtual void TearDown() {
+        gfal_mds_bdii_cache_clear();
+        gfal_mds_ldap = original;
+    }
+};
+
+
+TEST_F(MdsLdapTestFixture, test_resolution_cached)
+{
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+
+    for (int i = 0; i < 3; ++i) {
+        int ret = gfal_mds_bdii_get_srm_endpoint(context, "mocked.domain.com", endpoints, 5, &err);
+        ASSERT_EQ(err, (void*)NULL);
+        ASSERT_EQ(ret, 1);
+        ASSERT_EQ(endpoints[0].type, SRMv2);
+        ASSERT_STREQ(endpoints[0].url, "httpg://mocked.domain.com:8446/srm/managerv2");
+    }
+
+    ASSERT_EQ(n_initialize, 1);
+    ASSERT_EQ(n_search, 1);
+}
+
+
+TEST_F(MdsLdapTestFixture, test_connection_reused)
+{
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+
+    int ret = gfal_mds_bdii_get_srm_endpoint(context, "mocked.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(ret, 1);
+    ret = gfal_mds_bdii_get_srm_endpoint(context, "another.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(ret, 1);
+
+    ASSERT_EQ(n_initialize, 1);
+    ASSERT_EQ(n_search, 2);
+    ASSERT_EQ(n_unbind, 0);
+}
+
+
+TEST_F(MdsLdapTestFixture, test_negative_cached)
+{
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+    has_entries = false;
+
+    for (int i = 0; i < 2; ++i) {
+        int ret = gfal_mds_bdii_get_srm_endpoint(context, "missing.domain.com", endpoints, 5, &err);
+        ASSERT_EQ(ret, -1);
+        ASSERT_NE(err, (void*)NULL);
+        ASSERT_EQ(err->code, ENXIO);
+        g_clear_error(&err);
+    }
+
+    ASSERT_EQ(n_search, 1);
+}
+
+
+TEST_F(MdsLdapTestFixture, test_negative_cache_disabled)
+{
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+    has_entries = false;
+    gfal2_set_opt_integer(context, "BDII", "RESOLUTION_NEGATIVE_CACHE_TTL", 0, NULL);
+
+    for (int i = 0; i < 2; ++i) {
+        int ret = gfal_mds_bdii_get_srm_endpoint(context, "missing.domain.com", endpoints, 5, &err);
+        ASSERT_EQ(ret, -1);
+        g_clear_error(&err);
+    }
+
+    ASSERT_EQ(n_search, 2);
+}
+
+
+TEST_F(MdsLdapTestFixture, test_reconnect_on_failure)
+{
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+    search_failures = 1;
+
+    int ret = gfal_mds_bdii_get_srm_endpoint(context, "mocked.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(err, (void*)NULL);
+    ASSERT_EQ(ret, 1);
+
+    ASSERT_EQ(n_initialize, 2);
+    ASSERT_EQ(n_search, 2);
+    ASSERT_EQ(n_unbind, 1);
+}
+
+
+TEST_F(MdsLdapTestFixture, test_connection_errors_not_cached)
+{
+    gfal_mds_endpoint endpoints[5];
+    GError* err = NULL;
+    search_failures = 2;
+
+    int ret = gfal_mds_bdii_get_srm_endpoint(context, "mocked.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(ret, -1);
+    ASSERT_NE(err, (void*)NULL);
+    g_clear_error(&err);
+
+    ret = gfal_mds_bdii_get_srm_endpoint(context, "mocked.domain.com", endpoints, 5, &err);
+    ASSERT_EQ(err, (void*)NULL);
+    ASSERT_EQ(ret, 1);
+}
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include <gfal_api.h>
+#include <gtest/gtest.h>
+#include <common/gfal_gtest_asserts.h>
+#include <utils/exceptions/gerror_to_cpp.h>
+
+extern "C" {
+#include "plugins/mock/gfal_mock_plugin.h"
+
+gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err);
+}
+
+
+TEST(MockQueryTest, WholeKey)
+{
+    char value[64];
+
+    gfal_plugin_mock_get_value("mock://host/file?size_pre=5&size=10", "size", value, sizeof(value));
+    EXPECT_STREQ("10", value);
+
+    gfal_plugin_mock_get_value("mock://host/file?size=10&size_pre=5", "size_pre", value, sizeof(value));
+    EXPECT_STREQ("5", value);
+
+    gfal_plugin_mock_get_value("mock://host/file?size_pre=5", "size", value, sizeof(value));
+    EXPECT_STREQ("", value);
+
+    gfal_plugin_mock_get_value("mock://host/file?xsize=3", "size", value, sizeof(value));
+    EXPECT_STREQ("", value);
+
+    gfal_plugin_mock_get_value("mock://host/file", "size", value, sizeof(value));
+    EXPECT_STREQ("", value);
+}
+
+
+class MockShapingTest: public testing::Test {
+public:
+    MockShapingTest() {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        Gfal::gerror_to_cpp(&error);
+
+        mock_ifce = gfal_plugin_init(context, &error);
+        Gfal::gerror_to_cpp(&error);
+        mdata = (MockPluginData *) mock_ifce.plugin_data;
+    }
+
+    virtual ~MockShapingTest() {
+        mock_ifce.plugin_delete(mdata);
+        gfal2_context_free(context);
+    }
+
+protected:
+    gfal2_context_t context;
+    gfal_plugin_interface mock_ifce;
+    MockPluginData *mdata;
+
+    gfal_file_handle open_file(const char *url, GError **error) {
+        return mock_ifce.openG(mdata, url, O_RDONLY, 0, error);
+    }
+
+    void close_file(gfal_file_handle fh) {
+        GError *error = NULL;
+        ASSERT_EQ(0, mock_ifce.closeG(mdata, fh, &error));
+    }
+
+    static double elapsed_since(gint64 start) {
+        return (g_get_monotonic_time() - start) / (double) G_USEC_PER_SEC;
+    }
+};
+
+
+TEST_F(MockShapingTest, Latency)
+{
+    GError *error = NULL;
+    struct stat st;
+
+    gint64 start = g_get_monotonic_time();
+    int ret = mock_ifce.statG(mdata, "mock://host/file?size=10&latency=200", &st, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    EXPECT_EQ(10, st.st_size);
+    EXPECT_GE(elapsed_since(start), 0.19);
+}
+
+
+TEST_F(MockShapingTest, Bandwidth)
+{
+    GError *error = NULL;
+    char buffer[100000];
+
+    gfal_file_handle fh = open_file("mock://host/file?size=100000&payload=zero&bandwidth=500000", &error);
+    ASSERT_TRUE(fh != NULL);
+
+    gint64 start = g_get_monotonic_time();
+    ssize_t total = 0, ret;
+    while ((ret = mock_ifce.readG(mdata, fh, buffer, sizeof(buffer), &error)) > 0)
+        total += ret;
+    ASSERT_EQ(0, ret);
+    EXPECT_EQ(100000, total);
+    // 100000 bytes at 500000 bytes/s
+    EXPECT_GE(elapsed_since(start), 0.19);
+    close_file(fh);
+}
+
+
+TEST_F(MockShapingTest, Pattern)
+{
+    GError *error = NULL;
+    unsigned char buffer[1000];
+
+    gfal_file_handle fh = open_file("mock://host/file?size=2000&payload=pattern", &error);
+    ASSERT_TRUE(fh != NULL);
+    ASSERT_EQ((ssize_t) sizeof(buffer), mock_ifce.preadG(mdata, fh, buffer, sizeof(buffer), 600, &error));
+    for (size_t i = 0; i < sizeof(buffer); ++i)
+        ASSERT_EQ((600 + i) % 251, buffer[i]);
+    close_file(fh);
+}
+
+
+TEST_F(MockShapingTest, MaxConnectionsTimeout)
+{
+    GError *error = NULL;
+    const char *url = "mock://limited/file?size=10&payload=zero&max_connections=1&connect_timeout=1";
+
+    gfal_file_handle first = open_file(url, &error);
+    ASSERT_TRUE(first != NULL);
+
+    gint64 start = g_get_monotonic_time();
+    gfal_file_handle second = open_file(url, &error);
+    EXPECT_TRUE(second == NULL);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, -1, error, ETIMEDOUT);
+    EXPECT_GE(elapsed_since(start), 0.9);
+    g_clear_error(&error);
+
+    // Another host is not affected
+    gfal_file_handle other = open_file("mock://other/file?size=10&payload=zero&max_connections=1", &error);
+    ASSERT_TRUE(other != NULL);
+    close_file(other);
+
+    close_file(first);
+    second = open_file(url, &error);
+    ASSERT_TRUE(second != NULL);
+    close_file(second);
+}
+
+
+TEST_F(MockShapingTest, MaxConnectionsWaitsForClose)
+{
+    GError *error = NULL;
+    const char *url = "mock://limited/file?size=10&payload=zero&max_connections=1&connect_timeout=30";
+
+    gfal_file_handle first = open_file(url, &error);
+    ASSERT_TRUE(first != NULL);
+
+    std::thread closer([this, first]() {
+        usleep(200000);
+        close_file(first);
+    });
+
+    gint64 start = g_get_monotonic_time();
+    gfal_file_handle second = open_file(url, &error);
+    closer.join();
+    ASSERT_TRUE(second != NULL);
+    EXPECT_GE(elapsed_since(start), 0.19);
+    EXPECT_LT(elapsed_since(start), 10);
+    close_file(second);
+}
+
+
+TEST_F(MockShapingTest, MaxConnectionsCancel)
+{
+    GError *error = NULL;
+    const char *url = "mock://limited/file?size=10&payload=zero&max_connections=1&connect_timeout=30";
+
+    gfal_file_handle first = open_file(url, &error);
+    ASSERT_TRUE(first != NULL);
+
+    std::thread canceler([this]() {
+        usleep(200000);
+        gfal2_cancel(context);
+    });
+
+    gint64 start = g_get_monotonic_time();
+    gfal_file_handle second = open_file(url, &error);
+    canceler.join();
+    EXPECT_TRUE(second == NULL);
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, -1, error, ECANCELED);
+    EXPECT_LT(elapsed_since(start), 10);
+    g_clear_error(&error);
+
+    close_file(first);
+}
@@ -0,0 +1,531 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gfal_api.h>
+#include <gtest/gtest.h>
+#include <common/gfal_gtest_asserts.h>
+#include <utils/exceptions/gerror_to_cpp.h>
+
+#define __GFAL2_H_INSIDE__
+#include <common/gfal_plugin.h>
+#undef __GFAL2_H_INSIDE__
+
+extern "C" {
+#include "plugins/srm/gfal_srm.h"
+#include "plugins/srm/gfal_srm_copy.h"
+#include "plugins/srm/gfal_srm_getput.h"
+#include "plugins/srm/gfal_srm_internal_layer.h"
+#include "plugins/srm/gfal_srm_request.h"
+
+gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err);
+}
+
+// Calls done on the mocked srm-ifce and on the TURL plugin, in order
+static std::vector<std::string> calls;
+// Return an error, with a request token, from the next PrepareToGet
+static bool fail_prepare = false;
+
+
+static std::string count_call(const char *name, int n)
+{
+    return std::string(name) + ":" + std::to_string(n);
+}
+
+
+// Indexes of the surls the endpoint answers for, in the order of the response
+// A "short" surl gets no status, and a "reversed" one reverses the response
+static std::vector<int> mock_status_order(int nbfiles, char **surls)
+{
+    std::vector<int> order;
+    bool reversed = false;
+    for (int i = 0; i < nbfiles; ++i) {
+        if (!strstr(surls[i], "short"))
+            order.push_back(i);
+        if (strstr(surls[i], "reversed"))
+            reversed = true;
+    }
+    if (reversed)
+        std::reverse(order.begin(), order.end());
+    return order;
+}
+
+
+static struct srmv2_pinfilestatus *mock_pinfilestatuses(int nbfiles, char **surls, int *n)
+{
+    struct srmv2_pinfilestatus *statuses = NULL;
+    std::vector<int> order = mock_status_order(nbfiles, surls);
+
+    *n = order.size();
+    statuses = (struct srmv2_pinfilestatus *) calloc(*n, sizeof(struct srmv2_pinfilestatus));
+    for (int i = 0; i < *n; ++i) {
+        const char *surl = surls[order[i]];
+        statuses[i].surl = strdup(surl);
+        statuses[i].status = 0;
+        // Protocol that was not requested
+        if (strstr(surl, "badproto"))
+            statuses[i].turl = g_strconcat("rfio://turl", surl, NULL);
+        else
+            statuses[i].turl = g_strconcat("test://turl", surl, NULL);
+    }
+    return statuses;
+}
+
+
+static int mock_prepare_to_get(struct srm_context *context,
+    struct srm_preparetoget_input *input, struct srm_preparetoget_output *output)
+{
+    calls.push_back(count_call("get", input->nbfiles));
+    output->token = strdup("get-token");
+    if (fail_prepare) {
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    int n;
+    output->filestatuses = mock_pinfilestatuses(input->nbfiles, input->surls, &n);
+    return n;
+}
+
+
+static int mock_prepare_to_put(struct srm_context *context,
+    struct srm_preparetoput_input *input, struct srm_preparetoput_output *output)
+{
+    calls.push_back(count_call("put", input->nbfiles));
+    output->token = strdup("put-token");
+    int n;
+    output->filestatuses = mock_pinfilestatuses(input->nbfiles, input->surls, &n);
+    return n;
+}
+
+
+static int mock_filestatuses(int nbfiles, char **surls, struct srmv2_filestatus **statuses)
+{
+    std::vector<int> order = mock_status_order(nbfiles, surls);
+
+    *statuses = (struct srmv2_filestatus *) calloc(order.size(), sizeof(struct srmv2_filestatus));
+    for (size_t i = 0; i < order.size(); ++i) {
+        const char *surl = surls[order[i]];
+        (*statuses)[i].surl = strdup(surl);
+        if (strstr(surl, "denied")) {
+            (*statuses)[i].status = EACCES;
+            (*statuses)[i].explanation = strdup("permission denied");
+        }
+    }
+    return order.size();
+}
+
+
+static int mock_put_done(struct srm_context *context,
+    struct srm_putdone_input *input, struct srmv2_filestatus **statuses)
+{
+    calls.push_back(count_call("putdone", input->nbfiles));
+    return mock_filestatuses(input->nbfiles, input->surls, statuses);
+}
+
+
+static int mock_release_files(struct srm_context *context,
+    struct srm_releasefiles_input *input, struct srmv2_filestatus **statuses)
+{
+    calls.push_back(count_call("release", input->nbfiles));
+    return mock_filestatuses(input->nbfiles, input->surls, statuses);
+}
+
+
+static int mock_abort_files(struct srm_context *context,
+    struct srm_abort_files_input *input, struct srmv2_filestatus **statuses)
+{
+    calls.push_back(count_call("abort", input->nbfiles));
+    return mock_filestatuses(input->nbfiles, input->surls, statuses);
+}
+
+
+static int mock_abort_request(struct srm_context *context, char *reqtoken)
+{
+    calls.push_back(std::string("abort_request:") + reqtoken);
+    return 0;
+}
+
+
+static int mock_ls(struct srm_context *context,
+    struct srm_ls_input *input, struct srm_ls_output *output)
+{
+    errno = ENOENT;
+    return -1;
+}
+
+
+static int mock_rm(struct srm_context *context,
+    struct srm_rm_input *input, struct srm_rm_output *output)
+{
+    calls.push_back(count_call("rm", input->nbfiles));
+    errno = ENOENT;
+    return -1;
+}
+
+
+static int mock_xping(struct srm_context *context, struct srm_xping_output *output)
+{
+    return -1;
+}
+
+
+static void mock_pinfilestatus_delete(struct srmv2_pinfilestatus *statuses, int n)
+{
+    int i;
+    for (i = 0; i < n; ++i) {
+        free(statuses[i].surl);
+        g_free(statuses[i].turl);
+    }
+    free(statuses);
+}
+
+
+static void mock_filestatus_delete(struct srmv2_filestatus *statuses, int n)
+{
+    int i;
+    for (i = 0; i < n; ++i) {
+        free(statuses[i].surl);
+        free(statuses[i].explanation);
+    }
+    free(statuses);
+}
+
+
+static void mock_retstatus_delete(struct srm2__TReturnStatus *status)
+{
+}
+
+
+// Plugin handling the TURLs returned by the mock
+static const char *test_turl_getName()
+{
+    return "test_turl";
+}
+
+
+static int test_turl_check_url_transfer(plugin_handle plugin_data, gfal2_context_t context,
+    const char *src, const char *dst, gfal_url2_check check)
+{
+    return check == GFAL_FILE_COPY &&
+           strncmp(src, "test://", 7) == 0 && strncmp(dst, "test://", 7) == 0;
+}
+
+
+static int test_turl_copy(plugin_handle plugin_data, gfal2_context_t context, gfalt_params_t params,
+    const char *src, const char *dst, GError **err)
+{
+    calls.push_back("copy");
+    return 0;
+}
+
+
+class SrmBulkTest: public testing::Test {
+public:
+    SrmBulkTest() {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        Gfal::gerror_to_cpp(&error);
+
+        srm_ifce = gfal_plugin_init(context, &error);
+        Gfal::gerror_to_cpp(&error);
+        opts = (gfal_srmv2_opt *) srm_ifce.plugin_data;
+        gfal2_register_plugin(context, &srm_ifce, &error);
+        Gfal::gerror_to_cpp(&error);
+
+        gfal_plugin_interface turl_ifce;
+        memset(&turl_ifce, 0, sizeof(turl_ifce));
+        turl_ifce.getName = test_turl_getName;
+        turl_ifce.check_plugin_url_transfer = test_turl_check_url_transfer;
+        turl_ifce.copy_file = test_turl_copy;
+        gfal2_register_plugin(context, &turl_ifce, &error);
+        Gfal::gerror_to_cpp(&error);
+
+        gfal2_set_opt_string_list(context, "SRM PLUGIN", "TURL_3RD_PARTY_PROTOCOLS",
+            protocols, 1, NULL);
+    }
+
+    virtual ~SrmBulkTest() {
+        gfal2_context_free(context);
+    }
+
+    virtual void SetUp() {
+        calls.clear();
+        fail_prepare = false;
+        external_call_backup = gfal_srm_external_call;
+
+        gfal_srm_external_call.srm_prepare_to_get = mock_prepare_to_get;
+        gfal_srm_external_call.srm_prepare_to_put = mock_prepare_to_put;
+        gfal_srm_external_call.srm_put_done = mock_put_done;
+        gfal_srm_external_call.srm_release_files = mock_release_files;
+        gfal_srm_external_call.srm_abort_files = mock_abort_files;
+        gfal_srm_external_call.srm_abort_request = mock_abort_request;
+        gfal_srm_external_call.srm_ls = mock_ls;
+        gfal_srm_external_call.srm_rm = mock_rm;
+        gfal_srm_external_call.srm_xping = mock_xping;
+        gfal_srm_external_call.srm_srmv2_pinfilestatus_delete = mock_pinfilestatus_delete;
+        gfal_srm_external_call.srm_srmv2_filestatus_delete = mock_filestatus_delete;
+        gfal_srm_external_call.srm_srm2__TReturnStatus_delete = mock_retstatus_delete;
+    }
+
+    virtual void TearDown() {
+        gfal_srm_external_call = external_call_backup;
+    }
+
+protected:
+    static const char *protocols[];
+
+    gfal2_context_t context;
+    gfal_plugin_interface srm_ifce;
+    gfal_srmv2_opt *opts;
+    struct _gfal_srm_external_call external_call_backup;
+
+    gfal_srm_params_t test_params() {
+        gfal_srm_params_t params = gfal_srm_params_new(opts);
+        gfal_srm_params_set_protocols(params, g_strdupv((char **) protocols));
+        return params;
+    }
+
+    static void free_results(gfal_srm_result *resu, int n) {
+        for (int i = 0; i < n; ++i) {
+            g_free(resu[i].reqtoken);
+        }
+        free(resu);
+    }
+};
+
+const char *SrmBulkTest::protocols[] = {"test", NULL};
+
+
+// A TURL with a protocol that was not requested only fails its own file
+TEST_F(SrmBulkTest, ListRejectsOnlyBadTurl)
+{
+    GError *error = NULL;
+    gfal_srm_result *resu = NULL;
+    const char *surls[] = {
+        "srm://se.example.com:8446/srm/managerv2?SFN=/dir/file1",
+        "srm://se.example.com:8446/srm/managerv2?SFN=/dir/badproto",
+        "srm://se.example.com:8446/srm/managerv2?SFN=/dir/file3",
+    };
+
+    gfal_srm_params_t params = test_params();
+    int ret = gfal_srm_getTURLS_list(opts, params, 3, surls, &resu, &error);
+    gfal_srm_params_free(params);
+
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ASSERT_EQ(3, ret);
+    EXPECT_EQ(0, resu[0].err_code);
+    EXPECT_EQ(EBADMSG, resu[1].err_code);
+    EXPECT_EQ(0, resu[2].err_code);
+    // The rejected file is still part of the request
+    EXPECT_STREQ("get-token", resu[1].reqtoken);
+    free_results(resu, ret);
+}
+
+
+// A missing status only fails its own file, which keeps the token
+TEST_F(SrmBulkTest, ListShortResponse)
+{
+    GError *error = NULL;
+    gfal_srm_result *resu = NULL;
+    const char *surls[] = {
+        "srm://se.example.com:8446/srm/managerv2?SFN=/dir/short",
+        "srm://se.example.com:8446/srm/managerv2?SFN=/dir/file2",
+    };
+
+    gfal_srm_params_t params = test_params();
+    int ret = gfal_srm_getTURLS_list(opts, params, 2, surls, &resu, &error);
+    gfal_srm_params_free(params);
+
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ASSERT_EQ(2, ret);
+    EXPECT_EQ(EIO, resu[0].err_code);
+    EXPECT_STREQ("", resu[0].turl);
+    EXPECT_STREQ("get-token", resu[0].reqtoken);
+    EXPECT_EQ(0, resu[1].err_code);
+    EXPECT_TRUE(g_str_has_suffix(resu[1].turl, "/dir/file2"));
+    free_results(resu, ret);
+}
+
+
+// The statuses are matched to the surls, not to their position in the response
+TEST_F(SrmBulkTest, ListReorderedResponse)
+{
+    GError *error = NULL;
+    gfal_srm_result *resu = NULL;
+    const char *surls[] = {
+        "srm://se.example.com:8446/srm/managerv2?SFN=/dir/reversed",
+        "srm://se.example.com:8446/srm/managerv2?SFN=/dir/file2",
+        "srm://se.example.com:8446/srm/managerv2?SFN=/dir/file3",
+    };
+
+    gfal_srm_params_t params = test_params();
+    int ret = gfal_srm_putTURLS_list(opts, params, 3, surls, NULL, &resu, &error);
+    gfal_srm_params_free(params);
+
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ASSERT_EQ(3, ret);
+    EXPECT_TRUE(g_str_has_suffix(resu[0].turl, "/dir/reversed"));
+    EXPECT_TRUE(g_str_has_suffix(resu[1].turl, "/dir/file2"));
+    EXPECT_TRUE(g_str_has_suffix(resu[2].turl, "/dir/file3"));
+    free_results(resu, ret);
+}
+
+
+TEST_F(SrmBulkTest, PutDoneMatchesSurls)
+{
+    GError *errors[3] = {NULL, NULL, NULL};
+    const char *surls[] = {
+        "srm://se.example.com:8446/srm/managerv2?SFN=/dir/reversed",
+        "srm://se.example.com:8446/srm/managerv2?SFN=/dir/denied",
+        "srm://se.example.com:8446/srm/managerv2?SFN=/dir/short",
+    };
+
+    int ret = gfal_srm_putdone_list(opts, 3, surls, "put-token", errors);
+
+    EXPECT_EQ(-2, ret);
+    EXPECT_EQ(NULL, errors[0]);
+    EXPECT_PRED_FORMAT3(AssertGfalErrno, -1, errors[1], EACCES);
+    EXPECT_PRED_FORMAT3(AssertGfalErrno, -1, errors[2], EIO);
+    g_clear_error(&errors[1]);
+    g_clear_error(&errors[2]);
+}
+
+
+// A failed request that got a token is aborted
+TEST_F(SrmBulkTest, ListFailureAbortsRequest)
+{
+    GError *error = NULL;
+    gfal_srm_result *resu = NULL;
+    const char *surls[] = {
+        "srm://se.example.com:8446/srm/managerv2?SFN=/dir/file1",
+    };
+
+    fail_prepare = true;
+    gfal_srm_params_t params = test_params();
+    int ret = gfal_srm_getTURLS_list(opts, params, 1, surls, &resu, &error);
+    gfal_srm_params_free(params);
+
+    ASSERT_PRED_FORMAT3(AssertGfalErrno, ret, error, ETIMEDOUT);
+    g_error_free(error);
+    EXPECT_EQ(NULL, resu);
+    ASSERT_EQ(2, calls.size());
+    EXPECT_EQ("abort_request:get-token", calls[1]);
+}
+
+
+// TURLs are resolved one window at a time, right before their transfer
+TEST_F(SrmBulkTest, CopyResolvesPerWindow)
+{
+    GError *op_error = NULL;
+    GError **file_errors = NULL;
+    const char *srcs[5], *dsts[5];
+    std::vector<std::string> urls;
+
+    for (int i = 0; i < 5; ++i) {
+        urls.push_back("srm://src.example.com:8446/srm/managerv2?SFN=/dir/file" + std::to_string(i));
+        urls.push_back("srm://dst.example.com:8446/srm/managerv2?SFN=/dir/file" + std::to_string(i));
+    }
+    for (int i = 0; i < 5; ++i) {
+        srcs[i] = urls[2 * i].c_str();
+        dsts[i] = urls[2 * i + 1].c_str();
+    }
+
+    gfal2_set_opt_integer(context, "SRM PLUGIN", "BULK_REQUEST_SIZE", 2, NULL);
+    gfalt_params_t params = gfalt_params_handle_new(NULL);
+    int ret = srm_plugin_copy_bulk(opts, context, params, 5, srcs, dsts, NULL, &op_error, &file_errors);
+    gfalt_params_handle_delete(params, NULL);
+
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, op_error);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(NULL, file_errors[i]);
+    }
+    g_free(file_errors);
+
+    const std::vector<std::string> expected = {
+        "get:2", "put:2", "copy", "copy", "putdone:2", "release:2",
+        "get:2", "put:2", "copy", "copy", "putdone:2", "release:2",
+        "get:1", "put:1", "copy", "putdone:1", "release:1",
+    };
+    EXPECT_EQ(expected, calls);
+}
+
+
+// A rejected TURL fails its file, which is aborted and released, without affecting the others
+TEST_F(SrmBulkTest, CopyRollsBackRejectedTurl)
+{
+    GError *op_error = NULL;
+    GError **file_errors = NULL;
+    const char *srcs[] = {
+        "srm://src.example.com:8446/srm/managerv2?SFN=/dir/file1",
+        "srm://src.example.com:8446/srm/managerv2?SFN=/dir/file2",
+    };
+    const char *dsts[] = {
+        "srm://dst.example.com:8446/srm/managerv2?SFN=/dir/file1",
+        "srm://dst.example.com:8446/srm/managerv2?SFN=/dir/badproto",
+    };
+
+    gfal2_set_opt_integer(context, "SRM PLUGIN", "BULK_REQUEST_SIZE", 10, NULL);
+    gfalt_params_t params = gfalt_params_handle_new(NULL);
+    int ret = srm_plugin_copy_bulk(opts, context, params, 2, srcs, dsts, NULL, &op_error, &file_errors);
+    gfalt_params_handle_delete(params, NULL);
+
+    EXPECT_EQ(-1, ret);
+    EXPECT_EQ(NULL, op_error);
+    EXPECT_EQ(NULL, file_errors[0]);
+    EXPECT_PRED_FORMAT3(AssertGfalErrno, -1, file_errors[1], EBADMSG);
+    g_clear_error(&file_errors[1]);
+    g_free(file_errors);
+
+    const std::vector<std::string> expected = {
+        "get:2", "put:2", "copy", "putdone:1", "abort:1", "rm:1", "release:2",
+    };
+    EXPECT_EQ(expected, calls);
+}
+
+
+// Destinations are not overwritten before their sources are resolved
+TEST_F(SrmBulkTest, CopyKeepsDestinationWhenSourceFails)
+{
+    GError *op_error = NULL;
+    GError **file_errors = NULL;
+    const char *srcs[] = {
+        "srm://src.example.com:8446/srm/managerv2?SFN=/dir/file1",
+    };
+    const char *dsts[] = {
+        "srm://dst.example.com:8446/srm/managerv2?SFN=/dir/file1",
+    };
+
+    fail_prepare = true;
+    gfalt_params_t params = gfalt_params_handle_new(NULL);
+    gfalt_set_replace_existing_file(params, TRUE, NULL);
+    int ret = srm_plugin_copy_bulk(opts, context, params, 1, srcs, dsts, NULL, &op_error, &file_errors);
+    gfalt_params_handle_delete(params, NULL);
+
+    EXPECT_EQ(-1, ret);
+    EXPECT_EQ(NULL, op_error);
+    EXPECT_PRED_FORMAT3(AssertGfalErrno, -1, file_errors[0], ETIMEDOUT);
+    g_clear_error(&file_errors[0]);
+    g_free(file_errors);
+
+    const std::vector<std::string> expected = {
+        "get:1", "abort_request:get-token",
+    };
+    EXPECT_EQ(expected, calls);
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <gfal_api.h>
+#include <gtest/gtest.h>
+#include <common/gfal_gtest_asserts.h>
+#include <utils/exceptions/gerror_to_cpp.h>
+
+extern "C" {
+#include <gsimplecache/gcachemain.h>
+#include "plugins/srm/gfal_srm.h"
+#include "plugins/srm/gfal_srm_getput.h"
+#include "plugins/srm/gfal_srm_internal_layer.h"
+#include "plugins/srm/gfal_srm_internal_ls.h"
+#include "plugins/srm/gfal_srm_namespace.h"
+
+gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err);
+}
+
+static const char *test_dir = "srm://se.example.com:8446/srm/managerv2?SFN=/dir";
+static const char *test_file = "srm://se.example.com:8446/srm/managerv2?SFN=/dir/file";
+
+
+static int mock_put_done(struct srm_context *context,
+    struct srm_putdone_input *input, struct srmv2_filestatus **statuses)
+{
+    *statuses = (struct srmv2_filestatus *) calloc(input->nbfiles, sizeof(struct srmv2_filestatus));
+    return input->nbfiles;
+}
+
+
+static void mock_filestatus_delete(struct srmv2_filestatus *statuses, int n)
+{
+    free(statuses);
+}
+
+
+static int mock_ls(struct srm_context *context,
+    struct srm_ls_input *input, struct srm_ls_output *output)
+{
+    errno = ENOENT;
+    return -1;
+}
+
+
+static int mock_mkdir(struct srm_context *context, struct srm_mkdir_input *input)
+{
+    return 0;
+}
+
+
+static void copy_int(gpointer original, gpointer copy)
+{
+    memcpy(copy, original, sizeof(int));
+}
+
+
+// A batch is never wiped by the space it makes for itself
+TEST(SimpleCacheTest, BatchSurvivesManageSpace)
+{
+    GSimpleCache *cache = gsimplecache_new(10, copy_int, sizeof(int));
+    char key[16];
+    int i, value;
+
+    for (i = 0; i < 8; ++i) {
+        snprintf(key, sizeof(key), "old%d", i);
+        gsimplecache_add_item_kstr(cache, key, &i);
+    }
+
+    char batch_keys[5][16];
+    const char *keys[5];
+    int values[5];
+    for (i = 0; i < 5; ++i) {
+        snprintf(batch_keys[i], sizeof(batch_keys[i]), "new%d", i);
+        keys[i] = batch_keys[i];
+        values[i] = 100 + i;
+    }
+    gsimplecache_add_items_ttl_kstr(cache, 5, keys, values, 60);
+
+    for (i = 0; i < 5; ++i) {
+        ASSERT_EQ(0, gsimplecache_take_one_kstr(cache, keys[i], &value));
+        EXPECT_EQ(100 + i, value);
+    }
+    gsimplecache_delete(cache);
+}
+
+
+// A batch larger than the cache never fills it past its limit
+TEST(SimpleCacheTest, BatchLargerThanCache)
+{
+    GSimpleCache *cache = gsimplecache_new(10, copy_int, sizeof(int));
+    char key[16];
+    int i, value;
+
+    char batch_keys[25][16];
+    const char *keys[25];
+    int values[25];
+    for (i = 0; i < 25; ++i) {
+        snprintf(batch_keys[i], sizeof(batch_keys[i]), "entry%d", i);
+        keys[i] = batch_keys[i];
+        values[i] = i;
+    }
+    gsimplecache_add_items_ttl_kstr(cache, 25, keys, values, 60);
+
+    int cached = 0;
+    for (i = 0; i < 25; ++i) {
+        if (gsimplecache_take_one_kstr(cache, keys[i], &value) == 0) {
+            EXPECT_EQ(i, value);
+            ++cached;
+        }
+    }
+    EXPECT_EQ(10, cached);
+
+    // The cache is full, the next item makes room for itself
+    snprintf(key, sizeof(key), "other");
+    gsimplecache_add_item_kstr(cache, key, &i);
+    EXPECT_EQ(0, gsimplecache_take_one_kstr(cache, key, &value));
+    gsimplecache_delete(cache);
+}
+
+
+class SrmLsCacheTest: public testing::Test {
+public:
+    SrmLsCacheTest() {
+        GError *error = NULL;
+        context = gfal2_context_new(&error);
+        Gfal::gerror_to_cpp(&error);
+
+        srm_ifce = gfal_plugin_init(context, &error);
+        Gfal::gerror_to_cpp(&error);
+        opts = (gfal_srmv2_opt *) srm_ifce.plugin_data;
+    }
+
+    virtual ~SrmLsCacheTest() {
+        srm_ifce.plugin_delete(opts);
+        gfal2_context_free(context);
+    }
+
+    virtual void SetUp() {
+        external_call_backup = gfal_srm_external_call;
+        gfal_srm_external_call.srm_put_done = mock_put_done;
+        gfal_srm_external_call.srm_srmv2_filestatus_delete = mock_filestatus_delete;
+        gfal_srm_external_call.srm_ls = mock_ls;
+        gfal_srm_external_call.srm_mkdir = mock_mkdir;
+
+        // Both the entry and its parent are cached
+        struct stat st;
+        memset(&st, 0, sizeof(st));
+        TFileLocality loc = (TFileLocality) 0;
+        gfal_srm_cache_stat_add(opts, test_dir, &st, &loc);
+        gfal_srm_cache_stat_add(opts, test_file, &st, &loc);
+    }
+
+    virtual void TearDown() {
+        gfal_srm_external_call = external_call_backup;
+    }
+
+protected:
+    gfal2_context_t context;
+    gfal_plugin_interface srm_ifce;
+    gfal_srmv2_opt *opts;
+    struct _gfal_srm_external_call external_call_backup;
+
+    bool is_cached(const char *surl) {
+        struct extended_stat xstat;
+        return gfal_srm_cache_stat_get(opts, surl, &xstat) == 0;
+    }
+};
+
+
+TEST_F(SrmLsCacheTest, PutDoneInvalidatesEntryAndParent)
+{
+    GError *errors[1] = {NULL};
+    const char *surls[] = {test_file};
+
+    int ret = gfal_srm_putdone_list(opts, 1, surls, "token", errors);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, errors[0]);
+
+    EXPECT_FALSE(is_cached(test_file));
+    EXPECT_FALSE(is_cached(test_dir));
+}
+
+
+TEST_F(SrmLsCacheTest, MkdirInvalidatesParent)
+{
+    GError *error = NULL;
+    const char *subdir = "srm://se.example.com:8446/srm/managerv2?SFN=/dir/subdir";
+
+    int ret = gfal_srm_mkdirG(opts, subdir, 0755, FALSE, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    EXPECT_FALSE(is_cached(test_dir));
+    // A sibling is not affected
+    EXPECT_TRUE(is_cached(test_file));
+}
+
+
+// Whatever the form of the surl
+TEST_F(SrmLsCacheTest, RemoveMatchesDecodedSurl)
+{
+    gfal_srm_cache_stat_remove(opts, "srm://se.example.com/dir/file");
+
+    EXPECT_FALSE(is_cached(test_file));
+    EXPECT_FALSE(is_cached(test_dir));
+}
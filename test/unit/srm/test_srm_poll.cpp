@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "plugins/srm/gfal_srm.h"
+#include "plugins/srm/gfal_srm_poll.h"
+}
+
+static const char *surl1 = "srm://se.example.com:8446/srm/managerv2?SFN=/dir/file1";
+static const char *surl2 = "srm://se.example.com:8446/srm/managerv2?SFN=/dir/file2";
+static const char *surl3 = "srm://se.example.com:8446/srm/managerv2?SFN=/dir/file3";
+
+
+TEST(SrmPollTest, BackoffGrowsUpToTheCap)
+{
+    gint interval = gfal_srm_poll_next_interval(0, 0, 2, 600);
+    EXPECT_EQ(2, interval);
+
+    gint expected = 2;
+    while (expected < 600) {
+        interval = gfal_srm_poll_next_interval(interval, 0, 2, 600);
+        expected = MIN(expected * 2, 600);
+        EXPECT_EQ(expected, interval);
+    }
+
+    // Stays at the cap
+    EXPECT_EQ(600, gfal_srm_poll_next_interval(interval, 0, 2, 600));
+    // Does not overflow with a huge cap
+    EXPECT_EQ(G_MAXINT, gfal_srm_poll_next_interval(G_MAXINT / 2 + 1, 0, 1, G_MAXINT));
+}
+
+
+TEST(SrmPollTest, BackoffFollowsEstimatedWait)
+{
+    EXPECT_EQ(30, gfal_srm_poll_next_interval(64, 30, 2, 600));
+    EXPECT_EQ(2, gfal_srm_poll_next_interval(64, 1, 2, 600));
+    EXPECT_EQ(600, gfal_srm_poll_next_interval(2, 3600, 2, 600));
+}
+
+
+TEST(SrmPollTest, JitterBounds)
+{
+    const gint interval = 10;
+    const gint64 base = interval * G_USEC_PER_SEC;
+    const gint64 low = (gint64) (base * (1.0 - GFAL_SRM_POLL_JITTER));
+    const gint64 high = (gint64) (base * (1.0 + GFAL_SRM_POLL_JITTER));
+
+    // Allow for the rounding of the conversion to microseconds
+    EXPECT_NEAR(low, gfal_srm_poll_jittered_delay(interval, 0.0), 1);
+    EXPECT_NEAR(base, gfal_srm_poll_jittered_delay(interval, 0.5), 1);
+    EXPECT_NEAR(high, gfal_srm_poll_jittered_delay(interval, 1.0), 1);
+
+    // Out of range values are clamped
+    EXPECT_NEAR(low, gfal_srm_poll_jittered_delay(interval, -1.0), 1);
+    EXPECT_NEAR(high, gfal_srm_poll_jittered_delay(interval, 2.0), 1);
+
+    for (int i = 0; i < 1000; ++i) {
+        gint64 delay = gfal_srm_poll_jittered_delay(interval, g_random_double());
+        EXPECT_LE(low - 1, delay);
+        EXPECT_GE(high + 1, delay);
+    }
+}
+
+
+TEST(SrmPollTest, CoalesceDuplicatesAndPending)
+{
+    gfal_srmv2_opt opts;
+    memset(&opts, 0, sizeof(opts));
+    gfal_srm_poll_init(&opts);
+
+    gfal_srm_poll_entry_t entry = gfal_srm_poll_acquire(&opts, surl1, "token");
+    gfal_srm_poll_update(entry, surl1, EAGAIN, NULL, 0);
+    gfal_srm_poll_update(entry, surl2, EAGAIN, NULL, 0);
+    gfal_srm_poll_update(entry, surl3, 0, NULL, 0);
+
+    // surl1 is asked twice, surl2 is still pending, surl3 is done
+    const char *surls[] = {surl1, surl1};
+    char **query = gfal_srm_poll_coalesce(entry, 2, surls);
+    ASSERT_EQ(2, g_strv_length(query));
+    EXPECT_STREQ(surl1, query[0]);
+    EXPECT_STREQ(surl2, query[1]);
+    g_strfreev(query);
+
+    // Asking for a pending one again does not duplicate it
+    const char *surls2[] = {surl2, surl1, surl2};
+    query = gfal_srm_poll_coalesce(entry, 3, surls2);
+    ASSERT_EQ(2, g_strv_length(query));
+    EXPECT_STREQ(surl2, query[0]);
+    EXPECT_STREQ(surl1, query[1]);
+    g_strfreev(query);
+
+    gfal_srm_poll_release(&opts, entry);
+    gfal_srm_poll_destroy(&opts);
+}
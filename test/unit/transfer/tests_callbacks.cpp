@@ -20,6 +20,9 @@
 
 #include <gtest/gtest.h>
 #include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
 #include <gfal_api.h>
 #include <gfal_plugins_api.h>
 
@@ -90,6 +93,76 @@ TEST(gfalTransfer, test_monitor_callbacks)
 }
 
 
+static void monitor_callback_status(gfalt_transfer_status_t h, const char* src, const char* dst,
+        gpointer user_data)
+{
+    std::vector<_gfalt_transfer_status> *samples = (std::vector<_gfalt_transfer_status>*)(user_data);
+    samples->push_back(*h);
+}
+
+
+TEST(gfalTransfer, test_perf_meter)
+{
+    std::vector<_gfalt_transfer_status> samples;
+
+    gfal2_context_t context = gfal2_context_new(NULL);
+    gfal2_set_opt_integer(context, "CORE", "TRANSFER_MONITOR_INTERVAL", 0, NULL);
+    gfalt_params_t params = gfalt_params_handle_new(NULL);
+    gfalt_add_monitor_callback(params, monitor_callback_status, &samples, NULL, NULL);
+
+    gfalt_perf_meter_t meter;
+    gfalt_perf_meter_init(context, &meter);
+
+    for (int i = 0; i < 4; ++i) {
+        g_usleep(1000);
+        _gfalt_transfer_status status;
+        ASSERT_TRUE(gfalt_perf_meter_update(&meter, 1024, &status));
+        status.streams = 1;
+        plugin_trigger_monitor_ext(params, &status, sizeof(status), "source", "destination");
+    }
+
+    ASSERT_EQ(4u, samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        EXPECT_EQ(1024 * (i + 1), gfalt_copy_get_bytes_transfered(&samples[i], NULL));
+        EXPECT_EQ(1u, gfalt_copy_get_streams(&samples[i], NULL));
+        EXPECT_EQ(0u, gfalt_copy_get_bytes_in_flight(&samples[i], NULL));
+        // Sub-second transfers still get a rate
+        EXPECT_GT(gfalt_copy_get_average_baudrate(&samples[i], NULL), 0u);
+        EXPECT_GT(gfalt_copy_get_instant_baudrate(&samples[i], NULL), 0u);
+        EXPECT_GE(gfalt_copy_get_elapsed_time_ns(&samples[i], NULL), (gint64)(1000000 * (i + 1)));
+        if (i > 0) {
+            EXPECT_GT(gfalt_copy_get_timestamp(&samples[i], NULL), gfalt_copy_get_timestamp(&samples[i - 1], NULL));
+        }
+    }
+
+    // Plugins not filling the timestamp get one
+    _gfalt_transfer_status status;
+    memset(&status, 0, sizeof(status));
+    plugin_trigger_monitor(params, &status, "source", "destination");
+    ASSERT_EQ(5u, samples.size());
+    EXPECT_GE(samples[4].timestamp, samples[3].timestamp);
+    // without writing into the status of the plugin
+    EXPECT_EQ(0, status.timestamp);
+
+    // Plugins built against the old structure: nothing past bytes_transfered is read
+    status.bytes_transfered = 42;
+    status.streams = 8;
+    plugin_trigger_monitor(params, &status, "source", "destination");
+    ASSERT_EQ(6u, samples.size());
+    EXPECT_EQ(42u, samples[5].bytes_transfered);
+    EXPECT_EQ(0u, samples[5].streams);
+    EXPECT_GT(samples[5].timestamp, 0);
+
+    // With a long interval, no marker right away
+    gfal2_set_opt_integer(context, "CORE", "TRANSFER_MONITOR_INTERVAL", 60000, NULL);
+    gfalt_perf_meter_init(context, &meter);
+    EXPECT_FALSE(gfalt_perf_meter_update(&meter, 1024, &status));
+
+    gfalt_params_handle_delete(params, NULL);
+    gfal2_context_free(context);
+}
+
+
 TEST(gfalTransfer, test_event_callbacks)
 {
     int counter1 = 0, counter2 = 0;
@@ -206,3 +279,99 @@ TEST(gfalTransfer, test_inject_callback_bulk)
 
     gfalt_params_handle_delete(params, NULL);
 }
+
+
+struct TestSpan {
+    std::string name, plugin, span_id, parent_span_id, trace_id;
+    guint64 bytes;
+    int status;
+};
+
+
+static void span_callback(const gfalt_span_t *span, gpointer user_data)
+{
+    std::vector<TestSpan> *spans = static_cast<std::vector<TestSpan>*>(user_data);
+    TestSpan copy;
+    copy.name = span->name;
+    copy.plugin = span->plugin ? span->plugin : "";
+    copy.span_id = span->span_id;
+    copy.parent_span_id = span->parent_span_id ? span->parent_span_id : "";
+    copy.trace_id = span->trace_id;
+    copy.bytes = span->bytes;
+    copy.status = span->status;
+    g_assert(span->start_time <= span->end_time);
+    spans->push_back(copy);
+}
+
+
+static int test_plugin_traced_copy(plugin_handle plugin_data, gfal2_context_t context,
+        gfalt_params_t params, const char* src, const char* dst, GError** error)
+{
+    struct _gfalt_transfer_status status;
+    memset(&status, 0, sizeof(status));
+    status.bytes_transfered = 100;
+
+    plugin_trigger_event(params, domain, GFAL_EVENT_NONE, GFAL_EVENT_TRANSFER_ENTER, "");
+    plugin_trigger_monitor(params, &status, src, dst);
+    plugin_trigger_event(params, domain, GFAL_EVENT_NONE, GFAL_EVENT_TRANSFER_EXIT, "");
+
+    // Never finished
+    plugin_trigger_event(params, domain, GFAL_EVENT_DESTINATION, GFAL_EVENT_CHECKSUM_ENTER, "");
+    g_set_error(error, domain, ECOMM, "Checksum failed");
+    return -1;
+}
+
+
+TEST(gfalTransfer, test_trace_spans)
+{
+    gfal_plugin_interface test_plugin;
+    memset(&test_plugin, 0, sizeof(test_plugin));
+
+    test_plugin.getName = test_plugin_name;
+    test_plugin.check_plugin_url_transfer = test_plugin_check_transfer;
+    test_plugin.copy_file = test_plugin_traced_copy;
+
+    gfal2_context_t context = gfal2_context_new(NULL);
+    gfal2_register_plugin(context, &test_plugin, NULL);
+
+    std::vector<TestSpan> spans;
+    gfalt_params_t params = gfalt_params_handle_new(NULL);
+    gfalt_add_span_callback(params, span_callback, &spans, NULL, NULL);
+
+    GError *error = NULL;
+    int ret = gfalt_copy_file(context, params, "test://", "test://", &error);
+    ASSERT_NE(0, ret);
+    g_clear_error(&error);
+
+    ASSERT_EQ(3, spans.size());
+
+    EXPECT_EQ("transfer", spans[0].name);
+    EXPECT_EQ("TEST", spans[0].plugin);
+    EXPECT_EQ(100, spans[0].bytes);
+    EXPECT_EQ(0, spans[0].status);
+
+    // Closed with the copy
+    EXPECT_EQ("checksum", spans[1].name);
+    EXPECT_EQ(ECOMM, spans[1].status);
+
+    EXPECT_EQ("copy", spans[2].name);
+    EXPECT_EQ("TEST-PLUGIN", spans[2].plugin);
+    EXPECT_EQ("", spans[2].parent_span_id);
+    EXPECT_EQ(100, spans[2].bytes);
+    EXPECT_EQ(ECOMM, spans[2].status);
+
+    EXPECT_EQ(spans[2].span_id, spans[0].parent_span_id);
+    EXPECT_EQ(spans[2].span_id, spans[1].parent_span_id);
+    EXPECT_EQ(32, spans[2].trace_id.size());
+    EXPECT_EQ(spans[2].trace_id, spans[0].trace_id);
+
+    // A new copy is a new trace
+    std::string first_trace = spans[2].trace_id;
+    spans.clear();
+    gfalt_copy_file(context, params, "test://", "test://", NULL);
+    ASSERT_EQ(3, spans.size());
+    EXPECT_NE(first_trace, spans[2].trace_id);
+
+    gfalt_params_handle_delete(params, NULL);
+    gfal2_context_free(context);
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) CERN 2013-2017
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <set>
+#include "gfal_xrootd_plugin_parallelism.h"
+
+
+TEST(ParallelismTuner, RampsWhileImproving)
+{
+    ParallelismTuner tuner("ramp", 2, 16);
+    ASSERT_EQ(2, tuner.GetLevel());
+    tuner.Feedback(100, false);
+    ASSERT_EQ(4, tuner.GetLevel());
+    tuner.Feedback(200, false);
+    ASSERT_EQ(8, tuner.GetLevel());
+    // Saturated: back to the best level, and settled
+    tuner.Feedback(205, false);
+    ASSERT_EQ(4, tuner.GetLevel());
+    ASSERT_FALSE(tuner.IsRamping());
+}
+
+
+TEST(ParallelismTuner, NeverAboveMax)
+{
+    ParallelismTuner tuner("max", 2, 5);
+    for (int i = 0; i < 10; ++i) {
+        tuner.Feedback(100 * (i + 1), false);
+        ASSERT_LE(tuner.GetLevel(), 5);
+    }
+    ASSERT_EQ(5, tuner.GetLevel());
+}
+
+
+TEST(ParallelismTuner, RecoversAfterErrors)
+{
+    {
+        ParallelismTuner tuner("recover", 8, 16);
+        tuner.Feedback(0, true);
+        ASSERT_EQ(4, tuner.GetLevel());
+        tuner.Feedback(0, true);
+        ASSERT_EQ(2, tuner.GetLevel());
+    }
+
+    // A new batch starts from the remembered level
+    ParallelismTuner tuner("recover", 8, 16);
+    ASSERT_EQ(2, tuner.GetLevel());
+    ASSERT_FALSE(tuner.IsRamping());
+
+    // but probes higher levels, and keeps them if they pay off
+    double throughput = 100;
+    for (int i = 0; i < 40 && tuner.GetLevel() < 8; ++i) {
+        throughput = tuner.GetLevel() * 50;
+        tuner.Feedback(throughput, false);
+    }
+    ASSERT_GE(tuner.GetLevel(), 8);
+    // Confirmed by the next sample
+    tuner.Feedback(tuner.GetLevel() * 50, false);
+
+    // and the next batch starts from there
+    ParallelismTuner next("recover", 2, 16);
+    ASSERT_GE(next.GetLevel(), 8);
+}
+
+
+TEST(ParallelismTuner, ProbeRevertsWithoutGain)
+{
+    ParallelismTuner tuner("probe", 4, 16);
+    tuner.Feedback(100, false);
+    tuner.Feedback(100, false);
+    ASSERT_EQ(4, tuner.GetLevel());
+    ASSERT_FALSE(tuner.IsRamping());
+
+    tuner.Feedback(100, false);
+    tuner.Feedback(100, false);
+    tuner.Feedback(100, false);
+    ASSERT_EQ(5, tuner.GetLevel());
+    tuner.Feedback(100, false);
+    ASSERT_EQ(4, tuner.GetLevel());
+}
+
+
+class AdaptiveSchedulerTest: public testing::Test {
+public:
+    AdaptiveSchedulerTest(): running(0) {
+    }
+
+protected:
+    std::mutex mutex;
+    std::map<std::string, int> maxRunning;
+    std::map<std::string, int> runningPerPair;
+    int running;
+    int maxRunningTotal;
+    std::vector<std::string> keys;
+    std::set<size_t> done, skipped;
+
+    bool RunJob(size_t index, std::atomic<uint64_t>* bytes, int sleepMs, bool fail) {
+        const std::string& key = keys[index];
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            int n = ++runningPerPair[key];
+            maxRunning[key] = std::max(maxRunning[key], n);
+            maxRunningTotal = std::max(maxRunningTotal, ++running);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(sleepMs));
+        *bytes += 1024;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --runningPerPair[key];
+            --running;
+            done.insert(index);
+        }
+        return !fail;
+    }
+
+    void SetUp() {
+        maxRunningTotal = 0;
+    }
+};
+
+
+// Both pairs run at the same time, within their window
+TEST_F(AdaptiveSchedulerTest, PairsRunConcurrently)
+{
+    AdaptiveScheduler scheduler(2, 4, std::chrono::milliseconds(1000));
+    for (size_t i = 0; i < 20; ++i) {
+        keys.push_back(i % 2 ? "concurrent-a" : "concurrent-b");
+        scheduler.Add(keys.back(), i);
+    }
+
+    scheduler.Run(
+        [this](size_t index, std::atomic<uint64_t>* bytes) { return RunJob(index, bytes, 10, false); },
+        [this](size_t index) { skipped.insert(index); },
+        []() { return false; });
+
+    ASSERT_EQ(20u, done.size());
+    ASSERT_TRUE(skipped.empty());
+    // Window of 2 per pair, since there is no sample before the end
+    EXPECT_EQ(2, maxRunning["concurrent-a"]);
+    EXPECT_EQ(2, maxRunning["concurrent-b"]);
+    EXPECT_EQ(4, maxRunningTotal);
+}
+
+
+// The global limit holds even if each pair could go higher
+TEST_F(AdaptiveSchedulerTest, GlobalLimit)
+{
+    AdaptiveScheduler scheduler(3, 3, std::chrono::milliseconds(1000));
+    for (size_t i = 0; i < 18; ++i) {
+        keys.push_back(i % 3 == 0 ? "limit-a" : (i % 3 == 1 ? "limit-b" : "limit-c"));
+        scheduler.Add(keys.back(), i);
+    }
+
+    scheduler.Run(
+        [this](size_t index, std::atomic<uint64_t>* bytes) { return RunJob(index, bytes, 5, false); },
+        [this](size_t index) { skipped.insert(index); },
+        []() { return false; });
+
+    ASSERT_EQ(18u, done.size());
+    EXPECT_LE(maxRunningTotal, 3);
+    // Nobody starved
+    EXPECT_GE(maxRunning["limit-a"], 1);
+    EXPECT_GE(maxRunning["limit-b"], 1);
+    EXPECT_GE(maxRunning["limit-c"], 1);
+}
+
+
+// Errors shrink the window of the pair
+TEST_F(AdaptiveSchedulerTest, ErrorsShrinkWindow)
+{
+    AdaptiveScheduler scheduler(4, 8, std::chrono::milliseconds(20));
+    for (size_t i = 0; i < 40; ++i) {
+        keys.push_back("errors");
+        scheduler.Add(keys.back(), i);
+    }
+
+    scheduler.Run(
+        [this](size_t index, std::atomic<uint64_t>* bytes) { return RunJob(index, bytes, 10, true); },
+        [this](size_t index) { skipped.insert(index); },
+        []() { return false; });
+
+    ASSERT_EQ(40u, done.size());
+    ParallelismTuner after("errors", 4, 8);
+    EXPECT_LT(after.GetLevel(), 4);
+}
+
+
+TEST_F(AdaptiveSchedulerTest, Cancel)
+{
+    AdaptiveScheduler scheduler(1, 1, std::chrono::milliseconds(10));
+    for (size_t i = 0; i < 10; ++i) {
+        keys.push_back("cancel");
+        scheduler.Add(keys.back(), i);
+    }
+
+    scheduler.Run(
+        [this](size_t index, std::atomic<uint64_t>* bytes) { return RunJob(index, bytes, 20, false); },
+        [this](size_t index) { skipped.insert(index); },
+        [this]() { std::lock_guard<std::mutex> lock(mutex); return !done.empty(); });
+
+    EXPECT_LT(done.size(), 10u);
+    EXPECT_EQ(10u, done.size() + skipped.size());
+}